@@ -406,6 +406,8 @@ public:
     friend class PipelineUnittest;
     friend class InputFileUnittest;
     friend class AggregatorUnittest;
+    friend class CheckpointLogUnittest;
+    friend class CheckpointBenchmark;
 #endif
 };
 
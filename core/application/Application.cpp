@@ -41,6 +41,7 @@
 #include "monitor/LogFileProfiler.h"
 #include "monitor/MetricExportor.h"
 #include "monitor/Monitor.h"
+#include "monitor/SamplingProfiler.h"
 #include "pipeline/PipelineManager.h"
 #include "plugin/PluginRegistry.h"
 #include "processor/daemon/LogProcess.h"
@@ -67,6 +68,7 @@ DEFINE_FLAG_INT32(exit_flushout_duration, "exit process flushout duration", 20 *
 
 DECLARE_FLAG_BOOL(send_prefer_real_ip);
 DECLARE_FLAG_BOOL(global_network_success);
+DECLARE_FLAG_BOOL(enable_sampling_profiler);
 
 using namespace std;
 
@@ -209,6 +211,9 @@ void Application::Start() {
 
     LogtailAlarm::GetInstance()->Init();
     LogtailMonitor::GetInstance()->Init();
+    if (BOOL_FLAG(enable_sampling_profiler)) {
+        SamplingProfiler::GetInstance()->Start();
+    }
 
     PluginRegistry::GetInstance()->LoadPlugins();
 
@@ -315,6 +320,7 @@ void Application::Exit() {
     CommonConfigProvider::GetInstance()->Stop();
 #endif
 
+    SamplingProfiler::GetInstance()->Stop();
     LogtailMonitor::GetInstance()->Stop();
     LogtailAlarm::GetInstance()->Stop();
     // from now on, alarm should not be used.
@@ -40,6 +40,10 @@ DEFINE_FLAG_INT32(check_point_version, "now check point version xx.xx.xx such as
 DEFINE_FLAG_INT32(check_point_dump_interval, "default 15 min", 15 * 60);
 DEFINE_FLAG_INT32(check_point_max_count, "max check point count", 100000);
 DEFINE_FLAG_INT32(checkpoint_find_max_file_count, "", 1000);
+DEFINE_FLAG_BOOL(enable_binary_checkpoint,
+                 "dump checkpoints to an incremental binary log instead of the json file, versions before it can only "
+                 "read the json file, so turn it off and let a dump run before downgrading",
+                 false);
 
 namespace logtail {
 
@@ -48,6 +52,7 @@ bool CheckPointManager::CheckVersion() {
 }
 
 void CheckPointManager::AddCheckPoint(CheckPoint* checkPointPtr) {
+    std::lock_guard<std::mutex> lock(mFileCheckPointMux);
     DevInodeCheckPointHashMap::iterator it
         = mDevInodeCheckPointPtrMap.find(CheckPointKey(checkPointPtr->mDevInode, checkPointPtr->mConfigName));
     if (it != mDevInodeCheckPointPtrMap.end())
@@ -57,12 +62,14 @@ void CheckPointManager::AddCheckPoint(CheckPoint* checkPointPtr) {
 }
 
 void CheckPointManager::DeleteCheckPoint(DevInode devInode, const std::string& configName) {
+    std::lock_guard<std::mutex> lock(mFileCheckPointMux);
     DevInodeCheckPointHashMap::iterator it = mDevInodeCheckPointPtrMap.find(CheckPointKey(devInode, configName));
     if (it != mDevInodeCheckPointPtrMap.end())
         mDevInodeCheckPointPtrMap.erase(it);
 }
 
 bool CheckPointManager::GetCheckPoint(DevInode devInode, const std::string& configName, CheckPointPtr& checkPointPtr) {
+    std::lock_guard<std::mutex> lock(mFileCheckPointMux);
     DevInodeCheckPointHashMap::iterator it = mDevInodeCheckPointPtrMap.find(CheckPointKey(devInode, configName));
     if (it != mDevInodeCheckPointPtrMap.end()) {
         checkPointPtr = it->second;
@@ -120,6 +127,14 @@ void CheckPointManager::AddDirCheckPoint(const string& dirname) {
     ptr->mSubDir.insert(dirname);
 }
 void CheckPointManager::LoadCheckPoint() {
+    if (BOOL_FLAG(enable_binary_checkpoint) && LoadBinaryCheckPoint()) {
+        return;
+    }
+    // a log left by a run with the flag on is the latest state if there is no json file, the next dump exports it
+    if (!BOOL_FLAG(enable_binary_checkpoint) && !CheckExistance(AppConfig::GetInstance()->GetCheckPointFilePath())
+        && LoadBinaryCheckPoint()) {
+        return;
+    }
     Json::Value root;
     ParseConfResult cptRes = ParseConfig(AppConfig::GetInstance()->GetCheckPointFilePath(), root);
     // if new checkpoint file not exist, check old checkpoint file.
@@ -315,6 +330,10 @@ bool CheckPointManager::DumpCheckPointToLocal() {
         return false;
     }
 
+    if (BOOL_FLAG(enable_binary_checkpoint)) {
+        return DumpBinaryCheckPoint();
+    }
+
     Json::Value root;
     mReaderCount = mDevInodeCheckPointPtrMap.size();
     if (mDevInodeCheckPointPtrMap.size() <= (size_t)INT32_FLAG(check_point_max_count)) {
@@ -418,6 +437,13 @@ bool CheckPointManager::DumpCheckPointToLocal() {
                                                std::string("rename check point file fail, errno ") + ToString(errno));
         return false;
     }
+    // the checkpoint log has been exported, remove it so that it does not shadow the json file if the flag is turned on
+    if (CheckExistance(checkPointFile + ".bin")) {
+        mCheckpointLog.reset();
+        if (remove((checkPointFile + ".bin").c_str()) == 0) {
+            LOG_INFO(sLogger, ("checkpoint log is exported to json checkpoint file, remove it", checkPointFile));
+        }
+    }
     LOG_DEBUG(sLogger,
               ("dump checkpoint, version", INT32_FLAG(check_point_version))(
                   "file check point", mDevInodeCheckPointPtrMap.size())("dir check point", mDirNameMap.size()));
@@ -425,6 +451,196 @@ bool CheckPointManager::DumpCheckPointToLocal() {
     return true;
 }
 
+// Records of the checkpoint log are keyed by type, file checkpoints by dev, inode and config name like the json file.
+// Dir checkpoints keep their update time first in the value, so that loading drops timed out ones as the json file does.
+static const char kFileRecordType = 'f';
+static const char kDirRecordType = 'd';
+static const std::string kMetaRecordKey = "m";
+
+static void EncodeFileCheckPoint(const CheckPoint& cpt, std::string& key, std::string& value) {
+    key.clear();
+    key.push_back(kFileRecordType);
+    CheckpointLog::PutFixed64(key, cpt.mDevInode.dev);
+    CheckpointLog::PutFixed64(key, cpt.mDevInode.inode);
+    key.append(cpt.mConfigName);
+
+    value.clear();
+    uint32_t flags = (cpt.mFileOpenFlag ? 1 : 0) | (cpt.mContainerStopped ? 2 : 0) | (cpt.mLastForceRead ? 4 : 0);
+    CheckpointLog::PutFixed32(value, flags);
+    CheckpointLog::PutFixed64(value, (uint64_t)cpt.mOffset);
+    CheckpointLog::PutFixed32(value, cpt.mSignatureSize);
+    CheckpointLog::PutFixed64(value, cpt.mSignatureHash);
+    CheckpointLog::PutFixed32(value, (uint32_t)cpt.mLastUpdateTime);
+    CheckpointLog::PutString(value, cpt.mFileName);
+    CheckpointLog::PutString(value, cpt.mRealFileName);
+}
+
+static CheckPoint* DecodeFileCheckPoint(const std::string& key, const std::string& value) {
+    const char* p = key.data() + 1;
+    const char* end = key.data() + key.size();
+    DevInode devInode;
+    if (!CheckpointLog::GetFixed64(p, end, devInode.dev) || !CheckpointLog::GetFixed64(p, end, devInode.inode)) {
+        return nullptr;
+    }
+    std::string configName(p, end);
+
+    p = value.data();
+    end = value.data() + value.size();
+    uint32_t flags = 0, sigSize = 0, updateTime = 0;
+    uint64_t offset = 0, sigHash = 0;
+    std::string fileName, realFileName;
+    if (!CheckpointLog::GetFixed32(p, end, flags) || !CheckpointLog::GetFixed64(p, end, offset)
+        || !CheckpointLog::GetFixed32(p, end, sigSize) || !CheckpointLog::GetFixed64(p, end, sigHash)
+        || !CheckpointLog::GetFixed32(p, end, updateTime) || !CheckpointLog::GetString(p, end, fileName)
+        || !CheckpointLog::GetString(p, end, realFileName)) {
+        return nullptr;
+    }
+    CheckPoint* cpt = new CheckPoint(fileName,
+                                     (int64_t)offset,
+                                     sigSize,
+                                     sigHash,
+                                     devInode,
+                                     configName,
+                                     realFileName,
+                                     (flags & 1) != 0,
+                                     (flags & 2) != 0,
+                                     (flags & 4) != 0);
+    cpt->mLastUpdateTime = (int32_t)updateTime;
+    return cpt;
+}
+
+CheckpointLog& CheckPointManager::GetCheckpointLog() {
+    if (!mCheckpointLog) {
+        mCheckpointLog.reset(new CheckpointLog(AppConfig::GetInstance()->GetCheckPointFilePath() + ".bin"));
+    }
+    return *mCheckpointLog;
+}
+
+bool CheckPointManager::LoadBinaryCheckPoint() {
+    CheckpointLog& log = GetCheckpointLog();
+    if (!log.Exists()) {
+        return false;
+    }
+    std::unordered_map<std::string, std::string> records;
+    if (!log.Load(records)) {
+        LogtailAlarm::GetInstance()->SendAlarm(CHECKPOINT_ALARM, "checkpoint log is invalid: " + log.GetPath());
+        return false;
+    }
+
+    int32_t dumpTime = 0;
+    auto metaIter = records.find(kMetaRecordKey);
+    if (metaIter != records.end()) {
+        const char* p = metaIter->second.data();
+        const char* end = p + metaIter->second.size();
+        uint32_t version = 0, dumpSec = 0;
+        if (CheckpointLog::GetFixed32(p, end, version) && CheckpointLog::GetFixed32(p, end, dumpSec)) {
+            mLoadVersion = (int32_t)version;
+            dumpTime = (int32_t)dumpSec;
+        }
+        records.erase(metaIter);
+    }
+    for (const auto& record : records) {
+        if (record.first.empty()) {
+            continue;
+        }
+        if (record.first[0] == kFileRecordType) {
+            CheckPoint* cpt = DecodeFileCheckPoint(record.first, record.second);
+            if (cpt == nullptr || !cpt->mDevInode.IsValid()) {
+                LOG_WARNING(sLogger, ("invalid file checkpoint in checkpoint log, discard it", log.GetPath()));
+                delete cpt;
+                continue;
+            }
+            AddCheckPoint(cpt);
+        } else if (record.first[0] == kDirRecordType) {
+            const char* p = record.second.data();
+            const char* end = p + record.second.size();
+            uint32_t updateTime = 0;
+            if (!CheckpointLog::GetFixed32(p, end, updateTime)) {
+                LOG_WARNING(sLogger, ("invalid dir checkpoint in checkpoint log, discard it", log.GetPath()));
+                continue;
+            }
+            if ((int32_t)updateTime < time(NULL) - INT32_FLAG(file_check_point_time_out)) {
+                LOG_INFO(sLogger,
+                         ("load timeout dir check point, ignore", record.first.substr(1))(ToString(updateTime),
+                                                                                          time(NULL)));
+                continue;
+            }
+            DirCheckPointPtr dir(new DirCheckPoint(record.first.substr(1)));
+            std::string subDir;
+            while (p < end && CheckpointLog::GetString(p, end, subDir)) {
+                dir->mSubDir.insert(subDir);
+            }
+            mDirNameMap.insert(make_pair(dir->mParentName, dir));
+        }
+    }
+    mReaderCount = mDevInodeCheckPointPtrMap.size();
+    LOG_INFO(sLogger,
+             ("load checkpoint log, version", mLoadVersion)("dump time", dumpTime)(
+                 "file check point", mDevInodeCheckPointPtrMap.size())("dir check point", mDirNameMap.size())(
+                 "log size", log.GetFileSize()));
+    return true;
+}
+
+bool CheckPointManager::DumpBinaryCheckPoint() {
+    CheckpointLog& log = GetCheckpointLog();
+    std::string key, value;
+    log.BeginDump();
+
+    mReaderCount = mDevInodeCheckPointPtrMap.size();
+    if (mDevInodeCheckPointPtrMap.size() <= (size_t)INT32_FLAG(check_point_max_count)) {
+        for (const auto& item : mDevInodeCheckPointPtrMap) {
+            EncodeFileCheckPoint(*item.second, key, value);
+            log.Put(key, value);
+        }
+    } else {
+        vector<CheckPoint*> sortedCheckPointVec;
+        sortedCheckPointVec.reserve(mDevInodeCheckPointPtrMap.size());
+        for (const auto& item : mDevInodeCheckPointPtrMap) {
+            sortedCheckPointVec.push_back(item.second.get());
+        }
+        sort(sortedCheckPointVec.begin(), sortedCheckPointVec.end(), CheckPointManager::CheckPointCmpByUpdateTime);
+        for (int32_t i = 0; i < INT32_FLAG(check_point_max_count); ++i) {
+            EncodeFileCheckPoint(*sortedCheckPointVec[i], key, value);
+            log.Put(key, value);
+        }
+        LOG_WARNING(sLogger, ("Too many check point", mDevInodeCheckPointPtrMap.size()));
+        LogtailAlarm::GetInstance()->SendAlarm(CHECKPOINT_ALARM,
+                                               "Too many check point:" + ToString(mDevInodeCheckPointPtrMap.size()));
+    }
+    for (const auto& item : mDirNameMap) {
+        key.clear();
+        key.push_back(kDirRecordType);
+        key.append(item.first);
+        value.clear();
+        CheckpointLog::PutFixed32(value, (uint32_t)item.second->mUpdateTime);
+        for (const auto& subDir : item.second->mSubDir) {
+            CheckpointLog::PutString(value, subDir);
+        }
+        log.Put(key, value);
+    }
+    value.clear();
+    CheckpointLog::PutFixed32(value, (uint32_t)INT32_FLAG(check_point_version));
+    CheckpointLog::PutFixed32(value, (uint32_t)mLastDumpTime);
+    log.Put(kMetaRecordKey, value);
+
+    if (!log.EndDump()) {
+        LogtailAlarm::GetInstance()->SendAlarm(CHECKPOINT_ALARM, "dump check point to log failed");
+        return false;
+    }
+    // the json file has been imported, remove it so that it is not loaded if the log is lost
+    std::string checkPointFile = AppConfig::GetInstance()->GetCheckPointFilePath();
+    if (CheckExistance(checkPointFile)) {
+        if (remove(checkPointFile.c_str()) == 0) {
+            LOG_INFO(sLogger, ("json checkpoint file is imported to checkpoint log, remove it", checkPointFile));
+        }
+    }
+    LOG_DEBUG(sLogger,
+              ("dump checkpoint log, version", INT32_FLAG(check_point_version))(
+                  "file check point", mDevInodeCheckPointPtrMap.size())("dir check point", mDirNameMap.size())(
+                  "written records", log.GetLastDumpRecordCount())("log size", log.GetFileSize()));
+    return true;
+}
+
 int32_t CheckPointManager::GetReaderCount() {
     return mReaderCount;
 }
@@ -538,6 +754,8 @@ void CheckPointManager::RemoveLocalCheckPoint() {
     std::string checkPointFile = AppConfig::GetInstance()->GetCheckPointFilePath();
     if (remove(checkPointFile.c_str()) == -1) {
     }
+    remove((checkPointFile + ".bin").c_str());
+    mCheckpointLog.reset();
 }
 
 void CheckPointManager::PrintStatus() {
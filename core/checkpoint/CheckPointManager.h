@@ -17,11 +17,13 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <set>
 #include <ctime>
 #include <json/json.h>
 #include <boost/optional.hpp>
+#include "checkpoint/CheckpointLog.h"
 #include "common/DevInode.h"
 #include "common/EncodingConverter.h"
 #include "common/SplitedFilePath.h"
@@ -109,14 +111,24 @@ public:
 
 private:
     DevInodeCheckPointHashMap mDevInodeCheckPointPtrMap;
+    // Readers of different shards get and delete file checkpoints at the same time, other accesses are made by the
+    // event processing thread when no shard is running.
+    std::mutex mFileCheckPointMux;
     std::unordered_map<std::string, DirCheckPointPtr> mDirNameMap;
     int32_t mLastCheckTime;
     int32_t mLastDumpTime;
     int32_t mLoadVersion;
     int32_t mReaderCount;
+    std::unique_ptr<CheckpointLog> mCheckpointLog;
     CheckPointManager()
         : mLastCheckTime(time(NULL)), mLastDumpTime(time(NULL)), mLoadVersion(NO_CHECKPOINT_VERSION), mReaderCount(0) {}
 
+    CheckpointLog& GetCheckpointLog();
+    // LoadBinaryCheckPoint returns false if there is no valid checkpoint log, then the json file is loaded instead and
+    // imported by the next dump.
+    bool LoadBinaryCheckPoint();
+    bool DumpBinaryCheckPoint();
+
 public:
     bool CheckVersion();
     void AddCheckPoint(CheckPoint* checkPointPtr);
@@ -147,6 +159,8 @@ public:
 
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class ConfigUpdatorUnittest;
+    friend class CheckpointLogUnittest;
+    friend class CheckpointBenchmark;
     void RemoveLocalCheckPoint();
     void PrintStatus();
 #endif
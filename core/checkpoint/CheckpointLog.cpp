@@ -0,0 +1,271 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "checkpoint/CheckpointLog.h"
+#include <cstring>
+#include <fstream>
+#include <thread>
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+#include "common/FileSystemUtil.h"
+#include "common/Flags.h"
+#include "common/xxhash/xxhash.h"
+#include "logger/Logger.h"
+
+DEFINE_FLAG_INT32(checkpoint_log_compact_ratio,
+                  "checkpoint log is rewritten when it is larger than its live records by this ratio",
+                  4);
+DEFINE_FLAG_INT32(checkpoint_log_compact_min_bytes, "checkpoint log smaller than this is never rewritten", 1024 * 1024);
+
+namespace logtail {
+
+static const char kLogMagic[] = "ILCKPT01";
+static const size_t kLogHeaderSize = sizeof(kLogMagic) - 1;
+// payload length and checksum
+static const size_t kRecordFrameSize = 8;
+static const size_t kWriteChunkSize = 1024 * 1024;
+
+CheckpointLog::~CheckpointLog() {
+    if (mFile != nullptr) {
+        fclose(mFile);
+    }
+}
+
+bool CheckpointLog::Exists() const {
+    return CheckExistance(mPath);
+}
+
+bool CheckpointLog::Load(std::unordered_map<std::string, std::string>& records) {
+    mPersisted.clear();
+    mFileSize = 0;
+    mLiveBytes = 0;
+    mNeedRewrite = true;
+
+    std::ifstream fin(mPath.c_str(), std::ios::binary);
+    if (!fin) {
+        return false;
+    }
+    std::string content;
+    fin.seekg(0, std::ios::end);
+    content.resize((size_t)fin.tellg());
+    fin.seekg(0, std::ios::beg);
+    if (!fin.read(&content[0], content.size())) {
+        LOG_ERROR(sLogger, ("read checkpoint log failed", mPath));
+        return false;
+    }
+    if (content.size() < kLogHeaderSize || content.compare(0, kLogHeaderSize, kLogMagic) != 0) {
+        LOG_ERROR(sLogger, ("invalid checkpoint log header", mPath));
+        return false;
+    }
+
+    const char* begin = content.data();
+    const char* end = begin + content.size();
+    const char* p = begin + kLogHeaderSize;
+    std::string key, value;
+    while (p < end) {
+        const char* record = p;
+        uint32_t length = 0, checksum = 0;
+        if (!GetFixed32(p, end, length) || !GetFixed32(p, end, checksum) || (size_t)(end - p) < length
+            || XXH32(p, length, 0) != checksum || length < 1) {
+            p = record;
+            break;
+        }
+        const char* payloadEnd = p + length;
+        uint8_t type = (uint8_t)*p++;
+        if (!GetString(p, payloadEnd, key)) {
+            p = record;
+            break;
+        }
+        if (type == RECORD_PUT) {
+            value.assign(p, payloadEnd - p);
+            PersistedRecord& persisted = mPersisted[key];
+            persisted.mHash = XXH64(value.data(), value.size(), 0);
+            persisted.mSize = (uint32_t)(kRecordFrameSize + length);
+            records[key].swap(value);
+        } else {
+            mPersisted.erase(key);
+            records.erase(key);
+        }
+        p = payloadEnd;
+    }
+    mFileSize = p - begin;
+    if (p != end) {
+        LOG_WARNING(sLogger,
+                    ("checkpoint log is truncated, drop the tail", mPath)("valid size", mFileSize)("file size",
+                                                                                              content.size()));
+    } else {
+        mNeedRewrite = false;
+    }
+    for (const auto& item : mPersisted) {
+        mLiveBytes += item.second.mSize;
+    }
+    return true;
+}
+
+void CheckpointLog::BeginDump() {
+    ++mEpoch;
+    mBuffer.clear();
+    mLastDumpRecordCount = 0;
+    mWriteFailed = false;
+    mCompacting = mNeedRewrite || mFileSize == 0 || !Exists()
+        || (mFileSize > (uint64_t)INT32_FLAG(checkpoint_log_compact_min_bytes)
+            && mFileSize > mLiveBytes * (uint64_t)INT32_FLAG(checkpoint_log_compact_ratio));
+    if (mCompacting) {
+        mFileSize = 0;
+        mFile = fopen((mPath + ".tmp").c_str(), "wb");
+        mBuffer.append(kLogMagic, kLogHeaderSize);
+    } else {
+        mFile = fopen(mPath.c_str(), "ab");
+    }
+    if (mFile == nullptr) {
+        LOG_ERROR(sLogger, ("open checkpoint log failed", mPath)("errno", errno));
+        mWriteFailed = true;
+    }
+}
+
+void CheckpointLog::Put(const std::string& key, const std::string& value) {
+    uint64_t hash = XXH64(value.data(), value.size(), 0);
+    PersistedRecord& persisted = mPersisted[key];
+    if (!mCompacting && persisted.mSize > 0 && persisted.mHash == hash) {
+        persisted.mEpoch = mEpoch;
+        return;
+    }
+    persisted.mHash = hash;
+    persisted.mSize = (uint32_t)AppendRecord(RECORD_PUT, key, &value);
+    persisted.mEpoch = mEpoch;
+}
+
+bool CheckpointLog::EndDump() {
+    for (auto iter = mPersisted.begin(); iter != mPersisted.end();) {
+        if (iter->second.mEpoch != mEpoch) {
+            if (!mCompacting) {
+                AppendRecord(RECORD_DELETE, iter->first, nullptr);
+            }
+            iter = mPersisted.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    mLiveBytes = 0;
+    for (const auto& item : mPersisted) {
+        mLiveBytes += item.second.mSize;
+    }
+
+    FlushBuffer();
+    bool success = !mWriteFailed;
+    if (mFile != nullptr) {
+        success = fflush(mFile) == 0 && success;
+#if defined(__linux__)
+        success = fsync(fileno(mFile)) == 0 && success;
+#endif
+        success = fclose(mFile) == 0 && success;
+        mFile = nullptr;
+    }
+    if (success && mCompacting) {
+#if defined(_MSC_VER)
+        // The rename on Windows will fail if the destination is existing.
+        remove(mPath.c_str());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+        success = rename((mPath + ".tmp").c_str(), mPath.c_str()) == 0;
+    }
+    if (!success) {
+        LOG_ERROR(sLogger, ("write checkpoint log failed", mPath)("errno", errno)("compacting", mCompacting));
+        // the file may not match records in memory, so rewrite all of them next time
+        mNeedRewrite = true;
+        return false;
+    }
+    mNeedRewrite = false;
+    return true;
+}
+
+size_t CheckpointLog::AppendRecord(RecordType type, const std::string& key, const std::string* value) {
+    uint32_t length = 1 + 4 + key.size() + (value == nullptr ? 0 : value->size());
+    size_t frameBegin = mBuffer.size();
+    PutFixed32(mBuffer, length);
+    PutFixed32(mBuffer, 0);
+    size_t payloadBegin = mBuffer.size();
+    mBuffer.push_back((char)type);
+    PutString(mBuffer, key);
+    if (value != nullptr) {
+        mBuffer.append(*value);
+    }
+    uint32_t checksum = XXH32(mBuffer.data() + payloadBegin, length, 0);
+    std::memcpy(&mBuffer[frameBegin + 4], &checksum, sizeof(checksum));
+    ++mLastDumpRecordCount;
+    if (mBuffer.size() >= kWriteChunkSize) {
+        FlushBuffer();
+    }
+    return kRecordFrameSize + length;
+}
+
+void CheckpointLog::FlushBuffer() {
+    if (mBuffer.empty()) {
+        return;
+    }
+    if (mFile != nullptr && !mWriteFailed) {
+        if (fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size()) {
+            mWriteFailed = true;
+        }
+    }
+    if (!mWriteFailed) {
+        mFileSize += mBuffer.size();
+    }
+    mBuffer.clear();
+}
+
+// Integers are stored in little endian as the agent only runs on such platforms.
+void CheckpointLog::PutFixed32(std::string& dst, uint32_t value) {
+    dst.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void CheckpointLog::PutFixed64(std::string& dst, uint64_t value) {
+    dst.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void CheckpointLog::PutString(std::string& dst, const std::string& value) {
+    PutFixed32(dst, value.size());
+    dst.append(value);
+}
+
+bool CheckpointLog::GetFixed32(const char*& p, const char* end, uint32_t& value) {
+    if ((size_t)(end - p) < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, p, sizeof(value));
+    p += sizeof(value);
+    return true;
+}
+
+bool CheckpointLog::GetFixed64(const char*& p, const char* end, uint64_t& value) {
+    if ((size_t)(end - p) < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, p, sizeof(value));
+    p += sizeof(value);
+    return true;
+}
+
+bool CheckpointLog::GetString(const char*& p, const char* end, std::string& value) {
+    uint32_t size = 0;
+    if (!GetFixed32(p, end, size) || (size_t)(end - p) < size) {
+        return false;
+    }
+    value.assign(p, size);
+    p += size;
+    return true;
+}
+
+} // namespace logtail
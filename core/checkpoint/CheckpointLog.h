@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+namespace logtail {
+
+// CheckpointLog persists key-value records as an append-only log of binary records, each framed by its length and
+// checksum. A dump passes every live record by Put, only the records whose value changed since the last dump are
+// appended, and keys which are not put are appended as deletions. When the log grows much larger than the live
+// records, the dump rewrites all of them to a new file instead, which is renamed over the log.
+//
+// Only fingerprints of persisted values are kept in memory. Not thread safe.
+class CheckpointLog {
+public:
+    explicit CheckpointLog(const std::string& path) : mPath(path) {}
+    ~CheckpointLog();
+
+    const std::string& GetPath() const { return mPath; }
+    bool Exists() const;
+
+    // Load replays the log into records. A torn or corrupted record and the ones after it are dropped, which only
+    // happens if the agent crashed in the middle of an append.
+    bool Load(std::unordered_map<std::string, std::string>& records);
+
+    void BeginDump();
+    void Put(const std::string& key, const std::string& value);
+    bool EndDump();
+
+    uint64_t GetFileSize() const { return mFileSize; }
+    uint64_t GetLiveBytes() const { return mLiveBytes; }
+    // GetLastDumpRecordCount returns the number of records written by the last dump, including deletions.
+    size_t GetLastDumpRecordCount() const { return mLastDumpRecordCount; }
+
+    static void PutFixed32(std::string& dst, uint32_t value);
+    static void PutFixed64(std::string& dst, uint64_t value);
+    static void PutString(std::string& dst, const std::string& value);
+    static bool GetFixed32(const char*& p, const char* end, uint32_t& value);
+    static bool GetFixed64(const char*& p, const char* end, uint64_t& value);
+    static bool GetString(const char*& p, const char* end, std::string& value);
+
+private:
+    enum RecordType : uint8_t { RECORD_PUT = 1, RECORD_DELETE = 2 };
+
+    struct PersistedRecord {
+        uint64_t mHash = 0;
+        uint32_t mSize = 0;
+        uint32_t mEpoch = 0;
+    };
+
+    // AppendRecord returns the size of the record.
+    size_t AppendRecord(RecordType type, const std::string& key, const std::string* value);
+    void FlushBuffer();
+
+    std::string mPath;
+    std::unordered_map<std::string, PersistedRecord> mPersisted;
+    uint64_t mFileSize = 0;
+    uint64_t mLiveBytes = 0;
+    // the log is missing, truncated or failed to write
+    bool mNeedRewrite = true;
+
+    uint32_t mEpoch = 0;
+    bool mCompacting = false;
+    FILE* mFile = nullptr;
+    bool mWriteFailed = false;
+    std::string mBuffer;
+    size_t mLastDumpRecordCount = 0;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class CheckpointLogUnittest;
+#endif
+};
+
+} // namespace logtail
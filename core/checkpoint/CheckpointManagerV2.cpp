@@ -29,6 +29,13 @@ DEFINE_FLAG_INT32(logtail_checkpoint_gc_threshold_sec, "30 minutes", 30 * 60);
 DEFINE_FLAG_DOUBLE(logtail_checkpoint_max_gc_count_ratio_per_round, "10%", 0.1);
 DEFINE_FLAG_INT64(logtail_checkpoint_max_used_time_per_round_in_msec, "500ms", 500);
 DEFINE_FLAG_INT32(logtail_checkpoint_expired_threshold_sec, "6 hours", 6 * 60 * 60);
+DEFINE_FLAG_INT32(logtail_checkpoint_group_commit_window_ms,
+                  "checkpoint writes are buffered and committed in one batch every window, 0 to write directly",
+                  10);
+DEFINE_FLAG_INT32(logtail_checkpoint_group_commit_max_batch_size,
+                  "buffered checkpoint writes are committed before the window ends if there are so many of them",
+                  1024);
+DEFINE_FLAG_INT32(logtail_checkpoint_group_commit_retry_interval_ms, "retry interval after a failed commit", 1000);
 
 DECLARE_FLAG_INT32(max_exactly_once_concurrency);
 
@@ -93,15 +100,32 @@ std::string CheckpointManagerV2::MakeRangeKey(const std::string& primaryKey, uin
     return key;
 }
 
+std::function<void()> CheckpointManagerV2::sCommitListener;
+
 CheckpointManagerV2::CheckpointManagerV2() {
     mDefaultWriteOption.sync = AppConfig::GetInstance()->EnableCheckpointSyncWrite();
 
     if (open()) {
+        // read by the threads, so it is set before any of them starts
+        mEnableGroupCommit = INT32_FLAG(logtail_checkpoint_group_commit_window_ms) > 0;
         mGCThreadPtr.reset(new std::thread([&]() { runGCLoop(); }));
+        if (mEnableGroupCommit) {
+            mCommitThreadPtr.reset(new std::thread([&]() { runCommitLoop(); }));
+        }
     }
 }
 
 CheckpointManagerV2::~CheckpointManagerV2() {
+    if (mCommitThreadPtr) {
+        {
+            std::lock_guard<std::mutex> lock(mPendingMutex);
+            mStopCommitThread = true;
+        }
+        mPendingCond.notify_all();
+        mCommitThreadPtr->join();
+        mCommitThreadPtr.reset();
+    }
+
     mStopGCThread = true;
     if (mGCThreadPtr) {
         mGCThreadPtr->join();
@@ -288,6 +312,8 @@ CheckpointManagerV2::ScanCheckpoints(const std::vector<std::string>& exactlyOnce
         return checkpoints;
     }
 
+    // Full scan iterates the database, so buffered writes must be there.
+    Flush();
     std::vector<std::string> toDeleteKeys;
     auto scanUsedTimeInMs = scanCheckpoints(exactlyOnceConfigs, &checkpoints, toDeleteKeys);
     auto deleteUsedTimeInMs = DeleteCheckpoints(toDeleteKeys);
@@ -304,6 +330,8 @@ uint64_t CheckpointManagerV2::DeleteCheckpoints(const std::vector<std::string>&
     }
 
     auto const startTimeInMs = GetCurrentTimeInMilliSeconds();
+    // Buffered writes of these keys must not be committed after the deletion.
+    Flush();
     leveldb::WriteBatch batch;
     for (auto& k : keys) {
         batch.Delete(k);
@@ -322,6 +350,7 @@ uint64_t CheckpointManagerV2::UpdatePrimaryCheckpoints(
     const std::vector<std::pair<std::string, PrimaryCheckpointPB>*>& checkpoints) {
 #define METHOD_LOG_PATTERN ("method", "UpdatePrimaryCheckpoints")("count", checkpoints.size())
     auto const startTimeInMs = GetCurrentTimeInMilliSeconds();
+    Flush();
     leveldb::WriteBatch batch;
     for (auto& cptPair : checkpoints) {
         auto& key = cptPair->first;
@@ -392,7 +421,19 @@ bool CheckpointManagerV2::readDatabase(const std::string& key, std::string& valu
 }
 
 bool CheckpointManagerV2::read(const std::string& key, std::string& value) {
-    if (!readDatabase(key, value)) {
+    bool found = false;
+    if (mEnableGroupCommit) {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        auto iter = mPendingWrites.find(key);
+        if (iter != mPendingWrites.end()) {
+            value = iter->second;
+            found = true;
+        } else if ((iter = mCommittingWrites.find(key)) != mCommittingWrites.end()) {
+            value = iter->second;
+            found = true;
+        }
+    }
+    if (!found && !readDatabase(key, value)) {
         return false;
     }
 
@@ -409,10 +450,31 @@ bool CheckpointManagerV2::read(const std::string& key, std::string& value) {
     return true;
 }
 
-bool CheckpointManagerV2::write(const std::string& key, const std::string& value) {
+bool CheckpointManagerV2::write(const std::string& key, const std::string& value, uint64_t* seq) {
     ASSERT_LEVELDB_STATUS;
 
+    if (mEnableGroupCommit) {
+        bool notify = false;
+        {
+            std::lock_guard<std::mutex> lock(mPendingMutex);
+            mPendingWrites[key] = value;
+            if (seq != nullptr) {
+                *seq = mPendingSeq;
+            }
+            notify = mPendingWrites.size() == 1
+                || mPendingWrites.size()
+                    >= static_cast<size_t>(INT32_FLAG(logtail_checkpoint_group_commit_max_batch_size));
+        }
+        if (notify) {
+            mPendingCond.notify_one();
+        }
+        return true;
+    }
+
     leveldb::Status s = mDatabase->Put(mDefaultWriteOption, key, value);
+    if (seq != nullptr) {
+        *seq = 0;
+    }
     if (s.ok()) {
         return true;
     }
@@ -420,6 +482,83 @@ bool CheckpointManagerV2::write(const std::string& key, const std::string& value
     return false;
 }
 
+void CheckpointManagerV2::Flush() {
+    if (mEnableGroupCommit) {
+        commitPendingWrites();
+    }
+}
+
+bool CheckpointManagerV2::commitPendingWrites() {
+    std::lock_guard<std::mutex> commitLock(mCommitMutex);
+    ASSERT_LEVELDB_STATUS;
+    uint64_t seq = 0;
+    {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        if (mPendingWrites.empty()) {
+            return true;
+        }
+        mCommittingWrites.swap(mPendingWrites);
+        seq = mPendingSeq++;
+    }
+
+    // Readers only look up mCommittingWrites, so it can be iterated without lock.
+    leveldb::WriteBatch batch;
+    for (auto& item : mCommittingWrites) {
+        batch.Put(item.first, item.second);
+    }
+    auto status = mDatabase->Write(mDefaultWriteOption, &batch);
+
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    if (!status.ok()) {
+        detail::logDatabaseError("group_commit", std::to_string(mCommittingWrites.size()), status);
+        // Retry them with the next batch, newer writes of the same keys win. The sequence is not committed, so
+        //  writers of this batch wait for the next one.
+        for (auto& item : mCommittingWrites) {
+            mPendingWrites.emplace(item.first, std::move(item.second));
+        }
+        mCommittingWrites.clear();
+        return false;
+    }
+    LOG_DEBUG(sLogger, ("commit checkpoints, count", mCommittingWrites.size())("seq", seq));
+    mCommittingWrites.clear();
+    mCommittedSeq.store(seq, std::memory_order_release);
+    return true;
+}
+
+void CheckpointManagerV2::runCommitLoop() {
+    std::unique_lock<std::mutex> lock(mPendingMutex);
+    while (true) {
+        mPendingCond.wait(lock, [this]() { return mStopCommitThread || !mPendingWrites.empty(); });
+        // Collect writes until the durability window ends or the batch is large enough.
+        mPendingCond.wait_for(
+            lock, std::chrono::milliseconds(INT32_FLAG(logtail_checkpoint_group_commit_window_ms)), [this]() {
+                return mStopCommitThread
+                    || mPendingWrites.size()
+                    >= static_cast<size_t>(INT32_FLAG(logtail_checkpoint_group_commit_max_batch_size));
+            });
+        lock.unlock();
+        bool success = commitPendingWrites();
+        if (success && sCommitListener) {
+            sCommitListener();
+        }
+        lock.lock();
+        if (mStopCommitThread) {
+            if (!success) {
+                // The database is closed after this thread exits, these writes are lost as if the process crashed.
+                LOG_ERROR(sLogger, ("commit checkpoints before exit failed, count", mPendingWrites.size()));
+            }
+            break;
+        }
+        if (!success) {
+            mPendingCond.wait_for(
+                lock,
+                std::chrono::milliseconds(INT32_FLAG(logtail_checkpoint_group_commit_retry_interval_ms)),
+                [this]() { return mStopCommitThread; });
+        }
+    }
+    LOG_INFO(sLogger, ("runCommitLoop exit", "done"));
+}
+
 void CheckpointManagerV2::MarkGC(const std::string& primaryKey) {
     {
         std::lock_guard<std::mutex> lock(mMutex);
@@ -485,6 +624,8 @@ void CheckpointManagerV2::runGCLoop() {
     while (!mStopGCThread) {
         std::this_thread::sleep_for(std::chrono::seconds(INT32_FLAG(logtail_checkpoint_check_gc_interval_sec)));
 
+        // GC and scan read the database directly.
+        Flush();
         checkGCItems();
 
         std::vector<std::string> toDeleteCptKeys;
@@ -501,6 +642,11 @@ void CheckpointManagerV2::runGCLoop() {
 
 #ifdef APSARA_UNIT_TEST_MAIN
 void CheckpointManagerV2::rebuild() {
+    std::lock_guard<std::mutex> commitLock(mCommitMutex);
+    {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        mPendingWrites.clear();
+    }
     bool opened = close();
     leveldb::DestroyDB(detail::getDatabasePath(), leveldb::Options());
     if (opened) {
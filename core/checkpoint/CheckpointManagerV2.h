@@ -15,6 +15,9 @@
  */
 
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <thread>
@@ -45,6 +48,12 @@ namespace logtail {
 //  range checkpoints, that is why we call N concurrency.
 // - If order is import, the 1 primary checkpoint + N range checkpoints model downgrades
 //  to 1 primary + 1 range, ie. there is only one concurrency for the file.
+//
+// Writes are group committed: they are buffered and a dedicated thread commits all
+//  of them in one leveldb::WriteBatch after the durability window, so that writes
+//  from readers and senders share the cost of a (synchronous) database write.
+//  Reads see buffered writes. A write is persisted when the sequence returned by
+//  SetPB is committed, see IsCommitted.
 class CheckpointManagerV2 {
 public:
     static std::string MakeRangeKey(const std::string& primaryKey, uint32_t idx);
@@ -84,16 +93,29 @@ public:
         return value.ParseFromString(data);
     }
 
+    // @seq: if not null, set to the sequence of the batch which persists the value.
     template <class PBType>
-    bool SetPB(const std::string& key, const PBType& value) {
+    bool SetPB(const std::string& key, const PBType& value, uint64_t* seq = nullptr) {
         std::string data;
         if (!value.SerializeToString(&data)) {
             return false;
         }
 
-        return write(key, data);
+        return write(key, data, seq);
     }
 
+    // IsCommitted returns true if the batch of seq and all batches before it are
+    //  written to database.
+    bool IsCommitted(uint64_t seq) const { return seq <= mCommittedSeq.load(std::memory_order_acquire); }
+
+    // Flush commits buffered writes synchronously.
+    void Flush();
+
+    // SetCommitListener sets the listener called after each batch is committed, so
+    //  that items waiting for their checkpoints can be sent without polling.
+    //  It must be set before any write.
+    static void SetCommitListener(const std::function<void()>& listener) { sCommitListener = listener; }
+
     // Add primaryKey to GC list, called in destructor of LogFileReader.
     //
     // GetPB will remove primaryKey from GC list, so for config update case, primary
@@ -132,11 +154,19 @@ private:
     // Read/Write checkpoints by key.
     // @return true if succeed.
     bool read(const std::string& key, std::string& value);
-    bool write(const std::string& key, const std::string& value);
+    bool write(const std::string& key, const std::string& value, uint64_t* seq = nullptr);
 
     // Routine of GC thread.
     void runGCLoop();
 
+    // Routine of commit thread, which commits buffered writes every durability window.
+    void runCommitLoop();
+
+    // Commit buffered writes in one batch.
+    //
+    // @return true if succeed or nothing to commit.
+    bool commitPendingWrites();
+
     void checkGCItems();
 
     // Scan whole database according to mode.
@@ -176,6 +206,23 @@ private:
                        time_t /* create time */>
         mGCItems;
 
+    bool mEnableGroupCommit = false;
+    bool mStopCommitThread = false;
+    std::unique_ptr<std::thread> mCommitThreadPtr;
+    // Serializes batch commits, so that a finished Flush means all previous writes are in database.
+    std::mutex mCommitMutex;
+    // Protects mPendingWrites, mCommittingWrites and mPendingSeq.
+    std::mutex mPendingMutex;
+    std::condition_variable mPendingCond;
+    // Writes which will be committed by batch mPendingSeq.
+    std::unordered_map<std::string, std::string> mPendingWrites;
+    // Writes which are being committed, only modified under mPendingMutex.
+    std::unordered_map<std::string, std::string> mCommittingWrites;
+    uint64_t mPendingSeq = 1;
+    std::atomic<uint64_t> mCommittedSeq{0};
+
+    static std::function<void()> sCommitListener;
+
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class CheckpointManagerV2Unittest;
     friend class ExactlyOnceReaderUnittest;
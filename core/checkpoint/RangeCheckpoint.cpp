@@ -20,7 +20,12 @@ namespace logtail {
 void RangeCheckpoint::save() {
     static auto sCptM = CheckpointManagerV2::GetInstance();
     data.set_update_time(time(NULL));
-    sCptM->SetPB(key, data);
+    sCptM->SetPB(key, data, &commitSeq);
+}
+
+bool RangeCheckpoint::IsPersisted() const {
+    static auto sCptM = CheckpointManagerV2::GetInstance();
+    return sCptM->IsCommitted(commitSeq);
 }
 
 } // namespace logtail
\ No newline at end of file
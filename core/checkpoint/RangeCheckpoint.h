@@ -31,6 +31,8 @@ public:
     LogstoreFeedBackKey fbKey;
     RangeCheckpointPB data;
     std::vector<std::pair<uint64_t, size_t>> positions;
+    // Sequence of the checkpoint batch which persists the last save.
+    uint64_t commitSeq = 0;
 
     inline void Prepare() {
         positions.clear();
@@ -47,6 +49,8 @@ public:
 
     inline bool IsComplete() const { return data.has_hash_key(); }
 
+    bool IsPersisted() const;
+
 private:
     void save();
 };
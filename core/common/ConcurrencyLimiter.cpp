@@ -0,0 +1,86 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ConcurrencyLimiter.h"
+#include <algorithm>
+#include "common/Flags.h"
+
+DEFINE_FLAG_DOUBLE(concurrency_limiter_latency_tolerance,
+                   "decrease send concurrency when smoothed rtt exceeds min rtt by this ratio",
+                   2.0);
+DEFINE_FLAG_DOUBLE(concurrency_limiter_latency_backoff, "decrease ratio when latency grows", 0.9);
+DEFINE_FLAG_DOUBLE(concurrency_limiter_congestion_backoff, "decrease ratio on quota, network or server error", 0.5);
+DEFINE_FLAG_INT32(concurrency_limiter_min_rtt_window_sec,
+                  "min rtt is re-probed after this interval to follow route or backend changes",
+                  60);
+
+namespace logtail {
+
+ConcurrencyLimiter::ConcurrencyLimiter(uint32_t minLimit, uint32_t maxLimit, uint32_t initLimit)
+    : mMinLimit(std::max(minLimit, 1U)), mMaxLimit(std::max(maxLimit, mMinLimit)) {
+    mLimit = std::min(std::max(initLimit, mMinLimit), mMaxLimit);
+    mSlowStartThreshold = mMaxLimit;
+}
+
+void ConcurrencyLimiter::OnSuccess(uint64_t rttMs, uint64_t nowMs) {
+    OnRelease();
+    UpdateRtt(rttMs, nowMs);
+
+    if (mSmoothedRttMs > mMinRttMs * DOUBLE_FLAG(concurrency_limiter_latency_tolerance)) {
+        Decrease(DOUBLE_FLAG(concurrency_limiter_latency_backoff), nowMs);
+        mSlowStartThreshold = mLimit;
+        return;
+    }
+    if (mLimit < mSlowStartThreshold) {
+        mLimit += 1.0;
+    } else {
+        mLimit += 1.0 / mLimit;
+    }
+    mLimit = std::min(mLimit, (double)mMaxLimit);
+}
+
+void ConcurrencyLimiter::OnCongestion(uint64_t nowMs) {
+    Decrease(DOUBLE_FLAG(concurrency_limiter_congestion_backoff), nowMs);
+    mSlowStartThreshold = mLimit;
+}
+
+void ConcurrencyLimiter::OnRelease() {
+    if (mInFlight > 0) {
+        --mInFlight;
+    }
+}
+
+void ConcurrencyLimiter::UpdateRtt(uint64_t rttMs, uint64_t nowMs) {
+    // Avoid zero rtt, which makes every later sample look like queueing.
+    rttMs = std::max(rttMs, (uint64_t)1);
+    if (mMinRttMs == 0
+        || nowMs - mMinRttResetTime >= (uint64_t)INT32_FLAG(concurrency_limiter_min_rtt_window_sec) * 1000) {
+        mMinRttMs = rttMs;
+        mMinRttResetTime = nowMs;
+        mSmoothedRttMs = rttMs;
+        return;
+    }
+    mMinRttMs = std::min(mMinRttMs, rttMs);
+    mSmoothedRttMs += (rttMs - mSmoothedRttMs) / 8.0;
+}
+
+void ConcurrencyLimiter::Decrease(double factor, uint64_t nowMs) {
+    if (mLastDecreaseTime != 0 && nowMs - mLastDecreaseTime < (uint64_t)mSmoothedRttMs) {
+        return;
+    }
+    mLimit = std::max(mLimit * factor, (double)mMinLimit);
+    mLastDecreaseTime = nowMs;
+}
+
+} // namespace logtail
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstdint>
+
+namespace logtail {
+
+// ConcurrencyLimiter controls the number of in-flight send requests with AIMD plus a latency gradient:
+// - the limit grows by one per success during slow start, then by 1/limit per success (one per round trip);
+// - when the smoothed RTT exceeds min RTT * latency tolerance, the backend is queueing and the limit is
+//   decreased gently;
+// - on congestion (quota exceeded, network or server errors) the limit is cut by half.
+// Decreases happen at most once per smoothed RTT so that one failed window only counts once.
+//
+// Not thread safe, callers should protect it with their own lock. All time parameters are in milliseconds.
+class ConcurrencyLimiter {
+public:
+    ConcurrencyLimiter(uint32_t minLimit, uint32_t maxLimit, uint32_t initLimit);
+
+    bool IsValidToSend() const { return mInFlight < GetLimit(); }
+    // Number of new requests allowed to be sent now.
+    uint32_t GetQuota() const { return mInFlight < GetLimit() ? GetLimit() - mInFlight : 0; }
+
+    void OnSend() { ++mInFlight; }
+    // Request finished successfully with the given RTT.
+    void OnSuccess(uint64_t rttMs, uint64_t nowMs);
+    // Congestion signal, does not release the request because it may be retried.
+    void OnCongestion(uint64_t nowMs);
+    // Request finished without any signal about the backend.
+    void OnRelease();
+
+    uint32_t GetLimit() const { return static_cast<uint32_t>(mLimit); }
+    uint32_t GetInFlight() const { return mInFlight; }
+    uint64_t GetMinRtt() const { return mMinRttMs; }
+    uint64_t GetSmoothedRtt() const { return static_cast<uint64_t>(mSmoothedRttMs); }
+
+private:
+    void UpdateRtt(uint64_t rttMs, uint64_t nowMs);
+    void Decrease(double factor, uint64_t nowMs);
+
+    uint32_t mMinLimit;
+    uint32_t mMaxLimit;
+    double mLimit;
+    double mSlowStartThreshold;
+    uint32_t mInFlight = 0;
+
+    uint64_t mMinRttMs = 0;
+    uint64_t mMinRttResetTime = 0;
+    double mSmoothedRttMs = 0.0;
+    uint64_t mLastDecreaseTime = 0;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class ConcurrencyLimiterUnittest;
+#endif
+};
+
+} // namespace logtail
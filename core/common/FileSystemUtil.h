@@ -254,6 +254,9 @@ namespace fsutil {
         int GetMode() const {
             return static_cast<int>(mRawStat.st_mode);
         }
+
+        // GetLinkCount returns st_nlink.
+        uint64_t GetLinkCount() const { return static_cast<uint64_t>(mRawStat.st_nlink); }
     };
 
 } // namespace fsutil
@@ -25,9 +25,18 @@
 #include "QueueManager.h"
 
 #define MAX_CONFIG_PRIORITY_LEVEL (3)
+#define MAX_SCHEDULING_WEIGHT (100)
 
 namespace logtail {
 
+// QueueItemCost is the cost of an item for deficit round robin, each queue earns Quantum() * weight per round.
+// By default every item costs one, which makes the scheduling weighted round robin by item count.
+template <class T>
+struct QueueItemCost {
+    static size_t Get(const T& item) { return 1; }
+    static size_t Quantum() { return 1; }
+};
+
 class LogstoreFeedBackInterface {
 public:
     LogstoreFeedBackInterface() {}
@@ -153,8 +162,17 @@ public:
 
     size_t GetSize() const { return mSize; }
 
+    // Front returns the item to be popped next, the queue must not be empty.
+    const TT& Front() const { return mArray[mRead % SIZE]; }
+
     QueueType GetQueueType() const { return mType; }
 
+    void SetWeight(uint32_t weight) { mWeight = weight > 0 ? weight : 1; }
+    uint32_t GetWeight() const { return mWeight; }
+
+    // deficit of deficit round robin, reset when the queue is drained
+    int64_t mDeficit = 0;
+
 protected:
     size_t LOW_SIZE;
     size_t HIGH_SIZE;
@@ -166,6 +184,7 @@ protected:
     volatile uint64_t mRead;
     volatile size_t mSize;
     volatile QueueType mType;
+    uint32_t mWeight = 1;
 
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class QueueManagerUnittest;
@@ -391,43 +410,42 @@ public:
                 }
             }
 
-            // Iterate queues, startKey is used for fairness.
+            // Iterate queues with deficit round robin, startKey is the queue whose turn it is. It keeps popping
+            // until its deficit can not afford the next item, then every following queue earns its quantum.
             LogstoreFeedBackQueueMapIterator startKeyIter = mLogstoreQueueMap.find(startKey);
-            if (startKeyIter == mLogstoreQueueMap.end()) {
-                startKeyIter = mLogstoreQueueMap.begin();
-            } else {
+            if (startKeyIter != mLogstoreQueueMap.end()) {
+                rst = PopItemByDeficit(threadNo, threadNum, pCheckObj, startKeyIter, item, false);
+                if (rst != 0) {
+                    break;
+                }
                 ++startKeyIter;
+            } else {
+                startKeyIter = mLogstoreQueueMap.begin();
             }
 
-            // Range: the key of last poped item -> end.
-            for (auto iter = startKeyIter; iter != mLogstoreQueueMap.end(); ++iter) {
-                if (!CanPopItem(threadNo, threadNum, pCheckObj, iter->first, iter->second)) {
-                    continue;
+            // Keep going round until some queue earns enough for its next item or no queue can be popped.
+            bool poppable = true;
+            while (rst == 0 && poppable) {
+                poppable = false;
+                // Range: the key of last poped item -> end.
+                for (auto iter = startKeyIter; iter != mLogstoreQueueMap.end(); ++iter) {
+                    rst = PopItemByDeficit(threadNo, threadNum, pCheckObj, iter, item, true, &poppable);
+                    if (rst != 0) {
+                        startKey = iter->first;
+                        break;
+                    }
                 }
-
-                rst = iter->second.PopItem(item);
-                if (rst == 0) {
-                    continue;
+                if (rst != 0) {
+                    break;
                 }
-                startKey = iter->first;
-                break;
-            }
-            if (rst != 0) {
-                break;
-            }
-
-            // Range: begin -> the key of last poped item.
-            for (auto iter = mLogstoreQueueMap.begin(); iter != startKeyIter; ++iter) {
-                if (!CanPopItem(threadNo, threadNum, pCheckObj, iter->first, iter->second)) {
-                    continue;
-                }
-
-                rst = iter->second.PopItem(item);
-                if (rst == 0) {
-                    continue;
+                // Range: begin -> the key of last poped item.
+                for (auto iter = mLogstoreQueueMap.begin(); iter != startKeyIter; ++iter) {
+                    rst = PopItemByDeficit(threadNo, threadNum, pCheckObj, iter, item, true, &poppable);
+                    if (rst != 0) {
+                        startKey = iter->first;
+                        break;
+                    }
                 }
-                startKey = iter->first;
-                break;
             }
         } while (false);
 
@@ -528,6 +546,8 @@ public:
         mLogstoreQueueMap[key].SetType(QueueType::ExactlyOnce);
     }
 
+    void SetWeightNoLock(const LogstoreFeedBackKey& key, uint32_t weight) { mLogstoreQueueMap[key].SetWeight(weight); }
+
 protected:
     PTMutex mLock;
     TriggerEvent mTrigger;
@@ -536,6 +556,38 @@ protected:
     LogstoreFeedBackQueueVector mPriorityQueueArray[MAX_CONFIG_PRIORITY_LEVEL];
 
 private:
+    // PopItemByDeficit pops the front item of iter if its deficit affords it, newTurn means the queue earns its
+    // quantum first. poppable is set if the queue has items and is allowed to be popped.
+    int PopItemByDeficit(int32_t threadNo,
+                         int32_t threadNum,
+                         LogstoreFeedBackInterface* checkObj,
+                         LogstoreFeedBackQueueMapIterator iter,
+                         T& item,
+                         bool newTurn,
+                         bool* poppable = NULL) {
+        SingleLogStoreQueue& queue = iter->second;
+        if (!CanPopItem(threadNo, threadNum, checkObj, iter->first, queue)) {
+            return 0;
+        }
+        if (queue.IsEmpty()) {
+            queue.mDeficit = 0;
+            return 0;
+        }
+        if (poppable != NULL) {
+            *poppable = true;
+        }
+        if (newTurn) {
+            queue.mDeficit += QueueItemCost<T>::Quantum() * queue.GetWeight();
+        }
+        int64_t cost = QueueItemCost<T>::Get(queue.Front());
+        if (cost > queue.mDeficit) {
+            return 0;
+        }
+        int rst = queue.PopItem(item);
+        queue.mDeficit = queue.IsEmpty() ? 0 : queue.mDeficit - cost;
+        return rst;
+    }
+
     bool CanPopItem(int32_t threadNo,
                     int32_t threadNum,
                     LogstoreFeedBackInterface* checkObj,
@@ -15,6 +15,7 @@
 #include "LogstoreSenderQueue.h"
 #include "common/Flags.h"
 #include "common/StringTools.h"
+#include "common/TimeUtil.h"
 #include "monitor/LogtailAlarm.h"
 
 
@@ -36,6 +37,13 @@ DEFINE_FLAG_INT32(client_send_concurrency_trigger,
 DEFINE_FLAG_INT32(client_send_concurrency_max, "max concurrency of one client", 512);
 DEFINE_FLAG_INT32(client_send_concurrency_max_update_time, "max update time seconds", 300);
 DEFINE_FLAG_DOUBLE(client_quota_send_retry_interval_scale, "", 2.0);
+DEFINE_FLAG_BOOL(enable_adaptive_send_concurrency,
+                 "adjust in-flight requests per logstore and region by observed rtt and errors",
+                 false);
+DEFINE_FLAG_INT32(client_send_concurrency_init, "initial concurrency of one client with adaptive concurrency", 16);
+DEFINE_FLAG_INT32(sender_queue_drr_quantum_bytes,
+                  "bytes a logstore earns per round when dispatching send requests, weighted by SchedulingWeight",
+                  256 * 1024);
 
 namespace logtail {
 
@@ -48,7 +56,10 @@ LogstoreSenderInfo::LogstoreSenderInfo()
       mQuotaRetryInterval((double)INT32_FLAG(client_quota_send_retry_interval)),
       mNetworkValidFlag(true),
       mQuotaValidFlag(true),
-      mSendConcurrency(INT32_FLAG(client_send_concurrency_max)) {
+      mSendConcurrency(INT32_FLAG(client_send_concurrency_max)),
+      mConcurrencyLimiter(INT32_FLAG(client_quota_send_concurrency_min),
+                          INT32_FLAG(client_send_concurrency_max),
+                          INT32_FLAG(client_send_concurrency_init)) {
     mSendConcurrencyUpdateTime = time(NULL);
 }
 
@@ -92,7 +103,34 @@ bool LogstoreSenderInfo::CanSend(int32_t curTime) {
     return true;
 }
 
-bool LogstoreSenderInfo::RecordSendResult(SendResult rst, LogstoreSenderStatistics& statisticsItem) {
+bool LogstoreSenderInfo::RecordSendResult(SendResult rst,
+                                          LogstoreSenderStatistics& statisticsItem,
+                                          uint64_t sendTimeInMs) {
+    if (BOOL_FLAG(enable_adaptive_send_concurrency)) {
+        uint64_t nowMs = GetCurrentTimeInMilliSeconds();
+        switch (rst) {
+            case LogstoreSenderInfo::SendResult_OK:
+                // the rtt is unknown if the request was not sent by the sender threads, e.g. in debug mode
+                if (sendTimeInMs > 0) {
+                    mConcurrencyLimiter.OnSuccess(nowMs > sendTimeInMs ? nowMs - sendTimeInMs : 0, nowMs);
+                } else {
+                    mConcurrencyLimiter.OnRelease();
+                }
+                break;
+            case LogstoreSenderInfo::SendResult_NetworkFail:
+            case LogstoreSenderInfo::SendResult_QuotaFail:
+                mConcurrencyLimiter.OnCongestion(nowMs);
+                mConcurrencyLimiter.OnRelease();
+                break;
+            default:
+                mConcurrencyLimiter.OnRelease();
+                break;
+        }
+    }
+    return UpdateSendState(rst, statisticsItem);
+}
+
+bool LogstoreSenderInfo::UpdateSendState(SendResult rst, LogstoreSenderStatistics& statisticsItem) {
     switch (rst) {
         case LogstoreSenderInfo::SendResult_OK:
             ++statisticsItem.mSendSuccessCount;
@@ -108,6 +146,9 @@ bool LogstoreSenderInfo::RecordSendResult(SendResult rst, LogstoreSenderStatisti
             } else {
                 mSendConcurrencyUpdateTime = time(NULL);
             }
+            if (BOOL_FLAG(enable_adaptive_send_concurrency)) {
+                return mConcurrencyLimiter.IsValidToSend();
+            }
             // return true only if concurrency < client_send_concurrency_trigger
             return mSendConcurrency < INT32_FLAG(client_send_concurrency_trigger);
             break;
@@ -172,7 +213,8 @@ bool LogstoreSenderInfo::OnRegionRecover(const std::string& region) {
     if (region == mRegion) {
         bool rst = !(mNetworkValidFlag && mQuotaValidFlag);
         LogstoreSenderStatistics senderStatistics;
-        RecordSendResult(LogstoreSenderInfo::SendResult_OK, senderStatistics);
+        // no request is finished, so the concurrency limiter is left untouched
+        UpdateSendState(LogstoreSenderInfo::SendResult_OK, senderStatistics);
         LOG_DEBUG(sLogger, ("On region recover  ", this->mRegion));
         return rst;
     }
@@ -188,6 +230,9 @@ void LogstoreSenderInfo::SetRegion(const std::string& region) {
 }
 
 bool LogstoreSenderInfo::ConcurrencyValid() {
+    if (BOOL_FLAG(enable_adaptive_send_concurrency)) {
+        return mConcurrencyLimiter.IsValidToSend();
+    }
     if (mSendConcurrency <= 0) {
         // check consurrency update time
         int32_t nowTime = time(NULL);
@@ -199,6 +244,14 @@ bool LogstoreSenderInfo::ConcurrencyValid() {
     return mSendConcurrency > 0;
 }
 
+void LogstoreSenderInfo::ConcurrencyDec() {
+    if (BOOL_FLAG(enable_adaptive_send_concurrency)) {
+        mConcurrencyLimiter.OnSend();
+        return;
+    }
+    --mSendConcurrency;
+}
+
 LogstoreSenderStatistics::LogstoreSenderStatistics() {
     Reset();
 }
@@ -212,6 +265,8 @@ void LogstoreSenderStatistics::Reset() {
     mSendQuotaErrorCount = 0;
     mSendDiscardErrorCount = 0;
     mSendSuccessCount = 0;
+    mSendConcurrencyLimit = 0;
+    mSendInFlightCount = 0;
     mSendBlockFlag = false;
     mValidToSendFlag = false;
 }
@@ -17,12 +17,20 @@
 #pragma once
 #include <unordered_map>
 #include <string>
+#include <algorithm>
 #include <deque>
 #include <stdio.h>
 #include "logger/Logger.h"
 #include "LogGroupContext.h"
 #include "Lock.h"
 #include "LogstoreFeedbackQueue.h"
+#include "ConcurrencyLimiter.h"
+#include "MemoryBudget.h"
+#include "common/Flags.h"
+#include "monitor/LogtailMetric.h"
+#include "monitor/MetricConstants.h"
+
+DECLARE_FLAG_INT32(sender_queue_drr_quantum_bytes);
 
 namespace logtail {
 
@@ -42,6 +50,8 @@ struct LogstoreSenderStatistics {
     uint32_t mSendQuotaErrorCount;
     uint32_t mSendDiscardErrorCount;
     uint32_t mSendSuccessCount;
+    uint32_t mSendConcurrencyLimit;
+    uint32_t mSendInFlightCount;
     bool mSendBlockFlag;
     bool mValidToSendFlag;
 };
@@ -63,6 +73,7 @@ struct LoggroupTimeValue {
 
     int32_t mSendRetryTimes;
     int32_t mLastSendTime;
+    uint64_t mLastSendTimeInMs;
     int32_t mLastLogWarningTime;
     std::string mAliuid;
     std::string mRegion;
@@ -75,6 +86,8 @@ struct LoggroupTimeValue {
     // each succeeded sending log group only contains logs in the same minute
     int32_t mLogTimeInMinute;
     LogGroupContext mLogGroupContext;
+    // bytes of mLogData charged to MemoryBudget
+    int64_t mChargedBytes = 0;
 
     LoggroupTimeValue(const std::string& projectName,
                       const std::string& logstore,
@@ -103,6 +116,7 @@ struct LoggroupTimeValue {
         mEnqueueTime = lastUpdateTime;
         mSendRetryTimes = 0;
         mLastSendTime = 0;
+        mLastSendTimeInMs = 0;
         mLastLogWarningTime = 0;
         mLogData.clear();
         mShardHashKey = shardHashKey;
@@ -113,6 +127,19 @@ struct LoggroupTimeValue {
         mLogGroupContext = context;
     }
 
+    LoggroupTimeValue(const LoggroupTimeValue&) = delete;
+    LoggroupTimeValue& operator=(const LoggroupTimeValue&) = delete;
+
+    ~LoggroupTimeValue() { MemoryBudget::GetInstance()->Release(mChargedBytes); }
+
+    // Charges mLogData to the memory budget when the item is queued, it may be recompressed or merged before
+    // being queued again, so only the difference is charged.
+    void ChargeMemoryBudget() {
+        int64_t size = static_cast<int64_t>(mLogData.size());
+        MemoryBudget::GetInstance()->Charge(size - mChargedBytes);
+        mChargedBytes = size;
+    }
+
 #ifdef APSARA_UNIT_TEST_MAIN
     LoggroupTimeValue() {
     }
@@ -140,20 +167,27 @@ struct LogstoreSenderInfo {
     volatile bool mQuotaValidFlag;
     volatile int32_t mSendConcurrency;
     volatile int32_t mSendConcurrencyUpdateTime;
+    // Used instead of mSendConcurrency when enable_adaptive_send_concurrency is set.
+    ConcurrencyLimiter mConcurrencyLimiter;
 
     LogstoreSenderInfo();
 
     void SetRegion(const std::string& region);
 
     bool ConcurrencyValid();
-    void ConcurrencyDec() { --mSendConcurrency; }
+    void ConcurrencyDec();
 
     bool CanSend(int32_t curTime);
     // RecordSendResult
+    // @param sendTimeInMs when the finished request was sent, 0 if unknown.
     // @return true if need to trigger.
-    bool RecordSendResult(SendResult rst, LogstoreSenderStatistics& statisticsItem);
+    bool RecordSendResult(SendResult rst, LogstoreSenderStatistics& statisticsItem, uint64_t sendTimeInMs = 0);
     // return value, recover sucess flag(if logstore is invalid before, return true, else return false)
     bool OnRegionRecover(const std::string& region);
+
+private:
+    // UpdateSendState updates the flags and the legacy concurrency, @return true if need to trigger.
+    bool UpdateSendState(SendResult rst, LogstoreSenderStatistics& statisticsItem);
 };
 
 template <class PARAM>
@@ -179,19 +213,23 @@ public:
             if (item == NULL) {
                 continue;
             }
-            if (item->mStatus == LoggroupSendStatus_Idle) {
+            if (item->mStatus == LoggroupSendStatus_Idle && isCheckpointPersisted(item)) {
                 item->mStatus = LoggroupSendStatus_Sending;
                 logGroupVec.push_back(item);
             }
         }
     }
 
-    void GetAllIdleLoggroupWithLimit(std::vector<LoggroupTimeValue*>& logGroupVec,
-                                     int32_t nowTime,
-                                     std::unordered_map<std::string, int>& regionConcurrencyLimits) {
+    // GetIdleLoggroupByDeficit is one round of deficit round robin: the queue earns its quantum in bytes and pops
+    // idle items as long as the deficit, flow control and concurrency allow.
+    // @return true if idle items are left only because the deficit can not afford them yet.
+    bool GetIdleLoggroupByDeficit(std::vector<LoggroupTimeValue*>& logGroupVec,
+                                  int32_t nowTime,
+                                  std::unordered_map<std::string, int>& regionConcurrencyLimits) {
         bool expireFlag = (mFlowControlExpireTime > 0 && nowTime > mFlowControlExpireTime);
         if (this->mSize == 0 || (!expireFlag && mMaxSendBytesPerSecond == 0)) {
-            return;
+            this->mDeficit = 0;
+            return false;
         }
         if (!expireFlag && mMaxSendBytesPerSecond > 0 && nowTime != mLastSendTimeSecond) {
             mLastSecondTotalBytes = 0;
@@ -203,9 +241,11 @@ public:
         if (iter != regionConcurrencyLimits.end())
             regionConcurrency = iter->second;
         if (0 == regionConcurrency) {
-            return;
+            return false;
         }
 
+        this->mDeficit += (int64_t)std::max(INT32_FLAG(sender_queue_drr_quantum_bytes), 1) * this->GetWeight();
+        bool deficitBlocked = false;
         uint64_t index = QueueType::ExactlyOnce == this->mType ? 0 : this->mRead;
         const uint64_t endIndex = QueueType::ExactlyOnce == this->mType ? this->SIZE : this->mWrite;
         for (; index < endIndex; ++index) {
@@ -213,14 +253,19 @@ public:
             if (item == NULL) {
                 continue;
             }
-            if (item->mStatus == LoggroupSendStatus_Idle) {
+            if (item->mStatus == LoggroupSendStatus_Idle && isCheckpointPersisted(item)) {
                 // check consurrency
                 // check first, when mMaxSendBytesPerSecond is 1000, and the packet size is 10K, we should send this
                 // packet. if not, this logstore will block
                 if ((!mSenderInfo.ConcurrencyValid())
                     || (!expireFlag && mMaxSendBytesPerSecond > 0 && mLastSecondTotalBytes > mMaxSendBytesPerSecond)) {
-                    return;
+                    break;
+                }
+                if (item->mRawSize > this->mDeficit) {
+                    deficitBlocked = true;
+                    break;
                 }
+                this->mDeficit -= item->mRawSize;
                 mSenderInfo.ConcurrencyDec();
                 mLastSecondTotalBytes += item->mRawSize;
                 item->mStatus = LoggroupSendStatus_Sending;
@@ -235,6 +280,18 @@ public:
         if (iter != regionConcurrencyLimits.end()) {
             iter->second = regionConcurrency;
         }
+        // Queues which are not waiting for deficit do not keep credits, as in deficit round robin.
+        if (!deficitBlocked) {
+            this->mDeficit = 0;
+        }
+        return deficitBlocked;
+    }
+
+    // Exactly once data can only be sent after its prepared checkpoint is persisted, otherwise it might be sent
+    // again with another sequence ID after restart.
+    static bool isCheckpointPersisted(const LoggroupTimeValue* item) {
+        auto& eo = item->mLogGroupContext.mExactlyOnceCheckpoint;
+        return !eo || eo->IsPersisted();
     }
 
     bool insertExactlyOnceItem(LoggroupTimeValue* item) {
@@ -290,6 +347,10 @@ public:
     // with empty item
     bool InsertItem(LoggroupTimeValue* item) {
         mSenderInfo.SetRegion(item->mRegion);
+        item->ChargeMemoryBudget();
+        if (!mSendSuccessTotal) {
+            InitMetrics(*item);
+        }
         if (QueueType::ExactlyOnce == this->mType) {
             return insertExactlyOnceItem(item);
         }
@@ -389,6 +450,8 @@ public:
 
         statisticsItem.mSendBlockFlag = !this->IsValid();
         statisticsItem.mValidToSendFlag = IsValidToSend(time(NULL));
+        statisticsItem.mSendConcurrencyLimit = mSenderInfo.mConcurrencyLimiter.GetLimit();
+        statisticsItem.mSendInFlightCount = mSenderInfo.mConcurrencyLimiter.GetInFlight();
         if (this->IsEmpty()) {
             return statisticsItem;
         }
@@ -418,7 +481,7 @@ public:
     }
 
     int32_t OnSendDone(LoggroupTimeValue* item, LogstoreSenderInfo::SendResult sendRst, bool& needTrigger) {
-        needTrigger = mSenderInfo.RecordSendResult(sendRst, mSenderStatistics);
+        needTrigger = mSenderInfo.RecordSendResult(sendRst, mSenderStatistics, item->mLastSendTimeInMs);
         if (!mSenderInfo.mNetworkValidFlag) {
             LOG_WARNING(sLogger,
                         ("Network fail, pause logstore", item->mLogstore)("project", item->mProjectName)(
@@ -439,6 +502,14 @@ public:
         if (mSenderStatistics.mMaxSendSuccessTime < item->mEnqueueTime) {
             mSenderStatistics.mMaxSendSuccessTime = item->mEnqueueTime;
         }
+        if (sendRst == LogstoreSenderInfo::SendResult_OK && mSendSuccessTotal) {
+            mSendSuccessTotal->Add(1);
+            mSendSuccessSizeBytes->Add(item->mRawSize);
+            int32_t curTime = time(NULL);
+            uint64_t latencyMs = curTime > item->mEnqueueTime ? (uint64_t)(curTime - item->mEnqueueTime) * 1000 : 0;
+            mSendLatencyMs->Add(latencyMs);
+            mSendLatencyHistogramMs->Observe(latencyMs);
+        }
         // else remove item except buffered
         return RemoveItem(item, sendRst != LogstoreSenderInfo::SendResult_Buffered);
     }
@@ -459,6 +530,27 @@ public:
 
     std::vector<RangeCheckpointPtr> mRangeCheckpoints;
     std::deque<LoggroupTimeValue*> mExtraBuffers;
+
+private:
+    // per logstore metrics, labels are taken from the first item
+    void InitMetrics(const LoggroupTimeValue& item) {
+        MetricLabels labels;
+        labels.emplace_back(std::make_pair("project", item.mProjectName));
+        labels.emplace_back(std::make_pair("logstore", item.mLogstore));
+        labels.emplace_back(std::make_pair("region", item.mRegion));
+        labels.emplace_back(std::make_pair("config_name", item.mConfigName));
+        WriteMetrics::GetInstance()->PrepareMetricsRecordRef(mMetricsRecordRef, std::move(labels));
+        mSendSuccessTotal = mMetricsRecordRef.CreateCounter(METRIC_SEND_QUEUE_SUCCESS_TOTAL);
+        mSendSuccessSizeBytes = mMetricsRecordRef.CreateCounter(METRIC_SEND_QUEUE_SUCCESS_SIZE_BYTES);
+        mSendLatencyMs = mMetricsRecordRef.CreateCounter(METRIC_SEND_QUEUE_LATENCY_MS);
+        mSendLatencyHistogramMs = mMetricsRecordRef.CreateHistogram(METRIC_SEND_QUEUE_LATENCY_HISTOGRAM_MS);
+    }
+
+    MetricsRecordRef mMetricsRecordRef;
+    CounterPtr mSendSuccessTotal;
+    CounterPtr mSendSuccessSizeBytes;
+    CounterPtr mSendLatencyMs;
+    HistogramPtr mSendLatencyHistogramMs;
 };
 
 template <class PARAM>
@@ -509,6 +601,11 @@ public:
         singleQueue.SetMaxSendBytesPerSecond(maxBytes, expireTime);
     }
 
+    void SetLogstoreWeight(const LogstoreFeedBackKey& key, uint32_t weight) {
+        PTScopedLock dataLock(mLock);
+        mLogstoreSenderQueueMap[key].SetWeight(weight);
+    }
+
     void ConvertToExactlyOnceQueue(const LogstoreFeedBackKey& key, const std::vector<RangeCheckpointPtr>& checkpoints) {
         PTScopedLock dataLock(mLock);
         auto& queue = mLogstoreSenderQueueMap[key];
@@ -553,10 +650,26 @@ public:
         LogstoreFeedBackQueueMapIterator beginIter = mLogstoreSenderQueueMap.begin();
         std::advance(beginIter, mSenderQueueBeginIndex++);
 
-        PopItem(
-            beginIter, mLogstoreSenderQueueMap.end(), itemVec, curTime, regionConcurrencyLimits, singleQueueFullFlag);
-        PopItem(
-            mLogstoreSenderQueueMap.begin(), beginIter, itemVec, curTime, regionConcurrencyLimits, singleQueueFullFlag);
+        // Deficit round robin, so that one logstore can not use up the region concurrency. Rounds go on until no
+        // logstore is left waiting only for deficit.
+        bool deficitBlocked = true;
+        while (deficitBlocked) {
+            deficitBlocked = false;
+            PopItem(beginIter,
+                    mLogstoreSenderQueueMap.end(),
+                    itemVec,
+                    curTime,
+                    regionConcurrencyLimits,
+                    singleQueueFullFlag,
+                    deficitBlocked);
+            PopItem(mLogstoreSenderQueueMap.begin(),
+                    beginIter,
+                    itemVec,
+                    curTime,
+                    regionConcurrencyLimits,
+                    singleQueueFullFlag,
+                    deficitBlocked);
+        }
     }
 
     static void PopItem(LogstoreFeedBackQueueMapIterator beginIter,
@@ -564,13 +677,14 @@ public:
                         std::vector<LoggroupTimeValue*>& itemVec,
                         int32_t curTime,
                         std::unordered_map<std::string, int>& regionConcurrencyLimits,
-                        bool& singleQueueFullFlag) {
+                        bool& singleQueueFullFlag,
+                        bool& deficitBlocked) {
         for (LogstoreFeedBackQueueMapIterator iter = beginIter; iter != endIter; ++iter) {
             SingleLogStoreManager& singleQueue = iter->second;
             if (!singleQueue.IsValidToSend(curTime)) {
                 continue;
             }
-            singleQueue.GetAllIdleLoggroupWithLimit(itemVec, curTime, regionConcurrencyLimits);
+            deficitBlocked |= singleQueue.GetIdleLoggroupByDeficit(itemVec, curTime, regionConcurrencyLimits);
             singleQueueFullFlag |= !singleQueue.IsValid();
         }
     }
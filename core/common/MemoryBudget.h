@@ -0,0 +1,58 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace logtail {
+
+// MemoryBudget accounts the bytes held by buffered data across the pipeline: read buffers (SourceBuffer) waiting
+// in the process queue and serialized log groups (LoggroupTimeValue) waiting in the sender queue. Readers stop
+// reading when the budget is used up, so that a send outage fills the budget and stops there instead of growing
+// until the memory limit restarts the agent.
+//
+// Header only since SourceBuffer is used by modules which do not link common.
+class MemoryBudget {
+public:
+    static MemoryBudget* GetInstance() {
+        static MemoryBudget sInstance;
+        return &sInstance;
+    }
+
+    void Charge(int64_t bytes) { mUsedBytes.fetch_add(bytes, std::memory_order_relaxed); }
+    void Release(int64_t bytes) { mUsedBytes.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    // 0 means unlimited.
+    void SetLimitBytes(int64_t bytes) { mLimitBytes.store(bytes, std::memory_order_relaxed); }
+    int64_t GetLimitBytes() const { return mLimitBytes.load(std::memory_order_relaxed); }
+    int64_t GetUsedBytes() const { return mUsedBytes.load(std::memory_order_relaxed); }
+
+    bool IsExceeded() const {
+        int64_t limit = GetLimitBytes();
+        return limit > 0 && GetUsedBytes() >= limit;
+    }
+
+private:
+    MemoryBudget() = default;
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    std::atomic<int64_t> mUsedBytes{0};
+    std::atomic<int64_t> mLimitBytes{0};
+};
+
+} // namespace logtail
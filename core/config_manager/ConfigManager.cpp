@@ -94,6 +94,9 @@ using namespace std;
 DEFINE_FLAG_INT32(wildcard_max_sub_dir_count, "", 1000);
 DEFINE_FLAG_INT32(config_match_max_cache_size, "", 1000000);
 DEFINE_FLAG_INT32(multi_config_alarm_interval, "second", 600);
+DEFINE_FLAG_BOOL(enable_config_match_index,
+                 "only check configs whose base path is an ancestor of the path when matching configs",
+                 true);
 
 DEFINE_FLAG_STRING(ilogtail_docker_path_version, "ilogtail docker path config file", "0.1.0");
 DEFINE_FLAG_INT32(max_docker_config_update_times, "max times docker config update in 3 minutes", 10);
@@ -525,24 +528,47 @@ bool ConfigManager::RegisterDescendants(const string& path, const FileDiscoveryC
     return result;
 }
 
+// The caches are bounded by config_match_max_cache_size and invalidated on config and container path updates, the
+// periodic clear is only a safety net.
 void ConfigManager::ClearConfigMatchCache() {
     static const int32_t FORCE_CLEAR_INTERVAL = 6 * 3600;
     static int32_t s_lastClearTime = (int32_t)time(NULL) - rand() % 600;
     static int32_t s_lastClearAllTime = (int32_t)time(NULL) - rand() % 600;
     int32_t curTime = (int32_t)time(NULL);
 
-    ScopedSpinLock cachedLock(mCacheFileConfigMapLock);
-    if (curTime - s_lastClearTime > FORCE_CLEAR_INTERVAL
-        || mCacheFileConfigMap.size() > (size_t)INT32_FLAG(config_match_max_cache_size)) {
+    if (curTime - s_lastClearTime > FORCE_CLEAR_INTERVAL) {
         s_lastClearTime = curTime;
-        mCacheFileConfigMap.clear();
+        mCacheFileConfigMap.Clear();
+        ++mFileMatchEpoch;
     }
-
-    ScopedSpinLock allCachedLock(mCacheFileAllConfigMapLock);
-    if (curTime - s_lastClearAllTime > FORCE_CLEAR_INTERVAL
-        || mCacheFileAllConfigMap.size() > (size_t)INT32_FLAG(config_match_max_cache_size)) {
+    if (curTime - s_lastClearAllTime > FORCE_CLEAR_INTERVAL) {
         s_lastClearAllTime = curTime;
-        mCacheFileAllConfigMap.clear();
+        mCacheFileAllConfigMap.Clear();
+    }
+}
+
+static ConfigMatchCache<FileDiscoveryConfig>::Dependencies
+GetMatchDependencies(const vector<FileDiscoveryConfig>& configs) {
+    const FileDiscoveryIndex& index = FileServer::GetInstance()->GetFileDiscoveryIndex();
+    ConfigMatchCache<FileDiscoveryConfig>::Dependencies dependencies;
+    dependencies.reserve(configs.size());
+    for (const auto& config : configs) {
+        if (config.first != nullptr) {
+            dependencies.emplace_back(config.first, index.GetGeneration(config.first));
+        }
+    }
+    return dependencies;
+}
+
+void ConfigManager::GetMatchCandidates(const string& path, vector<FileDiscoveryConfig>& candidates) {
+    if (BOOL_FLAG(enable_config_match_index)) {
+        FileServer::GetInstance()->GetFileDiscoveryIndex().FindCandidates(path, candidates);
+        return;
+    }
+    const auto& nameConfigMap = FileServer::GetInstance()->GetAllFileDiscoveryConfigs();
+    candidates.reserve(nameConfigMap.size());
+    for (const auto& item : nameConfigMap) {
+        candidates.push_back(item.second);
     }
 }
 
@@ -552,26 +578,26 @@ FileDiscoveryConfig ConfigManager::FindBestMatch(const string& path, const strin
     cachedFileKey.append(name);
     bool acceptMultiConfig = AppConfig::GetInstance()->IsAcceptMultiConfig();
     {
-        ScopedSpinLock cachedLock(mCacheFileConfigMapLock);
-        auto iter = mCacheFileConfigMap.find(cachedFileKey);
-        if (iter != mCacheFileConfigMap.end()) {
+        FileDiscoveryConfig cachedMatch(nullptr, nullptr);
+        int32_t alarmTime = 0;
+        if (mCacheFileConfigMap.Get(
+                cachedFileKey, FileServer::GetInstance()->GetFileDiscoveryIndex(), cachedMatch, alarmTime)) {
             // if need report alarm, do not return, just continue to find all match and send alarm
-            if (acceptMultiConfig || iter->second.second == 0
-                || time(NULL) - iter->second.second < INT32_FLAG(multi_config_alarm_interval)) {
-                return iter->second.first;
+            if (acceptMultiConfig || alarmTime == 0 || time(NULL) - alarmTime < INT32_FLAG(multi_config_alarm_interval)) {
+                return cachedMatch;
             }
         }
     }
-    const auto& nameConfigMap = FileServer::GetInstance()->GetAllFileDiscoveryConfigs();
-    auto itr = nameConfigMap.begin();
+    vector<FileDiscoveryConfig> candidates;
+    GetMatchCandidates(path, candidates);
     FileDiscoveryConfig prevMatch(nullptr, nullptr);
     size_t prevLen = 0;
     size_t curLen = 0;
     uint32_t nameRepeat = 0;
     string logNameList;
     vector<FileDiscoveryConfig> multiConfigs;
-    for (; itr != nameConfigMap.end(); ++itr) {
-        const FileDiscoveryOptions* config = itr->second.first;
+    for (auto itr = candidates.begin(); itr != candidates.end(); ++itr) {
+        const FileDiscoveryOptions* config = itr->first;
         // // exclude __FUSE_CONFIG__
         // if (itr->first == STRING_FLAG(fuse_customized_config_name)) {
         //     continue;
@@ -583,21 +609,21 @@ FileDiscoveryConfig ConfigManager::FindBestMatch(const string& path, const strin
             if (!name.empty() && !config->mAllowingIncludedByMultiConfigs) {
                 nameRepeat++;
                 logNameList.append("logstore:");
-                logNameList.append(itr->second.second->GetLogstoreName());
+                logNameList.append(itr->second->GetLogstoreName());
                 logNameList.append(",config:");
-                logNameList.append(itr->second.second->GetConfigName());
+                logNameList.append(itr->second->GetConfigName());
                 logNameList.append(" ");
-                multiConfigs.push_back(itr->second);
+                multiConfigs.push_back(*itr);
             }
 
             // note: best config is the one which length is longest and create time is nearest
             curLen = config->GetBasePath().size();
             if (prevLen < curLen) {
-                prevMatch = itr->second;
+                prevMatch = *itr;
                 prevLen = curLen;
             } else if (prevLen == curLen && prevMatch.first) {
-                if (prevMatch.second->GetCreateTime() > itr->second.second->GetCreateTime()) {
-                    prevMatch = itr->second;
+                if (prevMatch.second->GetCreateTime() > itr->second->GetCreateTime()) {
+                    prevMatch = *itr;
                     prevLen = curLen;
                 }
             }
@@ -621,12 +647,13 @@ FileDiscoveryConfig ConfigManager::FindBestMatch(const string& path, const strin
                 (*iter).second->GetRegion());
         }
     }
-    {
-        ScopedSpinLock cachedLock(mCacheFileConfigMapLock);
-        // use operator [], force update time
-        mCacheFileConfigMap[cachedFileKey]
-            = std::make_pair(prevMatch, nameRepeat > 1 && !name.empty() ? (int32_t)time(NULL) : (int32_t)0);
-    }
+    // force update time
+    mCacheFileConfigMap.Put(cachedFileKey,
+                            path.size(),
+                            prevMatch,
+                            nameRepeat > 1 && !name.empty() ? (int32_t)time(NULL) : (int32_t)0,
+                            GetMatchDependencies(vector<FileDiscoveryConfig>(1, prevMatch)),
+                            INT32_FLAG(config_match_max_cache_size));
     return prevMatch;
 }
 
@@ -640,21 +667,21 @@ int32_t ConfigManager::FindAllMatch(vector<FileDiscoveryConfig>& allConfig,
     cachedFileKey.append(name);
     const int32_t maxMultiConfigSize = appConfig->GetMaxMultiConfigSize();
     {
-        ScopedSpinLock cachedLock(mCacheFileAllConfigMapLock);
-        auto iter = mCacheFileAllConfigMap.find(cachedFileKey);
-        if (iter != mCacheFileAllConfigMap.end()) {
-            if (iter->second.second == 0
-                || time(NULL) - iter->second.second < INT32_FLAG(multi_config_alarm_interval)) {
-                allConfig = iter->second.first;
+        vector<FileDiscoveryConfig> cachedConfigs;
+        int32_t alarmTime = 0;
+        if (mCacheFileAllConfigMap.Get(
+                cachedFileKey, FileServer::GetInstance()->GetFileDiscoveryIndex(), cachedConfigs, alarmTime)) {
+            if (alarmTime == 0 || time(NULL) - alarmTime < INT32_FLAG(multi_config_alarm_interval)) {
+                allConfig = std::move(cachedConfigs);
                 return (int32_t)allConfig.size();
             }
         }
     }
     bool alarmFlag = false;
-    auto nameConfigMap = FileServer::GetInstance()->GetAllFileDiscoveryConfigs();
-    auto itr = nameConfigMap.begin();
-    for (; itr != nameConfigMap.end(); ++itr) {
-        const FileDiscoveryOptions* config = itr->second.first;
+    vector<FileDiscoveryConfig> candidates;
+    GetMatchCandidates(path, candidates);
+    for (auto itr = candidates.begin(); itr != candidates.end(); ++itr) {
+        const FileDiscoveryOptions* config = itr->first;
         // // exclude __FUSE_CONFIG__
         // if (itr->first == STRING_FLAG(fuse_customized_config_name)) {
         //     continue;
@@ -662,7 +689,7 @@ int32_t ConfigManager::FindAllMatch(vector<FileDiscoveryConfig>& allConfig,
 
         bool match = config->IsMatch(path, name);
         if (match) {
-            allConfig.push_back(itr->second);
+            allConfig.push_back(*itr);
         }
     }
 
@@ -673,11 +700,13 @@ int32_t ConfigManager::FindAllMatch(vector<FileDiscoveryConfig>& allConfig,
         SendAllMatchAlarm(path, name, allConfig, maxMultiConfigSize);
         allConfig.resize(maxMultiConfigSize);
     }
-    {
-        ScopedSpinLock cachedLock(mCacheFileAllConfigMapLock);
-        // use operator [], force update time
-        mCacheFileAllConfigMap[cachedFileKey] = std::make_pair(allConfig, alarmFlag ? (int32_t)time(NULL) : (int32_t)0);
-    }
+    // force update time
+    mCacheFileAllConfigMap.Put(cachedFileKey,
+                               path.size(),
+                               allConfig,
+                               alarmFlag ? (int32_t)time(NULL) : (int32_t)0,
+                               GetMatchDependencies(allConfig),
+                               INT32_FLAG(config_match_max_cache_size));
     return (int32_t)allConfig.size();
 }
 
@@ -689,26 +718,26 @@ int32_t ConfigManager::FindMatchWithForceFlag(std::vector<FileDiscoveryConfig>&
     cachedFileKey.push_back('<');
     cachedFileKey.append(name);
     {
-        ScopedSpinLock cachedLock(mCacheFileAllConfigMapLock);
-        auto iter = mCacheFileAllConfigMap.find(cachedFileKey);
-        if (iter != mCacheFileAllConfigMap.end()) {
-            if (iter->second.second == 0
-                || time(NULL) - iter->second.second < INT32_FLAG(multi_config_alarm_interval)) {
-                allConfig = iter->second.first;
+        vector<FileDiscoveryConfig> cachedConfigs;
+        int32_t alarmTime = 0;
+        if (mCacheFileAllConfigMap.Get(
+                cachedFileKey, FileServer::GetInstance()->GetFileDiscoveryIndex(), cachedConfigs, alarmTime)) {
+            if (alarmTime == 0 || time(NULL) - alarmTime < INT32_FLAG(multi_config_alarm_interval)) {
+                allConfig = std::move(cachedConfigs);
                 return (int32_t)allConfig.size();
             }
         }
     }
-    auto nameConfigMap = FileServer::GetInstance()->GetAllFileDiscoveryConfigs();
-    auto itr = nameConfigMap.begin();
+    vector<FileDiscoveryConfig> candidates;
+    GetMatchCandidates(path, candidates);
     FileDiscoveryConfig prevMatch = make_pair(nullptr, nullptr);
     size_t prevLen = 0;
     size_t curLen = 0;
     uint32_t nameRepeat = 0;
     string logNameList;
     vector<FileDiscoveryConfig> multiConfigs;
-    for (; itr != nameConfigMap.end(); ++itr) {
-        FileDiscoveryConfig config = itr->second;
+    for (auto itr = candidates.begin(); itr != candidates.end(); ++itr) {
+        FileDiscoveryConfig config = *itr;
         // // exclude __FUSE_CONFIG__
         // if (itr->first == STRING_FLAG(fuse_customized_config_name)) {
         //     continue;
@@ -768,11 +797,13 @@ int32_t ConfigManager::FindMatchWithForceFlag(std::vector<FileDiscoveryConfig>&
     if (prevMatch.first) {
         allConfig.push_back(prevMatch);
     }
-    {
-        ScopedSpinLock cachedLock(mCacheFileAllConfigMapLock);
-        // use operator [], force update time
-        mCacheFileAllConfigMap[cachedFileKey] = std::make_pair(allConfig, alarmFlag ? (int32_t)time(NULL) : (int32_t)0);
-    }
+    // force update time
+    mCacheFileAllConfigMap.Put(cachedFileKey,
+                               path.size(),
+                               allConfig,
+                               alarmFlag ? (int32_t)time(NULL) : (int32_t)0,
+                               GetMatchDependencies(allConfig),
+                               INT32_FLAG(config_match_max_cache_size));
     return (int32_t)allConfig.size();
 }
 
@@ -849,8 +880,10 @@ bool ConfigManager::DoUpdateContainerPaths() {
                                                                                            tmpPathCmdVec[i]->mParams));
             continue;
         }
+        bool success = false;
         if (tmpPathCmdVec[i]->mDeleteFlag) {
-            if (config.first->DeleteDockerContainerPath(tmpPathCmdVec[i]->mParams)) {
+            success = config.first->DeleteDockerContainerPath(tmpPathCmdVec[i]->mParams);
+            if (success) {
                 LOG_DEBUG(sLogger,
                           ("container path delete cmd success",
                            tmpPathCmdVec[i]->mConfigName)("params", tmpPathCmdVec[i]->mParams));
@@ -860,7 +893,9 @@ bool ConfigManager::DoUpdateContainerPaths() {
                                                                                             tmpPathCmdVec[i]->mParams));
             }
         } else {
-            if (config.first->UpdateDockerContainerPath(tmpPathCmdVec[i]->mParams, tmpPathCmdVec[i]->mUpdateAllFlag)) {
+            success
+                = config.first->UpdateDockerContainerPath(tmpPathCmdVec[i]->mParams, tmpPathCmdVec[i]->mUpdateAllFlag);
+            if (success) {
                 LOG_DEBUG(sLogger,
                           ("container path update cmd success", tmpPathCmdVec[i]->mConfigName)(
                               "params", tmpPathCmdVec[i]->mParams)("all", tmpPathCmdVec[i]->mUpdateAllFlag));
@@ -870,6 +905,11 @@ bool ConfigManager::DoUpdateContainerPaths() {
                               "params", tmpPathCmdVec[i]->mParams)("all", tmpPathCmdVec[i]->mUpdateAllFlag));
             }
         }
+        // the generations of the config are not changed by container paths, so matches cached with the old paths,
+        // including those matching no config, are dropped here
+        if (success) {
+            InvalidateFilePipelineMatchCache(*config.first);
+        }
         delete tmpPathCmdVec[i];
     }
     return true;
@@ -1053,10 +1093,20 @@ void ConfigManager::LoadDockerConfig() {
 }
 
 void ConfigManager::ClearFilePipelineMatchCache() {
-    ScopedSpinLock lock(mCacheFileConfigMapLock);
-    mCacheFileConfigMap.clear();
-    ScopedSpinLock allLock(mCacheFileAllConfigMapLock);
-    mCacheFileAllConfigMap.clear();
+    mCacheFileConfigMap.Clear();
+    mCacheFileAllConfigMap.Clear();
+    ++mFileMatchEpoch;
+}
+
+void ConfigManager::InvalidateFilePipelineMatchCache(const FileDiscoveryOptions& config) {
+    string prefix;
+    if (!FileDiscoveryIndex::GetIndexPrefix(config, prefix)) {
+        ClearFilePipelineMatchCache();
+        return;
+    }
+    mCacheFileConfigMap.InvalidatePath(prefix);
+    mCacheFileAllConfigMap.InvalidatePath(prefix);
+    ++mFileMatchEpoch;
 }
 
 #ifdef APSARA_UNIT_TEST_MAIN
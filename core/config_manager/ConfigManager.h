@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <unordered_map>
@@ -23,6 +24,7 @@
 #include <vector>
 
 #include "common/Lock.h"
+#include "config_manager/ConfigMatchCache.h"
 #include "event/Event.h"
 #include "file_server/FileDiscoveryOptions.h"
 #include "container_manager/DockerContainerPathCmd.h"
@@ -149,12 +151,11 @@ protected:
     // std::atomic_int mLastConfigUpdateTime{0};
     // std::atomic_int mLastConfigGetTime{0};
 
-    SpinLock mCacheFileConfigMapLock;
-    // value : best config, multi config last alarmTime, and if alarmTime is 0, it means no multi config
-    std::unordered_map<std::string, std::pair<FileDiscoveryConfig, int32_t>> mCacheFileConfigMap;
-
-    SpinLock mCacheFileAllConfigMapLock;
-    std::unordered_map<std::string, std::pair<std::vector<FileDiscoveryConfig>, int32_t>> mCacheFileAllConfigMap;
+    // value : best config
+    ConfigMatchCache<FileDiscoveryConfig> mCacheFileConfigMap{"best_match"};
+    ConfigMatchCache<std::vector<FileDiscoveryConfig>> mCacheFileAllConfigMap{"all_match"};
+    // increased whenever cached matches are dropped
+    std::atomic<uint64_t> mFileMatchEpoch{0};
 
     PTMutex mDockerContainerPathCmdLock;
     std::vector<DockerContainerPathCmd*> mDockerContainerPathCmdVec;
@@ -418,9 +419,17 @@ public:
     // void RemoveAllConfigs();
 
     void ClearFilePipelineMatchCache();
+    // InvalidateFilePipelineMatchCache removes cached matches which config may change, it is called when config is
+    // added or its container paths are updated. Removed configs need not be invalidated, since cached matches are
+    // checked against config generations.
+    void InvalidateFilePipelineMatchCache(const FileDiscoveryOptions& config);
 
     void ClearConfigMatchCache();
 
+    // GetFileMatchEpoch changes whenever FindBestMatch may return another config for a file than before, so that
+    // callers can keep match results as long as it does not change.
+    uint64_t GetFileMatchEpoch() const { return mFileMatchEpoch.load(std::memory_order_acquire); }
+
     // 废弃，路径映射
     // bool NeedReloadMappingConfig() { return mHaveMappingPathConfig && mMappingPathsChanged; }
     // void SetMappingPathsChanged() { mMappingPathsChanged = true; }
@@ -560,6 +569,8 @@ private:
                            const std::string& name,
                            std::vector<FileDiscoveryConfig>& allConfig,
                            int32_t maxMultiConfigSize);
+    // GetMatchCandidates returns the configs which may match files in dir path.
+    void GetMatchCandidates(const std::string& path, std::vector<FileDiscoveryConfig>& candidates);
 
     // void MappingPluginConfig(const Json::Value& configValue, Config* config, Json::Value& pluginJson);
 
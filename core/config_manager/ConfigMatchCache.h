@@ -0,0 +1,192 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/FileSystemUtil.h"
+#include "common/Lock.h"
+#include "file_server/FileDiscoveryIndex.h"
+#include "monitor/LogtailMetric.h"
+#include "monitor/MetricConstants.h"
+
+namespace logtail {
+
+// ConfigMatchCache caches the configs matched by a file, keyed by path + '<' + name. It is split into shards with
+// their own lock and LRU list, and each shard holds at most capacity / shard count entries, so that short-lived
+// paths, e.g. directories of rotated pods, are evicted instead of growing the cache until it is cleared.
+//
+// Each entry records the generations of the configs in its value. An entry is stale once any of them is removed or
+// replaced, which is checked against FileDiscoveryIndex on lookup. A newly added config may match paths cached
+// before, so the caller invalidates the entries under its prefix by InvalidatePath.
+template <typename Value>
+class ConfigMatchCache {
+public:
+    using Dependencies = std::vector<std::pair<const FileDiscoveryOptions*, uint64_t>>;
+
+    explicit ConfigMatchCache(const std::string& name, size_t shardCount = 16) : mShards(shardCount) {
+        MetricLabels labels;
+        labels.emplace_back(std::make_pair("cache", name));
+        WriteMetrics::GetInstance()->PrepareMetricsRecordRef(mMetricsRecordRef, std::move(labels));
+        mHitTotal = mMetricsRecordRef.CreateCounter(METRIC_CONFIG_MATCH_CACHE_HIT_TOTAL);
+        mMissTotal = mMetricsRecordRef.CreateCounter(METRIC_CONFIG_MATCH_CACHE_MISS_TOTAL);
+        mEvictTotal = mMetricsRecordRef.CreateCounter(METRIC_CONFIG_MATCH_CACHE_EVICT_TOTAL);
+    }
+
+    // Get returns false if key is not cached or the entry is stale.
+    bool Get(const std::string& key, const FileDiscoveryIndex& index, Value& value, int32_t& alarmTime) {
+        Shard& shard = GetShard(key);
+        {
+            ScopedSpinLock lock(shard.mLock);
+            auto iter = shard.mMap.find(key);
+            if (iter != shard.mMap.end()) {
+                typename EntryList::iterator entry = iter->second;
+                if (IsValid(*entry, index)) {
+                    shard.mEntries.splice(shard.mEntries.begin(), shard.mEntries, entry);
+                    value = entry->mValue;
+                    alarmTime = entry->mAlarmTime;
+                    mHitTotal->Add(1);
+                    return true;
+                }
+                shard.mEntries.erase(entry);
+                shard.mMap.erase(iter);
+            }
+        }
+        mMissTotal->Add(1);
+        return false;
+    }
+
+    // Put adds or replaces the entry of key, pathSize is the length of the path part of key.
+    void Put(const std::string& key,
+             size_t pathSize,
+             const Value& value,
+             int32_t alarmTime,
+             Dependencies&& dependencies,
+             size_t capacity) {
+        Shard& shard = GetShard(key);
+        size_t shardCapacity = capacity / mShards.size() > 0 ? capacity / mShards.size() : 1;
+        uint64_t evicted = 0;
+        {
+            ScopedSpinLock lock(shard.mLock);
+            auto iter = shard.mMap.find(key);
+            if (iter != shard.mMap.end()) {
+                shard.mEntries.erase(iter->second);
+                shard.mMap.erase(iter);
+            }
+            while (shard.mEntries.size() >= shardCapacity) {
+                shard.mMap.erase(shard.mEntries.back().mKey);
+                shard.mEntries.pop_back();
+                ++evicted;
+            }
+            shard.mEntries.emplace_front(key, pathSize, value, alarmTime, std::move(dependencies));
+            shard.mMap[key] = shard.mEntries.begin();
+        }
+        if (evicted > 0) {
+            mEvictTotal->Add(evicted);
+        }
+    }
+
+    // InvalidatePath removes entries whose path is dir or under it.
+    void InvalidatePath(const std::string& dir) {
+        for (Shard& shard : mShards) {
+            ScopedSpinLock lock(shard.mLock);
+            for (auto iter = shard.mEntries.begin(); iter != shard.mEntries.end();) {
+                if (IsUnder(iter->mKey, iter->mPathSize, dir)) {
+                    shard.mMap.erase(iter->mKey);
+                    iter = shard.mEntries.erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+        }
+    }
+
+    void Clear() {
+        for (Shard& shard : mShards) {
+            ScopedSpinLock lock(shard.mLock);
+            shard.mEntries.clear();
+            shard.mMap.clear();
+        }
+    }
+
+    size_t Size() {
+        size_t size = 0;
+        for (Shard& shard : mShards) {
+            ScopedSpinLock lock(shard.mLock);
+            size += shard.mEntries.size();
+        }
+        return size;
+    }
+
+private:
+    struct Entry {
+        Entry(const std::string& key, size_t pathSize, const Value& value, int32_t alarmTime, Dependencies&& deps)
+            : mKey(key), mPathSize(pathSize), mValue(value), mAlarmTime(alarmTime), mDependencies(std::move(deps)) {}
+
+        std::string mKey;
+        size_t mPathSize;
+        Value mValue;
+        // last multi config alarm time, 0 means no multi config
+        int32_t mAlarmTime;
+        Dependencies mDependencies;
+    };
+    using EntryList = std::list<Entry>;
+
+    struct Shard {
+        SpinLock mLock;
+        EntryList mEntries; // most recently used first
+        std::unordered_map<std::string, typename EntryList::iterator> mMap;
+    };
+
+    Shard& GetShard(const std::string& key) { return mShards[std::hash<std::string>()(key) % mShards.size()]; }
+
+    static bool IsValid(const Entry& entry, const FileDiscoveryIndex& index) {
+        for (const auto& item : entry.mDependencies) {
+            if (index.GetGeneration(item.first) != item.second) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool IsUnder(const std::string& key, size_t pathSize, const std::string& dir) {
+        if (pathSize < dir.size() || key.compare(0, dir.size(), dir) != 0) {
+            return false;
+        }
+        return pathSize == dir.size() || dir.empty() || dir.back() == PATH_SEPARATOR[0]
+            || key[dir.size()] == PATH_SEPARATOR[0];
+    }
+
+    std::vector<Shard> mShards;
+
+    MetricsRecordRef mMetricsRecordRef;
+    CounterPtr mHitTotal;
+    CounterPtr mMissTotal;
+    CounterPtr mEvictTotal;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class ConfigMatchCacheUnittest;
+#endif
+};
+
+} // namespace logtail
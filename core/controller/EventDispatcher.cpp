@@ -232,7 +232,9 @@ bool EventDispatcher::RegisterEventHandler(const char* path,
     }
 
     wd = -1;
-    if (mInotifyWatchNum >= INT32_FLAG(default_max_inotify_watch_num)) {
+    // Directories on filesystems watched by fanotify need no inotify watch, so they are not limited.
+    bool inotifyAllowed = mInotifyWatchNum < INT32_FLAG(default_max_inotify_watch_num);
+    if (!inotifyAllowed && !mEventListener->IsFanotifyInit()) {
         LOG_INFO(sLogger,
                  ("failed to add inotify watcher for dir", path)("max allowd inotify watchers",
                                                                  INT32_FLAG(default_max_inotify_watch_num)));
@@ -241,8 +243,14 @@ bool EventDispatcher::RegisterEventHandler(const char* path,
     } else {
         // need check mEventListener valid
         if (mEventListener->IsInit() && !AppConfig::GetInstance()->IsInInotifyBlackList(path)) {
-            wd = mEventListener->AddWatch(path);
-            if (!mEventListener->IsValidID(wd)) {
+            wd = mEventListener->AddWatch(path, inotifyAllowed);
+            if (!mEventListener->IsValidID(wd) && !inotifyAllowed) {
+                LOG_INFO(sLogger,
+                         ("failed to add inotify watcher for dir", path)("max allowd inotify watchers",
+                                                                         INT32_FLAG(default_max_inotify_watch_num)));
+                LogtailAlarm::GetInstance()->SendAlarm(INOTIFY_DIR_NUM_LIMIT_ALARM,
+                                                       string("failed to register inotify watcher for dir") + path);
+            } else if (!mEventListener->IsValidID(wd)) {
                 string str = ErrnoToString(GetErrno());
                 LOG_WARNING(sLogger, ("failed to register dir", path)("reason", str));
 #if defined(__linux__)
@@ -276,7 +284,7 @@ bool EventDispatcher::RegisterEventHandler(const char* path,
                               ("can not register inotify monitor", path)("inode", inode)("wd", wd)(
                                   "reason", "there is already a dir in inotify watch list shard the same inode"));
                     wd = -1;
-                } else
+                } else if (!mEventListener->IsFanotifyID(wd))
                     mInotifyWatchNum++;
             }
         }
@@ -836,7 +844,8 @@ void EventDispatcher::UnregisterEventHandler(const char* path) {
     mWdUpdateTimeMap.erase(wd);
     if (mEventListener->IsValidID(wd) && mEventListener->IsInit()) {
         mEventListener->RemoveWatch(wd);
-        mInotifyWatchNum--;
+        if (!mEventListener->IsFanotifyID(wd))
+            mInotifyWatchNum--;
     }
     mWatchNum--;
     LOG_INFO(sLogger, ("remove the watcher for dir", path)("wd", wd));
@@ -285,6 +285,7 @@ protected:
     friend class FuseFileUnittest;
     friend class MultiServerConfigUpdatorUnitest;
     friend class EventDispatcherDirUnittest;
+    friend class LogInputUnittest;
 
     void CleanEnviroments();
     int32_t GetInotifyWatcherCount();
@@ -14,7 +14,7 @@
 
 #include "BlockEventManager.h"
 #include "processor/daemon/LogProcess.h"
-#include "common/HashUtil.h"
+#include "CoalescingEventQueue.h"
 #include "common/StringTools.h"
 #include "polling/PollingEventQueue.h"
 
@@ -36,17 +36,7 @@ void BlockedEventManager::UpdateBlockEvent(const LogstoreFeedBackKey& logstoreKe
         pEvent->SetConfigName(configName);
         pEvent->SetDev(devInode.dev);
         pEvent->SetInode(devInode.inode);
-        std::string key;
-        key.append(pEvent->GetSource())
-            .append(">")
-            .append(pEvent->GetObject())
-            .append(">")
-            .append(ToString(pEvent->GetDev()))
-            .append(">")
-            .append(ToString(pEvent->GetInode()))
-            .append(">")
-            .append(pEvent->GetConfigName());
-        hashKey = HashSignatureString(key.c_str(), key.size());
+        hashKey = CoalescingEventQueue::CalculateHashKey(*pEvent);
     }
     // LOG_DEBUG(sLogger, ("Add block event ", pEvent->GetSource())(pEvent->GetObject(),
     // pEvent->GetInode())(pEvent->GetConfigName(), hashKey));
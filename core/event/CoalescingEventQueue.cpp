@@ -0,0 +1,112 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoalescingEventQueue.h"
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <boost/functional/hash.hpp>
+#include "Event.h"
+
+namespace logtail {
+
+CoalescingEventQueue::~CoalescingEventQueue() {
+    Clear();
+}
+
+int64_t CoalescingEventQueue::CalculateHashKey(const Event& ev) {
+    size_t seed = 0;
+    boost::hash_combine(seed, boost::hash_value(ev.GetSource()));
+    boost::hash_combine(seed, boost::hash_value(ev.GetObject()));
+    boost::hash_combine(seed, boost::hash_value(ev.GetDev()));
+    boost::hash_combine(seed, boost::hash_value(ev.GetInode()));
+    boost::hash_combine(seed, boost::hash_value(ev.GetConfigName()));
+    return static_cast<int64_t>(seed);
+}
+
+bool CoalescingEventQueue::IsBarrier(const Event& ev, bool& dirOnly) {
+    dirOnly = false;
+    if (ev.GetType() == EVENT_MODIFY) {
+        return false;
+    }
+    // Events of directories (including the watched directory itself) may affect files in any subdirectory.
+    dirOnly = !ev.IsDir() && !ev.GetObject().empty();
+    return true;
+}
+
+bool CoalescingEventQueue::Push(Event* ev) {
+    ++mPushCount;
+    int64_t hashKey = CalculateHashKey(*ev);
+    ev->SetHashKey(hashKey);
+    bool dirOnly = false;
+    if (IsBarrier(*ev, dirOnly)) {
+        ++mSeq;
+        if (dirOnly) {
+            mDirBarrierMap[std::hash<std::string>()(ev->GetSource())] = mSeq;
+        } else {
+            mGlobalBarrier = mSeq;
+        }
+    } else {
+        auto iter = mPendingModifyMap.find(hashKey);
+        if (iter != mPendingModifyMap.end()) {
+            uint64_t barrier = mGlobalBarrier;
+            if (!mDirBarrierMap.empty()) {
+                auto dirIter = mDirBarrierMap.find(std::hash<std::string>()(ev->GetSource()));
+                if (dirIter != mDirBarrierMap.end()) {
+                    barrier = std::max(barrier, dirIter->second);
+                }
+            }
+            if (iter->second.mSeq >= barrier) {
+                ++mCoalescedCount;
+                delete ev;
+                return false;
+            }
+            // The pending one is before a barrier, this one becomes the pending one.
+            iter->second = PendingModify{ev, mSeq};
+        } else {
+            mPendingModifyMap.emplace(hashKey, PendingModify{ev, mSeq});
+        }
+    }
+    mQueue.push_back(ev);
+    return true;
+}
+
+Event* CoalescingEventQueue::Pop() {
+    if (mQueue.empty()) {
+        return nullptr;
+    }
+    Event* ev = mQueue.front();
+    mQueue.pop_front();
+    if (ev->GetType() == EVENT_MODIFY) {
+        auto iter = mPendingModifyMap.find(ev->GetHashKey());
+        if (iter != mPendingModifyMap.end() && iter->second.mEvent == ev) {
+            mPendingModifyMap.erase(iter);
+        }
+    }
+    if (mQueue.empty()) {
+        mDirBarrierMap.clear();
+    }
+    return ev;
+}
+
+void CoalescingEventQueue::Clear() {
+    for (Event* ev : mQueue) {
+        delete ev;
+    }
+    mQueue.clear();
+    mPendingModifyMap.clear();
+    mDirBarrierMap.clear();
+}
+
+} // namespace logtail
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+namespace logtail {
+
+class Event;
+
+// CoalescingEventQueue is the queue of file events waiting to be processed, it is not thread safe.
+//
+// A busy file produces MODIFY events much faster than they are processed, but one MODIFY is enough to read all
+// new content. So a MODIFY event is merged into the pending MODIFY event of the same file (source, object, dev,
+// inode and config) in O(1). To keep the order of events, it is only merged if no other event which may change the
+// file, e.g. CREATE, DELETE or MOVE of the file or its directory, is queued after the pending one.
+class CoalescingEventQueue {
+public:
+    CoalescingEventQueue() = default;
+    ~CoalescingEventQueue();
+    CoalescingEventQueue(const CoalescingEventQueue&) = delete;
+    CoalescingEventQueue& operator=(const CoalescingEventQueue&) = delete;
+
+    // Push takes the ownership of ev, it returns false if ev is merged into a pending event and deleted.
+    bool Push(Event* ev);
+    // Pop returns the first event, or nullptr if the queue is empty.
+    Event* Pop();
+    // Clear deletes all events.
+    void Clear();
+
+    size_t Size() const { return mQueue.size(); }
+    bool Empty() const { return mQueue.empty(); }
+
+    // Counters since the queue is created, for metrics.
+    uint64_t GetPushCount() const { return mPushCount; }
+    uint64_t GetCoalescedCount() const { return mCoalescedCount; }
+
+    // CalculateHashKey returns the key which identifies events of the same file and config.
+    static int64_t CalculateHashKey(const Event& ev);
+
+private:
+    // IsBarrier returns true if ev may change files of pending MODIFY events, @dirOnly is set if it only affects
+    // files of its source directory.
+    static bool IsBarrier(const Event& ev, bool& dirOnly);
+
+    struct PendingModify {
+        Event* mEvent;
+        uint64_t mSeq;
+    };
+
+    std::deque<Event*> mQueue;
+    std::unordered_map<int64_t, PendingModify> mPendingModifyMap;
+    // Sequence of the last barrier by hash of source directory, and the last barrier affecting all directories.
+    // Barriers only matter while there are events queued, so they are cleared once the queue is empty.
+    std::unordered_map<size_t, uint64_t> mDirBarrierMap;
+    uint64_t mGlobalBarrier = 0;
+    uint64_t mSeq = 0;
+
+    uint64_t mPushCount = 0;
+    uint64_t mCoalescedCount = 0;
+};
+
+} // namespace logtail
@@ -14,10 +14,13 @@
 
 #include "EventHandler.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include <boost/functional/hash.hpp>
+
 #include "LogInput.h"
 #include "app_config/AppConfig.h"
 #include "common/FileSystemUtil.h"
@@ -33,11 +36,19 @@
 #include "logger/Logger.h"
 #include "monitor/LogtailAlarm.h"
 #include "processor/daemon/LogProcess.h"
+#include "reader/GloablFileDescriptorManager.h"
 
 using namespace std;
 using namespace sls_logs;
 
 DEFINE_FLAG_INT64(read_file_time_slice, "microseconds", 50 * 1000);
+DEFINE_FLAG_INT32(modify_handler_thread_count,
+                  "number of threads to read files, readers are sharded by file dev inode, 1 means files are read by "
+                  "the event processing thread",
+                  1);
+DEFINE_FLAG_BOOL(reader_close_unused_file_by_timeout,
+                 "close files which are not updated for a while even if open files and memory are not under pressure",
+                 false);
 DEFINE_FLAG_INT32(logreader_timeout_interval,
                   "reader hasn't updated for a long time will be removed, seconds",
                   86400 * 20000); // roughly equivalent to not releasing logReader when timed out
@@ -184,37 +195,89 @@ void TimeoutHandler::HandleTimeOut() {
 }
 
 bool CreateModifyHandler::DumpReaderMeta(bool isRotatorReader, bool checkConfigFlag) {
-    for (ModifyHandlerMap::iterator iter = mModifyHandlerPtrMap.begin(); iter != mModifyHandlerPtrMap.end(); ++iter) {
-        iter->second->DumpReaderMeta(isRotatorReader, checkConfigFlag);
+    for (size_t shard = 0; shard < GetHandlerShardCount(); ++shard) {
+        ModifyHandlerMap& handlerMap = GetModifyHandlerMap(shard);
+        for (ModifyHandlerMap::iterator iter = handlerMap.begin(); iter != handlerMap.end(); ++iter) {
+            iter->second->DumpReaderMeta(isRotatorReader, checkConfigFlag);
+        }
     }
     return true;
 }
 
 bool CreateModifyHandler::IsAllFileRead() {
-    for (ModifyHandlerMap::iterator iter = mModifyHandlerPtrMap.begin(); iter != mModifyHandlerPtrMap.end(); ++iter) {
-        if (!iter->second->IsAllFileRead()) {
-            return false;
+    for (size_t shard = 0; shard < GetHandlerShardCount(); ++shard) {
+        ModifyHandlerMap& handlerMap = GetModifyHandlerMap(shard);
+        for (ModifyHandlerMap::iterator iter = handlerMap.begin(); iter != handlerMap.end(); ++iter) {
+            if (!iter->second->IsAllFileRead()) {
+                return false;
+            }
         }
     }
     return true;
 }
 
 ModifyHandler* CreateModifyHandler::GetOrCreateModifyHandler(const std::string& configName,
-                                                             const FileDiscoveryConfig& pConfig) {
-    ModifyHandlerMap::iterator iter = mModifyHandlerPtrMap.find(configName);
-    if (iter != mModifyHandlerPtrMap.end()) {
+                                                             const FileDiscoveryConfig& pConfig,
+                                                             size_t shard) {
+    ModifyHandlerMap& handlerMap = GetModifyHandlerMap(shard);
+    ModifyHandlerMap::iterator iter = handlerMap.find(configName);
+    if (iter != handlerMap.end()) {
         return iter->second;
     }
     ModifyHandler* pHanlder = new ModifyHandler(configName, pConfig);
-    mModifyHandlerPtrMap.insert(std::make_pair(configName, pHanlder));
+    handlerMap.insert(std::make_pair(configName, pHanlder));
     return pHanlder;
 }
 
 CreateModifyHandler::~CreateModifyHandler() {
-    for (ModifyHandlerMap::iterator iter = mModifyHandlerPtrMap.begin(); iter != mModifyHandlerPtrMap.end(); ++iter) {
-        delete iter->second;
+    for (size_t shard = 0; shard < GetHandlerShardCount(); ++shard) {
+        ModifyHandlerMap& handlerMap = GetModifyHandlerMap(shard);
+        for (ModifyHandlerMap::iterator iter = handlerMap.begin(); iter != handlerMap.end(); ++iter) {
+            delete iter->second;
+        }
+        handlerMap.clear();
     }
-    mModifyHandlerPtrMap.clear();
+}
+
+size_t CreateModifyHandler::GetShardCount() {
+    // The value is read once, handlers created before and after a change must have the same shards.
+    static const size_t sShardCount = static_cast<size_t>(std::max(INT32_FLAG(modify_handler_thread_count), 1));
+    return sShardCount;
+}
+
+size_t CreateModifyHandler::SelectShard(const Event& event, DevInode& devInode) {
+    devInode = DevInode(event.GetDev(), event.GetInode());
+    const size_t shardCount = GetHandlerShardCount();
+    if (shardCount == 1) {
+        return 0;
+    }
+    // devInode is known to be invalid for inotify events
+    if (!devInode.IsValid()) {
+        devInode = GetFileDevInode(std::string(event.GetSource()).append(PATH_SEPARATOR).append(event.GetObject()));
+    }
+    size_t nameShard = shardCount;
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        ModifyHandlerMap& handlerMap = GetModifyHandlerMap(shard);
+        for (ModifyHandlerMap::iterator iter = handlerMap.begin(); iter != handlerMap.end(); ++iter) {
+            if (devInode.IsValid() && iter->second->HasReader(devInode)) {
+                return shard;
+            }
+            if (nameShard == shardCount && iter->second->HasReaderOfName(event.GetObject())) {
+                nameShard = shard;
+            }
+        }
+    }
+    if (nameShard != shardCount) {
+        return nameShard;
+    }
+    if (!devInode.IsValid()) {
+        // no reader can be found or created for the file, any shard is ok
+        return 0;
+    }
+    size_t seed = 0;
+    boost::hash_combine(seed, devInode.dev);
+    boost::hash_combine(seed, devInode.inode);
+    return seed % shardCount;
 }
 
 // CreateModifyHandler implementation
@@ -241,54 +304,69 @@ void CreateModifyHandler::Handle(const Event& event) {
     if ((event.IsCreate() || event.IsMoveTo()) && isDir) {
         mCreateHandlerPtr->Handle(event);
     } else if (event.IsContainerStopped() && isDir) {
-        for (auto& pair : mModifyHandlerPtrMap) {
-            LOG_DEBUG(sLogger,
-                      ("Handle container stopped event, config", pair.first)("Source", event.GetSource())(
-                          "Object", event.GetObject())("Dev", event.GetDev())("Inode", event.GetInode()));
-            pair.second->Handle(event);
-        }
-    } else if (event.IsCreate() || event.IsModify() || event.IsMoveFrom() || event.IsMoveTo() || event.IsDeleted()) {
-        if (!event.GetConfigName().empty()) {
-            FileDiscoveryConfig pConfig = FileServer::GetInstance()->GetFileDiscoveryConfig(event.GetConfigName());
-            if (pConfig.first) {
+        for (size_t shard = 0; shard < GetHandlerShardCount(); ++shard) {
+            for (auto& pair : GetModifyHandlerMap(shard)) {
                 LOG_DEBUG(sLogger,
-                          ("Process event with existed config", event.GetConfigName())("Source", event.GetSource())(
+                          ("Handle container stopped event, config", pair.first)("Source", event.GetSource())(
                               "Object", event.GetObject())("Dev", event.GetDev())("Inode", event.GetInode()));
-                GetOrCreateModifyHandler(pConfig.second->GetConfigName(), pConfig)->Handle(event);
-            } else {
-                // if event is delete
-                LOG_WARNING(sLogger, ("can not find config, config may be deleted", event.GetConfigName()));
+                pair.second->Handle(event);
             }
+        }
+    } else if (event.IsMoveFrom() || event.IsDeleted()) {
+        // readers are found by file name for these events, and the name may have readers in any shard
+        for (size_t shard = 0; shard < GetHandlerShardCount(); ++shard) {
+            HandleInShard(event, shard);
+        }
+    } else if (event.IsCreate() || event.IsModify() || event.IsMoveTo()) {
+        DevInode devInode;
+        HandleInShard(event, SelectShard(event, devInode));
+    }
+}
+
+void CreateModifyHandler::HandleInShard(const Event& event, size_t shard) {
+    if (!event.GetConfigName().empty()) {
+        FileDiscoveryConfig pConfig = FileServer::GetInstance()->GetFileDiscoveryConfig(event.GetConfigName());
+        if (pConfig.first) {
+            LOG_DEBUG(sLogger,
+                      ("Process event with existed config", event.GetConfigName())("Source", event.GetSource())(
+                          "Object", event.GetObject())("Dev", event.GetDev())("Inode", event.GetInode()));
+            GetOrCreateModifyHandler(pConfig.second->GetConfigName(), pConfig, shard)->Handle(event);
         } else {
-            vector<FileDiscoveryConfig> pConfigVec;
-            if (AppConfig::GetInstance()->IsAcceptMultiConfig()) {
-                ConfigManager::GetInstance()->FindAllMatch(pConfigVec, event.GetSource(), event.GetObject());
-            } else {
-                ConfigManager::GetInstance()->FindMatchWithForceFlag(pConfigVec, event.GetSource(), event.GetObject());
-            }
+            // if event is delete
+            LOG_WARNING(sLogger, ("can not find config, config may be deleted", event.GetConfigName()));
+        }
+    } else {
+        vector<FileDiscoveryConfig> pConfigVec;
+        if (AppConfig::GetInstance()->IsAcceptMultiConfig()) {
+            ConfigManager::GetInstance()->FindAllMatch(pConfigVec, event.GetSource(), event.GetObject());
+        } else {
+            ConfigManager::GetInstance()->FindMatchWithForceFlag(pConfigVec, event.GetSource(), event.GetObject());
+        }
 
-            for (auto configIter = pConfigVec.begin(); configIter != pConfigVec.end(); ++configIter) {
-                LOG_DEBUG(sLogger,
-                          ("Process event with multi config", pConfigVec.size())(event.GetSource(), event.GetObject()));
-                GetOrCreateModifyHandler(configIter->second->GetConfigName(), *configIter)->Handle(event);
-
-                // 废弃
-                // if (pConfig->mIsFuseMode) {
-                //     FuseFileBlacklist::GetInstance()->RemoveFromBlackList(path);
-                // }
-                // // if file is deleted or moved, inode may be wrong
-                // if ((event.IsMoveFrom() || event.IsDeleted()) && pConfig->mMarkOffsetFlag) {
-                //     LogFileCollectOffsetIndicator::GetInstance()->DeleteItem(pConfig->mConfigName, path);
-                // }
-            }
+        for (auto configIter = pConfigVec.begin(); configIter != pConfigVec.end(); ++configIter) {
+            LOG_DEBUG(sLogger,
+                      ("Process event with multi config", pConfigVec.size())(event.GetSource(), event.GetObject()));
+            GetOrCreateModifyHandler(configIter->second->GetConfigName(), *configIter, shard)->Handle(event);
+
+            // 废弃
+            // if (pConfig->mIsFuseMode) {
+            //     FuseFileBlacklist::GetInstance()->RemoveFromBlackList(path);
+            // }
+            // // if file is deleted or moved, inode may be wrong
+            // if ((event.IsMoveFrom() || event.IsDeleted()) && pConfig->mMarkOffsetFlag) {
+            //     LogFileCollectOffsetIndicator::GetInstance()->DeleteItem(pConfig->mConfigName, path);
+            // }
         }
     }
 }
 
 
 void CreateModifyHandler::HandleTimeOut() {
-    for (ModifyHandlerMap::iterator iter = mModifyHandlerPtrMap.begin(); iter != mModifyHandlerPtrMap.end(); ++iter) {
-        iter->second->HandleTimeOut();
+    for (size_t shard = 0; shard < GetHandlerShardCount(); ++shard) {
+        ModifyHandlerMap& handlerMap = GetModifyHandlerMap(shard);
+        for (ModifyHandlerMap::iterator iter = handlerMap.begin(); iter != handlerMap.end(); ++iter) {
+            iter->second->HandleTimeOut();
+        }
     }
     mCreateHandlerPtr->HandleTimeOut(); // empty call
 }
@@ -323,10 +401,12 @@ void ModifyHandler::MakeSpaceForNewReader() {
         sortReaderArray[index++] = iter->second.get();
     }
 
-    // little to big
-    sort(sortReaderArray.begin(), sortReaderArray.end(), ModifyHandler::CompareReaderByUpdateTime);
-
     const int32_t deleteCount = (int32_t)mDevInodeReaderMap.size() - INT32_FLAG(logreader_count_max);
+    // only the oldest deleteCount readers are needed, they are not sorted among themselves
+    nth_element(sortReaderArray.begin(),
+                sortReaderArray.begin() + deleteCount,
+                sortReaderArray.end(),
+                ModifyHandler::CompareReaderByUpdateTime);
 
     for (int i = 0; i < deleteCount; ++i) {
         LogFileReader* pReader = sortReaderArray[i];
@@ -890,8 +970,18 @@ void ModifyHandler::HandleTimeOut() {
     for (; readerIter != mNameReaderMap.end();) {
         bool actioned = false;
         LogFileReaderPtrArray& readerArray = readerIter->second;
-        // donot check file delete flag or close ptr when array size > 1
+        // donot check file delete flag when array size > 1, but the readers before the newest one are of rotated files,
+        // which will not be written any more, so they are closed on timeout to release the disk space of removed ones
         if (readerArray.size() > 1) {
+            for (size_t i = 0; i + 1 < readerArray.size(); ++i) {
+                if (readerArray[i]->CloseTimeoutFilePtr(nowTime)) {
+                    ++closeFilePtrCount;
+                    LOG_DEBUG(sLogger,
+                              ("HandleTimeOut filename", readerIter->first)(
+                                  "dir", readerArray[i]->GetHostLogPath().c_str())("action", "close")(
+                                  "reason", "rotated file no new data timeout"));
+                }
+            }
             LOG_DEBUG(sLogger,
                       ("HandleTimeOut filename", readerIter->first)("dir", readerArray[0]->GetHostLogPath().c_str())(
                           "action", "continue")("reason", "reader array size > 1"));
@@ -919,10 +1009,13 @@ void ModifyHandler::HandleTimeOut() {
                 readerArray.erase(iter);
             }
         }
-        // only close file ptr when readerArray size is 1
-        // because when many file is queued, if we close file ptr, maybe we can't find this file again
+        // unless configured, unused files are only closed when open files or memory are under pressure, the least
+        // recently used ones are also closed by GloablFileDescriptorManager then. Files removed from the disk are
+        // always closed, or their disk space is held until the reader is removed
         if (readerArray.size() == 1) {
-            if (readerArray[0]->CloseTimeoutFilePtr(nowTime)) {
+            bool removedOnly = !BOOL_FLAG(reader_close_unused_file_by_timeout)
+                && !GloablFileDescriptorManager::GetInstance()->IsUnderPressure();
+            if (readerArray[0]->CloseTimeoutFilePtr(nowTime, removedOnly)) {
                 ++closeFilePtrCount;
                 actioned = true;
                 LOG_DEBUG(
@@ -966,6 +1059,16 @@ bool ModifyHandler::DumpReaderMeta(bool isRotatorReader, bool checkConfigFlag) {
     return true;
 }
 
+bool ModifyHandler::HasReader(const DevInode& devInode) const {
+    return mDevInodeReaderMap.find(devInode) != mDevInodeReaderMap.end()
+        || mRotatorReaderMap.find(devInode) != mRotatorReaderMap.end();
+}
+
+bool ModifyHandler::HasReaderOfName(const std::string& name) const {
+    NameLogFileReaderMap::const_iterator iter = mNameReaderMap.find(name);
+    return iter != mNameReaderMap.end() && !iter->second.empty();
+}
+
 bool ModifyHandler::IsAllFileRead() {
     for (auto it = mNameReaderMap.begin(); it != mNameReaderMap.end(); ++it) {
         if (it->second.size() > 1 || (!it->second.empty() && !it->second[0]->IsReadToEnd())) {
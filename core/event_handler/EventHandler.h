@@ -20,6 +20,7 @@
 #include <deque>
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #include "reader/LogFileReader.h"
 
@@ -99,11 +100,17 @@ public:
     virtual bool DumpReaderMeta(bool isRotatorReader, bool checkConfigFlag);
     bool IsAllFileRead() override;
 
+    // HasReader returns true if a reader of devInode exists, it may be a rotator reader.
+    bool HasReader(const DevInode& devInode) const;
+    // HasReaderOfName returns true if the reader queue of file name is not empty.
+    bool HasReaderOfName(const std::string& name) const;
+
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class ConfigUpdatorUnittest;
     friend class EventDispatcherTest;
     friend class SenderUnittest;
     friend class ModifyHandlerUnittest;
+    friend class CreateModifyHandlerUnittest;
 #endif
 };
 
@@ -138,14 +145,22 @@ class CreateModifyHandler : public EventHandler {
 private:
     CreateHandler* mCreateHandlerPtr;
     typedef std::unordered_map<std::string, ModifyHandler*> ModifyHandlerMap;
+    // modify handlers of shard 0, and of shard 1 ~ shard count - 1 in mShardModifyHandlerPtrMaps
     ModifyHandlerMap mModifyHandlerPtrMap;
+    std::vector<ModifyHandlerMap> mShardModifyHandlerPtrMaps;
+
+    ModifyHandlerMap& GetModifyHandlerMap(size_t shard) {
+        return shard == 0 ? mModifyHandlerPtrMap : mShardModifyHandlerPtrMaps[shard - 1];
+    }
+    size_t GetHandlerShardCount() const { return mShardModifyHandlerPtrMaps.size() + 1; }
 
     // no copy
     CreateModifyHandler(const CreateModifyHandler&);
     CreateModifyHandler& operator=(const CreateModifyHandler&);
 
 public:
-    CreateModifyHandler(CreateHandler* createHandler) : mCreateHandlerPtr(createHandler) {}
+    CreateModifyHandler(CreateHandler* createHandler)
+        : mCreateHandlerPtr(createHandler), mShardModifyHandlerPtrMaps(GetShardCount() - 1) {}
 
     virtual ~CreateModifyHandler();
     virtual void Handle(const Event& event);
@@ -153,7 +168,23 @@ public:
     virtual bool DumpReaderMeta(bool isRotatorReader, bool checkConfigFlag);
     bool IsAllFileRead() override;
 
-    ModifyHandler* GetOrCreateModifyHandler(const std::string& configName, const FileDiscoveryConfig& pConfig);
+    ModifyHandler* GetOrCreateModifyHandler(const std::string& configName,
+                                            const FileDiscoveryConfig& pConfig,
+                                            size_t shard = 0);
+
+    // Readers of files are split into shards by dev inode, each shard has its own modify handlers, so MODIFY events
+    // of different shards can be handled by different threads at the same time, see flag
+    // modify_handler_thread_count. A file rotated keeps its shard, and a new file with the name of a file which still
+    // has readers joins their shard, so the reader queue of a file name never spans shards.
+    static size_t GetShardCount();
+
+    // SelectShard returns the shard which owns, or will own, the reader of the file of event.
+    // @devInode is set to the dev inode of the file, it is invalid if the file can not be stat.
+    virtual size_t SelectShard(const Event& event, DevInode& devInode);
+
+    // HandleInShard handles a file event by modify handlers of shard. It may be called by different threads for
+    // different shards at the same time, and must not be called with Handle at the same time.
+    virtual void HandleInShard(const Event& event, size_t shard);
 
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class CreateModifyHandlerUnittest;
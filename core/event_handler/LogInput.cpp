@@ -16,16 +16,18 @@
 
 #include <time.h>
 
+#include <unordered_map>
+
 #include "EventHandler.h"
 #include "HistoryFileImporter.h"
 #include "app_config/AppConfig.h"
 #include "application/Application.h"
 #include "checkpoint/CheckPointManager.h"
 #include "common/FileSystemUtil.h"
-#include "common/HashUtil.h"
 #include "common/LogtailCommonFlags.h"
 #include "common/RuntimeUtil.h"
 #include "common/StringTools.h"
+#include "common/ThreadPool.h"
 #include "common/TimeUtil.h"
 #include "config_manager/ConfigManager.h"
 #include "controller/EventDispatcher.h"
@@ -33,6 +35,7 @@
 #include "logger/Logger.h"
 #include "monitor/LogtailAlarm.h"
 #include "monitor/Monitor.h"
+#include "monitor/SamplingProfiler.h"
 #include "polling/PollingCache.h"
 #include "polling/PollingDirFile.h"
 #include "polling/PollingEventQueue.h"
@@ -57,6 +60,9 @@ DEFINE_FLAG_INT32(dump_inotify_watcher_interval, "seconds", 180);
 DEFINE_FLAG_INT32(clear_config_match_interval, "seconds", 600);
 DEFINE_FLAG_INT32(check_block_event_interval, "seconds", 1);
 DEFINE_FLAG_STRING(local_event_data_file_name, "local event data file name", "local_event.json");
+DEFINE_FLAG_INT32(modify_handler_batch_size,
+                  "max number of events popped at once when files are read by multiple threads",
+                  1000);
 DEFINE_FLAG_INT32(read_local_event_interval, "seconds", 60);
 DEFINE_FLAG_BOOL(force_close_file_on_container_stopped,
                  "whether close file handler immediately when associate container stopped",
@@ -66,6 +72,10 @@ DECLARE_FLAG_BOOL(send_prefer_real_ip);
 
 
 namespace logtail {
+
+// set in threads which handle events of reader shards, they must not read fs events
+static thread_local bool sIsShardThread = false;
+
 LogInput::LogInput() : mAccessMainThreadRWL(ReadWriteLock::PREFER_WRITER) {
     mCheckBaseDirInterval = INT32_FLAG(check_base_dir_interval);
     mCheckSymbolicLinkInterval = INT32_FLAG(check_symbolic_link_interval);
@@ -74,6 +84,7 @@ LogInput::LogInput() : mAccessMainThreadRWL(ReadWriteLock::PREFER_WRITER) {
     mIdleFlag = false;
     mEventProcessCount = 0;
     mLastUpdateMetricTime = 0;
+    mShardEventVecs.resize(CreateModifyHandler::GetShardCount());
 }
 
 LogInput::~LogInput() {
@@ -112,7 +123,7 @@ void LogInput::HoldOn() {
 }
 
 void LogInput::TryReadEvents(bool forceRead) {
-    if (mInteruptFlag)
+    if (mInteruptFlag || sIsShardThread)
         return;
 
     if (!forceRead) {
@@ -148,10 +159,11 @@ void LogInput::TryReadEvents(bool forceRead) {
 void LogInput::FlowControl() {
     const static int32_t FLOW_CONTROL_SLEEP_MICROSECONDS = 20 * 1000; // 20ms
     const static int32_t MAX_SLEEP_COUNT = 50; // 1s
-    static int32_t sleepCount = 10;
-    static int32_t lastCheckTime = 0;
+    // Readers of different shards flow control at the same time, see modify_handler_thread_count.
+    static std::atomic<int32_t> sleepCount{10};
+    static std::atomic<int32_t> lastCheckTime{0};
     int32_t i = 0;
-    while (i < sleepCount) {
+    while (i < sleepCount.load(std::memory_order_relaxed)) {
         if (mInteruptFlag)
             return;
         usleep(FLOW_CONTROL_SLEEP_MICROSECONDS);
@@ -163,34 +175,37 @@ void LogInput::FlowControl() {
     if (mInteruptFlag)
         return;
     int32_t curTime = time(NULL);
-    if (curTime - lastCheckTime >= 1) {
-        lastCheckTime = curTime;
+    int32_t checkTime = lastCheckTime.load();
+    // only one thread adjusts the sleep count each second
+    if (curTime - checkTime >= 1 && lastCheckTime.compare_exchange_strong(checkTime, curTime)) {
+        int32_t count = sleepCount.load(std::memory_order_relaxed);
         double cpuUsageLevel = LogtailMonitor::GetInstance()->GetRealtimeCpuLevel();
         if (cpuUsageLevel >= 1.5) {
-            sleepCount += 5;
-            if (sleepCount > MAX_SLEEP_COUNT)
-                sleepCount = MAX_SLEEP_COUNT;
+            count += 5;
+            if (count > MAX_SLEEP_COUNT)
+                count = MAX_SLEEP_COUNT;
         } else if (cpuUsageLevel >= 1.2) {
-            sleepCount += 2;
-            if (sleepCount > MAX_SLEEP_COUNT)
-                sleepCount = MAX_SLEEP_COUNT;
+            count += 2;
+            if (count > MAX_SLEEP_COUNT)
+                count = MAX_SLEEP_COUNT;
         } else if (cpuUsageLevel >= 1.0) {
-            if (sleepCount < MAX_SLEEP_COUNT)
-                ++sleepCount;
+            if (count < MAX_SLEEP_COUNT)
+                ++count;
         } else if (cpuUsageLevel >= 0.9) {
         } else if (cpuUsageLevel >= 0.6) {
-            if (sleepCount > 0)
-                --sleepCount;
+            if (count > 0)
+                --count;
         } else if (cpuUsageLevel >= 0.3) {
-            sleepCount -= 2;
-            if (sleepCount < 0)
-                sleepCount = 0;
+            count -= 2;
+            if (count < 0)
+                count = 0;
         } else {
-            sleepCount -= 5;
-            if (sleepCount < 0)
-                sleepCount = 0;
+            count -= 5;
+            if (count < 0)
+                count = 0;
         }
-        LOG_DEBUG(sLogger, ("cpuUsageLevel", cpuUsageLevel)("sleepCount", sleepCount));
+        sleepCount.store(count, std::memory_order_relaxed);
+        LOG_DEBUG(sLogger, ("cpuUsageLevel", cpuUsageLevel)("sleepCount", count));
     }
 }
 
@@ -342,8 +357,36 @@ void LogInput::UpdateCriticalMetric(int32_t curTime) {
 
     LogtailMonitor::GetInstance()->UpdateMetric("event_tps",
                                                 1.0 * mEventProcessCount / (curTime - mLastUpdateMetricTime));
-    LogtailMonitor::GetInstance()->UpdateMetric("open_fd",
-                                                GloablFileDescriptorManager::GetInstance()->GetOpenedFilePtrSize());
+    // Events pushed to queue and merged into pending MODIFY events, events processed are counted by event_tps.
+    uint64_t pushCount = 0;
+    uint64_t coalescedCount = 0;
+    {
+        lock_guard<mutex> lock(mEventQueueMux);
+        pushCount = mInotifyEventQueue.GetPushCount();
+        coalescedCount = mInotifyEventQueue.GetCoalescedCount();
+    }
+    LogtailMonitor::GetInstance()->UpdateMetric(
+        "event_in_tps", 1.0 * (pushCount - mLastEventPushCount) / (curTime - mLastUpdateMetricTime));
+    LogtailMonitor::GetInstance()->UpdateMetric(
+        "event_coalesced_tps", 1.0 * (coalescedCount - mLastEventCoalescedCount) / (curTime - mLastUpdateMetricTime));
+    mLastEventPushCount = pushCount;
+    mLastEventCoalescedCount = coalescedCount;
+    GloablFileDescriptorManager* fdManager = GloablFileDescriptorManager::GetInstance();
+    LogtailMonitor::GetInstance()->UpdateMetric("open_fd", fdManager->GetOpenedFilePtrSize());
+    // Opens avoided are uses of files kept open, see GloablFileDescriptorManager.
+    uint64_t fileOpenCount = fdManager->GetOpenCount();
+    uint64_t fileOpenAvoidedCount = fdManager->GetAvoidedOpenCount();
+    uint64_t fileEvictCount = fdManager->GetEvictCount();
+    LogtailMonitor::GetInstance()->UpdateMetric(
+        "file_open_tps", 1.0 * (fileOpenCount - mLastFileOpenCount) / (curTime - mLastUpdateMetricTime));
+    LogtailMonitor::GetInstance()->UpdateMetric("file_open_avoided_tps",
+                                                1.0 * (fileOpenAvoidedCount - mLastFileOpenAvoidedCount)
+                                                    / (curTime - mLastUpdateMetricTime));
+    LogtailMonitor::GetInstance()->UpdateMetric(
+        "file_evict_tps", 1.0 * (fileEvictCount - mLastFileEvictCount) / (curTime - mLastUpdateMetricTime));
+    mLastFileOpenCount = fileOpenCount;
+    mLastFileOpenAvoidedCount = fileOpenAvoidedCount;
+    mLastFileEvictCount = fileEvictCount;
     LogtailMonitor::GetInstance()->UpdateMetric("register_handler", EventDispatcher::GetInstance()->GetHandlerCount());
     LogtailMonitor::GetInstance()->UpdateMetric("reader_count", CheckPointManager::Instance()->GetReaderCount());
     LogtailMonitor::GetInstance()->UpdateMetric("multi_config", AppConfig::GetInstance()->IsAcceptMultiConfig());
@@ -351,6 +394,7 @@ void LogInput::UpdateCriticalMetric(int32_t curTime) {
 }
 
 void* LogInput::ProcessLoop() {
+    SamplingProfiler::SetThreadRole("dispatcher");
     LOG_INFO(sLogger, ("event handle daemon", "started"));
     EventDispatcher* dispatcher = EventDispatcher::GetInstance();
     dispatcher->StartTimeCount();
@@ -368,6 +412,7 @@ void* LogInput::ProcessLoop() {
     mLastUpdateMetricTime = prevTime - rand() % 60;
     int32_t lastCheckBlockedTime = prevTime;
     int32_t lastReadLocalEventTime = prevTime;
+    int32_t lastEvictFileTime = prevTime;
     mEventProcessCount = 0;
     BlockedEventManager* pBlockedEventManager = BlockedEventManager::GetInstance();
     LogProcess::GetInstance()->SetFeedBack(pBlockedEventManager);
@@ -375,20 +420,31 @@ void* LogInput::ProcessLoop() {
     while (true) {
         ReadLock lock(mAccessMainThreadRWL);
         TryReadEvents(false);
-        Event* ev = PopEventQueue();
-        if (ev != NULL) {
-            ++mEventProcessCount;
-            if (mIdleFlag)
-                delete ev;
-            else
-                ProcessEvent(dispatcher, ev);
-        } else
-            usleep(INT32_FLAG(log_input_thread_wait_interval));
+        if (mShardEventVecs.size() > 1) {
+            if (ProcessEventBatch(dispatcher) == 0)
+                usleep(INT32_FLAG(log_input_thread_wait_interval));
+        } else {
+            Event* ev = PopEventQueue();
+            if (ev != NULL) {
+                ++mEventProcessCount;
+                if (mIdleFlag)
+                    delete ev;
+                else
+                    ProcessEvent(dispatcher, ev);
+            } else
+                usleep(INT32_FLAG(log_input_thread_wait_interval));
+        }
         if (mIdleFlag)
             continue;
 
         curTime = time(NULL);
 
+        // no reader is being read here
+        if (curTime != lastEvictFileTime) {
+            GloablFileDescriptorManager::GetInstance()->EvictOnPressure();
+            lastEvictFileTime = curTime;
+        }
+
 
         if (curTime - lastCheckBlockedTime >= INT32_FLAG(check_block_event_interval)) {
             std::vector<Event*> pEventVec;
@@ -464,64 +520,111 @@ void* LogInput::ProcessLoop() {
     return NULL;
 }
 
+int32_t LogInput::ProcessEventBatch(EventDispatcher* dispatcher) {
+    int32_t count = 0;
+    bool hasShardEvents = false;
+    unordered_map<string, size_t> pathShardMap;
+    for (; count < INT32_FLAG(modify_handler_batch_size); ++count) {
+        Event* ev = PopEventQueue();
+        if (ev == NULL)
+            break;
+        ++mEventProcessCount;
+        if (mIdleFlag) {
+            delete ev;
+            continue;
+        }
+        CreateModifyHandler* handler = NULL;
+        if (ev->IsModify() && !ev->IsDir() && !ev->IsTimeout() && !ev->IsContainerStopped()) {
+            handler = dynamic_cast<CreateModifyHandler*>(dispatcher->GetHandler(ev->GetSource().c_str()));
+        }
+        if (handler == NULL) {
+            // events other than file MODIFY may change readers of any shard
+            if (hasShardEvents) {
+                RunShardEvents();
+                hasShardEvents = false;
+                pathShardMap.clear();
+            }
+            ProcessEvent(dispatcher, ev);
+            continue;
+        }
+        DevInode devInode;
+        size_t shard = handler->SelectShard(*ev, devInode);
+        // Readers of events before are not created yet, if the same file name has gone to another shard in this
+        // batch, e.g. a.log is rotated and created again, run them first so that the shard is decided by readers.
+        string path = ev->GetSource() + PATH_SEPARATOR + ev->GetObject();
+        auto pathIter = pathShardMap.find(path);
+        if (pathIter != pathShardMap.end() && pathIter->second != shard) {
+            RunShardEvents();
+            pathShardMap.clear();
+            shard = handler->SelectShard(*ev, devInode);
+        }
+        pathShardMap[path] = shard;
+        // save the stat done by SelectShard
+        ev->SetDev(devInode.dev);
+        ev->SetInode(devInode.inode);
+        mShardEventVecs[shard].emplace_back(handler, ev);
+        hasShardEvents = true;
+        dispatcher->PropagateTimeout(ev->GetSource().c_str());
+    }
+    if (hasShardEvents) {
+        RunShardEvents();
+    }
+    return count;
+}
+
+void LogInput::RunShardEvents() {
+    if (!mShardThreadPool) {
+        // The event processing thread handles shard 0 itself.
+        mShardThreadPool.reset(new ThreadPool(mShardEventVecs.size() - 1));
+        mShardThreadPool->Start();
+        LOG_INFO(sLogger, ("modify handler threads", "started")("thread count", mShardEventVecs.size()));
+    }
+    auto processShard = [this](size_t shard) {
+        for (auto& item : mShardEventVecs[shard]) {
+            item.first->HandleInShard(*item.second, shard);
+            delete item.second;
+        }
+        mShardEventVecs[shard].clear();
+    };
+    mutex finishMux;
+    condition_variable finishCV;
+    size_t runningCount = 0;
+    for (size_t shard = 1; shard < mShardEventVecs.size(); ++shard) {
+        if (mShardEventVecs[shard].empty()) {
+            continue;
+        }
+        ++runningCount;
+        mShardThreadPool->Add([&, shard]() {
+            sIsShardThread = true;
+            processShard(shard);
+            lock_guard<mutex> lock(finishMux);
+            if (--runningCount == 0) {
+                finishCV.notify_one();
+            }
+        });
+    }
+    processShard(0);
+    unique_lock<mutex> lock(finishMux);
+    finishCV.wait(lock, [&runningCount]() { return runningCount == 0; });
+}
+
 void LogInput::PushEventQueue(std::vector<Event*>& eventVec) {
+    lock_guard<mutex> lock(mEventQueueMux);
     for (std::vector<Event*>::iterator iter = eventVec.begin(); iter != eventVec.end(); ++iter) {
-        string key;
-        key.append((*iter)->GetSource())
-            .append(">")
-            .append((*iter)->GetObject())
-            .append(">")
-            .append(ToString((*iter)->GetDev()))
-            .append(">")
-            .append(ToString((*iter)->GetInode()))
-            .append(">")
-            .append((*iter)->GetConfigName());
-        int64_t hashKey = HashSignatureString(key.c_str(), key.size());
-        if ((*iter)->GetType() == EVENT_MODIFY) {
-            if (mModifyEventSet.find(hashKey) != mModifyEventSet.end()) {
-                delete (*iter);
-                *iter = NULL;
-                continue;
-            } else
-                mModifyEventSet.insert(hashKey);
+        if (!mInotifyEventQueue.Push(*iter)) {
+            *iter = NULL;
         }
-        mInotifyEventQueue.push(*iter);
-        (*iter)->SetHashKey(hashKey);
     }
 }
 
 void LogInput::PushEventQueue(Event* ev) {
-    string key;
-    key.append(ev->GetSource())
-        .append(">")
-        .append(ev->GetObject())
-        .append(">")
-        .append(ToString(ev->GetDev()))
-        .append(">")
-        .append(ToString(ev->GetInode()))
-        .append(">")
-        .append(ev->GetConfigName());
-    int64_t hashKey = HashSignatureString(key.c_str(), key.size());
-    if (ev->GetType() == EVENT_MODIFY) {
-        if (mModifyEventSet.find(hashKey) != mModifyEventSet.end()) {
-            delete ev;
-            return;
-        } else
-            mModifyEventSet.insert(hashKey);
-    }
-    ev->SetHashKey(hashKey);
-    mInotifyEventQueue.push(ev);
+    lock_guard<mutex> lock(mEventQueueMux);
+    mInotifyEventQueue.Push(ev);
 }
 
 Event* LogInput::PopEventQueue() {
-    if (mInotifyEventQueue.size() > 0) {
-        Event* ev = mInotifyEventQueue.front();
-        mInotifyEventQueue.pop();
-        if (ev->GetType() == EVENT_MODIFY)
-            mModifyEventSet.erase(ev->GetHashKey());
-        return ev;
-    }
-    return NULL;
+    lock_guard<mutex> lock(mEventQueueMux);
+    return mInotifyEventQueue.Pop();
 }
 
 #ifdef APSARA_UNIT_TEST_MAIN
@@ -534,7 +637,6 @@ void LogInput::CleanEnviroments() {
             break;
         delete ev;
     }
-    mModifyEventSet.clear();
 }
 #endif
 
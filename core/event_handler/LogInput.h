@@ -17,19 +17,24 @@
 #ifndef __LOG_ILOGTAIL_LOG_INPUT_H__
 #define __LOG_ILOGTAIL_LOG_INPUT_H__
 
+#include <atomic>
 #include <condition_variable>
-#include <queue>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "common/Lock.h"
 #include "common/LogRunnable.h"
+#include "event/CoalescingEventQueue.h"
 
 namespace logtail {
 
 class Event;
 class EventDispatcher;
+class CreateModifyHandler;
+class ThreadPool;
 
 class LogInput : public LogRunnable {
 public:
@@ -66,9 +71,23 @@ private:
     void ProcessEvent(EventDispatcher* dispatcher, Event* ev);
     Event* PopEventQueue();
     void UpdateCriticalMetric(int32_t curTime);
-
-    std::queue<Event*> mInotifyEventQueue;
-    std::unordered_set<int64_t> mModifyEventSet;
+    // ProcessEventBatch processes a batch of events when readers are sharded, file MODIFY events are handled by
+    // threads of their shards, and other events are handled in order after all events before them are done.
+    // It returns the number of events popped.
+    int32_t ProcessEventBatch(EventDispatcher* dispatcher);
+    void RunShardEvents();
+
+    // The queue is pushed by shard threads, see modify_handler_thread_count.
+    CoalescingEventQueue mInotifyEventQueue;
+    std::mutex mEventQueueMux;
+    typedef std::vector<std::pair<CreateModifyHandler*, Event*>> ShardEventVec;
+    std::vector<ShardEventVec> mShardEventVecs;
+    std::unique_ptr<ThreadPool> mShardThreadPool;
+    uint64_t mLastEventPushCount = 0;
+    uint64_t mLastEventCoalescedCount = 0;
+    uint64_t mLastFileOpenCount = 0;
+    uint64_t mLastFileOpenAvoidedCount = 0;
+    uint64_t mLastFileEvictCount = 0;
     ReadWriteLock mAccessMainThreadRWL;
     int32_t mCheckBaseDirInterval;
     int32_t mCheckSymbolicLinkInterval;
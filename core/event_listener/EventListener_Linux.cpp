@@ -13,9 +13,15 @@
 // limitations under the License.
 
 #include "EventListener_Linux.h"
+#include <fcntl.h>
+#include <sys/fanotify.h>
 #include <sys/inotify.h>
+#include <sys/statfs.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include "logger/Logger.h"
 #include "monitor/LogtailAlarm.h"
 #include "common/ErrorUtil.h"
@@ -24,39 +30,166 @@
 #include "event_handler/LogInput.h"
 
 DEFINE_FLAG_BOOL(fs_events_inotify_enable, "", true);
+DEFINE_FLAG_BOOL(fs_events_fanotify_enable,
+                 "watch whole filesystems by fanotify instead of an inotify watch per directory, it needs "
+                 "CAP_SYS_ADMIN and linux 5.9+, otherwise inotify is used",
+                 false);
+DEFINE_FLAG_INT32(fs_events_fanotify_read_buffer_size, "buffer size to read fanotify events", 256 * 1024);
 
 namespace logtail {
 
 const uint32_t EventListener::mWatchEventMask
     = IN_CREATE | IN_MODIFY | IN_MASK_ADD | IN_DELETE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE;
 
+#if defined(FAN_REPORT_DFID_NAME)
+static const uint64_t kFanotifyEventMask
+    = FAN_CREATE | FAN_MODIFY | FAN_DELETE | FAN_DELETE_SELF | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_ONDIR;
+#endif
+// Ids of inotify watches are small positive numbers, fanotify ids start from here to be distinguished from them.
+static const int kFanotifyIdBase = 1 << 30;
+
+static std::string GetFsidKey(const void* fsid) {
+    return std::string(static_cast<const char*>(fsid), sizeof(fsid_t));
+}
+
 logtail::EventListener::~EventListener() {
     Destroy();
 }
 
 bool logtail::EventListener::Init() {
     mInotifyFd = inotify_init();
-    return mInotifyFd != -1;
+    if (BOOL_FLAG(fs_events_fanotify_enable)) {
+        InitFanotify();
+    }
+    return mInotifyFd != -1 || mFanotifyFd != -1;
+}
+
+bool EventListener::InitFanotify() {
+#if defined(FAN_REPORT_DFID_NAME)
+    mFanotifyFd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_CLOEXEC | FAN_NONBLOCK, O_RDONLY);
+    if (mFanotifyFd == -1) {
+        // EPERM without CAP_SYS_ADMIN, EINVAL if the kernel does not support reporting by directory handle.
+        LOG_WARNING(sLogger, ("init fanotify failed, use inotify instead", ErrnoToString(GetErrno())));
+        return false;
+    }
+    LOG_INFO(sLogger, ("init fanotify", "succeeded"));
+    return true;
+#else
+    LOG_WARNING(sLogger, ("init fanotify failed, use inotify instead", "not supported by this build"));
+    return false;
+#endif
 }
 
-int logtail::EventListener::AddWatch(const char* dir) {
+int logtail::EventListener::AddWatch(const char* dir, bool inotifyAllowed) {
+    if (mFanotifyFd != -1) {
+        int wd = AddFanotifyWatch(dir);
+        if (wd != -1) {
+            return wd;
+        }
+    }
+    if (!inotifyAllowed || mInotifyFd == -1) {
+        errno = ENOSPC;
+        return -1;
+    }
     return inotify_add_watch(mInotifyFd, dir, mWatchEventMask);
-    ;
+}
+
+int EventListener::AddFanotifyWatch(const char* dir) {
+#if defined(FAN_REPORT_DFID_NAME)
+    struct statfs fsBuf;
+    if (statfs(dir, &fsBuf) != 0) {
+        return -1;
+    }
+    std::string fsidKey = GetFsidKey(&fsBuf.f_fsid);
+    union {
+        struct file_handle handle;
+        char buf[sizeof(struct file_handle) + MAX_HANDLE_SZ];
+    } fh;
+    fh.handle.handle_bytes = MAX_HANDLE_SZ;
+    int mountId = 0;
+    // Registered directories may be symbolic links, which are followed like inotify does.
+    if (name_to_handle_at(AT_FDCWD, dir, &fh.handle, &mountId, AT_SYMLINK_FOLLOW) != 0) {
+        return -1;
+    }
+    std::string dirKey = fsidKey;
+    dirKey.append(reinterpret_cast<const char*>(&fh.handle.handle_type), sizeof(fh.handle.handle_type));
+    dirKey.append(reinterpret_cast<const char*>(fh.handle.f_handle), fh.handle.handle_bytes);
+
+    std::lock_guard<std::mutex> lock(mFanotifyMutex);
+    auto fsIter = mFanotifyFilesystemMap.find(fsidKey);
+    if (fsIter == mFanotifyFilesystemMap.end()) {
+        bool marked = fanotify_mark(mFanotifyFd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, kFanotifyEventMask, AT_FDCWD, dir)
+            == 0;
+        if (marked) {
+            LOG_INFO(sLogger, ("watch filesystem by fanotify, dir", dir));
+        } else {
+            // e.g. filesystems without fsid, dirs on them are watched by inotify.
+            LOG_WARNING(sLogger,
+                        ("failed to watch filesystem by fanotify, use inotify instead, dir",
+                         dir)("reason", ErrnoToString(GetErrno())));
+        }
+        fsIter = mFanotifyFilesystemMap.emplace(fsidKey, marked).first;
+    }
+    if (!fsIter->second) {
+        return -1;
+    }
+
+    return AddFanotifyDir(dirKey);
+#else
+    return -1;
+#endif
+}
+
+int EventListener::AddFanotifyDir(const std::string& dirKey) {
+    // A directory referred by several paths has one id, the same as inotify.
+    auto dirIter = mFanotifyDirMap.find(dirKey);
+    if (dirIter != mFanotifyDirMap.end()) {
+        return dirIter->second;
+    }
+    // Ids wrap around in a long running process, those still in use are skipped.
+    int wd = -1;
+    do {
+        if (mNextFanotifyId < 0 || mNextFanotifyId >= INT_MAX - kFanotifyIdBase) {
+            mNextFanotifyId = 0;
+        }
+        wd = kFanotifyIdBase + mNextFanotifyId++;
+    } while (mFanotifyIdMap.find(wd) != mFanotifyIdMap.end());
+    mFanotifyDirMap[dirKey] = wd;
+    mFanotifyIdMap[wd] = dirKey;
+    return wd;
 }
 
 bool logtail::EventListener::RemoveWatch(int wd) {
+    if (IsFanotifyID(wd)) {
+        // The filesystem keeps watched, events of the directory are dropped since then.
+        std::lock_guard<std::mutex> lock(mFanotifyMutex);
+        auto iter = mFanotifyIdMap.find(wd);
+        if (iter == mFanotifyIdMap.end()) {
+            return false;
+        }
+        mFanotifyDirMap.erase(iter->second);
+        mFanotifyIdMap.erase(iter);
+        return true;
+    }
     return inotify_rm_watch(mInotifyFd, wd) != -1;
 }
 
+bool EventListener::IsFanotifyID(int id) {
+    return id >= kFanotifyIdBase;
+}
+
 int32_t logtail::EventListener::ReadEvents(std::vector<logtail::Event*>& eventVec) {
     eventVec.clear();
+    if (mFanotifyFd >= 0) {
+        ReadFanotifyEvents(eventVec);
+    }
     if (mInotifyFd < 0) {
-        return 0;
+        return (int32_t)eventVec.size();
     }
     int len = 0;
     ioctl(mInotifyFd, FIONREAD, &len);
     if (len < 1)
-        return 0;
+        return (int32_t)eventVec.size();
     static char* s_lastHalfEventBuf = new char[65536];
     static int32_t s_lastHalfEventSize = 0;
 
@@ -68,7 +201,7 @@ int32_t logtail::EventListener::ReadEvents(std::vector<logtail::Event*>& eventVe
     if (readLen == 0) {
         LOG_ERROR(sLogger, ("read inotify fd error", ErrnoToString(GetErrno()))("read len", len));
         delete[] buffer;
-        return 0;
+        return (int32_t)eventVec.size();
     }
     // update len
     len = readLen + s_lastHalfEventSize;
@@ -122,13 +255,114 @@ int32_t logtail::EventListener::ReadEvents(std::vector<logtail::Event*>& eventVe
     return (int32_t)eventVec.size();
 }
 
+void EventListener::ReadFanotifyEvents(std::vector<Event*>& eventVec) {
+#if defined(FAN_REPORT_DFID_NAME)
+    static EventDispatcher* dispatcher = EventDispatcher::GetInstance();
+    mFanotifyBuffer.resize(std::max(INT32_FLAG(fs_events_fanotify_read_buffer_size), 4096));
+    // Events of a whole filesystem may keep coming, so the number of reads is limited to leave time for others.
+    for (int readCount = 0; readCount < 16; ++readCount) {
+        // Only whole events are returned by read, there are no half events like inotify.
+        ssize_t len = read(mFanotifyFd, mFanotifyBuffer.data(), mFanotifyBuffer.size());
+        if (len <= 0) {
+            if (len < 0 && errno != EAGAIN && errno != EINTR) {
+                LOG_ERROR(sLogger, ("read fanotify fd error", ErrnoToString(GetErrno())));
+            }
+            break;
+        }
+        if (!BOOL_FLAG(fs_events_inotify_enable) || LogInput::GetInstance()->IsInterupt()) {
+            continue;
+        }
+
+        size_t begin = eventVec.size();
+        ParseFanotifyEvents(mFanotifyBuffer.data(), len, eventVec);
+        size_t end = begin;
+        for (size_t i = begin; i < eventVec.size(); ++i) {
+            std::string path;
+            if (dispatcher->IsRegistered(eventVec[i]->GetWd(), path)) {
+                eventVec[i]->SetSource(path);
+                eventVec[end++] = eventVec[i];
+            } else {
+                delete eventVec[i];
+            }
+        }
+        eventVec.resize(end);
+    }
+#endif
+}
+
+void EventListener::ParseFanotifyEvents(const char* buf, size_t size, std::vector<Event*>& eventVec) {
+#if defined(FAN_REPORT_DFID_NAME)
+    ssize_t len = size;
+    std::lock_guard<std::mutex> lock(mFanotifyMutex);
+    auto metadata = reinterpret_cast<const struct fanotify_event_metadata*>(buf);
+    for (; FAN_EVENT_OK(metadata, len); metadata = FAN_EVENT_NEXT(metadata, len)) {
+        if (metadata->vers != FANOTIFY_METADATA_VERSION) {
+            LOG_ERROR(sLogger, ("unsupported fanotify metadata version", (int)metadata->vers));
+            break;
+        }
+        if (metadata->fd >= 0) {
+            close(metadata->fd);
+        }
+        if (metadata->mask & FAN_Q_OVERFLOW) {
+            LOG_INFO(sLogger, ("fanotify event queue overflow", "miss fanotify events"));
+            LogtailAlarm::GetInstance()->SendAlarm(INOTIFY_EVENT_OVERFLOW_ALARM, "fanotify event queue overflow");
+            continue;
+        }
+        if (metadata->event_len < metadata->metadata_len + sizeof(struct fanotify_event_info_fid)) {
+            continue;
+        }
+        auto fid = reinterpret_cast<const struct fanotify_event_info_fid*>(reinterpret_cast<const char*>(metadata)
+                                                                           + metadata->metadata_len);
+        if (fid->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME && fid->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID) {
+            continue;
+        }
+        auto handle = reinterpret_cast<const struct file_handle*>(fid->handle);
+        std::string dirKey = GetFsidKey(&fid->fsid);
+        dirKey.append(reinterpret_cast<const char*>(&handle->handle_type), sizeof(handle->handle_type));
+        dirKey.append(reinterpret_cast<const char*>(handle->f_handle), handle->handle_bytes);
+        auto dirIter = mFanotifyDirMap.find(dirKey);
+        if (dirIter == mFanotifyDirMap.end()) {
+            continue;
+        }
+        // Events of the directory itself have no name or name ".".
+        const char* name = "";
+        if (fid->hdr.info_type == FAN_EVENT_INFO_TYPE_DFID_NAME) {
+            name = reinterpret_cast<const char*>(handle->f_handle) + handle->handle_bytes;
+            if (strcmp(name, ".") == 0) {
+                name = "";
+            }
+        }
+
+        EventType etype = 0;
+        etype |= metadata->mask & FAN_DELETE_SELF ? EVENT_TIMEOUT : 0;
+        etype |= metadata->mask & FAN_CREATE ? EVENT_CREATE : 0;
+        etype |= metadata->mask & FAN_MODIFY ? EVENT_MODIFY : 0;
+        etype |= metadata->mask & FAN_ONDIR ? EVENT_ISDIR : 0;
+        etype |= metadata->mask & FAN_MOVED_FROM ? EVENT_MOVE_FROM : 0;
+        etype |= metadata->mask & FAN_MOVED_TO ? EVENT_MOVE_TO : 0;
+        etype |= metadata->mask & FAN_DELETE ? EVENT_DELETE : 0;
+        // fanotify does not pair renames by cookie.
+        if (etype != 0)
+            eventVec.push_back(new Event("", name, etype, dirIter->second, 0));
+    }
+#endif
+}
+
 bool logtail::EventListener::IsInit() {
-    return mInotifyFd != -1;
+    return mInotifyFd != -1 || mFanotifyFd != -1;
 }
 
 void logtail::EventListener::Destroy() {
     if (mInotifyFd >= 0)
         close(mInotifyFd);
+    mInotifyFd = -1;
+    if (mFanotifyFd >= 0)
+        close(mFanotifyFd);
+    mFanotifyFd = -1;
+    std::lock_guard<std::mutex> lock(mFanotifyMutex);
+    mFanotifyDirMap.clear();
+    mFanotifyIdMap.clear();
+    mFanotifyFilesystemMap.clear();
 }
 
 bool EventListener::IsValidID(int id) {
@@ -17,7 +17,9 @@
 #ifndef LOGTAIL_EVENTLISTENER_H
 #define LOGTAIL_EVENTLISTENER_H
 
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "event/Event.h"
 
@@ -40,14 +42,51 @@ public:
     static bool IsValidID(int id);
     static const uint32_t mWatchEventMask;
 
-    int AddWatch(const char* dir);
+    // IsFanotifyInit returns true if whole filesystems can be watched by fanotify (flag fs_events_fanotify_enable),
+    // so that the number of watched directories is not limited by inotify watches.
+    bool IsFanotifyInit() const { return mFanotifyFd != -1; }
+    // IsFanotifyID returns true if the watch is a directory on a filesystem watched by fanotify.
+    static bool IsFanotifyID(int id);
+
+    // AddWatch watches dir by fanotify if its filesystem can be watched, otherwise by inotify.
+    // @inotifyAllowed: false if no more inotify watches can be added, -1 is returned with errno ENOSPC if the
+    //   directory can not be watched by fanotify.
+    int AddWatch(const char* dir, bool inotifyAllowed = true);
     bool RemoveWatch(int wd);
 
     int32_t ReadEvents(std::vector<Event*>& eventVec);
 
 private:
     EventListener() = default;
+
+    bool InitFanotify();
+    // AddFanotifyWatch returns the id of dir, or -1 if the filesystem of dir can not be watched by fanotify.
+    int AddFanotifyWatch(const char* dir);
+    // AddFanotifyDir returns the id of the directory with dirKey, a new one if it is not watched yet. The caller holds
+    // mFanotifyMutex.
+    int AddFanotifyDir(const std::string& dirKey);
+    void ReadFanotifyEvents(std::vector<Event*>& eventVec);
+    // ParseFanotifyEvents appends the events of watched directories in buf to eventVec. Their source is left empty to
+    // be filled by the caller from the watch id.
+    void ParseFanotifyEvents(const char* buf, size_t size, std::vector<Event*>& eventVec);
+
     int32_t mInotifyFd = -1;
+
+    // fanotify reports events of a whole filesystem with the file handle of the parent directory, which is mapped
+    // back to the watch id of a registered directory, events of other directories are dropped.
+    int32_t mFanotifyFd = -1;
+    std::mutex mFanotifyMutex;
+    // Key is fsid and file handle of directory.
+    std::unordered_map<std::string, int> mFanotifyDirMap;
+    std::unordered_map<int, std::string> mFanotifyIdMap;
+    // Filesystems by fsid, false if it can not be watched (e.g. no permission or no fsid), so dirs on it use inotify.
+    std::unordered_map<std::string, bool> mFanotifyFilesystemMap;
+    int mNextFanotifyId = 0;
+    std::vector<char> mFanotifyBuffer;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class EventListenerUnittest;
+#endif
 };
 
 } // namespace logtail
@@ -34,7 +34,7 @@ bool EventListener::IsValidID(int id) {
     return id >= 0;
 }
 
-int EventListener::AddWatch(const char* dir) {
+int EventListener::AddWatch(const char* dir, bool inotifyAllowed) {
     static int counter = 0;
     auto ret = counter++;
     return (ret >= 0) ? ret : 0;
@@ -37,7 +37,10 @@ public:
 
     static bool IsValidID(int id);
 
-    int AddWatch(const char* dir);
+    bool IsFanotifyInit() const { return false; }
+    static bool IsFanotifyID(int id) { return false; }
+
+    int AddWatch(const char* dir, bool inotifyAllowed = true);
     bool RemoveWatch(int wd);
 
     int32_t ReadEvents(std::vector<Event*>& eventVec);
@@ -0,0 +1,158 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "file_server/FileDiscoveryIndex.h"
+
+#include <algorithm>
+
+#include "common/FileSystemUtil.h"
+
+using namespace std;
+
+namespace logtail {
+
+void FileDiscoveryIndex::Add(const string& name, const FileDiscoveryConfig& config) {
+    Remove(name);
+    mNameOptionsMap[name] = config.first;
+    mGenerations[config.first] = ++mLastGeneration;
+    string prefix;
+    if (config.first == nullptr || !GetIndexPrefix(*config.first, prefix)) {
+        mUnindexedConfigs.emplace_back(name, config);
+        mNameKeyMap[name] = make_pair(false, string());
+        return;
+    }
+    Node* node = &mRoot;
+    size_t begin = 0;
+    while (begin < prefix.size()) {
+        size_t end = prefix.find(PATH_SEPARATOR[0], begin);
+        if (end == string::npos) {
+            end = prefix.size();
+        }
+        if (end > begin) {
+            unique_ptr<Node>& child = node->mChildren[prefix.substr(begin, end - begin)];
+            if (!child) {
+                child.reset(new Node());
+            }
+            node = child.get();
+        }
+        begin = end + 1;
+    }
+    node->mConfigs.emplace_back(name, config);
+    mNameKeyMap[name] = make_pair(true, prefix);
+}
+
+void FileDiscoveryIndex::Remove(const string& name) {
+    auto iter = mNameKeyMap.find(name);
+    if (iter == mNameKeyMap.end()) {
+        return;
+    }
+    auto optionsIter = mNameOptionsMap.find(name);
+    if (optionsIter != mNameOptionsMap.end()) {
+        mGenerations.erase(optionsIter->second);
+        mNameOptionsMap.erase(optionsIter);
+    }
+    if (!iter->second.first) {
+        RemoveFrom(mUnindexedConfigs, name);
+        mNameKeyMap.erase(iter);
+        return;
+    }
+    // Empty nodes are left in the trie, they are few since configs are rarely removed.
+    const string& prefix = iter->second.second;
+    Node* node = &mRoot;
+    size_t begin = 0;
+    while (node != nullptr && begin < prefix.size()) {
+        size_t end = prefix.find(PATH_SEPARATOR[0], begin);
+        if (end == string::npos) {
+            end = prefix.size();
+        }
+        if (end > begin) {
+            auto child = node->mChildren.find(prefix.substr(begin, end - begin));
+            node = child == node->mChildren.end() ? nullptr : child->second.get();
+        }
+        begin = end + 1;
+    }
+    if (node != nullptr) {
+        RemoveFrom(node->mConfigs, name);
+    }
+    mNameKeyMap.erase(iter);
+}
+
+void FileDiscoveryIndex::Clear() {
+    mRoot.mChildren.clear();
+    mRoot.mConfigs.clear();
+    mUnindexedConfigs.clear();
+    mNameKeyMap.clear();
+    mNameOptionsMap.clear();
+    mGenerations.clear();
+}
+
+void FileDiscoveryIndex::FindCandidates(const string& path, vector<FileDiscoveryConfig>& candidates) const {
+    for (const auto& item : mUnindexedConfigs) {
+        candidates.push_back(item.second);
+    }
+    const Node* node = &mRoot;
+    string component;
+    size_t begin = 0;
+    while (true) {
+        for (const auto& item : node->mConfigs) {
+            candidates.push_back(item.second);
+        }
+        // skip empty components, e.g. the leading one of absolute paths
+        while (begin < path.size() && path[begin] == PATH_SEPARATOR[0]) {
+            ++begin;
+        }
+        if (begin >= path.size()) {
+            break;
+        }
+        size_t end = path.find(PATH_SEPARATOR[0], begin);
+        if (end == string::npos) {
+            end = path.size();
+        }
+        component.assign(path, begin, end - begin);
+        auto child = node->mChildren.find(component);
+        if (child == node->mChildren.end()) {
+            break;
+        }
+        node = child->second.get();
+        begin = end;
+    }
+}
+
+bool FileDiscoveryIndex::GetIndexPrefix(const FileDiscoveryOptions& options, string& prefix) {
+    if (options.IsContainerDiscoveryEnabled()) {
+        return false;
+    }
+    const auto& wildcardPaths = options.GetWildcardPaths();
+    if (wildcardPaths.empty()) {
+        // compared with memcmp, see _IsPathMatched
+        prefix = options.GetBasePath();
+        return true;
+    }
+    // compared with fnmatch, so the prefix is only literal without bracket expressions and escapes
+    prefix = wildcardPaths[0];
+#if defined(__linux__)
+    return prefix.find_first_of("[\\") == string::npos;
+#else
+    return prefix.find('[') == string::npos;
+#endif
+}
+
+void FileDiscoveryIndex::RemoveFrom(vector<pair<string, FileDiscoveryConfig>>& configs, const string& name) {
+    configs.erase(remove_if(configs.begin(),
+                            configs.end(),
+                            [&name](const pair<string, FileDiscoveryConfig>& item) { return item.first == name; }),
+                  configs.end());
+}
+
+} // namespace logtail
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "file_server/FileDiscoveryOptions.h"
+
+namespace logtail {
+
+// FileDiscoveryIndex is a trie of path components built from the constant prefix of each config's base path, i.e.
+// the base path itself or the part before the first wildcard directory. A path can only match configs whose prefix
+// is one of its ancestors, so finding the candidates of a path walks the trie once along its components instead of
+// running IsMatch on every config. Configs with container discovery match container paths which are not known when
+// indexing, so they are always candidates.
+//
+// Candidates still need FileDiscoveryOptions::IsMatch for wildcards, blacklists, depth and file pattern.
+//
+// Every added config gets a new generation, so that results cached for a config can be checked against the current
+// one by GetGeneration without touching the config, which may have been destroyed.
+//
+// Not thread safe, it is only modified when configs are updated.
+class FileDiscoveryIndex {
+public:
+    void Add(const std::string& name, const FileDiscoveryConfig& config);
+    void Remove(const std::string& name);
+    void Clear();
+
+    // FindCandidates appends configs which may match files in dir path to candidates.
+    void FindCandidates(const std::string& path, std::vector<FileDiscoveryConfig>& candidates) const;
+
+    size_t Size() const { return mNameKeyMap.size(); }
+
+    // GetGeneration returns 0 if options is not added.
+    uint64_t GetGeneration(const FileDiscoveryOptions* options) const {
+        auto iter = mGenerations.find(options);
+        return iter == mGenerations.end() ? 0 : iter->second;
+    }
+
+    // GetIndexPrefix returns false if the config can not be indexed by path.
+    static bool GetIndexPrefix(const FileDiscoveryOptions& options, std::string& prefix);
+
+private:
+    struct Node {
+        std::unordered_map<std::string, std::unique_ptr<Node>> mChildren;
+        std::vector<std::pair<std::string, FileDiscoveryConfig>> mConfigs;
+    };
+
+    static void RemoveFrom(std::vector<std::pair<std::string, FileDiscoveryConfig>>& configs, const std::string& name);
+
+    Node mRoot;
+    std::vector<std::pair<std::string, FileDiscoveryConfig>> mUnindexedConfigs;
+    // config name -> (indexed or not, prefix)
+    std::unordered_map<std::string, std::pair<bool, std::string>> mNameKeyMap;
+    std::unordered_map<std::string, const FileDiscoveryOptions*> mNameOptionsMap;
+    std::unordered_map<const FileDiscoveryOptions*, uint64_t> mGenerations;
+    uint64_t mLastGeneration = 0;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class FileDiscoveryIndexUnittest;
+#endif
+};
+
+} // namespace logtail
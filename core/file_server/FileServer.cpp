@@ -54,7 +54,6 @@ void FileServer::Pause(bool isConfigUpdate) {
         CheckPointManager::Instance()->DumpCheckPointToLocal();
         EventDispatcher::GetInstance()->ClearBrokenLinkSet();
         PollingDirFile::GetInstance()->ClearCache();
-        ConfigManager::GetInstance()->ClearFilePipelineMatchCache();
     }
 }
 
@@ -112,10 +111,15 @@ FileDiscoveryConfig FileServer::GetFileDiscoveryConfig(const string& name) const
 
 void FileServer::AddFileDiscoveryConfig(const string& name, FileDiscoveryOptions* opts, const PipelineContext* ctx) {
     mPipelineNameFileDiscoveryConfigsMap[name] = make_pair(opts, ctx);
+    mFileDiscoveryIndex.Add(name, make_pair(opts, ctx));
+    if (opts != nullptr) {
+        ConfigManager::GetInstance()->InvalidateFilePipelineMatchCache(*opts);
+    }
 }
 
 void FileServer::RemoveFileDiscoveryConfig(const string& name) {
     mPipelineNameFileDiscoveryConfigsMap.erase(name);
+    mFileDiscoveryIndex.Remove(name);
 }
 
 FileReaderConfig FileServer::GetFileReaderConfig(const string& name) const {
@@ -0,0 +1,115 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "go_pipeline/FlatLogGroup.h"
+
+#include <cstring>
+#include <limits>
+
+namespace logtail {
+
+namespace {
+
+class FlatBufferCursor {
+public:
+    FlatBufferCursor(char* base, size_t stringsOffset) : mBase(base), mStringsOffset(stringsOffset) {}
+
+    template <typename T>
+    void PutRecord(size_t& recordOffset, const T& record) {
+        memcpy(mBase + recordOffset, &record, sizeof(T));
+        recordOffset += sizeof(T);
+    }
+
+    FlatString PutString(const std::string& str) {
+        FlatString flat;
+        flat.offset = static_cast<uint32_t>(mStringsOffset);
+        flat.len = static_cast<uint32_t>(str.size());
+        if (!str.empty()) {
+            memcpy(mBase + mStringsOffset, str.data(), str.size());
+            mStringsOffset += str.size();
+        }
+        return flat;
+    }
+
+private:
+    char* mBase;
+    size_t mStringsOffset;
+};
+
+} // namespace
+
+bool FlatLogGroupWriter::Write(const sls_logs::LogGroup& logGroup) {
+    size_t contentCount = 0;
+    size_t stringBytes = logGroup.category().size() + logGroup.topic().size() + logGroup.source().size()
+        + logGroup.machineuuid().size();
+    for (const auto& log : logGroup.logs()) {
+        // values are not used by the pipeline, groups carrying them are left to protobuf
+        if (log.values_size() > 0) {
+            return false;
+        }
+        contentCount += log.contents_size();
+        for (const auto& content : log.contents()) {
+            stringBytes += content.key().size() + content.value().size();
+        }
+    }
+    for (const auto& tag : logGroup.logtags()) {
+        stringBytes += tag.key().size() + tag.value().size();
+    }
+    size_t stringsOffset = sizeof(FlatLogGroupHeader) + sizeof(FlatLog) * logGroup.logs_size()
+        + sizeof(FlatPair) * (contentCount + logGroup.logtags_size());
+    if (stringsOffset + stringBytes > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    // resize keeps the capacity, only the growth of the largest group allocates
+    mBuffer.resize(stringsOffset + stringBytes);
+
+    FlatBufferCursor cursor(&mBuffer[0], stringsOffset);
+    size_t recordOffset = 0;
+    FlatLogGroupHeader header;
+    header.magic = kFlatLogGroupMagic;
+    header.logCount = static_cast<uint32_t>(logGroup.logs_size());
+    header.contentCount = static_cast<uint32_t>(contentCount);
+    header.tagCount = static_cast<uint32_t>(logGroup.logtags_size());
+    header.category = cursor.PutString(logGroup.category());
+    header.topic = cursor.PutString(logGroup.topic());
+    header.source = cursor.PutString(logGroup.source());
+    header.machineUUID = cursor.PutString(logGroup.machineuuid());
+    cursor.PutRecord(recordOffset, header);
+
+    for (const auto& log : logGroup.logs()) {
+        FlatLog flatLog;
+        flatLog.time = log.time();
+        flatLog.timeNs = log.has_time_ns() ? log.time_ns() : 0;
+        flatLog.hasTimeNs = log.has_time_ns() ? 1 : 0;
+        flatLog.contentCount = static_cast<uint32_t>(log.contents_size());
+        cursor.PutRecord(recordOffset, flatLog);
+    }
+    for (const auto& log : logGroup.logs()) {
+        for (const auto& content : log.contents()) {
+            FlatPair pair;
+            pair.key = cursor.PutString(content.key());
+            pair.value = cursor.PutString(content.value());
+            cursor.PutRecord(recordOffset, pair);
+        }
+    }
+    for (const auto& tag : logGroup.logtags()) {
+        FlatPair pair;
+        pair.key = cursor.PutString(tag.key());
+        pair.value = cursor.PutString(tag.value());
+        cursor.PutRecord(recordOffset, pair);
+    }
+    return true;
+}
+
+} // namespace logtail
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "log_pb/sls_logs.pb.h"
+
+namespace logtail {
+
+// The flat log group is the format LogtailPlugin hands log groups to the Go plugin system in, the decoder is
+// pkg/protocol/sls_logs_flat.go. A group is a single buffer made of fixed size little endian records followed by the
+// bytes of all strings, so it is written without allocating per field and read on the Go side without parsing:
+//
+//   FlatLogGroupHeader
+//   FlatLog[logCount]
+//   FlatPair[contentCount]   contents of all logs in order, each log owns the next FlatLog::contentCount pairs
+//   FlatPair[tagCount]
+//   string bytes             FlatString offsets are relative to the start of the buffer
+//
+// Records are written in host order, which is little endian on all platforms the Go plugin system is built for.
+// Changes of the layout must bump kFlatLogGroupMagic and be made on both sides.
+static const uint32_t kFlatLogGroupMagic = 0x3146474c; // "LGF1"
+
+#pragma pack(push, 1)
+struct FlatString {
+    uint32_t offset;
+    uint32_t len;
+};
+
+struct FlatPair {
+    FlatString key;
+    FlatString value;
+};
+
+struct FlatLog {
+    uint32_t time;
+    uint32_t timeNs;
+    uint32_t hasTimeNs;
+    uint32_t contentCount;
+};
+
+struct FlatLogGroupHeader {
+    uint32_t magic;
+    uint32_t logCount;
+    uint32_t contentCount;
+    uint32_t tagCount;
+    FlatString category;
+    FlatString topic;
+    FlatString source;
+    FlatString machineUUID;
+};
+#pragma pack(pop)
+
+/**
+ * FlatLogGroupWriter encodes log groups into a buffer it keeps between groups, so a writer per thread encodes without
+ * allocating once the buffer has grown to the size of the largest group.
+ */
+class FlatLogGroupWriter {
+public:
+    /**
+     * @brief Write encodes logGroup, the result is valid until the next call.
+     * @return false if the group is too large for 32 bits offsets, nothing is written then.
+     */
+    bool Write(const sls_logs::LogGroup& logGroup);
+
+    const std::string& Buffer() const { return mBuffer; }
+
+private:
+    std::string mBuffer;
+};
+
+} // namespace logtail
@@ -20,6 +20,7 @@
 #include "common/TimeUtil.h"
 #include "config_manager/ConfigManager.h"
 #include "container_manager/DockerContainerPathCmd.h"
+#include "go_pipeline/FlatLogGroup.h"
 #include "logger/Logger.h"
 #include "monitor/LogFileProfiler.h"
 #include "monitor/LogtailAlarm.h"
@@ -30,6 +31,9 @@ DEFINE_FLAG_BOOL(enable_sls_metrics_format, "if enable format metrics in SLS met
 DEFINE_FLAG_BOOL(enable_containerd_upper_dir_detect,
                  "if enable containerd upper dir detect when locating rootfs",
                  false);
+DEFINE_FLAG_BOOL(enable_go_pipeline_flat_log_group,
+                 "if hand log groups to the Go plugin system in the flat format instead of protobuf",
+                 true);
 
 using namespace std;
 using namespace logtail;
@@ -44,6 +48,9 @@ LogtailPlugin::LogtailPlugin() {
     mResumeFun = NULL;
     mLoadGlobalConfigFun = NULL;
     mProcessRawLogFun = NULL;
+    mProcessLogsFun = NULL;
+    mProcessLogGroupFun = NULL;
+    mProcessLogGroupFlatFun = NULL;
     mPluginValid = false;
     mPluginAlarmConfig.mLogstore = "logtail_alarm";
     mPluginAlarmConfig.mAliuid = STRING_FLAG(logtail_profile_aliuid);
@@ -415,6 +422,11 @@ bool LogtailPlugin::LoadPluginBase() {
             LOG_ERROR(sLogger, ("load ProcessLogGroup error, Message", error));
             return mPluginValid;
         }
+        mProcessLogGroupFlatFun = (ProcessLogGroupFlatFun)loader.LoadMethod("ProcessLogGroupFlat", error);
+        if (!error.empty()) {
+            LOG_INFO(sLogger, ("ProcessLogGroupFlat is not exported, log groups are passed in protobuf", error));
+            mProcessLogGroupFlatFun = NULL;
+        }
 
         mPluginBasePtr = loader.Release();
     }
@@ -475,7 +487,7 @@ void LogtailPlugin::ProcessLog(const std::string& configName,
 void LogtailPlugin::ProcessLogGroup(const std::string& configName,
                                     sls_logs::LogGroup& logGroup,
                                     const std::string& packId) {
-    if (!logGroup.logs_size() || !(mPluginValid && mProcessLogsFun != NULL)) {
+    if (!logGroup.logs_size() || !(mPluginValid && mProcessLogGroupFun != NULL)) {
         return;
     }
     std::string realConfigName = configName + "/2";
@@ -486,10 +498,21 @@ void LogtailPlugin::ProcessLogGroup(const std::string& configName,
     goConfigName.p = realConfigName.c_str();
     goPackId.n = packId.size();
     goPackId.p = packId.c_str();
-    std::string sLog = logGroup.SerializeAsString();
-    goLog.len = goLog.cap = sLog.length();
-    goLog.data = (void*)sLog.c_str();
-    GoInt rst = mProcessLogGroupFun(goConfigName, goLog, goPackId);
+    GoInt rst = 0;
+    // process threads keep their writer, whose buffer is reused for every group
+    static thread_local FlatLogGroupWriter sFlatWriter;
+    if (mProcessLogGroupFlatFun != NULL && BOOL_FLAG(enable_go_pipeline_flat_log_group)
+        && sFlatWriter.Write(logGroup)) {
+        const std::string& flatLog = sFlatWriter.Buffer();
+        goLog.len = goLog.cap = flatLog.length();
+        goLog.data = (void*)flatLog.data();
+        rst = mProcessLogGroupFlatFun(goConfigName, goLog, goPackId);
+    } else {
+        std::string sLog = logGroup.SerializeAsString();
+        goLog.len = goLog.cap = sLog.length();
+        goLog.data = (void*)sLog.c_str();
+        rst = mProcessLogGroupFun(goConfigName, goLog, goPackId);
+    }
     if (rst != (GoInt)0) {
         LOG_WARNING(sLogger, ("process loggroup error", configName)("result", rst));
     }
@@ -122,8 +122,13 @@ void LogEvent::AppendContentNoCopy(StringView key, StringView val) {
 }
 
 uint64_t LogEvent::EventsSizeBytes() {
-    // TODO
-    return 0;
+    uint64_t size = 0;
+    for (const auto& content : mContents) {
+        if (content.second) {
+            size += content.first.first.size() + content.first.second.size();
+        }
+    }
+    return size;
 }
 
 #ifdef APSARA_UNIT_TEST_MAIN
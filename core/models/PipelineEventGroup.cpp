@@ -143,8 +143,11 @@ void PipelineEventGroup::DelTag(const StringView& key) {
 }
 
 uint64_t PipelineEventGroup::EventGroupSizeBytes() {
-    // TODO
-    return 0;
+    uint64_t size = 0;
+    for (auto& event : mEvents) {
+        size += event->EventsSizeBytes();
+    }
+    return size;
 }
 
 #ifdef APSARA_UNIT_TEST_MAIN
@@ -30,6 +30,8 @@
 DEFINE_FLAG_INT32(profile_data_send_interval, "interval of send LogFile/DomainSocket profile data, seconds", 600);
 DEFINE_FLAG_STRING(logtail_profile_snapshot, "reader profile on local disk", "logtail_profile_snapshot");
 
+DECLARE_FLAG_BOOL(enable_adaptive_send_concurrency);
+
 using namespace std;
 using namespace sls_logs;
 
@@ -195,6 +197,14 @@ bool LogFileProfiler::GetProfileData(LogGroup& logGroup, LogStoreStatistic* stat
         contentPtr = logPtr->add_contents();
         contentPtr->set_key("sender_valid_flag");
         contentPtr->set_value(ToString(senderStatistics.mValidToSendFlag));
+        if (BOOL_FLAG(enable_adaptive_send_concurrency)) {
+            contentPtr = logPtr->add_contents();
+            contentPtr->set_key("send_concurrency_limit");
+            contentPtr->set_value(ToString(senderStatistics.mSendConcurrencyLimit));
+            contentPtr = logPtr->add_contents();
+            contentPtr->set_key("send_inflight_count");
+            contentPtr->set_value(ToString(senderStatistics.mSendInFlightCount));
+        }
     }
 
     return true;
@@ -522,6 +532,10 @@ void LogFileProfiler::UpdateDumpData(const sls_logs::LogGroup& logGroup, Json::V
                 category["sender_valid_flag"] = value;
             else if (key == "send_block_flag")
                 category["send_block_flag"] = value;
+            else if (key == "send_concurrency_limit")
+                category["send_concurrency_limit"] = value;
+            else if (key == "send_inflight_count")
+                category["send_inflight_count"] = value;
         }
         if (logstoreFlag) {
             logstore.append(category);
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "LogtailMetric.h"
+#include <cmath>
 #include "common/StringTools.h"
 #include "MetricConstants.h"
 #include "logger/Logger.h"
@@ -24,23 +25,35 @@ using namespace sls_logs;
 
 namespace logtail {
 
-Counter::Counter(const std::string& name, uint64_t val = 0) : mName(name), mVal(val) {
+Counter::Counter(const std::string& name, uint64_t val = 0) : mName(name) {
+    for (auto& slot : mSlots) {
+        slot.mVal.store(0, std::memory_order_relaxed);
+    }
+    mSlots[0].mVal.store(val, std::memory_order_relaxed);
 }
 
 uint64_t Counter::GetValue() const {
-    return mVal;
+    uint64_t val = 0;
+    for (auto& slot : mSlots) {
+        val += slot.mVal.load(std::memory_order_relaxed);
+    }
+    return val;
 }
 
 const std::string& Counter::GetName() const {
     return mName;
 }
 
-Counter* Counter::CopyAndReset() {
-    return new Counter(mName, mVal.exchange(0));
+uint64_t Counter::GetAndReset() {
+    uint64_t val = 0;
+    for (auto& slot : mSlots) {
+        val += slot.mVal.exchange(0, std::memory_order_relaxed);
+    }
+    return val;
 }
 
-void Counter::Add(uint64_t value) {
-    mVal += value;
+Counter* Counter::CopyAndReset() {
+    return new Counter(mName, GetAndReset());
 }
 
 Gauge::Gauge(const std::string& name, uint64_t val = 0) : mName(name), mVal(val) {
@@ -62,6 +75,81 @@ void Gauge::Set(uint64_t value) {
     mVal = value;
 }
 
+Histogram::Histogram(const std::string& name) : mName(name) {
+    for (auto& shard : mShards) {
+        for (auto& bucket : shard.mBuckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        shard.mSum.store(0, std::memory_order_relaxed);
+    }
+}
+
+const std::string& Histogram::GetName() const {
+    return mName;
+}
+
+uint64_t Histogram::GetCount() const {
+    uint64_t count = 0;
+    for (auto& shard : mShards) {
+        for (auto& bucket : shard.mBuckets) {
+            count += bucket.load(std::memory_order_relaxed);
+        }
+    }
+    return count;
+}
+
+uint64_t Histogram::GetSum() const {
+    uint64_t sum = 0;
+    for (auto& shard : mShards) {
+        sum += shard.mSum.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+uint64_t Histogram::GetQuantile(double q) const {
+    uint64_t buckets[kBucketCount] = {0};
+    uint64_t count = 0;
+    for (auto& shard : mShards) {
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            uint64_t val = shard.mBuckets[i].load(std::memory_order_relaxed);
+            buckets[i] += val;
+            count += val;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+    // nearest rank, the epsilon keeps q * count from rounding up past an integer
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * count - 1e-9));
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    size_t i = 0;
+    for (; i < kBucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            break;
+        }
+    }
+    if (i == 0) {
+        return 0;
+    }
+    return i == kBucketCount - 1 ? 1ULL << (i - 1) : (1ULL << i) - 1;
+}
+
+Histogram* Histogram::CopyAndReset() {
+    Histogram* histogram = new Histogram(mName);
+    Shard& target = histogram->mShards[0];
+    for (auto& shard : mShards) {
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            target.mBuckets[i].fetch_add(shard.mBuckets[i].exchange(0), std::memory_order_relaxed);
+        }
+        target.mSum.fetch_add(shard.mSum.exchange(0), std::memory_order_relaxed);
+    }
+    return histogram;
+}
+
 MetricsRecord::MetricsRecord(LabelsPtr labels) : mLabels(labels), mDeleted(false) {
 }
 
@@ -77,6 +165,12 @@ GaugePtr MetricsRecord::CreateGauge(const std::string& name) {
     return gaugePtr;
 }
 
+HistogramPtr MetricsRecord::CreateHistogram(const std::string& name) {
+    HistogramPtr histogramPtr = std::make_shared<Histogram>(name);
+    mHistograms.emplace_back(histogramPtr);
+    return histogramPtr;
+}
+
 void MetricsRecord::MarkDeleted() {
     mDeleted = true;
 }
@@ -97,6 +191,10 @@ const std::vector<GaugePtr>& MetricsRecord::GetGauges() const {
     return mGauges;
 }
 
+const std::vector<HistogramPtr>& MetricsRecord::GetHistograms() const {
+    return mHistograms;
+}
+
 MetricsRecord* MetricsRecord::CopyAndReset() {
     MetricsRecord* metrics = new MetricsRecord(mLabels);
     for (auto& item : mCounters) {
@@ -107,6 +205,10 @@ MetricsRecord* MetricsRecord::CopyAndReset() {
         GaugePtr newPtr(item->CopyAndReset());
         metrics->mGauges.emplace_back(newPtr);
     }
+    for (auto& item : mHistograms) {
+        HistogramPtr newPtr(item->CopyAndReset());
+        metrics->mHistograms.emplace_back(newPtr);
+    }
     return metrics;
 }
 
@@ -135,6 +237,9 @@ CounterPtr MetricsRecordRef::CreateCounter(const std::string& name) {
 GaugePtr MetricsRecordRef::CreateGauge(const std::string& name) {
     return mMetrics->CreateGauge(name);
 }
+HistogramPtr MetricsRecordRef::CreateHistogram(const std::string& name) {
+    return mMetrics->CreateHistogram(name);
+}
 
 const MetricsRecord* MetricsRecordRef::operator->() const {
     return mMetrics;
@@ -260,6 +365,23 @@ MetricsRecord* WriteMetrics::DoSnapshot() {
     return snapshot;
 }
 
+static void AddHistogramContent(const std::string& key, uint64_t value, Log* logPtr) {
+    Log_Content* contentPtr = logPtr->add_contents();
+    contentPtr->set_key(key);
+    contentPtr->set_value(ToString(value));
+}
+
+// AddHistogramContents exports a histogram as its count, sum and quantiles, which stay comparable between intervals
+// without shipping all buckets.
+static void AddHistogramContents(const Histogram& histogram, Log* logPtr) {
+    const std::string prefix = VALUE_PREFIX + histogram.GetName();
+    AddHistogramContent(prefix + "_count", histogram.GetCount(), logPtr);
+    AddHistogramContent(prefix + "_sum", histogram.GetSum(), logPtr);
+    AddHistogramContent(prefix + "_p50", histogram.GetQuantile(0.5), logPtr);
+    AddHistogramContent(prefix + "_p90", histogram.GetQuantile(0.9), logPtr);
+    AddHistogramContent(prefix + "_p99", histogram.GetQuantile(0.99), logPtr);
+}
+
 ReadMetrics::~ReadMetrics() {
     Clear();
 }
@@ -320,6 +442,9 @@ void ReadMetrics::ReadAsLogGroup(std::map<std::string, sls_logs::LogGroup*>& log
             contentPtr->set_key(VALUE_PREFIX + gauge->GetName());
             contentPtr->set_value(ToString(gauge->GetValue()));
         }
+        for (auto& item : tmp->GetHistograms()) {
+            AddHistogramContents(*item, logPtr);
+        }
         tmp = tmp->GetNext();
     }
 }
@@ -17,22 +17,45 @@
 #pragma once
 #include <string>
 #include <atomic>
+#include <chrono>
+#include <utility>
 #include "common/Lock.h"
 #include "log_pb/sls_logs.pb.h"
 
 
 namespace logtail {
 
+// GetMetricShard returns a number fixed for the calling thread, threads get consecutive numbers so that threads
+// recording into the same sharded metric mostly write to different cache lines.
+inline size_t GetMetricShard() {
+    static std::atomic<size_t> sNextShard(0);
+    static thread_local size_t sShard = sNextShard.fetch_add(1, std::memory_order_relaxed);
+    return sShard;
+}
+
+// Counter is added to by many threads at once, e.g. by all process threads running the same pipeline. Threads add
+// to the slot of GetMetricShard, each slot on its own cache line, and slots are summed when read.
 class Counter {
+public:
+    static const size_t kShardCount = 8;
+
 private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> mVal;
+    };
+
     std::string mName;
-    std::atomic_long mVal;
+    Slot mSlots[kShardCount];
 
 public:
     Counter(const std::string& name, uint64_t val);
     uint64_t GetValue() const;
     const std::string& GetName() const;
-    void Add(uint64_t val);
+    void Add(uint64_t val) {
+        mSlots[GetMetricShard() % kShardCount].mVal.fetch_add(val, std::memory_order_relaxed);
+    }
+    // GetAndReset returns the value and sets it to 0, values added meanwhile are kept for the next call.
+    uint64_t GetAndReset();
     Counter* CopyAndReset();
 };
 
@@ -53,6 +76,68 @@ public:
 
 using GaugePtr = std::shared_ptr<Gauge>;
 
+// Histogram counts values in exponential buckets, bucket i holds values in [2^(i-1), 2^i) and the last one all
+// larger values. Threads record into the shard of GetMetricShard without locks, shards are merged when read.
+class Histogram {
+public:
+    static const size_t kBucketCount = 24;
+    static const size_t kShardCount = 4;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> mBuckets[kBucketCount];
+        std::atomic<uint64_t> mSum;
+    };
+
+    std::string mName;
+    Shard mShards[kShardCount];
+
+public:
+    explicit Histogram(const std::string& name);
+    const std::string& GetName() const;
+    void Observe(uint64_t val) {
+        Shard& shard = mShards[GetMetricShard() % kShardCount];
+        shard.mBuckets[BucketIndex(val)].fetch_add(1, std::memory_order_relaxed);
+        shard.mSum.fetch_add(val, std::memory_order_relaxed);
+    }
+    uint64_t GetCount() const;
+    uint64_t GetSum() const;
+    // GetQuantile returns the upper bound of the bucket holding the q-quantile, or the lower bound if it is the last
+    // bucket. It returns 0 when nothing is recorded.
+    uint64_t GetQuantile(double q) const;
+    Histogram* CopyAndReset();
+
+    static size_t BucketIndex(uint64_t val) {
+        size_t index = 0;
+        while (val != 0 && index < kBucketCount - 1) {
+            val >>= 1;
+            ++index;
+        }
+        return index;
+    }
+};
+
+using HistogramPtr = std::shared_ptr<Histogram>;
+
+// HistogramTimer records the microseconds from its construction to its destruction into a histogram.
+class HistogramTimer {
+public:
+    explicit HistogramTimer(HistogramPtr histogram)
+        : mHistogram(std::move(histogram)), mStart(std::chrono::steady_clock::now()) {}
+    ~HistogramTimer() { mHistogram->Observe(ElapsedMicroseconds()); }
+    HistogramTimer(const HistogramTimer&) = delete;
+    HistogramTimer& operator=(const HistogramTimer&) = delete;
+
+    uint64_t ElapsedMicroseconds() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mStart)
+            .count();
+    }
+
+private:
+    HistogramPtr mHistogram;
+    std::chrono::steady_clock::time_point mStart;
+};
+
 using MetricLabels = std::vector<std::pair<std::string, std::string>>;
 using LabelsPtr = std::shared_ptr<MetricLabels>;
 
@@ -62,6 +147,7 @@ private:
     std::atomic_bool mDeleted;
     std::vector<CounterPtr> mCounters;
     std::vector<GaugePtr> mGauges;
+    std::vector<HistogramPtr> mHistograms;
     MetricsRecord* mNext = nullptr;
 
 public:
@@ -72,8 +158,10 @@ public:
     const LabelsPtr& GetLabels() const;
     const std::vector<CounterPtr>& GetCounters() const;
     const std::vector<GaugePtr>& GetGauges() const;
+    const std::vector<HistogramPtr>& GetHistograms() const;
     CounterPtr CreateCounter(const std::string& name);
     GaugePtr CreateGauge(const std::string& name);
+    HistogramPtr CreateHistogram(const std::string& name);
     MetricsRecord* CopyAndReset();
     void SetNext(MetricsRecord* next);
     MetricsRecord* GetNext() const;
@@ -93,6 +181,7 @@ public:
     void SetMetricsRecord(MetricsRecord* metricRecord);
     CounterPtr CreateCounter(const std::string& name);
     GaugePtr CreateGauge(const std::string& name);
+    HistogramPtr CreateHistogram(const std::string& name);
     const MetricsRecord* operator->() const;
 };
 
@@ -34,6 +34,7 @@ const std::string METRIC_PROC_OUT_RECORDS_TOTAL = "proc_out_records_total";
 const std::string METRIC_PROC_OUT_RECORDS_SIZE_BYTES = "proc_out_records_size_bytes";
 const std::string METRIC_PROC_DISCARD_RECORDS_TOTAL = "proc_discard_records_total";
 const std::string METRIC_PROC_TIME_MS = "proc_time_ms";
+const std::string METRIC_PROC_LATENCY_US = "proc_latency_us";
 
 // processor cunstom metrics
 const std::string METRIC_PROC_PARSE_IN_SIZE_BYTES = "proc_parse_in_size_bytes";
@@ -62,4 +63,26 @@ const std::string PLUGIN_PROCESSOR_PARSE_REGEX_NATIVE = "processor_parse_regex_n
 // processor desensitize metrics
 const std::string METRIC_PROC_DESENSITIZE_RECORDS_TOTAL = "proc_desensitize_records_total";
 
+// process queue metrics
+const std::string METRIC_PROCESS_QUEUE_POP_TOTAL = "process_queue_pop_total";
+const std::string METRIC_PROCESS_QUEUE_POP_SIZE_BYTES = "process_queue_pop_size_bytes";
+const std::string METRIC_PROCESS_QUEUE_LATENCY_MS = "process_queue_latency_ms";
+const std::string METRIC_PROCESS_QUEUE_LATENCY_HISTOGRAM_MS = "process_queue_latency_histogram_ms";
+
+// sender queue metrics
+const std::string METRIC_SEND_QUEUE_SUCCESS_TOTAL = "send_queue_success_total";
+const std::string METRIC_SEND_QUEUE_SUCCESS_SIZE_BYTES = "send_queue_success_size_bytes";
+const std::string METRIC_SEND_QUEUE_LATENCY_MS = "send_queue_latency_ms";
+const std::string METRIC_SEND_QUEUE_LATENCY_HISTOGRAM_MS = "send_queue_latency_histogram_ms";
+
+// flusher metrics
+const std::string METRIC_FLUSHER_IN_RECORDS_TOTAL = "flusher_in_records_total";
+const std::string METRIC_FLUSHER_IN_SIZE_BYTES = "flusher_in_size_bytes";
+const std::string METRIC_FLUSHER_LATENCY_US = "flusher_latency_us";
+
+// config match cache metrics
+const std::string METRIC_CONFIG_MATCH_CACHE_HIT_TOTAL = "config_match_cache_hit_total";
+const std::string METRIC_CONFIG_MATCH_CACHE_MISS_TOTAL = "config_match_cache_miss_total";
+const std::string METRIC_CONFIG_MATCH_CACHE_EVICT_TOTAL = "config_match_cache_evict_total";
+
 } // namespace logtail
\ No newline at end of file
@@ -35,6 +35,7 @@ extern const std::string METRIC_PROC_OUT_RECORDS_TOTAL;
 extern const std::string METRIC_PROC_OUT_RECORDS_SIZE_BYTES;
 extern const std::string METRIC_PROC_DISCARD_RECORDS_TOTAL;
 extern const std::string METRIC_PROC_TIME_MS;
+extern const std::string METRIC_PROC_LATENCY_US;
 
 // processor custom metrics
 extern const std::string METRIC_PROC_PARSE_IN_SIZE_BYTES;
@@ -55,4 +56,26 @@ extern const std::string METRIC_PROC_FILTER_RECORDS_TOTAL;
 // processor desensitize metrics
 extern const std::string METRIC_PROC_DESENSITIZE_RECORDS_TOTAL;
 
+// process queue metrics
+extern const std::string METRIC_PROCESS_QUEUE_POP_TOTAL;
+extern const std::string METRIC_PROCESS_QUEUE_POP_SIZE_BYTES;
+extern const std::string METRIC_PROCESS_QUEUE_LATENCY_MS;
+extern const std::string METRIC_PROCESS_QUEUE_LATENCY_HISTOGRAM_MS;
+
+// sender queue metrics
+extern const std::string METRIC_SEND_QUEUE_SUCCESS_TOTAL;
+extern const std::string METRIC_SEND_QUEUE_SUCCESS_SIZE_BYTES;
+extern const std::string METRIC_SEND_QUEUE_LATENCY_MS;
+extern const std::string METRIC_SEND_QUEUE_LATENCY_HISTOGRAM_MS;
+
+// flusher metrics
+extern const std::string METRIC_FLUSHER_IN_RECORDS_TOTAL;
+extern const std::string METRIC_FLUSHER_IN_SIZE_BYTES;
+extern const std::string METRIC_FLUSHER_LATENCY_US;
+
+// config match cache metrics
+extern const std::string METRIC_CONFIG_MATCH_CACHE_HIT_TOTAL;
+extern const std::string METRIC_CONFIG_MATCH_CACHE_MISS_TOTAL;
+extern const std::string METRIC_CONFIG_MATCH_CACHE_EVICT_TOTAL;
+
 } // namespace logtail
\ No newline at end of file
@@ -28,6 +28,7 @@
 #include "common/ExceptionBase.h"
 #include "common/LogtailCommonFlags.h"
 #include "common/MachineInfoUtil.h"
+#include "common/MemoryBudget.h"
 #include "common/RuntimeUtil.h"
 #include "common/StringTools.h"
 #include "common/TimeUtil.h"
@@ -39,6 +40,7 @@
 #include "logger/Logger.h"
 #include "monitor/LogFileProfiler.h"
 #include "monitor/LogtailAlarm.h"
+#include "monitor/SamplingProfiler.h"
 #include "sender/Sender.h"
 #if defined(__linux__) && !defined(__ANDROID__)
 #include "ObserverManager.h"
@@ -54,6 +56,10 @@ using namespace std;
 using namespace sls_logs;
 
 DEFINE_FLAG_BOOL(logtail_dump_monitor_info, "enable to dump Logtail monitor info (CPU, mem)", false);
+DEFINE_FLAG_DOUBLE(memory_budget_ratio,
+                   "ratio of memory usage limit which can be used by buffered data, readers are paused beyond it, 0 "
+                   "means unlimited",
+                   0.5);
 DECLARE_FLAG_BOOL(send_prefer_real_ip);
 DECLARE_FLAG_BOOL(check_profile_region);
 
@@ -97,6 +103,7 @@ bool LogtailMonitor::Init() {
     mRealtimeCpuStat.Reset();
     // Reset memory statistics.
     mMemStat.Reset();
+    UpdateMemoryBudget();
 
 #if defined(__linux__)
     // Reset OS CPU statistics.
@@ -131,6 +138,7 @@ void LogtailMonitor::Stop() {
 }
 
 void LogtailMonitor::Monitor() {
+    SamplingProfiler::SetThreadRole("monitor");
     LOG_INFO(sLogger, ("profiling", "started"));
     int32_t lastMonitorTime = time(NULL);
     CpuStat curCpuStat;
@@ -176,6 +184,7 @@ void LogtailMonitor::Monitor() {
                 LogInput::GetInstance()->SetForceClearFlag(true);
             }
             GetMemStat();
+            UpdateMemoryBudget();
             CalCpuStat(curCpuStat, mCpuStat);
             // CalCpuLimit and CalMemLimit will check if the number of violation (CPU
             // or memory exceeds limit) // is greater or equal than limits (
@@ -187,6 +196,10 @@ void LogtailMonitor::Monitor() {
                 LOG_ERROR(sLogger,
                           ("Resource used by program exceeds upper limit",
                            "prepare restart Logtail")("cpu_usage", mCpuStat.mCpuUsage)("mem_rss", mMemStat.mRss));
+                // keep where the CPU went before restarting
+                if (SamplingProfiler::GetInstance()->IsRunning()) {
+                    SamplingProfiler::GetInstance()->Dump();
+                }
                 Suicide();
             }
 
@@ -246,12 +259,18 @@ bool LogtailMonitor::SendStatusProfile(bool suicide) {
     SetLogTime(logPtr, AppConfig::GetInstance()->EnableLogTimeAutoAdjust() ? now.tv_sec + GetTimeDelta() : now.tv_sec);
     // CPU usage of Logtail process.
     AddLogContent(logPtr, "cpu", mCpuStat.mCpuUsage);
+    // CPU usage per thread role, only known when the sampling profiler runs.
+    if (SamplingProfiler::GetInstance()->IsRunning()) {
+        AddLogContent(logPtr, "thread_cpu", SamplingProfiler::GetInstance()->GetThreadCpuReport());
+    }
 #if defined(__linux__) // TODO: Remove this if auto scale is available on Windows.
     // CPU usage of system.
     AddLogContent(logPtr, "os_cpu", mOsCpuStatForScale.mOsCpuUsage);
 #endif
     // Memory usage of Logtail process.
     AddLogContent(logPtr, "mem", mMemStat.mRss);
+    // Memory used by buffered data in MB.
+    AddLogContent(logPtr, "buffer_mem", MemoryBudget::GetInstance()->GetUsedBytes() / 1024 / 1024);
     // The version, uuid of Logtail.
     AddLogContent(logPtr, "version", ILOGTAIL_VERSION);
     AddLogContent(logPtr, "uuid", Application::GetInstance()->GetUUID());
@@ -436,6 +455,11 @@ bool LogtailMonitor::CheckCpuLimit() {
     return false;
 }
 
+void LogtailMonitor::UpdateMemoryBudget() {
+    MemoryBudget::GetInstance()->SetLimitBytes(static_cast<int64_t>(
+        AppConfig::GetInstance()->GetMemUsageUpLimit() * DOUBLE_FLAG(memory_budget_ratio) * 1024 * 1024));
+}
+
 bool LogtailMonitor::CheckMemLimit() {
     if (mMemStat.mRss > AppConfig::GetInstance()->GetMemUsageUpLimit()) {
         if (++mMemStat.mViolateNum > INT32_FLAG(mem_limit_num))
@@ -111,6 +111,8 @@ private:
     // CheckMemLimit checks if the memory usage exceeds limit.
     // @return true if the memory usage exceeds limit continuously.
     bool CheckMemLimit();
+    // UpdateMemoryBudget sets the budget of buffered data according to the memory usage limit.
+    void UpdateMemoryBudget();
 
     // SendStatusProfile collects status profile and send them to server.
     // @suicide indicates if the target LogStore is logtail_suicide_profile.
@@ -0,0 +1,561 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "SamplingProfiler.h"
+#if defined(__linux__) && !defined(__ANDROID__)
+#define UNW_LOCAL_ONLY
+#include <cxxabi.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <libunwind/libunwind.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include "common/Flags.h"
+#include "common/RuntimeUtil.h"
+#include "logger/Logger.h"
+
+DEFINE_FLAG_BOOL(enable_sampling_profiler, "sample stacks of all threads and dump them to a local file", false);
+DEFINE_FLAG_INT32(sampling_profiler_hz, "stacks sampled per second of CPU time used by the process, at most 1000", 99);
+DEFINE_FLAG_INT32(sampling_profiler_max_stacks, "count of distinct stacks the sampling profiler keeps", 4096);
+DEFINE_FLAG_INT32(sampling_profiler_dump_interval, "seconds between dumps of sampled stacks", 60);
+DEFINE_FLAG_DOUBLE(sampling_profiler_max_overhead_percent,
+                   "percent of a core the sampling profiler may use, the sampling rate is halved beyond it",
+                   1.0);
+DEFINE_FLAG_STRING(sampling_profiler_file_name,
+                   "file the sampling profiler dumps folded stacks to",
+                   "profiler_stacks.folded");
+
+using namespace std;
+
+namespace logtail {
+
+// the role is read in the signal handler, so it is a plain pointer set once per thread
+static thread_local const char* sThreadRole = nullptr;
+// whether the thread is sampled by a timer of its own, also read in the signal handler
+static thread_local bool sHasThreadTimer = false;
+
+// how many slots a stack may be put in after the one of its hash
+static const size_t kMaxProbes = 16;
+
+SamplingProfiler* SamplingProfiler::GetInstance() {
+    // never destructed, samples may still arrive while the process exits
+    static SamplingProfiler* ptr = new SamplingProfiler();
+    return ptr;
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+thread_local SamplingProfiler::ThreadTimer SamplingProfiler::sThreadTimer;
+
+SamplingProfiler::ThreadTimer::~ThreadTimer() {
+    if (!mCreated) {
+        return;
+    }
+    sHasThreadTimer = false;
+    SamplingProfiler* profiler = GetInstance();
+    lock_guard<mutex> lock(profiler->mThreadTimersMux);
+    auto& timers = profiler->mThreadTimers;
+    timers.erase(std::remove(timers.begin(), timers.end(), mTimer), timers.end());
+    timer_delete(mTimer);
+}
+
+static bool ArmThreadTimer(timer_t timer, int32_t hz) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (hz > 0) {
+        long periodNs = 1000000000L / hz;
+        spec.it_interval.tv_sec = periodNs / 1000000000L;
+        spec.it_interval.tv_nsec = periodNs % 1000000000L;
+        spec.it_value = spec.it_interval;
+    }
+    return timer_settime(timer, 0, &spec, nullptr) == 0;
+}
+#endif
+
+void SamplingProfiler::SetThreadRole(const char* role) {
+    sThreadRole = role;
+#if defined(__linux__) && !defined(__ANDROID__)
+    // fails for roles longer than 15 characters, their samples are still reported under the role
+    pthread_setname_np(pthread_self(), role);
+    if (!sThreadTimer.mCreated) {
+        GetInstance()->CreateThreadTimer();
+    }
+#endif
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+void SamplingProfiler::CreateThreadTimer() {
+    // the timer counts the CPU time of the calling thread only and sends SIGPROF to it, so the samples of a thread do
+    // not depend on which thread happens to run when the timer of the process expires
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+    timer_t timer;
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer) != 0) {
+        // the thread is still sampled by the timer of the process
+        LOG_WARNING(sLogger,
+                    ("failed to create sampling profiler thread timer", strerror(errno))("role", sThreadRole));
+        return;
+    }
+    lock_guard<mutex> lock(mThreadTimersMux);
+    sThreadTimer.mTimer = timer;
+    sThreadTimer.mCreated = true;
+    sHasThreadTimer = true;
+    mThreadTimers.push_back(timer);
+    if (mThreadTimerHz > 0 && !ArmThreadTimer(timer, mThreadTimerHz)) {
+        LOG_WARNING(sLogger, ("failed to set sampling profiler thread timer", strerror(errno))("role", sThreadRole));
+    }
+}
+#endif
+
+void SamplingProfiler::AllocateTables() {
+    if (mTables[0]) {
+        return;
+    }
+    mTableSize = static_cast<size_t>(max(INT32_FLAG(sampling_profiler_max_stacks), 1));
+    mTables[0].reset(new StackEntry[mTableSize]());
+    mTables[1].reset(new StackEntry[mTableSize]());
+}
+
+bool SamplingProfiler::Start() {
+#if defined(__linux__) && !defined(__ANDROID__)
+    if (mIsRunning) {
+        return true;
+    }
+    // the tables are kept after Stop, samples being handled then may still refer to them
+    AllocateTables();
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = HandleSignal;
+    // the Go runtime in the process requires handlers to run on the alternate signal stack of its threads
+    action.sa_flags = SA_RESTART | SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+        LOG_ERROR(sLogger, ("failed to install sampling profiler signal handler", strerror(errno)));
+        return false;
+    }
+
+    {
+        lock_guard<mutex> lock(mDumpMux);
+        mLastDumpTime = chrono::steady_clock::now();
+        mLastHandlerNs = mHandlerNs.load();
+        UpdateThreadCpu(0);
+        mHz = min(max(INT32_FLAG(sampling_profiler_hz), 1), 1000);
+        if (!SetTimer(mHz)) {
+            return false;
+        }
+        mIsRunning = true;
+    }
+
+    {
+        lock_guard<mutex> lock(mThreadRunningMux);
+        mIsThreadRunning = true;
+    }
+    mThreadRes = async(launch::async, &SamplingProfiler::Run, this);
+    LOG_INFO(sLogger,
+             ("sampling profiler", "started")("hz", mHz)("max stacks", mTableSize)(
+                 "file", GetProcessExecutionDir() + STRING_FLAG(sampling_profiler_file_name)));
+    return true;
+#else
+    LOG_WARNING(sLogger, ("sampling profiler", "not supported on this platform"));
+    return false;
+#endif
+}
+
+void SamplingProfiler::Stop() {
+    if (!mIsRunning) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(mThreadRunningMux);
+        mIsThreadRunning = false;
+    }
+    mStopCV.notify_one();
+    future_status s = mThreadRes.wait_for(chrono::seconds(1));
+    if (s == future_status::ready) {
+        LOG_INFO(sLogger, ("sampling profiler", "stopped successfully"));
+    } else {
+        LOG_WARNING(sLogger, ("sampling profiler", "forced to stopped"));
+    }
+    {
+        lock_guard<mutex> lock(mDumpMux);
+        mIsRunning = false;
+        SetTimer(0);
+    }
+    Dump();
+}
+
+void SamplingProfiler::Run() {
+    SetThreadRole("profiler");
+    unique_lock<mutex> lock(mThreadRunningMux);
+    while (mIsThreadRunning) {
+        if (mStopCV.wait_for(lock, chrono::seconds(INT32_FLAG(sampling_profiler_dump_interval)), [this]() {
+                return !mIsThreadRunning;
+            })) {
+            break;
+        }
+        Dump();
+    }
+}
+
+bool SamplingProfiler::SetTimer(int32_t hz) {
+#if defined(__linux__) && !defined(__ANDROID__)
+    // ITIMER_PROF counts the CPU time of all threads, the kernel sends SIGPROF to the thread running when it expires
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    if (hz > 0) {
+        // tv_usec must be less than a second
+        long periodUs = 1000000L / hz;
+        timer.it_interval.tv_sec = periodUs / 1000000L;
+        timer.it_interval.tv_usec = periodUs % 1000000L;
+        timer.it_value = timer.it_interval;
+    }
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        LOG_ERROR(sLogger, ("failed to set sampling profiler timer", strerror(errno))("hz", hz));
+        return false;
+    }
+    lock_guard<mutex> lock(mThreadTimersMux);
+    mThreadTimerHz = hz;
+    for (auto threadTimer : mThreadTimers) {
+        if (!ArmThreadTimer(threadTimer, hz)) {
+            LOG_WARNING(sLogger, ("failed to set sampling profiler thread timer", strerror(errno))("hz", hz));
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+void SamplingProfiler::HandleSignal(int signum, siginfo_t* info, void* ucontext) {
+    // threads with a timer of their own are sampled by it only, the timer of the process would count them twice
+    if (sHasThreadTimer && info != nullptr && info->si_code != SI_TIMER) {
+        return;
+    }
+    int savedErrno = errno;
+    timespec begin;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    uintptr_t pcs[kMaxFrames];
+    uint32_t depth = 0;
+    unw_context_t context;
+    unw_cursor_t cursor;
+    if (unw_getcontext(&context) == 0 && unw_init_local(&cursor, &context) == 0) {
+        while (depth < kMaxFrames && unw_step(&cursor) > 0) {
+            if (unw_is_signal_frame(&cursor) > 0) {
+                // the frames so far are the handler's own, the interrupted one comes next
+                depth = 0;
+                continue;
+            }
+            unw_word_t pc;
+            unw_get_reg(&cursor, UNW_REG_IP, &pc);
+            if (pc == 0) {
+                break;
+            }
+            pcs[depth++] = pc;
+        }
+    }
+
+    SamplingProfiler* profiler = GetInstance();
+    if (depth > 0) {
+        profiler->AddSample(sThreadRole, pcs, depth);
+    }
+    timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    profiler->mHandlerNs.fetch_add((end.tv_sec - begin.tv_sec) * 1000000000LL + (end.tv_nsec - begin.tv_nsec),
+                                   memory_order_relaxed);
+    profiler->mSamples.fetch_add(1, memory_order_relaxed);
+    errno = savedErrno;
+}
+#endif
+
+void SamplingProfiler::AddSample(const char* role, const uintptr_t* pcs, uint32_t depth) {
+    // FNV-1a over the role and the frames, 0 marks empty slots
+    uint64_t hash = 14695981039346656037ULL;
+    hash = (hash ^ reinterpret_cast<uintptr_t>(role)) * 1099511628211ULL;
+    for (uint32_t i = 0; i < depth; ++i) {
+        hash = (hash ^ pcs[i]) * 1099511628211ULL;
+    }
+    if (hash == 0) {
+        hash = 1;
+    }
+
+    // the active table is checked again once the sample is counted as a writer of it, so SwapTables either waits
+    // for the sample or the sample goes to the new table
+    uint32_t index = mActiveTable.load();
+    while (true) {
+        mTableWriters[index].fetch_add(1);
+        uint32_t active = mActiveTable.load();
+        if (active == index) {
+            break;
+        }
+        mTableWriters[index].fetch_sub(1);
+        index = active;
+    }
+    StackEntry* table = mTables[index].get();
+    bool counted = false;
+    for (size_t probe = 0; probe < kMaxProbes && probe < mTableSize; ++probe) {
+        StackEntry& entry = table[(hash + probe) % mTableSize];
+        uint64_t current = entry.mHash.load(memory_order_acquire);
+        if (current == 0) {
+            if (entry.mHash.compare_exchange_strong(current, hash, memory_order_acq_rel)) {
+                entry.mRole = role;
+                entry.mDepth = depth;
+                memcpy(entry.mPcs, pcs, depth * sizeof(uintptr_t));
+                entry.mCount.fetch_add(1, memory_order_relaxed);
+                entry.mReady.store(true, memory_order_release);
+                counted = true;
+                break;
+            }
+            // another thread took the slot, current holds its hash now
+        }
+        if (current == hash) {
+            entry.mCount.fetch_add(1, memory_order_relaxed);
+            counted = true;
+            break;
+        }
+    }
+    mTableWriters[index].fetch_sub(1, memory_order_release);
+    if (!counted) {
+        mDroppedSamples.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+uint32_t SamplingProfiler::SwapTables() {
+    uint32_t retired = mActiveTable.load();
+    mActiveTable.store(retired ^ 1);
+    // signal handlers that took the retired table before the swap are done within microseconds
+    while (mTableWriters[retired].load() != 0) {
+        this_thread::yield();
+    }
+    return retired;
+}
+
+void SamplingProfiler::ClearTable(uint32_t index) {
+    StackEntry* table = mTables[index].get();
+    for (size_t i = 0; i < mTableSize; ++i) {
+        StackEntry& entry = table[i];
+        if (entry.mHash.load(memory_order_relaxed) == 0) {
+            continue;
+        }
+        entry.mReady.store(false, memory_order_relaxed);
+        entry.mCount.store(0, memory_order_relaxed);
+        entry.mHash.store(0, memory_order_release);
+    }
+}
+
+void SamplingProfiler::Dump() {
+#if defined(__linux__) && !defined(__ANDROID__)
+    lock_guard<mutex> lock(mDumpMux);
+    if (!mTables[0]) {
+        return;
+    }
+    auto now = chrono::steady_clock::now();
+    uint64_t intervalNs = chrono::duration_cast<chrono::nanoseconds>(now - mLastDumpTime).count();
+    mLastDumpTime = now;
+    if (intervalNs == 0) {
+        return;
+    }
+    UpdateThreadCpu(intervalNs / 1e9);
+    CheckOverhead(intervalNs);
+
+    string path = GetProcessExecutionDir() + STRING_FLAG(sampling_profiler_file_name);
+    string tmpPath = path + ".tmp";
+    {
+        ofstream fout(tmpPath, ios::out | ios::trunc);
+        if (!fout) {
+            LOG_WARNING(sLogger, ("failed to open sampling profiler file", tmpPath)("errno", errno));
+            return;
+        }
+        fout << FoldStacks();
+    }
+    // readers never see a partly written file
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        LOG_WARNING(sLogger, ("failed to rename sampling profiler file", path)("errno", errno));
+    }
+#endif
+}
+
+string SamplingProfiler::GetThreadCpuReport() {
+    lock_guard<mutex> lock(mDumpMux);
+    return mThreadCpuReport;
+}
+
+void SamplingProfiler::CheckOverhead(uint64_t intervalNs) {
+    uint64_t handlerNs = mHandlerNs.load(memory_order_relaxed);
+    double overheadPercent = (handlerNs - mLastHandlerNs) * 100.0 / intervalNs;
+    mLastHandlerNs = handlerNs;
+    LOG_INFO(sLogger,
+             ("sampling profiler", "dump")("samples", mSamples.load())("dropped samples", mDroppedSamples.load())(
+                 "overhead percent", overheadPercent)("hz", mHz)("thread cpu", mThreadCpuReport));
+    if (mIsRunning && overheadPercent > DOUBLE_FLAG(sampling_profiler_max_overhead_percent) && mHz > 1) {
+        mHz = max(mHz / 2, 1);
+        SetTimer(mHz);
+        LOG_WARNING(sLogger,
+                    ("sampling profiler overhead exceeds limit", "halve sampling rate")(
+                        "overhead percent", overheadPercent)("hz", mHz));
+    }
+}
+
+void SamplingProfiler::UpdateThreadCpu(double intervalSeconds) {
+#if defined(__linux__) && !defined(__ANDROID__)
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        LOG_WARNING(sLogger, ("failed to open thread list", "/proc/self/task")("errno", errno));
+        return;
+    }
+    map<string, uint64_t> roleTicks;
+    unordered_map<int32_t, uint64_t> threadTicks;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        if (ent->d_name[0] < '0' || ent->d_name[0] > '9') {
+            continue;
+        }
+        ifstream fin(string("/proc/self/task/") + ent->d_name + "/stat");
+        string stat;
+        if (!getline(fin, stat)) {
+            continue;
+        }
+        // the name is in parentheses and may contain spaces
+        size_t nameBegin = stat.find('(');
+        size_t nameEnd = stat.rfind(')');
+        if (nameBegin == string::npos || nameEnd == string::npos || nameEnd < nameBegin || nameEnd + 2 > stat.size()) {
+            continue;
+        }
+        istringstream fields(stat.substr(nameEnd + 2));
+        // utime and stime follow the state and 10 other fields
+        string field;
+        for (int i = 0; i < 11; ++i) {
+            fields >> field;
+        }
+        uint64_t utime = 0, stime = 0;
+        fields >> utime >> stime;
+
+        int32_t tid = atoi(ent->d_name);
+        uint64_t ticks = utime + stime;
+        auto last = mThreadTicks.find(tid);
+        // threads started within the interval count from 0
+        roleTicks[stat.substr(nameBegin + 1, nameEnd - nameBegin - 1)]
+            += ticks - (last == mThreadTicks.end() ? 0 : min(last->second, ticks));
+        threadTicks[tid] = ticks;
+    }
+    closedir(dir);
+    mThreadTicks.swap(threadTicks);
+    if (intervalSeconds <= 0) {
+        return;
+    }
+
+    // cores used by each role, as the cpu of LogtailMonitor
+    double ticksPerSecond = sysconf(_SC_CLK_TCK);
+    string report;
+    for (auto& item : roleTicks) {
+        char cpu[32];
+        snprintf(cpu, sizeof(cpu), "%.2f", item.second / ticksPerSecond / intervalSeconds);
+        if (!report.empty()) {
+            report += ',';
+        }
+        report += item.first + ':' + cpu;
+    }
+    mThreadCpuReport = report;
+#endif
+}
+
+string SamplingProfiler::Symbolize(uintptr_t pc) {
+    auto iter = mSymbols.find(pc);
+    if (iter != mSymbols.end()) {
+        return iter->second;
+    }
+    string symbol;
+    char address[32];
+#if defined(__linux__) && !defined(__ANDROID__)
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(pc), &info) != 0) {
+        if (info.dli_sname != nullptr) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            symbol = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+            free(demangled);
+        } else if (info.dli_fname != nullptr) {
+            // not exported, the module and offset can be resolved by addr2line
+            const char* name = strrchr(info.dli_fname, '/');
+            snprintf(address, sizeof(address), "+0x%lx", static_cast<unsigned long>(pc - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+            symbol = string(name == nullptr ? info.dli_fname : name + 1) + address;
+        }
+    }
+#endif
+    if (symbol.empty()) {
+        snprintf(address, sizeof(address), "0x%lx", static_cast<unsigned long>(pc));
+        symbol = address;
+    }
+    // ';' separates frames in the folded format
+    replace(symbol.begin(), symbol.end(), ';', ':');
+    mSymbols[pc] = symbol;
+    return symbol;
+}
+
+string SamplingProfiler::FoldStacks() {
+    // the retired table holds the stacks sampled since the last fold, it is cleared afterwards so that stacks gone
+    // from the process leave room for new ones
+    uint32_t index = SwapTables();
+    StackEntry* table = mTables[index].get();
+    // stacks are folded by symbol, so samples at different lines of a function add up
+    map<string, uint64_t> folded;
+    for (size_t i = 0; i < mTableSize; ++i) {
+        StackEntry& entry = table[i];
+        if (!entry.mReady.load(memory_order_acquire)) {
+            continue;
+        }
+        uint64_t count = entry.mCount.load(memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        string line = entry.mRole == nullptr ? "unnamed" : entry.mRole;
+        // folded stacks start from the root, and callers are return addresses, which are looked up one byte earlier
+        // so that calls at the end of a function are not taken for the next one
+        for (uint32_t j = entry.mDepth; j > 0; --j) {
+            line += ';';
+            line += Symbolize(j == 1 ? entry.mPcs[0] : entry.mPcs[j - 1] - 1);
+        }
+        folded[line] += count;
+    }
+    ClearTable(index);
+    string result;
+    for (auto& item : folded) {
+        result += item.first + ' ' + to_string(item.second) + '\n';
+    }
+    return result;
+}
+
+} // namespace logtail
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <csignal>
+#include <ctime>
+#endif
+
+namespace logtail {
+
+/**
+ * SamplingProfiler samples the stacks of all threads of the process by SIGPROF, which the kernel sends at the rate of
+ * the CPU time used, so stacks are sampled in proportion to the CPU they burn. Threads that set their role get a timer
+ * of their own CPU time, the others are sampled by the timer of the CPU time of the process. Samples are counted in one
+ * of two tables of fixed size, and each dump the tables are swapped, so the stacks sampled in the interval are written
+ * to a local file in the folded format of flamegraph.pl, together with the CPU used per thread role in the interval.
+ *
+ * The time spent in the signal handler is measured, and the rate is halved whenever it exceeds
+ * sampling_profiler_max_overhead_percent of a core, so the profiler can be left on in production.
+ *
+ * It is Linux only, Start returns false elsewhere.
+ */
+class SamplingProfiler {
+public:
+    static const size_t kMaxFrames = 32;
+
+    SamplingProfiler(const SamplingProfiler&) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler&) = delete;
+
+    static SamplingProfiler* GetInstance();
+
+    // SetThreadRole names the calling thread, so that its samples and CPU are reported under role, and creates the
+    // timer the thread is sampled by. role must be a literal of at most 15 characters and is also set as the name of
+    // the thread in the OS.
+    static void SetThreadRole(const char* role);
+
+    bool Start();
+    void Stop();
+    bool IsRunning() const { return mIsRunning.load(); }
+
+    // Dump writes the stacks sampled since the last dump and the CPU per thread role, LogtailMonitor calls it when the
+    // CPU limit is exceeded so that the cause is kept before logtail restarts.
+    void Dump();
+
+    // GetThreadCpuReport returns the CPU per thread role of the last dump, e.g. "process:0.52,sender:0.10".
+    std::string GetThreadCpuReport();
+
+private:
+    struct StackEntry {
+        std::atomic<uint64_t> mHash;
+        std::atomic<bool> mReady;
+        std::atomic<uint64_t> mCount;
+        const char* mRole;
+        uint32_t mDepth;
+        uintptr_t mPcs[kMaxFrames];
+    };
+
+    SamplingProfiler() = default;
+    ~SamplingProfiler() = default;
+
+#if defined(__linux__) && !defined(__ANDROID__)
+    // ThreadTimer is the CPU timer of a thread with a role, it is deleted when the thread exits.
+    struct ThreadTimer {
+        timer_t mTimer;
+        bool mCreated = false;
+
+        ~ThreadTimer();
+    };
+
+    static void HandleSignal(int signum, siginfo_t* info, void* ucontext);
+    void CreateThreadTimer();
+    static thread_local ThreadTimer sThreadTimer;
+#endif
+    // AddSample counts a stack in the active table, it runs in the signal handler and must neither lock nor allocate.
+    void AddSample(const char* role, const uintptr_t* pcs, uint32_t depth);
+    void AllocateTables();
+    // SwapTables makes the other table active, and returns the retired one once no signal handler writes to it.
+    uint32_t SwapTables();
+    void ClearTable(uint32_t index);
+    bool SetTimer(int32_t hz);
+    void Run();
+    void CheckOverhead(uint64_t intervalNs);
+    void UpdateThreadCpu(double intervalSeconds);
+    std::string Symbolize(uintptr_t pc);
+    std::string FoldStacks();
+
+    // samples are counted in the active table while the other one is folded and cleared by the dump
+    std::unique_ptr<StackEntry[]> mTables[2];
+    size_t mTableSize = 0;
+    std::atomic<uint32_t> mActiveTable{0};
+    std::atomic<uint32_t> mTableWriters[2] = {{0}, {0}};
+
+    std::atomic<uint64_t> mSamples{0};
+    std::atomic<uint64_t> mDroppedSamples{0};
+    std::atomic<uint64_t> mHandlerNs{0};
+    uint64_t mLastHandlerNs = 0;
+    int32_t mHz = 0;
+    std::atomic_bool mIsRunning{false};
+
+    // guards the dump, which the profiler thread and LogtailMonitor both run
+    std::mutex mDumpMux;
+    std::chrono::steady_clock::time_point mLastDumpTime;
+    std::unordered_map<uintptr_t, std::string> mSymbols;
+    std::unordered_map<int32_t, uint64_t> mThreadTicks;
+    std::string mThreadCpuReport;
+
+#if defined(__linux__) && !defined(__ANDROID__)
+    // timers of the threads with a role, armed at the rate of mThreadTimerHz
+    std::mutex mThreadTimersMux;
+    std::vector<timer_t> mThreadTimers;
+    int32_t mThreadTimerHz = 0;
+#endif
+
+    std::future<void> mThreadRes;
+    std::mutex mThreadRunningMux;
+    bool mIsThreadRunning = false;
+    std::condition_variable mStopCV;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class SamplingProfilerUnittest;
+#endif
+};
+
+} // namespace logtail
@@ -19,11 +19,38 @@
 #include "Monitor.h"
 #include "iostream"
 #include "monitor/LogtailAlarm.h"
+#include <atomic>
 #include <cstdint>
 #include <sstream>
 
 namespace logtail {
 
+// StatisticCounter is a counter updated by several network observer workers at the same time. Relaxed atomic
+// operations keep updates from being lost, and statistics need no ordering with other memory.
+class StatisticCounter {
+public:
+    StatisticCounter(uint32_t val = 0) : mVal(val) {}
+    StatisticCounter(const StatisticCounter&) = delete;
+    StatisticCounter& operator=(const StatisticCounter&) = delete;
+
+    StatisticCounter& operator=(uint32_t val) {
+        mVal.store(val, std::memory_order_relaxed);
+        return *this;
+    }
+    StatisticCounter& operator+=(uint32_t val) {
+        mVal.fetch_add(val, std::memory_order_relaxed);
+        return *this;
+    }
+    StatisticCounter& operator++() { return *this += 1; }
+    operator uint32_t() const { return mVal.load(std::memory_order_relaxed); }
+
+    // Take returns the value and resets it, updates in between are kept for the next take.
+    uint32_t Take() { return mVal.exchange(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> mVal;
+};
+
 // Global statistics for container meta
 struct ProcessMetaStatistic {
     uint32_t mCgroupPathTotalCount{0};
@@ -136,40 +163,40 @@ private:
 
 // Global statistics for network stat
 struct NetworkStatistic {
-    uint32_t mOutputEvents{0};
-    uint32_t mOutputBytes{0};
-    uint32_t mInputEvents{0};
-    uint32_t mInputBytes{0};
-    uint32_t mProtocolMatched{0};
-    uint32_t mProtocolUnMatched{0};
-    uint32_t mGCCount{0};
-    uint32_t mGCReleaseConnCount{0};
-    uint32_t mGCReleaseProcessCount{0};
-    uint32_t mEbpfLostCount{0};
-    uint32_t mEbpfGCCount{0};
-    uint32_t mEbpfGCReleaseFDCount{0};
-    uint32_t mEbpfDisableProcesses{0};
-    uint32_t mEbpfUsingConnections{0};
+    StatisticCounter mOutputEvents{0};
+    StatisticCounter mOutputBytes{0};
+    StatisticCounter mInputEvents{0};
+    StatisticCounter mInputBytes{0};
+    StatisticCounter mProtocolMatched{0};
+    StatisticCounter mProtocolUnMatched{0};
+    StatisticCounter mGCCount{0};
+    StatisticCounter mGCReleaseConnCount{0};
+    StatisticCounter mGCReleaseProcessCount{0};
+    StatisticCounter mEbpfLostCount{0};
+    StatisticCounter mEbpfGCCount{0};
+    StatisticCounter mEbpfGCReleaseFDCount{0};
+    StatisticCounter mEbpfDisableProcesses{0};
+    StatisticCounter mEbpfUsingConnections{0};
 
     void FlushMetrics() {
         static auto sMonitor = LogtailMonitor::GetInstance();
+        uint32_t lostCount = mEbpfLostCount.Take();
         LogtailAlarm::GetInstance()->SendAlarm(OBSERVER_RUNTIME_ALARM,
-                                               "ebpf lost event count: " + std::to_string(mEbpfLostCount));
-        sMonitor->UpdateMetric("observer_input_events", mInputEvents);
-        sMonitor->UpdateMetric("observer_input_bytes", mInputBytes);
-        sMonitor->UpdateMetric("observer_output_events", mOutputEvents);
-        sMonitor->UpdateMetric("observer_output_raw_bytes", mOutputBytes);
-        sMonitor->UpdateMetric("observer_unmatched_protocol_event", mProtocolUnMatched);
-        sMonitor->UpdateMetric("observer_matched_protocol_event", mProtocolMatched);
-        sMonitor->UpdateMetric("observer_gc_count", mGCCount);
-        sMonitor->UpdateMetric("observer_gc_release_conn_count", mGCReleaseConnCount);
-        sMonitor->UpdateMetric("observer_gc_release_process_count", mGCReleaseProcessCount);
-        sMonitor->UpdateMetric("observer_gc_ebpf_count", mEbpfGCCount);
-        sMonitor->UpdateMetric("observer_gc_ebpf_release_fd_count", mEbpfGCReleaseFDCount);
-        sMonitor->UpdateMetric("observer_ebpf_disable_processes", mEbpfDisableProcesses);
-        sMonitor->UpdateMetric("observer_ebpf_holding_connections", mEbpfUsingConnections);
-        sMonitor->UpdateMetric("observer_ebpf_lost_count", mEbpfLostCount);
-        doClear();
+                                               "ebpf lost event count: " + std::to_string(lostCount));
+        sMonitor->UpdateMetric("observer_input_events", mInputEvents.Take());
+        sMonitor->UpdateMetric("observer_input_bytes", mInputBytes.Take());
+        sMonitor->UpdateMetric("observer_output_events", mOutputEvents.Take());
+        sMonitor->UpdateMetric("observer_output_raw_bytes", mOutputBytes.Take());
+        sMonitor->UpdateMetric("observer_unmatched_protocol_event", mProtocolUnMatched.Take());
+        sMonitor->UpdateMetric("observer_matched_protocol_event", mProtocolMatched.Take());
+        sMonitor->UpdateMetric("observer_gc_count", mGCCount.Take());
+        sMonitor->UpdateMetric("observer_gc_release_conn_count", mGCReleaseConnCount.Take());
+        sMonitor->UpdateMetric("observer_gc_release_process_count", mGCReleaseProcessCount.Take());
+        sMonitor->UpdateMetric("observer_gc_ebpf_count", mEbpfGCCount.Take());
+        sMonitor->UpdateMetric("observer_gc_ebpf_release_fd_count", mEbpfGCReleaseFDCount.Take());
+        sMonitor->UpdateMetric("observer_ebpf_disable_processes", mEbpfDisableProcesses.Take());
+        sMonitor->UpdateMetric("observer_ebpf_holding_connections", mEbpfUsingConnections.Take());
+        sMonitor->UpdateMetric("observer_ebpf_lost_count", lostCount);
     }
 
     std::string ToString() const {
@@ -225,21 +252,21 @@ private:
 
 // Global statistics for protocol
 struct ProtocolStatistic {
-    uint32_t mHTTPParseFailCount{0};
-    uint32_t mRedisParseFailCount{0};
-    uint32_t mMySQLParseFailCount{0};
-    uint32_t mPgSQLParseFailCount{0};
-    uint32_t mDNSParseFailCount{0};
-    uint32_t mHTTPDropCount{0};
-    uint32_t mRedisDropCount{0};
-    uint32_t mMySQLDropCount{0};
-    uint32_t mPgSQLDropCount{0};
-    uint32_t mDNSDropCount{0};
-    uint32_t mHTTPCount{0};
-    uint32_t mRedisCount{0};
-    uint32_t mMySQLCount{0};
-    uint32_t mPgSQLCount{0};
-    uint32_t mDNSCount{0};
+    StatisticCounter mHTTPParseFailCount{0};
+    StatisticCounter mRedisParseFailCount{0};
+    StatisticCounter mMySQLParseFailCount{0};
+    StatisticCounter mPgSQLParseFailCount{0};
+    StatisticCounter mDNSParseFailCount{0};
+    StatisticCounter mHTTPDropCount{0};
+    StatisticCounter mRedisDropCount{0};
+    StatisticCounter mMySQLDropCount{0};
+    StatisticCounter mPgSQLDropCount{0};
+    StatisticCounter mDNSDropCount{0};
+    StatisticCounter mHTTPCount{0};
+    StatisticCounter mRedisCount{0};
+    StatisticCounter mMySQLCount{0};
+    StatisticCounter mPgSQLCount{0};
+    StatisticCounter mDNSCount{0};
 
     static ProtocolStatistic* GetInstance() {
         static auto ptr = new ProtocolStatistic();
@@ -254,22 +281,21 @@ struct ProtocolStatistic {
     void FlushMetrics() {
         static auto sMonitor = LogtailMonitor::GetInstance();
 
-        sMonitor->UpdateMetric("observer_protocol_http_drop_count", mHTTPDropCount);
-        sMonitor->UpdateMetric("observer_protocol_dns_drop_count", mDNSDropCount);
-        sMonitor->UpdateMetric("observer_protocol_mysql_drop_count", mMySQLDropCount);
-        sMonitor->UpdateMetric("observer_protocol_pgsql_drop_count", mPgSQLDropCount);
-        sMonitor->UpdateMetric("observer_protocol_redis_drop_count", mRedisDropCount);
-        sMonitor->UpdateMetric("observer_protocol_http_count", mHTTPCount);
-        sMonitor->UpdateMetric("observer_protocol_dns_count", mDNSCount);
-        sMonitor->UpdateMetric("observer_protocol_mysql_count", mMySQLCount);
-        sMonitor->UpdateMetric("observer_protocol_pgsql_count", mPgSQLCount);
-        sMonitor->UpdateMetric("observer_protocol_redis_count", mRedisCount);
-        sMonitor->UpdateMetric("observer_protocol_http_parse_fail_count", mHTTPParseFailCount);
-        sMonitor->UpdateMetric("observer_protocol_dns_parse_fail_count", mDNSParseFailCount);
-        sMonitor->UpdateMetric("observer_protocol_mysql_parse_fail_count", mMySQLParseFailCount);
-        sMonitor->UpdateMetric("observer_protocol_pgsql_parse_fail_count", mPgSQLParseFailCount);
-        sMonitor->UpdateMetric("observer_protocol_redis_parse_fail_count", mRedisParseFailCount);
-        doClear();
+        sMonitor->UpdateMetric("observer_protocol_http_drop_count", mHTTPDropCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_dns_drop_count", mDNSDropCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_mysql_drop_count", mMySQLDropCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_pgsql_drop_count", mPgSQLDropCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_redis_drop_count", mRedisDropCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_http_count", mHTTPCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_dns_count", mDNSCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_mysql_count", mMySQLCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_pgsql_count", mPgSQLCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_redis_count", mRedisCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_http_parse_fail_count", mHTTPParseFailCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_dns_parse_fail_count", mDNSParseFailCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_mysql_parse_fail_count", mMySQLParseFailCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_pgsql_parse_fail_count", mPgSQLParseFailCount.Take());
+        sMonitor->UpdateMetric("observer_protocol_redis_parse_fail_count", mRedisParseFailCount.Take());
     }
 
     std::string ToString() const {
@@ -316,16 +342,16 @@ private:
 
 // Global statistics for analyse the memory usage of different protocol parsers.
 struct ProtocolDebugStatistic {
-    uint32_t mHTTPConnectionNum{0};
-    uint32_t mHTTPConnectionCachedSize{0};
-    uint32_t mDNSConnectionNum{0};
-    uint32_t mDNSConnectionCachedSize{0};
-    uint32_t mRedisConnectionNum{0};
-    uint32_t mRedisConnectionCachedSize{0};
-    uint32_t mMySQLConnectionNum{0};
-    uint32_t mMySQLConnectionCachedSize{0};
-    uint32_t mPgSQLConnectionNum{0};
-    uint32_t mPgSQLConnectionCachedSize{0};
+    StatisticCounter mHTTPConnectionNum{0};
+    StatisticCounter mHTTPConnectionCachedSize{0};
+    StatisticCounter mDNSConnectionNum{0};
+    StatisticCounter mDNSConnectionCachedSize{0};
+    StatisticCounter mRedisConnectionNum{0};
+    StatisticCounter mRedisConnectionCachedSize{0};
+    StatisticCounter mMySQLConnectionNum{0};
+    StatisticCounter mMySQLConnectionCachedSize{0};
+    StatisticCounter mPgSQLConnectionNum{0};
+    StatisticCounter mPgSQLConnectionCachedSize{0};
 
     static ProtocolDebugStatistic* GetInstance() {
         static auto ptr = new ProtocolDebugStatistic();
@@ -13,6 +13,11 @@
 // limitations under the License.
 
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#include <dirent.h>
+#include <chrono>
 #include <linux/sock_diag.h>
 #include <linux/unix_diag.h>
 #include <linux/inet_diag.h>
@@ -53,6 +58,7 @@ uint32_t ReadSocketInodeNum(const std::string& path, int8_t& errorCode) {
 
 
 bool ConnectionMetaManager::Init(const std::string& procBashPath) {
+    std::lock_guard<std::mutex> lock(mMutex);
     if (!this->mBashProcPath.empty()) {
         return true;
     }
@@ -69,49 +75,86 @@ bool ConnectionMetaManager::Init(const std::string& procBashPath) {
         return false;
     }
     this->mBashProcPath = bashPath;
+    struct statfs procStat;
+    this->mFdDirSizeIsCount = statfs(bashPath.c_str(), &procStat) == 0 && procStat.f_type == PROC_SUPER_MAGIC;
     LOG_INFO(sLogger, ("init observer connection manager", "success")("proc path", bashPath));
     return true;
 }
 
 ConnectionInfoPtr ConnectionMetaManager::GetConnectionInfo(uint32_t pid, uint32_t fd) {
+    std::lock_guard<std::mutex> lock(mMutex);
     ++mConnMetaStatistic->mGetSocketInfoCount;
-    std::string fdPath = this->mBashProcPath;
-    fdPath.append(std::to_string(pid)).append("/fd/").append(std::to_string(fd));
-    std::string fdLinkPath;
-    ReadFdLink(fdPath, fdLinkPath);
-    if (fdLinkPath.empty()) {
-        LOG_DEBUG(sLogger, ("fetch connection meta", "fail")("path", fdPath));
+    ProcessSockets& process = mProcessSockets[pid];
+    if (process.CheckGeneration == 0 && !CheckProcess(pid, process)) {
+        mProcessSockets.erase(pid);
+        LOG_DEBUG(sLogger, ("fetch connection meta", "fail")("process not exist", pid));
         ++mConnMetaStatistic->mGetSocketInfoFailCount;
         return nullptr;
     }
-    int8_t errorCode;
-    uint32_t inode = ReadSocketInodeNum(fdLinkPath, errorCode);
-    if (errorCode < 0) {
-        LOG_DEBUG(sLogger, ("fetch connection meta", "fail")("fdLink", fdLinkPath));
-        ++mConnMetaStatistic->mGetSocketInfoFailCount;
-        return nullptr;
+    uint32_t inode = 0;
+    auto fdIter = process.FdInodes.find(fd);
+    if (fdIter != process.FdInodes.end()) {
+        inode = fdIter->second;
+    } else {
+        std::string fdPath = this->mBashProcPath;
+        fdPath.append(std::to_string(pid)).append("/fd/").append(std::to_string(fd));
+        std::string fdLinkPath;
+        ReadFdLink(fdPath, fdLinkPath);
+        if (fdLinkPath.empty()) {
+            LOG_DEBUG(sLogger, ("fetch connection meta", "fail")("path", fdPath));
+            ++mConnMetaStatistic->mGetSocketInfoFailCount;
+            return nullptr;
+        }
+        int8_t errorCode;
+        inode = ReadSocketInodeNum(fdLinkPath, errorCode);
+        if (errorCode < 0) {
+            LOG_DEBUG(sLogger, ("fetch connection meta", "fail")("fdLink", fdLinkPath));
+            ++mConnMetaStatistic->mGetSocketInfoFailCount;
+            return nullptr;
+        }
+        process.FdInodes.insert(std::make_pair(fd, inode));
     }
     auto meta = mConnectionMeta.find(inode);
     if (meta != mConnectionMeta.end()) {
         return meta->second;
     }
     static auto sProberManger = NamespacedProberManger::GetInstance(this->mBashProcPath);
-    auto prober = sProberManger->GetOrCreateProber(pid);
+    if (process.NetNsInode == 0) {
+        process.NetNsInode = sProberManger->GetNetNsInode(pid);
+    }
     ++mConnMetaStatistic->mGetNetlinkProberCount;
-    if (prober == nullptr) {
-        LOG_DEBUG(sLogger, ("fetch connection meta", "fail")("prober create fail", pid));
+    if (process.NetNsInode == 0) {
+        LOG_DEBUG(sLogger, ("fetch connection meta", "fail")("cannot read net ns", pid));
         ++mConnMetaStatistic->mGetSocketInfoFailCount;
         ++mConnMetaStatistic->mGetNetlinkProberFailCount;
         return nullptr;
     }
-    if (mProberFetchLog.find(prober->Inode()) != mProberFetchLog.end()) {
+    // a namespace is fetched at most once in a generation
+    NetNsConnections& netNs = mNetNsConnections[process.NetNsInode];
+    if (netNs.FetchGeneration == mGeneration) {
         ++mConnMetaStatistic->mGetSocketInfoFailCount;
         return nullptr;
     }
-    mProberFetchLog.insert(prober->Inode());
+    auto prober = sProberManger->GetOrCreateProber(pid, process.NetNsInode);
+    if (prober == nullptr) {
+        LOG_DEBUG(sLogger, ("fetch connection meta", "fail")("prober create fail", pid));
+        ++mConnMetaStatistic->mGetSocketInfoFailCount;
+        ++mConnMetaStatistic->mGetNetlinkProberFailCount;
+        return nullptr;
+    }
+    netNs.FetchGeneration = mGeneration;
     ++mConnMetaStatistic->mFetchNetlinkCount;
-    prober->FetchInetConnections(this->mConnectionMeta);
-    prober->FetchUnixConnections(this->mConnectionMeta);
+    // a dump of sock_diag always returns all sockets of the namespace, so only the update is incremental
+    auto fetchStart = std::chrono::steady_clock::now();
+    std::unordered_map<uint32_t, ConnectionInfo> infos;
+    prober->FetchInetConnections(infos);
+    prober->FetchUnixConnections(infos);
+    size_t changed = UpdateNetNsConnections(netNs, infos);
+    LOG_DEBUG(sLogger,
+              ("fetch netlink connections", infos.size())("changed", changed)(
+                  "cost us",
+                  std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - fetchStart)
+                      .count()));
 
     meta = mConnectionMeta.find(inode);
     if (meta != mConnectionMeta.end()) {
@@ -125,9 +168,80 @@ ConnectionInfoPtr ConnectionMetaManager::GetConnectionInfo(uint32_t pid, uint32_
     return nullptr;
 }
 
+void ConnectionMetaManager::OnConnectionChanged(uint32_t pid, uint32_t fd) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto findIter = mProcessSockets.find(pid);
+    if (findIter != mProcessSockets.end()) {
+        findIter->second.FdInodes.erase(fd);
+    }
+}
+
+size_t ConnectionMetaManager::UpdateNetNsConnections(NetNsConnections& netNs,
+                                                     const std::unordered_map<uint32_t, ConnectionInfo>& infos) {
+    for (auto iter = netNs.Inodes.begin(); iter != netNs.Inodes.end();) {
+        if (infos.find(*iter) == infos.end()) {
+            mConnectionMeta.erase(*iter);
+            iter = netNs.Inodes.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    size_t changed = 0;
+    for (const auto& item : infos) {
+        // infos returned before are shared with sources out of the lock, so a changed state or role gets a new info
+        // rather than being updated in place
+        ConnectionInfoPtr& meta = mConnectionMeta[item.first];
+        if (meta == nullptr || !(*meta == item.second)) {
+            meta = std::make_shared<ConnectionInfo>(item.second);
+            netNs.Inodes.insert(item.first);
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+bool ConnectionMetaManager::CheckProcess(uint32_t pid, ProcessSockets& process) {
+    std::string processPath = this->mBashProcPath;
+    processPath.append(std::to_string(pid));
+    uint64_t startTime = ReadProcessStartTime(processPath + "/stat");
+    if (startTime == 0 || (process.CheckGeneration != 0 && startTime != process.StartTime)) {
+        return false;
+    }
+    int64_t fdCount = ReadProcessFdCount(processPath + "/fd", mFdDirSizeIsCount);
+    if (fdCount < 0) {
+        return false;
+    }
+    if (process.CheckGeneration != 0 && static_cast<uint64_t>(fdCount) != process.FdCount) {
+        process.FdInodes.clear();
+    }
+    process.StartTime = startTime;
+    process.FdCount = static_cast<uint64_t>(fdCount);
+    process.CheckGeneration = mGeneration;
+    return true;
+}
+
 bool ConnectionMetaManager::GarbageCollection() {
-    mConnectionMeta.erase(this->mConnectionMeta.begin(), this->mConnectionMeta.end());
-    mProberFetchLog.erase(this->mProberFetchLog.begin(), this->mProberFetchLog.end());
+    // namespaces not fetched in so many generations may not exist anymore
+    static const uint64_t kNetNsMaxIdleGenerations = 10;
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mGeneration;
+    for (auto iter = mProcessSockets.begin(); iter != mProcessSockets.end();) {
+        if (CheckProcess(iter->first, iter->second)) {
+            ++iter;
+        } else {
+            iter = mProcessSockets.erase(iter);
+        }
+    }
+    for (auto iter = mNetNsConnections.begin(); iter != mNetNsConnections.end();) {
+        if (iter->second.FetchGeneration + kNetNsMaxIdleGenerations < mGeneration) {
+            for (auto inode : iter->second.Inodes) {
+                mConnectionMeta.erase(inode);
+            }
+            iter = mNetNsConnections.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
     static auto sProberManger = NamespacedProberManger::GetInstance(this->mBashProcPath);
     sProberManger->GarbageCollection();
     return true;
@@ -196,7 +310,7 @@ bool NetLinkProber::SendMsg(const msgType& realMsg, std::string& errorMsg) {
 }
 
 template <typename msgType>
-bool NetLinkProber::ReceiveMsg(std::unordered_map<uint32_t, ConnectionInfoPtr>& infos, std::string& errorMsg) {
+bool NetLinkProber::ReceiveMsg(std::unordered_map<uint32_t, ConnectionInfo>& infos, std::string& errorMsg) {
     static int bufSize = 8192;
     long buffer[bufSize / sizeof(long)];
 
@@ -244,7 +358,7 @@ bool NetLinkProber::ReceiveMsg(std::unordered_map<uint32_t, ConnectionInfoPtr>&
     return true;
 }
 
-void NetLinkProber::FetchInetConnections(std::unordered_map<uint32_t, ConnectionInfoPtr>& infos, int connStat) {
+void NetLinkProber::FetchInetConnections(std::unordered_map<uint32_t, ConnectionInfo>& infos, int connStat) {
     inet_diag_req_v2 req = {};
     req.sdiag_protocol = IPPROTO_TCP;
     req.idiag_states = connStat;
@@ -275,26 +389,26 @@ void NetLinkProber::FetchInetConnections(std::unordered_map<uint32_t, Connection
         return;
     }
 
-    std::unordered_set<ConnectionInfoPtr, ConnectionInfoPtrHashFn, ConnectionInfoPtrEqFn> connSet;
+    std::unordered_set<const ConnectionInfo*, ConnectionInfoPtrHashFn, ConnectionInfoPtrEqFn> connSet;
     for (const auto& item : infos) {
-        if (item.second->stat == TCPConnectionStat::Listening) {
-            connSet.insert(item.second);
+        if (item.second.stat == TCPConnectionStat::Listening) {
+            connSet.insert(&item.second);
         }
     }
-    ConnectionInfoPtr ip = std::make_shared<ConnectionInfo>();
-    ip->localAddr.Addr = {};
-    for (const auto& item : infos) {
-        ip->localPort = item.second->localPort;
-        ip->localAddr.Type = item.second->localAddr.Type;
-        if (connSet.find(ip) != connSet.end() || connSet.find(item.second) != connSet.end()) {
-            item.second->role = PacketRoleType::Server;
+    ConnectionInfo ip{};
+    ip.localAddr.Addr = {};
+    for (auto& item : infos) {
+        ip.localPort = item.second.localPort;
+        ip.localAddr.Type = item.second.localAddr.Type;
+        if (connSet.find(&ip) != connSet.end() || connSet.find(&item.second) != connSet.end()) {
+            item.second.role = PacketRoleType::Server;
         } else {
-            item.second->role = PacketRoleType::Client;
+            item.second.role = PacketRoleType::Client;
         }
     }
 }
 
-void NetLinkProber::FetchUnixConnections(std::unordered_map<uint32_t, ConnectionInfoPtr>& infos, int connStat) {
+void NetLinkProber::FetchUnixConnections(std::unordered_map<uint32_t, ConnectionInfo>& infos, int connStat) {
     unix_diag_req req = {};
     std::string errorMsg;
     req.sdiag_family = AF_UNIX;
@@ -322,7 +436,7 @@ NetLinkProber::~NetLinkProber() {
 
 bool ExtractDiagMsg(const inet_diag_msg& msg,
                     uint32_t len,
-                    std::unordered_map<uint32_t, ConnectionInfoPtr>& infos,
+                    std::unordered_map<uint32_t, ConnectionInfo>& infos,
                     std::string& errorMsg) {
     if (len < sizeof(msg)) {
         errorMsg = "no enough netlink data";
@@ -342,38 +456,37 @@ bool ExtractDiagMsg(const inet_diag_msg& msg,
         errorMsg = "duplicate inode msg " + std::to_string(inode);
         return false;
     }
-    auto info = std::make_shared<ConnectionInfo>();
-    info->family = msg.idiag_family;
-    info->localPort = ntohs(msg.id.idiag_sport);
-    info->remotePort = ntohs(msg.id.idiag_dport);
-    info->stat = static_cast<TCPConnectionStat>(msg.idiag_state);
+    ConnectionInfo& info = infos[inode];
+    info.family = msg.idiag_family;
+    info.localPort = ntohs(msg.id.idiag_sport);
+    info.remotePort = ntohs(msg.id.idiag_dport);
+    info.stat = static_cast<TCPConnectionStat>(msg.idiag_state);
 
     if (msg.idiag_family == AF_INET) {
-        info->localAddr = SockAddress{.Type = SockAddressType_IPV4,
+        info.localAddr = SockAddress{.Type = SockAddressType_IPV4,
+                                     .Addr = SockAddressDetail{
+                                         .IPV4 = msg.id.idiag_src[0],
+                                     }};
+        info.remoteAddr = SockAddress{.Type = SockAddressType_IPV4,
                                       .Addr = SockAddressDetail{
-                                          .IPV4 = msg.id.idiag_src[0],
+                                          .IPV4 = msg.id.idiag_dst[0],
                                       }};
-        info->remoteAddr = SockAddress{.Type = SockAddressType_IPV4,
-                                       .Addr = SockAddressDetail{
-                                           .IPV4 = msg.id.idiag_dst[0],
-                                       }};
     } else if (msg.idiag_family == AF_INET6) {
-        info->localAddr = SockAddress{.Type = SockAddressType_IPV6,
+        info.localAddr = SockAddress{.Type = SockAddressType_IPV6,
+                                     .Addr = SockAddressDetail{
+                                         .IPV6 = {((uint64_t*)msg.id.idiag_src)[0], ((uint64_t*)msg.id.idiag_src)[1]},
+                                     }};
+        info.remoteAddr = SockAddress{.Type = SockAddressType_IPV6,
                                       .Addr = SockAddressDetail{
-                                          .IPV6 = {((uint64_t*)msg.id.idiag_src)[0], ((uint64_t*)msg.id.idiag_src)[1]},
+                                          .IPV6 = {((uint64_t*)msg.id.idiag_dst)[0], ((uint64_t*)msg.id.idiag_dst)[1]},
                                       }};
-        info->remoteAddr = SockAddress{.Type = SockAddressType_IPV6,
-                                       .Addr = SockAddressDetail{
-                                           .IPV6 = {((uint64_t*)msg.id.idiag_dst)[0], ((uint64_t*)msg.id.idiag_dst)[1]},
-                                       }};
     }
-    infos.insert(std::make_pair(inode, info));
     return true;
 }
 
 bool ExtractDiagMsg(const unix_diag_msg& msg,
                     uint32_t len,
-                    std::unordered_map<uint32_t, ConnectionInfoPtr>& infos,
+                    std::unordered_map<uint32_t, ConnectionInfo>& infos,
                     std::string& errorMsg) {
     if (len < sizeof(msg)) {
         errorMsg = "no enough netlink data";
@@ -401,17 +514,16 @@ bool ExtractDiagMsg(const unix_diag_msg& msg,
         errorMsg = "duplicate inode msg " + std::to_string(msg.udiag_ino);
         return false;
     }
-    auto info = std::make_shared<ConnectionInfo>();
-    info->family = msg.udiag_family;
-    info->localPort = msg.udiag_ino;
-    info->remotePort = peer;
-    info->stat = static_cast<TCPConnectionStat>(msg.udiag_state);
-    info->localAddr = SockAddress{.Type = SockAddressType_IPV4,
-                                  .Addr = SockAddressDetail{
-                                      .IPV4 = 0,
-                                  }};
-    info->remoteAddr = info->localAddr;
-    infos.insert(std::make_pair(msg.udiag_ino, info));
+    ConnectionInfo& info = infos[msg.udiag_ino];
+    info.family = msg.udiag_family;
+    info.localPort = msg.udiag_ino;
+    info.remotePort = peer;
+    info.stat = static_cast<TCPConnectionStat>(msg.udiag_state);
+    info.localAddr = SockAddress{.Type = SockAddressType_IPV4,
+                                 .Addr = SockAddressDetail{
+                                     .IPV4 = 0,
+                                 }};
+    info.remoteAddr = info.localAddr;
     return true;
 }
 
@@ -474,31 +586,43 @@ void NetLinkBinder::Close() {
     }
 }
 
-std::shared_ptr<NetLinkProber> NamespacedProberManger::GetOrCreateProber(uint32_t pid) {
+uint32_t NamespacedProberManger::GetNetNsInode(uint32_t pid) {
     std::string nsPath = this->mBaseProcPath;
     nsPath.append(std::to_string(pid)).append("/ns/net");
     std::string fdLink;
     ReadFdLink(nsPath, fdLink);
     if (fdLink.empty()) {
         LOG_DEBUG(sLogger, ("get netlink prober", "fail")("cannot read fdlink path", fdLink));
-        return nullptr;
+        return 0;
     }
     int8_t errorCode;
     uint32_t inode = ReadNetworkNsInodeNum(fdLink, errorCode);
     if (errorCode < 0) {
         LOG_DEBUG(sLogger, ("get netlink prober", "fail")("cannot read net inode", nsPath)("error", errorCode));
+        return 0;
+    }
+    return inode;
+}
+
+std::shared_ptr<NetLinkProber> NamespacedProberManger::GetOrCreateProber(uint32_t pid) {
+    uint32_t inode = GetNetNsInode(pid);
+    if (inode == 0) {
         return nullptr;
     }
-    auto item = this->mProbers.find(inode);
+    return GetOrCreateProber(pid, inode);
+}
+
+std::shared_ptr<NetLinkProber> NamespacedProberManger::GetOrCreateProber(uint32_t pid, uint32_t netNsInode) {
+    auto item = this->mProbers.find(netNsInode);
     if (item != this->mProbers.end()) {
         return item->second;
     }
-    auto prober = std::make_shared<NetLinkProber>(pid, inode, this->mBaseProcPath);
+    auto prober = std::make_shared<NetLinkProber>(pid, netNsInode, this->mBaseProcPath);
     if (prober->Status() < 0) {
         LOG_DEBUG(sLogger, ("get netlink prober", "fail")("prober create fail", prober->Status()));
         return nullptr;
     }
-    this->mProbers.insert(std::make_pair(inode, prober));
+    this->mProbers.insert(std::make_pair(netNsInode, prober));
     return prober;
 }
 
@@ -514,4 +638,50 @@ void ReadFdLink(std::string& fdPath, std::string& fdLinkPath) {
         fdLinkPath = path.string();
     }
 }
+
+uint64_t ReadProcessStartTime(const std::string& statPath) {
+    std::string content;
+    if (!ReadFileContent(statPath, content, 1024) || content.empty()) {
+        return 0;
+    }
+    // the command in the second field may have spaces, fields are counted from its closing parenthesis
+    size_t pos = content.rfind(')');
+    if (pos == std::string::npos) {
+        return 0;
+    }
+    // starttime is the 22nd field, 20 fields after the command
+    for (int field = 0; field < 20; ++field) {
+        pos = content.find(' ', pos + 1);
+        if (pos == std::string::npos) {
+            return 0;
+        }
+    }
+    return std::strtoull(content.c_str() + pos + 1, NULL, 10);
+}
+
+int64_t ReadProcessFdCount(const std::string& fdDirPath, bool sizeIsCount) {
+    if (sizeIsCount) {
+        struct stat fdDirStat;
+        if (stat(fdDirPath.c_str(), &fdDirStat) != 0) {
+            return -1;
+        }
+        // the size of a fd directory of procfs is the count of its fds since linux 6.2, and 0 before
+        if (fdDirStat.st_size > 0) {
+            return fdDirStat.st_size;
+        }
+    }
+    DIR* dir = opendir(fdDirPath.c_str());
+    if (dir == NULL) {
+        return -1;
+    }
+    int64_t count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            ++count;
+        }
+    }
+    closedir(dir);
+    return count;
+}
 } // namespace logtail
\ No newline at end of file
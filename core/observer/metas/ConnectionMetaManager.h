@@ -18,7 +18,9 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <fcntl.h>
 #include <sys/socket.h>
 #include <ostream>
@@ -66,12 +68,18 @@ struct ConnectionInfo {
     }
 
     void Print() { std::cout << *this << std::endl; }
+
+    bool operator==(const ConnectionInfo& other) const {
+        return family == other.family && localAddr == other.localAddr && remoteAddr == other.remoteAddr
+            && localPort == other.localPort && remotePort == other.remotePort && stat == other.stat
+            && role == other.role;
+    }
 };
 
 typedef std::shared_ptr<ConnectionInfo> ConnectionInfoPtr;
 
 struct ConnectionInfoPtrHashFn {
-    size_t operator()(const ConnectionInfoPtr& ptr) const {
+    size_t operator()(const ConnectionInfo* ptr) const {
         size_t hash = XXH32(reinterpret_cast<char*>(ptr->localAddr.Addr.IPV6), sizeof(union SockAddressDetail), 0);
         hash = XXH32(&ptr->localPort, sizeof(ptr->localPort), hash);
         return hash;
@@ -79,7 +87,7 @@ struct ConnectionInfoPtrHashFn {
 };
 
 struct ConnectionInfoPtrEqFn {
-    size_t operator()(const ConnectionInfoPtr& a, const ConnectionInfoPtr& b) const {
+    size_t operator()(const ConnectionInfo* a, const ConnectionInfo* b) const {
         return a->localPort == b->localPort && a->localAddr == b->localAddr;
     }
 };
@@ -108,11 +116,11 @@ class NetLinkProber {
 public:
     explicit NetLinkProber(uint32_t pid, uint32_t inode, const std::string& procPath = "/proc/");
 
-    void FetchInetConnections(std::unordered_map<uint32_t, ConnectionInfoPtr>& infos,
+    void FetchInetConnections(std::unordered_map<uint32_t, ConnectionInfo>& infos,
                               int connStat
                               = (1 << (int)TCPConnectionStat::Established) | (1 << (int)TCPConnectionStat::Listening));
 
-    void FetchUnixConnections(std::unordered_map<uint32_t, ConnectionInfoPtr>& infos,
+    void FetchUnixConnections(std::unordered_map<uint32_t, ConnectionInfo>& infos,
                               int connStat
                               = (1 << (int)TCPConnectionStat::Established) | (1 << (int)TCPConnectionStat::Listening));
 
@@ -139,7 +147,7 @@ private:
      * 2. pixie
      */
     template <typename msgType>
-    bool ReceiveMsg(std::unordered_map<uint32_t, ConnectionInfoPtr>& infos, std::string& errorMsg);
+    bool ReceiveMsg(std::unordered_map<uint32_t, ConnectionInfo>& infos, std::string& errorMsg);
 
     int mFd = -1;
     int8_t mStatus = 0;
@@ -156,6 +164,13 @@ public:
 
     std::shared_ptr<NetLinkProber> GetOrCreateProber(uint32_t pid);
 
+    std::shared_ptr<NetLinkProber> GetOrCreateProber(uint32_t pid, uint32_t netNsInode);
+
+    /**
+     * @return the inode of the network namespace of pid, or 0 when it cannot be read.
+     */
+    uint32_t GetNetNsInode(uint32_t pid);
+
     void GarbageCollection();
 
 private:
@@ -166,6 +181,25 @@ private:
 };
 
 
+// ProcessSockets caches the socket inodes of the fds of a process. They are kept while the start time and the fd
+// count of the process stay the same, which are checked once a generation, and fds reported by connect or close
+// events are forgotten at once.
+struct ProcessSockets {
+    uint64_t StartTime = 0;
+    uint64_t FdCount = 0;
+    // the generation when StartTime and FdCount were read, 0 if they are not read
+    uint64_t CheckGeneration = 0;
+    uint32_t NetNsInode = 0;
+    std::unordered_map<uint32_t, uint32_t> FdInodes;
+};
+
+// NetNsConnections records the connection inodes fetched from a network namespace, so that a fetch only adds, changes
+// and removes the difference from the previous one.
+struct NetNsConnections {
+    uint64_t FetchGeneration = 0;
+    std::unordered_set<uint32_t> Inodes;
+};
+
 class ConnectionMetaManager {
 public:
     static ConnectionMetaManager* GetInstance() {
@@ -176,6 +210,17 @@ public:
 
     ConnectionInfoPtr GetConnectionInfo(uint32_t pid, uint32_t fd);
 
+    /**
+     * @brief OnConnectionChanged forgets the cached socket of fd, which is connected or closed, because the fd may be
+     * reused by another socket.
+     */
+    void OnConnectionChanged(uint32_t pid, uint32_t fd);
+
+    /**
+     * @brief GarbageCollection starts a new generation. Network namespaces may be fetched again once in a generation,
+     * processes whose start time or fd count changed are rescanned, and connections of namespaces not fetched for
+     * long are dropped.
+     */
     bool GarbageCollection();
 
     void Print();
@@ -183,11 +228,31 @@ public:
 private:
     ConnectionMetaManager() { mConnMetaStatistic = ConnectionMetaStatistic::GetInstance(); }
 
+    /**
+     * @brief UpdateNetNsConnections applies the fetched infos to the connections of a network namespace. Known
+     * connections whose info is unchanged are kept as they are, a new info is only created for new or changed ones,
+     * and the inodes gone since the last fetch are removed.
+     * @return the count of new or changed connections.
+     */
+    size_t UpdateNetNsConnections(NetNsConnections& netNs, const std::unordered_map<uint32_t, ConnectionInfo>& infos);
+
+    // CheckProcess reads the start time and the fd count of pid, the fd cache is cleared when they changed.
+    // @return false if the process does not exist or is a new one with the same pid.
+    bool CheckProcess(uint32_t pid, ProcessSockets& process);
+
 private:
     ConnectionMetaStatistic* mConnMetaStatistic;
+    // connections are looked up by sources, and garbage collected by the maintenance of NetworkObserver
+    std::mutex mMutex;
     std::string mBashProcPath;
+    bool mFdDirSizeIsCount = false;
+    uint64_t mGeneration = 1;
     std::unordered_map<uint32_t, ConnectionInfoPtr> mConnectionMeta{};
-    std::unordered_set<uint32_t> mProberFetchLog{};
+    std::unordered_map<uint32_t, NetNsConnections> mNetNsConnections{};
+    std::unordered_map<uint32_t, ProcessSockets> mProcessSockets{};
+
+    friend class ConnectionMetaUnitTest;
+    friend class ConnectionMetaBenchmark;
 };
 
 
@@ -198,4 +263,15 @@ uint32_t ReadNetworkNsInodeNum(const std::string& path, int8_t& errorCode);
 uint32_t ReadSocketInodeNum(const std::string& path, int8_t& errorCode);
 
 void ReadFdLink(std::string& fdPath, std::string& fdLinkPath);
+
+/**
+ * @return the start time of the process in clock ticks from its stat file, such as /proc/1/stat, or 0 on failure.
+ */
+uint64_t ReadProcessStartTime(const std::string& statPath);
+
+/**
+ * @param sizeIsCount whether the directory is on procfs, whose size may be the count of fds without listing it.
+ * @return the count of open fds in the fd directory of a process, such as /proc/1/fd, or -1 on failure.
+ */
+int64_t ReadProcessFdCount(const std::string& fdDirPath, bool sizeIsCount);
 } // namespace logtail
@@ -36,9 +36,35 @@ void ContainerProcessGroup::FlushOutMetrics(uint64_t timeNano,
     mAggregator.FlushOutMetrics(timeNano, allData, metaTags, tags, interval);
 }
 
+ProtocolEventAggregators* ContainerProcessGroup::GetWorkerAggregator(size_t index) {
+    std::lock_guard<std::mutex> lock(mWorkerAggregatorsMutex);
+    if (mWorkerAggregators.size() <= index) {
+        mWorkerAggregators.resize(index + 1);
+    }
+    if (!mWorkerAggregators[index]) {
+        mWorkerAggregators[index].reset(new ProtocolEventAggregators);
+        mWorkerAggregators[index]->SetProcessMeta(mMetaPtr);
+    }
+    return mWorkerAggregators[index].get();
+}
+
+void ContainerProcessGroup::MergeWorkerAggregator(size_t index) {
+    ProtocolEventAggregators* aggregator = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mWorkerAggregatorsMutex);
+        if (index < mWorkerAggregators.size()) {
+            aggregator = mWorkerAggregators[index].get();
+        }
+    }
+    if (aggregator != nullptr) {
+        mAggregator.MergeFrom(*aggregator);
+    }
+}
+
 void ContainerProcessGroupManager::FlushOutMetrics(std::vector<sls_logs::Log>& allData,
                                                    std::vector<std::pair<std::string, std::string>>& tags,
                                                    uint64_t interval) {
+    std::lock_guard<std::mutex> lock(mMutex);
     uint64_t timeNano = GetCurrentTimeInNanoSeconds();
     for (auto& iter : mPureProcessGroupMap) {
         iter.second->FlushOutMetrics(timeNano, allData, tags, interval);
@@ -48,8 +74,19 @@ void ContainerProcessGroupManager::FlushOutMetrics(std::vector<sls_logs::Log>& a
     }
 }
 
+void ContainerProcessGroupManager::MergeWorkerAggregators(size_t index) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& iter : mPureProcessGroupMap) {
+        iter.second->MergeWorkerAggregator(index);
+    }
+    for (auto& iter : mContainerProcessGroupMap) {
+        iter.second->MergeWorkerAggregator(index);
+    }
+}
+
 
 bool ContainerProcessGroupManager::Init(const std::string& cgroupPath) {
+    std::lock_guard<std::mutex> lock(mMutex);
     if (!this->mGgoupBasePath.empty()) {
         return true;
     }
@@ -114,6 +151,7 @@ int32_t ContainerProcessGroupManager::DetectContainerType(const std::string& pro
 }
 
 void ContainerProcessGroupManager::FlushMetas() {
+    std::lock_guard<std::mutex> lock(mMutex);
     // ProcessMetaStatistic is the gauge value, so must clear history data before fetching meta.
     ProcessMetaStatistic::Clear();
     std::vector<std::string> paths;
@@ -242,6 +280,7 @@ void ContainerProcessGroupManager::FlushPids(const std::unordered_set<uint32_t>&
 }
 
 ProcessMetaPtr ContainerProcessGroupManager::GetProcessMeta(uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mMutex);
     auto findIter = mProcessMetaMap.find(pid);
     if (findIter != mProcessMetaMap.end()) {
         // todo 还需要检查插入时间，如果超过几分钟，还需要刷新一次PID列表
@@ -267,10 +306,8 @@ ProcessMetaPtr ContainerProcessGroupManager::GetProcessMeta(uint32_t pid) {
                               ("getMeta get container meta for pid", pid)("id", containerID)("meta",
                                                                                              containerMeta.ToString()));
                 }
-                ProcessMetaPtr meta = mProcessMetaMap.find(pids[i]) == mProcessMetaMap.end()
-                    ? std::make_shared<ProcessMeta>()
-                    : mProcessMetaMap[pids[i]];
-                meta->Clear();
+                // other workers may be reading the old meta of pids[i], so it is replaced
+                ProcessMetaPtr meta = std::make_shared<ProcessMeta>();
                 meta->PID = pids[i];
                 meta->Container.ContainerID = containerID;
                 meta->Pod.PodUUID = podID;
@@ -283,7 +320,7 @@ ProcessMetaPtr ContainerProcessGroupManager::GetProcessMeta(uint32_t pid) {
                 meta->Container.Labels = containerMeta.containerLabels;
                 meta->Container.Envs = containerMeta.envs;
                 LOG_DEBUG(sLogger, ("getMeta insert process meta with container meta", pid));
-                mProcessMetaMap.insert(std::make_pair(pids[i], meta));
+                mProcessMetaMap[pids[i]] = meta;
             }
             return mProcessMetaMap[pid];
         } else if (res < -1) {
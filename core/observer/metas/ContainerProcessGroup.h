@@ -53,9 +53,25 @@ struct ContainerProcessGroup {
                          std::vector<std::pair<std::string, std::string>>& tags,
                          uint64_t interval);
 
+    /**
+     * @brief GetWorkerAggregator returns the aggregators which the NetworkObserver worker of index adds events to.
+     * @note the aggregators are only used by that worker, until they are merged into mAggregator before flushing.
+     */
+    ProtocolEventAggregators* GetWorkerAggregator(size_t index);
+
+    /**
+     * @brief MergeWorkerAggregator merges the aggregators of worker index into mAggregator, the worker must not be
+     * running.
+     */
+    void MergeWorkerAggregator(size_t index);
+
     std::unordered_set<uint32_t> mAllProcesses;
     ProcessMetaPtr mMetaPtr;
     ProtocolEventAggregators mAggregator;
+
+private:
+    std::mutex mWorkerAggregatorsMutex;
+    std::vector<std::unique_ptr<ProtocolEventAggregators>> mWorkerAggregators;
 };
 
 typedef std::shared_ptr<ContainerProcessGroup> ContainerProcessGroupPtr;
@@ -77,6 +93,7 @@ public:
     bool Init(const std::string& cgroupPath = "/sys/fs");
 
     void ResetFilterProcessMeta() {
+        std::lock_guard<std::mutex> lock(mMutex);
         for (const auto& item : this->mProcessMetaMap) {
             item.second->ResetFilter();
         }
@@ -98,6 +115,7 @@ public:
      * @return
      */
     ContainerProcessGroupPtr GetContainerProcessGroupPtr(const ProcessMetaPtr& meta, uint32_t pid) {
+        std::lock_guard<std::mutex> lock(mMutex);
         const std::string& containerID = meta->Container.ContainerID;
         if (containerID.empty()) {
             auto findIter = mPureProcessGroupMap.find(meta->PID);
@@ -125,6 +143,7 @@ public:
      * @param pid
      */
     void OnProcessDestroy(ProcessMeta* meta, uint32_t pid) {
+        std::lock_guard<std::mutex> lock(mMutex);
         const std::string& containerID = meta->Container.ContainerID;
         if (containerID.empty()) {
             // only delete pid without container
@@ -145,6 +164,11 @@ public:
                          std::vector<std::pair<std::string, std::string>>& tags,
                          uint64_t interval);
 
+    /**
+     * @brief MergeWorkerAggregators merges the aggregators of NetworkObserver worker index of all groups, see
+     * ContainerProcessGroup::MergeWorkerAggregator.
+     */
+    void MergeWorkerAggregators(size_t index);
 
     void FlushMetas();
 
@@ -165,6 +189,9 @@ private:
     ContainerProcessGroupManager() { mProcessMetaStatistic = ProcessMetaStatistic::GetInstance(); }
 
     ProcessMetaStatistic* mProcessMetaStatistic;
+    // NetworkObserver workers look up metas and groups of new processes concurrently, metas which may be in use are
+    // replaced but not modified out of FlushMetas, which runs while workers are paused.
+    std::mutex mMutex;
     // 从ContainerCenter同步过来的所有容器对应PID列表
     std::unordered_map<uint32_t, ProcessMetaPtr> mProcessMetaMap;
     uint32_t mLastNormalProcessMetaUpdateTime = 0;
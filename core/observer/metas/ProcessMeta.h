@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <memory>
 #include <vector>
@@ -168,7 +169,8 @@ struct ProcessMeta {
 
 private:
     std::vector<std::pair<std::string, std::string> > mMetaInfo;
-    int8_t mPassFilterRules = 0;
+    // cached by NetworkObserver workers which share the meta
+    std::atomic<int8_t> mPassFilterRules{0};
     friend class CGroupPathResolverUnittest;
 };
 
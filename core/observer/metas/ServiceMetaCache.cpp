@@ -60,6 +60,7 @@ void ServiceMetaCache::Put(const std::string& remoteIP, const std::string& host,
 
 
 void ServiceMetaManager::AddHostName(uint32_t pid, const std::string& hostname, const std::string& ip) {
+    std::lock_guard<std::mutex> lock(mMutex);
     auto meta = mHostnameMetas.find(pid);
     if (meta == mHostnameMetas.end()) {
         meta = mHostnameMetas.insert(std::make_pair(pid, new ServiceMetaCache(200))).first;
@@ -68,20 +69,22 @@ void ServiceMetaManager::AddHostName(uint32_t pid, const std::string& hostname,
     LOG_TRACE(sLogger, ("ServiceMeta ADD hostname, ip", ip)("data", meta->second->mData.begin()->second.ToString()));
 }
 
-const ServiceMeta&
-ServiceMetaManager::GetOrPutServiceMeta(uint32_t pid, const std::string& ip, ProtocolType protocolType) {
+ServiceMeta ServiceMetaManager::GetOrPutServiceMeta(uint32_t pid, const std::string& ip, ProtocolType protocolType) {
+    std::lock_guard<std::mutex> lock(mMutex);
     auto& meta = doGetOrPutServiceMeta(pid, ip, protocolType);
     LOG_TRACE(sLogger, ("ServiceMeta GET or PUT, pid", pid)("ip", ip)("data", meta.ToString()));
     return meta;
 }
 
-const ServiceMeta& ServiceMetaManager::GetServiceMeta(uint32_t pid, const std::string& ip) {
+ServiceMeta ServiceMetaManager::GetServiceMeta(uint32_t pid, const std::string& ip) {
+    std::lock_guard<std::mutex> lock(mMutex);
     auto& meta = doGetServiceMeta(pid, ip);
     LOG_TRACE(sLogger, ("ServiceMeta GET, pid", pid)("ip", ip)("data", meta.ToString()));
     return meta;
 }
 
 void ServiceMetaManager::OnProcessDestroy(uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mMutex);
     auto meta = mHostnameMetas.find(pid);
     if (meta == mHostnameMetas.end()) {
         return;
@@ -92,6 +95,7 @@ void ServiceMetaManager::OnProcessDestroy(uint32_t pid) {
 }
 
 void ServiceMetaManager::GarbageTimeoutHostname(long currentTime) {
+    std::lock_guard<std::mutex> lock(mMutex);
     long timeoutTime = currentTime - INT64_FLAG(sls_observer_network_hostname_timeout);
     for (auto iter = mHostnameMetas.begin(); iter != mHostnameMetas.end();) {
         while (!iter->second->mData.empty()) {
@@ -34,6 +34,7 @@
 #endif
 #include "flusher/FlusherSLS.h"
 #include "common/HashUtil.h"
+#include <cstring>
 
 DEFINE_FLAG_INT64(sls_observer_network_ebpf_connection_gc_interval,
                   "SLS Observer NetWork connection gc interval seconds",
@@ -42,14 +43,23 @@ DEFINE_FLAG_INT64(sls_observer_network_max_save_size,
                   "SLS Observer NetWork max save file size",
                   1024LL * 1024LL * 1024LL);
 DEFINE_FLAG_STRING(sls_observer_network_save_filename, "SLS Observer NetWork save disk's file name", "ebpf.dump");
+DEFINE_FLAG_INT32(sls_observer_network_worker_thread_count,
+                  "SLS Observer NetWork threads processing packets partitioned by connection, 1 processes them on "
+                  "the event loop thread",
+                  1);
+DEFINE_FLAG_INT32(sls_observer_network_worker_queue_size,
+                  "SLS Observer NetWork max batches queued for each worker thread",
+                  64);
 
 DECLARE_FLAG_INT32(merge_log_count_limit);
+DECLARE_FLAG_INT32(sls_observer_ebpf_batch_size);
+DECLARE_FLAG_INT32(sls_observer_ebpf_batch_max_bytes);
 
 namespace logtail {
 
 NetworkObserver::~NetworkObserver() {
-    for (auto& mAllProcess : mAllProcesses) {
-        delete mAllProcess.second;
+    for (auto& worker : mWorkers) {
+        worker->Stop();
     }
 }
 void NetworkObserver::HoldOn(bool exitFlag) {
@@ -57,6 +67,8 @@ void NetworkObserver::HoldOn(bool exitFlag) {
         mEBPFWrapper->HoldOn(exitFlag);
     }
     mEventLoopThreadRWL.lock();
+    // workers read the config when they filter processes
+    mHoldOnPausedWorkers = PauseWorkers();
     LOG_INFO(sLogger, ("hold on", "observer"));
 }
 
@@ -65,10 +77,44 @@ void NetworkObserver::Resume() {
         mEBPFWrapper->Resume();
     }
     Reload();
+    ResumeWorkers(mHoldOnPausedWorkers);
     mEventLoopThreadRWL.unlock();
     LOG_INFO(sLogger, ("resume on", "observer"));
 }
 
+size_t NetworkObserver::PauseWorkers() {
+    size_t count = mWorkers.size();
+    for (size_t i = 0; i < count; ++i) {
+        mWorkers[i]->mProcessMutex.lock();
+    }
+    return count;
+}
+
+void NetworkObserver::ResumeWorkers(size_t count) {
+    for (size_t i = count; i > 0; --i) {
+        mWorkers[i - 1]->mProcessMutex.unlock();
+    }
+}
+
+void NetworkObserver::DisableProcess(uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mDisabledPidsMutex);
+    mDisabledPids.push_back(pid);
+}
+
+void NetworkObserver::ApplyDisabledProcesses() {
+    std::vector<uint32_t> pids;
+    {
+        std::lock_guard<std::mutex> lock(mDisabledPidsMutex);
+        pids.swap(mDisabledPids);
+    }
+    if (mEBPFWrapper == nullptr) {
+        return;
+    }
+    for (auto pid : pids) {
+        mEBPFWrapper->DisableProcess(pid);
+    }
+}
+
 uint32_t NetworkObserver::EBPFConnectionGC(uint64_t nowTimeNs) {
     std::vector<struct connect_id_t> connIds, toDeleteConnIds;
     mEBPFWrapper->GetAllConnections(connIds);
@@ -76,15 +122,26 @@ uint32_t NetworkObserver::EBPFConnectionGC(uint64_t nowTimeNs) {
     if (originConnSize < (size_t)64) {
         return originConnSize;
     }
-    std::unordered_set<int32_t> pids;
-    GetAllPids(pids);
+    // connections observed by workers are kept, workers are paused only while they are looked up
+    std::vector<struct connect_id_t> unknownConnIds;
+    size_t pausedWorkers = PauseWorkers();
     for (auto& connId : connIds) {
-        auto findIter = mAllProcesses.find(connId.tgid);
-        if (findIter != mAllProcesses.end()) {
-            if (findIter->second->HasConnection(EBPFWrapper::ConvertConnIdToSockHash(&connId))) {
-                continue;
+        uint32_t sockHash = EBPFWrapper::ConvertConnIdToSockHash(&connId);
+        bool found = false;
+        for (auto& worker : mWorkers) {
+            if (worker->HasConnection(connId.tgid, sockHash)) {
+                found = true;
+                break;
             }
         }
+        if (!found) {
+            unknownConnIds.push_back(connId);
+        }
+    }
+    ResumeWorkers(pausedWorkers);
+    std::unordered_set<int32_t> pids;
+    GetAllPids(pids);
+    for (auto& connId : unknownConnIds) {
         // check pid exists
         if (pids.find(connId.tgid) == pids.end()) {
             // @debug
@@ -112,33 +169,45 @@ uint32_t NetworkObserver::EBPFConnectionGC(uint64_t nowTimeNs) {
 }
 
 void NetworkObserver::GarbageCollection(uint64_t nowTimeNs) {
+    static ContainerProcessGroupManager* containerProcessGroupManager = ContainerProcessGroupManager::GetInstance();
     size_t maxSizeLimit = 1024 * 1024;
     ++mNetworkStatistic->mGCCount;
     ProtocolDebugStatistic::Clear();
-    for (auto iter = mAllProcesses.begin(); iter != mAllProcesses.end();) {
-        ProcessObserver* observer = iter->second;
-        if (observer->GarbageCollection(maxSizeLimit, nowTimeNs)) {
-            LOG_DEBUG(sLogger,
-                      ("delete processor observer when gc, meta", observer->GetProcessMeta()->ToString())("pid",
-                                                                                                          iter->first));
-            static ContainerProcessGroupManager* containerProcessGroupManager
-                = ContainerProcessGroupManager::GetInstance();
-            // @note we must us iter->first as pid (not processMeta->Pid), because processMeta may belong to other pid
-            // in the same container
-            containerProcessGroupManager->OnProcessDestroy(observer->GetProcessMeta().get(), iter->first);
-            mServiceMetaManager->OnProcessDestroy(iter->first);
-            delete observer;
-            iter = mAllProcesses.erase(iter);
-            ++mNetworkStatistic->mGCReleaseProcessCount;
-        } else {
-            ++iter;
+    std::unordered_map<uint32_t, ProcessMetaPtr> deletedProcesses;
+    bool hasProcesses = false;
+    size_t pausedWorkers = PauseWorkers();
+    for (auto& worker : mWorkers) {
+        hasProcesses = hasProcesses || worker->ProcessCount() > 0;
+        worker->GarbageCollection(maxSizeLimit, nowTimeNs, deletedProcesses);
+    }
+    for (auto& item : deletedProcesses) {
+        // connections of the process in other workers are still observed
+        bool observed = false;
+        for (auto& worker : mWorkers) {
+            if (worker->HasProcess(item.first)) {
+                observed = true;
+                break;
+            }
         }
+        if (observed) {
+            continue;
+        }
+        containerProcessGroupManager->OnProcessDestroy(item.second.get(), item.first);
+        mServiceMetaManager->OnProcessDestroy(item.first);
+    }
+    ResumeWorkers(pausedWorkers);
+    if (hasProcesses) {
         mServiceMetaManager->GarbageTimeoutHostname(nowTimeNs / 1000000);
     }
 }
 
 void NetworkObserver::FlushOutMetrics(std::vector<sls_logs::Log>& allData) {
     static ContainerProcessGroupManager* containerProcessGroupManager = ContainerProcessGroupManager::GetInstance();
+    // workers are paused one by one, only while their aggregators are merged
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+        std::lock_guard<std::mutex> lock(mWorkers[i]->mProcessMutex);
+        containerProcessGroupManager->MergeWorkerAggregators(i);
+    }
     containerProcessGroupManager->FlushOutMetrics(allData, mConfig->mTags, mConfig->mFlushOutL7Interval);
 }
 
@@ -176,9 +245,7 @@ void NetworkObserver::FlushStatistics(logtail::NetStaticticsMap& statisticsMap,
         } else {
             const ProcessMetaPtr& ptr = cpgManager->GetProcessMeta(iter->first.PID);
             if (!ptr->PassFilterRules()) {
-                if (this->mEBPFWrapper != nullptr) {
-                    this->mEBPFWrapper->DisableProcess(iter->first.PID);
-                }
+                DisableProcess(iter->first.PID);
                 continue;
             }
             for (const auto& item : ptr->GetFormattedMeta()) {
@@ -197,37 +264,29 @@ void NetworkObserver::FlushStatistics(logtail::NetStaticticsMap& statisticsMap,
     }
 }
 
-void NetworkObserver::FlushOutStatistics(std::vector<sls_logs::Log>& allData) {
+void NetworkObserver::TakeStatistics() {
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
     // pcap wrapper, do not need to add meta
     if (mPCAPWrapper != nullptr) {
-        NetStaticticsMap& statisticsMap = mPCAPWrapper->GetStatistics();
-        FlushStatistics(statisticsMap, allData);
-        statisticsMap.Clear();
+        mPendingStatistics.emplace_back();
+        mPendingStatistics.back().mHashMap.swap(mPCAPWrapper->GetStatistics().mHashMap);
     }
 
     if (mEBPFWrapper != nullptr) {
-        NetStaticticsMap& statisticsMap = mEBPFWrapper->GetStatistics();
-        FlushStatistics(statisticsMap, allData);
-        statisticsMap.Clear();
+        mPendingStatistics.emplace_back();
+        mPendingStatistics.back().mHashMap.swap(mEBPFWrapper->GetStatistics().mHashMap);
     }
 }
 
-ProcessObserver* NetworkObserver::GetProcess(PacketEventHeader* header, bool create) {
-    auto findIter = mAllProcesses.find(header->PID);
-    if (findIter != mAllProcesses.end()) {
-        return findIter->second;
+void NetworkObserver::FlushOutStatistics(std::vector<sls_logs::Log>& allData) {
+    std::vector<NetStaticticsMap> allStatistics;
+    {
+        std::lock_guard<std::mutex> lock(mStatisticsMutex);
+        allStatistics.swap(mPendingStatistics);
     }
-    if (!create) {
-        return nullptr;
+    for (auto& statisticsMap : allStatistics) {
+        FlushStatistics(statisticsMap, allData);
     }
-    auto newProc = new ProcessObserver(header->TimeNano);
-    static ContainerProcessGroupManager* containerProcessGroupManager = ContainerProcessGroupManager::GetInstance();
-    ProcessMetaPtr processMeta = containerProcessGroupManager->GetProcessMeta(header->PID);
-    ContainerProcessGroupPtr groupPtr
-        = containerProcessGroupManager->GetContainerProcessGroupPtr(processMeta, header->PID);
-    newProc->SetProcessGroup(groupPtr);
-    mAllProcesses.insert(std::make_pair(header->PID, newProc));
-    return newProc;
 }
 
 int NetworkObserver::OnPacketEvent(void* event, size_t len) {
@@ -235,74 +294,111 @@ int NetworkObserver::OnPacketEvent(void* event, size_t len) {
         LOG_ERROR(sLogger, ("invalid packet len", len));
         return -1;
     }
+    DumpPacketEvent(event, len);
+    if (HasWorkerThreads()) {
+        PartitionPacketEvent(static_cast<const char*>(event), len);
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mWorkers[0]->mProcessMutex);
+    ProcessObserver* proc = nullptr;
+    mWorkers[0]->DispatchPacketEvent(static_cast<PacketEventHeader*>(event), proc);
+    return 0;
+}
+
+int NetworkObserver::OnPacketEventBatch(PacketEventBatch& batch) {
+    if (!HasWorkerThreads()) {
+        if (mConfig->mSaveToDisk) {
+            batch.ForEach([&](char* event, size_t len) {
+                if (len >= sizeof(PacketEventHeader)) {
+                    DumpPacketEvent(event, len);
+                }
+            });
+        }
+        std::lock_guard<std::mutex> lock(mWorkers[0]->mProcessMutex);
+        return mWorkers[0]->ProcessBatch(batch);
+    }
+    int count = 0;
+    batch.ForEach([&](char* event, size_t len) {
+        if (len < sizeof(PacketEventHeader)) {
+            LOG_ERROR(sLogger, ("invalid packet len", len));
+            return;
+        }
+        DumpPacketEvent(event, len);
+        PartitionPacketEvent(event, len);
+        ++count;
+    });
+    SubmitPendingBatches();
+    return count;
+}
+
+void NetworkObserver::PartitionPacketEvent(const char* event, size_t len) {
+    auto header = reinterpret_cast<const PacketEventHeader*>(event);
+    size_t index = header->SockHash % mWorkers.size();
+    PacketEventBatch*& batch = mPendingBatches[index];
+    if (batch == nullptr) {
+        batch = mWorkers[index]->AcquireBatch();
+    }
+    // the payload of data events does not always follow them, such as events from pcap, so events are copied in the
+    // layout of dump files
+    if (header->EventType == PacketEventType_Data && len >= sizeof(PacketEventHeader) + sizeof(PacketEventData)) {
+        auto data = reinterpret_cast<const PacketEventData*>(event + sizeof(PacketEventHeader));
+        size_t eventLen = sizeof(PacketEventHeader) + sizeof(PacketEventData);
+        size_t bufferLen = data->BufferLen > 0 ? static_cast<size_t>(data->BufferLen) : 0;
+        char* dest = batch->Append(eventLen + bufferLen);
+        memcpy(dest, event, eventLen);
+        if (bufferLen > 0) {
+            memcpy(dest + eventLen, data->Buffer, bufferLen);
+        }
+    } else {
+        memcpy(batch->Append(len), event, len);
+    }
+    if (batch->IsFull()) {
+        mWorkers[index]->Submit(batch);
+        batch = nullptr;
+    }
+}
+
+void NetworkObserver::SubmitPendingBatches() {
+    for (size_t i = 0; i < mPendingBatches.size(); ++i) {
+        if (mPendingBatches[i] != nullptr) {
+            mWorkers[i]->Submit(mPendingBatches[i]);
+            mPendingBatches[i] = nullptr;
+        }
+    }
+}
+
+void NetworkObserver::DumpPacketEvent(void* event, size_t len) {
+    if (!mConfig->mSaveToDisk) {
+        return;
+    }
     auto header = static_cast<PacketEventHeader*>(event);
     static bool openPartialSelect = false;
-    if (mConfig->mSaveToDisk) {
-        if (mDumpFilePtr == nullptr) {
-            std::string fileName = STRING_FLAG(sls_observer_network_save_filename);
-            if (mConfig->mLocalFileEnabled) {
-                fileName += ".new";
-            }
-            mDumpFilePtr = fopen64(fileName.c_str(), "wb+");
-            openPartialSelect = mConfig->isOpenPartialSelectDump();
-        }
-        if (mDumpFilePtr != nullptr && mDumpSize < INT64_FLAG(sls_observer_network_max_save_size)) {
-            if (!openPartialSelect
-                || (header->PID == mConfig->localPickPID || header->SockHash == mConfig->localPickConnectionHashId
-                    || header->SrcPort == mConfig->localPickSrcPort || header->DstPort == mConfig->localPickDstPort)) {
-                std::string dumpContent;
-                PacketEventToBuffer(event, len, dumpContent);
-                mDumpSize += dumpContent.size();
-                fwrite(dumpContent.data(), 1, dumpContent.size(), mDumpFilePtr);
-            }
+    if (mDumpFilePtr == nullptr) {
+        std::string fileName = STRING_FLAG(sls_observer_network_save_filename);
+        if (mConfig->mLocalFileEnabled) {
+            fileName += ".new";
         }
+        mDumpFilePtr = fopen64(fileName.c_str(), "wb+");
+        openPartialSelect = mConfig->isOpenPartialSelectDump();
     }
-    switch (header->EventType) {
-        case PacketEventType_None:
-            break;
-        case PacketEventType_Data: {
-            auto data = reinterpret_cast<PacketEventData*>((char*)event + sizeof(PacketEventHeader));
-
-            if (data->PtlType == ProtocolType_None) {
-                break;
-            }
-            ProcessObserver* proc = GetProcess(header);
-            if (!proc->GetProcessMeta()->PassFilterRules()) {
-                if (this->mEBPFWrapper != nullptr) {
-                    this->mEBPFWrapper->DisableProcess(header->PID);
-                }
-                break;
-            }
-            proc->OnData(header, data);
-        } break;
-        case PacketEventType_Connected:
-        case PacketEventType_Accepted:
-            // create process
-            GetProcess(header);
-            break;
-        case PacketEventType_Closed: {
-            ProcessObserver* proc = GetProcess(header, false);
-            if (proc == nullptr) {
-                break;
-            }
-            proc->ConnectionMarkDeleted(header);
-        } break;
+    if (mDumpFilePtr != nullptr && mDumpSize < INT64_FLAG(sls_observer_network_max_save_size)) {
+        if (!openPartialSelect
+            || (header->PID == mConfig->localPickPID || header->SockHash == mConfig->localPickConnectionHashId
+                || header->SrcPort == mConfig->localPickSrcPort || header->DstPort == mConfig->localPickDstPort)) {
+            std::string dumpContent;
+            PacketEventToBuffer(event, len, dumpContent);
+            mDumpSize += dumpContent.size();
+            fwrite(dumpContent.data(), 1, dumpContent.size(), mDumpFilePtr);
+        }
     }
-    return 0;
 }
+
 void NetworkObserver::OnProcessDestroyed(uint32_t pid, const char* command, size_t len) {
-    auto findIter = mAllProcesses.find(pid);
-    if (findIter != mAllProcesses.end()) {
-        auto& meta = findIter->second->GetProcessMeta();
-        if (meta && meta->ProcessCMD.size() == len && memcmp(meta->ProcessCMD.c_str(), command, len) == 0) {
-            findIter->second->MarkDeleted();
-            LOG_DEBUG(sLogger, ("process destroyed, mark deleted, command", command)("pid", pid));
-        } else {
-            LOG_INFO(sLogger,
-                     ("find pid on process destroyed, but command not match, destroyed command",
-                      command)("pid", pid)("real command", meta ? meta->ProcessCMD : ""));
-        }
+    size_t pausedWorkers = PauseWorkers();
+    for (auto& worker : mWorkers) {
+        worker->OnProcessDestroyed(pid, command, len);
     }
+    ResumeWorkers(pausedWorkers);
 }
 void NetworkObserver::ReloadSource() {
     LOG_INFO(sLogger, ("reload observer", "begin"));
@@ -324,7 +420,7 @@ void NetworkObserver::ReloadSource() {
         LOG_INFO(sLogger, ("reload module", "ebpf"));
         mEBPFWrapper = EBPFWrapper::GetInstance();
         success = mEBPFWrapper->Stop()
-            && mEBPFWrapper->Init(std::bind(&NetworkObserver::OnPacketEventStringPiece, this, std::placeholders::_1))
+            && mEBPFWrapper->Init(std::bind(&NetworkObserver::OnPacketEventBatch, this, std::placeholders::_1))
             && mEBPFWrapper->Start();
     } else {
         if (mEBPFWrapper != nullptr) {
@@ -364,7 +460,9 @@ void NetworkObserver::EventLoop() {
     if (mConfig->mLocalFileEnabled) {
         mReplayFilePtr = fopen64(STRING_FLAG(sls_observer_network_save_filename).c_str(), "rb+");
     }
-    uint64_t lastProfilingTime = GetCurrentTimeInNanoSeconds();
+    mLastProfilingTimeNs = GetCurrentTimeInNanoSeconds();
+    const int32_t batchSize = std::max(INT32_FLAG(sls_observer_ebpf_batch_size), 1);
+    PacketEventBatch replayBatch(batchSize, std::max(INT32_FLAG(sls_observer_ebpf_batch_max_bytes), 0));
     while (true) {
         bool hasMoreData = false;
         ReadLock lock(mEventLoopThreadRWL);
@@ -382,6 +480,7 @@ void NetworkObserver::EventLoop() {
         // fetching and processing packets
         if (mPCAPWrapper != nullptr) {
             int32_t rst = mPCAPWrapper->ProcessPackets(100, 100);
+            SubmitPendingBatches();
             if (rst >= 100) {
                 hasMoreData = true;
             }
@@ -397,14 +496,15 @@ void NetworkObserver::EventLoop() {
                 mLastCleanAllDisableProcessNs = nowTimeNs;
                 mEBPFWrapper->CleanAllDisableProcesses();
             }
+            ApplyDisabledProcesses();
             mNetworkStatistic->mEbpfDisableProcesses = mEBPFWrapper->GetDisablesProcessCount();
             if (nowTimeNs - mLastProbeDisableProcessNs
                 >= INT64_FLAG(sls_observer_network_probe_disable_process_interval) * 1000ULL * 1000ULL * 1000ULL) {
                 mLastProbeDisableProcessNs = nowTimeNs;
                 mEBPFWrapper->ProbeProcessStat();
             }
-            int32_t rst = mEBPFWrapper->ProcessPackets(100, 100);
-            if (rst >= 100) {
+            int32_t rst = mEBPFWrapper->ProcessPackets(batchSize, 100);
+            if (rst >= batchSize) {
                 hasMoreData = true;
             }
             if (rst != 0) {
@@ -415,67 +515,93 @@ void NetworkObserver::EventLoop() {
         }
         if (mReplayFilePtr != nullptr) {
             uint32_t dataSize = 0;
-            fread(&dataSize, 1, 4, mReplayFilePtr);
-            if (dataSize != 0 && dataSize < 1024 * 1024) {
-                char* buf = (char*)malloc(dataSize);
-                if (dataSize != fread(buf, 1, dataSize, mReplayFilePtr)) {
-                    LOG_ERROR(sLogger, ("read ebpf replay file failed", errno));
-                } else {
-                    void* event = nullptr;
-                    int32_t len = 0;
-                    BufferToPacketEvent(buf, static_cast<int32_t>(dataSize), event, len);
-                    if (event != nullptr) {
-                        OnPacketEvent(event, len);
-                        hasMoreData = true;
-                    }
+            bool corrupted = false;
+            while (!replayBatch.IsFull() && fread(&dataSize, 1, 4, mReplayFilePtr) == 4) {
+                // the payload can not be skipped without a valid size, the rest of the file is not aligned any more
+                if (dataSize < sizeof(PacketEventHeader) || dataSize >= 1024 * 1024) {
+                    LOG_ERROR(sLogger, ("invalid packet size in ebpf replay file, stop replaying, size", dataSize));
+                    corrupted = true;
+                    break;
+                }
+                if (dataSize != fread(replayBatch.Append(dataSize), 1, dataSize, mReplayFilePtr)) {
+                    LOG_ERROR(sLogger, ("read ebpf replay file failed, stop replaying", errno));
+                    replayBatch.RemoveLast();
+                    corrupted = true;
+                    break;
                 }
-                free(buf);
+            }
+            if (corrupted) {
+                fclose(mReplayFilePtr);
+                mReplayFilePtr = nullptr;
+            }
+            if (!replayBatch.Empty()) {
+                OnPacketEventBatch(replayBatch);
+                replayBatch.Clear();
+                hasMoreData = true;
             }
         }
 
-        // fetching metas
-        if (nowTimeNs - mLastFlushMetaTimeNs >= mConfig->mFlushMetaInterval * 1000ULL * 1000ULL * 1000ULL) {
-            mLastFlushMetaTimeNs = nowTimeNs;
-            ContainerProcessGroupManager::GetInstance()->Init();
-            ContainerProcessGroupManager::GetInstance()->FlushMetas();
-        }
-
-        // GC
-        if (nowTimeNs - mLastGCTimeNs >= INT64_FLAG(sls_observer_network_gc_interval) * 1000ULL * 1000ULL * 1000ULL) {
-            mLastGCTimeNs = nowTimeNs;
-            GarbageCollection(nowTimeNs);
-        }
+        // the connections and statistics of sources are only touched by the event loop
         if (mEBPFWrapper != nullptr
             && nowTimeNs - mLastEbpfGCTimeNs
                 > INT64_FLAG(sls_observer_network_ebpf_connection_gc_interval) * 1000ULL * 1000ULL * 1000ULL) {
             mLastEbpfGCTimeNs = nowTimeNs;
             mNetworkStatistic->mEbpfUsingConnections = EBPFConnectionGC(nowTimeNs);
         }
-        if (nowTimeNs - mLastFlushNetlinkTimeNs >= mConfig->mFlushNetlinkInterval * 1000ULL * 1000ULL * 1000ULL) {
-            mLastFlushNetlinkTimeNs = nowTimeNs;
-            ConnectionMetaManager::GetInstance()->Init();
-            ConnectionMetaManager::GetInstance()->GarbageCollection();
-        }
-
-        // flush observer metrics
         if (nowTimeNs - mLastL4FlushTimeNs >= mConfig->mFlushOutL4Interval * 1000ULL * 1000ULL * 1000ULL) {
             mLastL4FlushTimeNs = nowTimeNs;
-            std::vector<sls_logs::Log> allLogs;
-            FlushOutStatistics(allLogs);
-            if (mSenderFunc) {
-                mSenderFunc(allLogs, mConfig->mLastApplyedConfig);
-            }
-            mNetworkStatistic->mOutputEvents += allLogs.size();
-            for (const auto& item : allLogs) {
-                mNetworkStatistic->mOutputBytes += item.GetCachedSize();
+            TakeStatistics();
+        }
+
+        if (!HasWorkerThreads()) {
+            RunMaintenance(nowTimeNs);
+        }
+        if (!hasMoreData) {
+            usleep(1000 * INT32_FLAG(sls_observer_network_no_data_sleep_interval_ms));
+        }
+    }
+}
+
+void NetworkObserver::MaintenanceLoop() {
+    LOG_INFO(sLogger, ("start observer network maintenance loop", "success"));
+    while (true) {
+        {
+            ReadLock lock(mEventLoopThreadRWL);
+            if (mPCAPWrapper != nullptr || mEBPFWrapper != nullptr) {
+                RunMaintenance(GetCurrentTimeInNanoSeconds());
             }
         }
+        usleep(1000 * INT32_FLAG(sls_observer_network_no_data_sleep_interval_ms));
+    }
+}
+
+void NetworkObserver::RunMaintenance(uint64_t nowTimeNs) {
+    // fetching metas
+    if (nowTimeNs - mLastFlushMetaTimeNs >= mConfig->mFlushMetaInterval * 1000ULL * 1000ULL * 1000ULL) {
+        mLastFlushMetaTimeNs = nowTimeNs;
+        // metas are shared by the processes of workers
+        size_t pausedWorkers = PauseWorkers();
+        ContainerProcessGroupManager::GetInstance()->Init();
+        ContainerProcessGroupManager::GetInstance()->FlushMetas();
+        ResumeWorkers(pausedWorkers);
+    }
+
+    // GC
+    if (nowTimeNs - mLastGCTimeNs >= INT64_FLAG(sls_observer_network_gc_interval) * 1000ULL * 1000ULL * 1000ULL) {
+        mLastGCTimeNs = nowTimeNs;
+        GarbageCollection(nowTimeNs);
+    }
+    if (nowTimeNs - mLastFlushNetlinkTimeNs >= mConfig->mFlushNetlinkInterval * 1000ULL * 1000ULL * 1000ULL) {
+        mLastFlushNetlinkTimeNs = nowTimeNs;
+        ConnectionMetaManager::GetInstance()->Init();
+        ConnectionMetaManager::GetInstance()->GarbageCollection();
+    }
 
-        // flush observer metrics
-        if (nowTimeNs - mLastL7FlushTimeNs >= mConfig->mFlushOutL7Interval * 1000ULL * 1000ULL * 1000ULL) {
-            mLastL7FlushTimeNs = nowTimeNs;
-            std::vector<sls_logs::Log> allLogs;
-            FlushOutMetrics(allLogs);
+    // flush observer statistics taken by the event loop
+    {
+        std::vector<sls_logs::Log> allLogs;
+        FlushOutStatistics(allLogs);
+        if (!allLogs.empty()) {
             if (mSenderFunc) {
                 mSenderFunc(allLogs, mConfig->mLastApplyedConfig);
             }
@@ -484,31 +610,42 @@ void NetworkObserver::EventLoop() {
                 mNetworkStatistic->mOutputBytes += item.GetCachedSize();
             }
         }
-        // flush profile metrics
-        if ((nowTimeNs - lastProfilingTime) >= INT32_FLAG(monitor_interval) * 1000ULL * 1000ULL * 1000ULL) {
-            static auto sPMStat = ProcessMetaStatistic::GetInstance();
-            static auto sCMStat = ConnectionMetaStatistic::GetInstance();
-            static auto sPStat = ProtocolStatistic::GetInstance();
-            static auto sPDStat = ProtocolDebugStatistic::GetInstance();
-            LOG_DEBUG(sLogger, ("observer_process_meta_statistic", sPMStat->ToString()));
-            LOG_DEBUG(sLogger, ("observer_connection_meta_statistic", sCMStat->ToString()));
-            LOG_DEBUG(sLogger, ("observer_protocol_statistic", sPStat->ToString()));
-            LOG_DEBUG(sLogger, ("observer_protocol_mem_statistic", sPDStat->ToString()));
-            LOG_DEBUG(sLogger, ("observer_network_statistic", mNetworkStatistic->ToString()));
-
-            sPMStat->FlushMetrics();
-            sCMStat->FlushMetrics();
-            sPStat->FlushMetrics();
-            sPDStat->FlushMetrics(BOOL_FLAG(sls_observer_network_protocol_stat));
-            mNetworkStatistic->FlushMetrics();
-            LogtailMonitor::GetInstance()->UpdateMetric("observer_container_category",
-                                                     ContainerProcessGroupManager::GetInstance()->GetContainerType());
-            lastProfilingTime = nowTimeNs;
+    }
+
+    // flush observer metrics
+    if (nowTimeNs - mLastL7FlushTimeNs >= mConfig->mFlushOutL7Interval * 1000ULL * 1000ULL * 1000ULL) {
+        mLastL7FlushTimeNs = nowTimeNs;
+        std::vector<sls_logs::Log> allLogs;
+        FlushOutMetrics(allLogs);
+        if (mSenderFunc) {
+            mSenderFunc(allLogs, mConfig->mLastApplyedConfig);
         }
-        if (!hasMoreData) {
-            usleep(1000 * INT32_FLAG(sls_observer_network_no_data_sleep_interval_ms));
+        mNetworkStatistic->mOutputEvents += allLogs.size();
+        for (const auto& item : allLogs) {
+            mNetworkStatistic->mOutputBytes += item.GetCachedSize();
         }
     }
+    // flush profile metrics
+    if ((nowTimeNs - mLastProfilingTimeNs) >= INT32_FLAG(monitor_interval) * 1000ULL * 1000ULL * 1000ULL) {
+        static auto sPMStat = ProcessMetaStatistic::GetInstance();
+        static auto sCMStat = ConnectionMetaStatistic::GetInstance();
+        static auto sPStat = ProtocolStatistic::GetInstance();
+        static auto sPDStat = ProtocolDebugStatistic::GetInstance();
+        LOG_DEBUG(sLogger, ("observer_process_meta_statistic", sPMStat->ToString()));
+        LOG_DEBUG(sLogger, ("observer_connection_meta_statistic", sCMStat->ToString()));
+        LOG_DEBUG(sLogger, ("observer_protocol_statistic", sPStat->ToString()));
+        LOG_DEBUG(sLogger, ("observer_protocol_mem_statistic", sPDStat->ToString()));
+        LOG_DEBUG(sLogger, ("observer_network_statistic", mNetworkStatistic->ToString()));
+
+        sPMStat->FlushMetrics();
+        sCMStat->FlushMetrics();
+        sPStat->FlushMetrics();
+        sPDStat->FlushMetrics(BOOL_FLAG(sls_observer_network_protocol_stat));
+        mNetworkStatistic->FlushMetrics();
+        LogtailMonitor::GetInstance()->UpdateMetric("observer_container_category",
+                                                 ContainerProcessGroupManager::GetInstance()->GetContainerType());
+        mLastProfilingTimeNs = nowTimeNs;
+    }
 }
 
 void NetworkObserver::BindSender() {
@@ -518,8 +655,29 @@ void NetworkObserver::BindSender() {
 
 inline void NetworkObserver::StartEventLoop() {
     if (!mEventLoopThread) {
+        StartWorkers();
         mEventLoopThread = CreateThread([this]() { EventLoop(); });
+        if (HasWorkerThreads()) {
+            mMaintenanceThread = CreateThread([this]() { MaintenanceLoop(); });
+        }
+    }
+}
+
+void NetworkObserver::StartWorkers() {
+    const size_t workerCount = std::max(INT32_FLAG(sls_observer_network_worker_thread_count), 1);
+    if (workerCount == 1) {
+        return;
+    }
+    for (size_t i = mWorkers.size(); i < workerCount; ++i) {
+        mWorkers.emplace_back(new NetworkObserverWorker(this, i));
+    }
+    for (auto& worker : mWorkers) {
+        worker->Start(std::max(INT32_FLAG(sls_observer_network_worker_queue_size), 1),
+                      std::max(INT32_FLAG(sls_observer_ebpf_batch_size), 1),
+                      std::max(INT32_FLAG(sls_observer_ebpf_batch_max_bytes), 0));
     }
+    mPendingBatches.assign(mWorkers.size(), nullptr);
+    LOG_INFO(sLogger, ("start observer network workers", workerCount));
 }
 int NetworkObserver::OutputPluginProcess(std::vector<sls_logs::Log>& logs, const Pipeline* config) {
     static auto sPlugin = LogtailPlugin::GetInstance();
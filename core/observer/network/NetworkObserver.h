@@ -30,6 +30,11 @@
 #include "ConnectionObserver.h"
 #include "metas/ConnectionMetaManager.h"
 #include "interface/layerfour.h"
+#include "network/PacketEventBatch.h"
+#include "network/NetworkObserverWorker.h"
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace logtail {
 class ProcessObserver;
@@ -48,6 +53,9 @@ public:
         if (mEventLoopThread) {
             mEventLoopThread->Wait(100);
         }
+        if (mMaintenanceThread) {
+            mMaintenanceThread->Wait(100);
+        }
     }
 
     void HoldOn(bool exitFlag = false);
@@ -64,23 +72,50 @@ private:
         mConfig = NetworkConfig::GetInstance();
         mNetworkStatistic = NetworkStatistic::GetInstance();
         mServiceMetaManager = ServiceMetaManager::GetInstance();
+        // events are processed on the event loop thread by this worker, unless more workers are started
+        mWorkers.emplace_back(new NetworkObserverWorker(this, 0));
     }
     ~NetworkObserver();
 
+    /**
+     * @brief EventLoop fetches packets from sources and passes them to workers. It runs the maintenance as well,
+     * unless the maintenance has its own thread.
+     */
     void EventLoop();
 
+    /**
+     * @brief MaintenanceLoop runs the maintenance of workers on its own thread, when packets are processed by worker
+     * threads, so that flushing and garbage collection do not hold back fetching packets.
+     */
+    void MaintenanceLoop();
+
+    /**
+     * @brief RunMaintenance fetches metas, garbage collects processes and connections, and flushes metrics when
+     * their intervals are over.
+     */
+    void RunMaintenance(uint64_t nowTimeNs);
 
     void GarbageCollection(uint64_t nowTimeNs);
 
     uint32_t EBPFConnectionGC(uint64_t nowTimeNs);
 
     /**
-     * @brief Get or create a new process observer to process network packet.
-     * @param header the network packet meta data.
-     * @param create  whether create new process obj when not found
-     * @return ProcessObserver allocated in heap.
+     * @brief PauseWorkers waits for workers to finish their current batches and keeps them from the next ones, so that
+     * their processes can be visited. Workers are always locked by index.
+     * @return the count of paused workers, to be passed to ResumeWorkers.
+     */
+    size_t PauseWorkers();
+    void ResumeWorkers(size_t count);
+
+    bool HasWorkerThreads() const { return mWorkers.size() > 1; }
+
+    /**
+     * @brief DisableProcess disables a process filtered out by config on the next round of the event loop, which
+     * owns the sources. It may be called by workers.
      */
-    ProcessObserver* GetProcess(PacketEventHeader* header, bool create = true);
+    void DisableProcess(uint32_t pid);
+
+    void ApplyDisabledProcesses();
 
     /**
      * @brief BindSender bind different output ways, such as sls or plugins output ways.
@@ -98,8 +133,29 @@ private:
 
     int OnPacketEvent(void* event, size_t len);
 
+    /**
+     * @brief Process a batch of packet events, which are grouped by process and connection.
+     * @return the count of processed events.
+     */
+    int OnPacketEventBatch(PacketEventBatch& batch);
+
+    void DumpPacketEvent(void* event, size_t len);
+
+    /**
+     * @brief PartitionPacketEvent copies an event into the pending batch of the worker of its connection.
+     */
+    void PartitionPacketEvent(const char* event, size_t len);
+
+    // SubmitPendingBatches passes the pending batches to workers, it is called after every poll of a source.
+    void SubmitPendingBatches();
+
     void OnProcessDestroyed(uint32_t pid, const char* command, size_t len);
 
+    /**
+     * @brief TakeStatistics moves the layer 4 statistics of sources to be flushed by FlushOutStatistics.
+     */
+    void TakeStatistics();
+
     /**
      * @brief Output layer 4 statistics
      * @param allData allData stores all observer logs
@@ -118,10 +174,22 @@ private:
     // create a still running thread to process observer data.
     void StartEventLoop();
 
-    std::unordered_map<uint32_t, ProcessObserver*> mAllProcesses;
+    void StartWorkers();
+
+    // partitioned by the hash of connections, mWorkers[0] is always there
+    std::vector<std::unique_ptr<NetworkObserverWorker>> mWorkers;
+    // batches being filled for workers by the event loop, indexed as mWorkers
+    std::vector<PacketEventBatch*> mPendingBatches;
+    std::mutex mDisabledPidsMutex;
+    std::vector<uint32_t> mDisabledPids;
+    // layer 4 statistics taken from sources by the event loop, and flushed by the maintenance
+    std::mutex mStatisticsMutex;
+    std::vector<NetStaticticsMap> mPendingStatistics;
     std::function<int(std::vector<sls_logs::Log>&, const Pipeline*)> mSenderFunc;
     ThreadPtr mEventLoopThread;
+    ThreadPtr mMaintenanceThread;
     ReadWriteLock mEventLoopThreadRWL;
+    size_t mHoldOnPausedWorkers = 0;
     uint64_t mLastGCTimeNs = 0;
     uint64_t mLastL4FlushTimeNs = 0;
     uint64_t mLastL7FlushTimeNs = 0;
@@ -130,6 +198,7 @@ private:
     uint64_t mLastFlushNetlinkTimeNs = 0;
     uint64_t mLastProbeDisableProcessNs = 0;
     uint64_t mLastCleanAllDisableProcessNs = 0;
+    uint64_t mLastProfilingTimeNs = 0;
     FILE* mDumpFilePtr = nullptr;
     FILE* mReplayFilePtr = nullptr;
     int64_t mDumpSize = 0;
@@ -150,6 +219,9 @@ private:
     friend class ProtocolMySqlUnittest;
     friend class ProtocolRedisUnittest;
     friend class ProtocolPgSqlUnittest;
+    friend class PacketEventBatchUnittest;
+    friend class PacketEventBatchBenchmark;
+    friend class NetworkObserverWorker;
 };
 
 } // namespace logtail
@@ -0,0 +1,220 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "NetworkObserverWorker.h"
+#include "NetworkObserver.h"
+#include "ProcessObserver.h"
+#include "logger/Logger.h"
+#include "metas/ContainerProcessGroup.h"
+
+namespace logtail {
+
+NetworkObserverWorker::~NetworkObserverWorker() {
+    Stop();
+    for (auto& process : mAllProcesses) {
+        delete process.second;
+    }
+}
+
+void NetworkObserverWorker::Start(size_t queueSize, size_t batchSize, size_t batchMaxBytes) {
+    if (mThread) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mStopped = false;
+        for (size_t i = 0; i < std::max(queueSize, size_t(1)); ++i) {
+            mBatches.emplace_back(new PacketEventBatch(batchSize, batchMaxBytes));
+            mFreeBatches.push_back(mBatches.back().get());
+        }
+    }
+    mThread = CreateThread([this]() { Run(); });
+    LOG_INFO(sLogger, ("start observer network worker", mIndex)("queue size", queueSize));
+}
+
+void NetworkObserverWorker::Stop() {
+    if (!mThread) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mStopped = true;
+    }
+    mQueueCond.notify_all();
+    mFreeCond.notify_all();
+    mThread->Wait(0);
+    mThread.reset();
+}
+
+PacketEventBatch* NetworkObserverWorker::AcquireBatch() {
+    std::unique_lock<std::mutex> lock(mQueueMutex);
+    mFreeCond.wait(lock, [this]() { return !mFreeBatches.empty(); });
+    PacketEventBatch* batch = mFreeBatches.back();
+    mFreeBatches.pop_back();
+    return batch;
+}
+
+void NetworkObserverWorker::Submit(PacketEventBatch* batch) {
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mQueue.push_back(batch);
+    }
+    mQueueCond.notify_one();
+}
+
+void NetworkObserverWorker::Run() {
+    while (true) {
+        PacketEventBatch* batch = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mQueueMutex);
+            mQueueCond.wait(lock, [this]() { return mStopped || !mQueue.empty(); });
+            if (mQueue.empty()) {
+                return;
+            }
+            batch = mQueue.front();
+            mQueue.pop_front();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mProcessMutex);
+            ProcessBatch(*batch);
+        }
+        batch->Clear();
+        {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            mFreeBatches.push_back(batch);
+        }
+        mFreeCond.notify_one();
+    }
+}
+
+int NetworkObserverWorker::ProcessBatch(PacketEventBatch& batch) {
+    ProcessObserver* proc = nullptr;
+    uint32_t pid = 0;
+    int count = 0;
+    batch.ForEachGrouped([&](char* event, size_t len) {
+        if (len < sizeof(PacketEventHeader)) {
+            LOG_ERROR(sLogger, ("invalid packet len", len));
+            return;
+        }
+        auto header = reinterpret_cast<PacketEventHeader*>(event);
+        // events are grouped by pid, the process is looked up once for a group
+        if (proc != nullptr && header->PID != pid) {
+            proc = nullptr;
+        }
+        pid = header->PID;
+        DispatchPacketEvent(header, proc);
+        ++count;
+    });
+    return count;
+}
+
+void NetworkObserverWorker::DispatchPacketEvent(PacketEventHeader* header, ProcessObserver*& proc) {
+    switch (header->EventType) {
+        case PacketEventType_None:
+            break;
+        case PacketEventType_Data: {
+            auto data = reinterpret_cast<PacketEventData*>((char*)header + sizeof(PacketEventHeader));
+
+            if (data->PtlType == ProtocolType_None) {
+                break;
+            }
+            if (proc == nullptr) {
+                proc = GetProcess(header);
+            }
+            if (!proc->GetProcessMeta()->PassFilterRules()) {
+                mObserver->DisableProcess(header->PID);
+                break;
+            }
+            proc->OnData(header, data);
+        } break;
+        case PacketEventType_Connected:
+        case PacketEventType_Accepted:
+            // create process
+            if (proc == nullptr) {
+                proc = GetProcess(header);
+            }
+            break;
+        case PacketEventType_Closed: {
+            if (proc == nullptr) {
+                proc = GetProcess(header, false);
+            }
+            if (proc == nullptr) {
+                break;
+            }
+            proc->ConnectionMarkDeleted(header);
+        } break;
+    }
+}
+
+ProcessObserver* NetworkObserverWorker::GetProcess(PacketEventHeader* header, bool create) {
+    auto findIter = mAllProcesses.find(header->PID);
+    if (findIter != mAllProcesses.end()) {
+        return findIter->second;
+    }
+    if (!create) {
+        return nullptr;
+    }
+    auto newProc = new ProcessObserver(header->TimeNano);
+    static ContainerProcessGroupManager* containerProcessGroupManager = ContainerProcessGroupManager::GetInstance();
+    ProcessMetaPtr processMeta = containerProcessGroupManager->GetProcessMeta(header->PID);
+    ContainerProcessGroupPtr groupPtr
+        = containerProcessGroupManager->GetContainerProcessGroupPtr(processMeta, header->PID);
+    newProc->SetProcessGroup(groupPtr, mIndex);
+    mAllProcesses.insert(std::make_pair(header->PID, newProc));
+    return newProc;
+}
+
+void NetworkObserverWorker::GarbageCollection(size_t sizeLimitBytes,
+                                              uint64_t nowTimeNs,
+                                              std::unordered_map<uint32_t, ProcessMetaPtr>& deletedProcesses) {
+    static auto sNetStatistic = NetworkStatistic::GetInstance();
+    for (auto iter = mAllProcesses.begin(); iter != mAllProcesses.end();) {
+        ProcessObserver* observer = iter->second;
+        if (observer->GarbageCollection(sizeLimitBytes, nowTimeNs)) {
+            LOG_DEBUG(sLogger,
+                      ("delete processor observer when gc, meta", observer->GetProcessMeta()->ToString())("pid",
+                                                                                                          iter->first));
+            // @note we must us iter->first as pid (not processMeta->Pid), because processMeta may belong to other pid
+            // in the same container
+            deletedProcesses.insert(std::make_pair(iter->first, observer->GetProcessMeta()));
+            delete observer;
+            iter = mAllProcesses.erase(iter);
+            ++sNetStatistic->mGCReleaseProcessCount;
+        } else {
+            ++iter;
+        }
+    }
+}
+
+bool NetworkObserverWorker::HasConnection(uint32_t pid, uint32_t sockHash) const {
+    auto findIter = mAllProcesses.find(pid);
+    return findIter != mAllProcesses.end() && findIter->second->HasConnection(sockHash);
+}
+
+void NetworkObserverWorker::OnProcessDestroyed(uint32_t pid, const char* command, size_t len) {
+    auto findIter = mAllProcesses.find(pid);
+    if (findIter != mAllProcesses.end()) {
+        auto& meta = findIter->second->GetProcessMeta();
+        if (meta && meta->ProcessCMD.size() == len && memcmp(meta->ProcessCMD.c_str(), command, len) == 0) {
+            findIter->second->MarkDeleted();
+            LOG_DEBUG(sLogger, ("process destroyed, mark deleted, command", command)("pid", pid));
+        } else {
+            LOG_INFO(sLogger,
+                     ("find pid on process destroyed, but command not match, destroyed command",
+                      command)("pid", pid)("real command", meta ? meta->ProcessCMD : ""));
+        }
+    }
+}
+
+} // namespace logtail
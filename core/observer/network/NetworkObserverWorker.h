@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "common/Thread.h"
+#include "interface/network.h"
+#include "metas/ProcessMeta.h"
+#include "network/PacketEventBatch.h"
+
+namespace logtail {
+class NetworkObserver;
+class ProcessObserver;
+
+/**
+ * NetworkObserverWorker owns the processes and connections of a partition of NetworkObserver, connections are
+ * assigned to workers by their hash. Its ProcessObserver map is only touched while mProcessMutex is held, which the
+ * worker holds for a whole batch, and the maintenance of NetworkObserver holds to pause it.
+ * When the worker is not started, events are processed on the caller thread by ProcessBatch.
+ */
+class NetworkObserverWorker {
+public:
+    NetworkObserverWorker(NetworkObserver* observer, size_t index) : mObserver(observer), mIndex(index) {}
+
+    ~NetworkObserverWorker();
+
+    /**
+     * @brief Start creates queueSize batches and the thread processing them.
+     */
+    void Start(size_t queueSize, size_t batchSize, size_t batchMaxBytes);
+
+    void Stop();
+
+    bool Started() const { return mThread != nullptr; }
+
+    /**
+     * @brief AcquireBatch returns an empty batch to be filled and passed to Submit, it waits while all batches of the
+     * worker are queued, which holds the source back as the single threaded observer did.
+     */
+    PacketEventBatch* AcquireBatch();
+
+    void Submit(PacketEventBatch* batch);
+
+    // The following methods require mProcessMutex to be held.
+
+    /**
+     * @return the count of processed events.
+     */
+    int ProcessBatch(PacketEventBatch& batch);
+
+    /**
+     * @brief Dispatch a packet event to its process.
+     * @param proc the process of header->PID if it is known, or nullptr, which is set when the process is found.
+     */
+    void DispatchPacketEvent(PacketEventHeader* header, ProcessObserver*& proc);
+
+    /**
+     * @brief Get or create a new process observer to process network packet.
+     * @param header the network packet meta data.
+     * @param create  whether create new process obj when not found
+     * @return ProcessObserver allocated in heap.
+     */
+    ProcessObserver* GetProcess(PacketEventHeader* header, bool create = true);
+
+    /**
+     * @brief GarbageCollection deletes timeout processes, and adds their pids and metas to deletedProcesses.
+     */
+    void GarbageCollection(size_t sizeLimitBytes,
+                           uint64_t nowTimeNs,
+                           std::unordered_map<uint32_t, ProcessMetaPtr>& deletedProcesses);
+
+    bool HasProcess(uint32_t pid) const { return mAllProcesses.find(pid) != mAllProcesses.end(); }
+
+    size_t ProcessCount() const { return mAllProcesses.size(); }
+
+    bool HasConnection(uint32_t pid, uint32_t sockHash) const;
+
+    void OnProcessDestroyed(uint32_t pid, const char* command, size_t len);
+
+    std::mutex mProcessMutex;
+
+private:
+    void Run();
+
+    NetworkObserver* mObserver;
+    size_t mIndex;
+    std::unordered_map<uint32_t, ProcessObserver*> mAllProcesses;
+
+    ThreadPtr mThread;
+    std::mutex mQueueMutex;
+    std::condition_variable mQueueCond;
+    std::condition_variable mFreeCond;
+    bool mStopped = false;
+    std::vector<std::unique_ptr<PacketEventBatch>> mBatches;
+    std::deque<PacketEventBatch*> mQueue;
+    std::vector<PacketEventBatch*> mFreeBatches;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class NetworkObserverUnittest;
+    friend class ProtocolDnsUnittest;
+    friend class ProtocolHttpUnittest;
+    friend class ProtocolMySqlUnittest;
+    friend class ProtocolRedisUnittest;
+    friend class ProtocolPgSqlUnittest;
+#endif
+};
+
+} // namespace logtail
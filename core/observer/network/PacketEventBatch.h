@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "interface/network.h"
+
+namespace logtail {
+
+/**
+ * PacketEventBatch keeps packet events of a source in one buffer, so that they can be processed together.
+ * Each event is laid out as in dump files, a PacketEventHeader, followed by a PacketEventData and the payload for
+ * data events. The buffer grows while events are appended, so PacketEventData::Buffer is set again when events
+ * are visited.
+ */
+class PacketEventBatch {
+public:
+    PacketEventBatch(size_t maxEvents, size_t maxBytes) : mMaxEvents(maxEvents), mMaxBytes(maxBytes) {
+        mEntries.reserve(maxEvents);
+        mBuffer.reserve(maxBytes);
+    }
+
+    /**
+     * Append adds an event of len bytes and returns where it should be written, which is valid until the next
+     * Append. The event must start with its PacketEventHeader.
+     */
+    char* Append(size_t len) {
+        // headers have 8 bytes fields
+        size_t offset = (mBuffer.size() + 7) & ~static_cast<size_t>(7);
+        mBuffer.resize(offset + len);
+        mEntries.push_back(Entry{0, 0, static_cast<uint32_t>(offset), static_cast<uint32_t>(len)});
+        return &mBuffer[offset];
+    }
+
+    // RemoveLast drops the event added by the last Append, when it cannot be written.
+    void RemoveLast() {
+        mBuffer.resize(mEntries.back().Offset);
+        mEntries.pop_back();
+    }
+
+    bool IsFull() const { return mEntries.size() >= mMaxEvents || mBuffer.size() >= mMaxBytes; }
+    bool Empty() const { return mEntries.empty(); }
+    size_t Size() const { return mEntries.size(); }
+
+    void Clear() {
+        mEntries.clear();
+        mBuffer.clear();
+    }
+
+    /**
+     * ForEach calls func(event, len) for all events in the order they were appended.
+     */
+    template <typename Func>
+    void ForEach(Func func) {
+        for (const auto& entry : mEntries) {
+            func(prepareEvent(entry), static_cast<size_t>(entry.Len));
+        }
+    }
+
+    /**
+     * ForEachGrouped calls func(event, len) for all events, grouped by pid and then by connection, so consumers
+     * can look up per process and per connection state once for a group. Events of a connection keep their order.
+     */
+    template <typename Func>
+    void ForEachGrouped(Func func) {
+        for (auto& entry : mEntries) {
+            if (entry.Len >= sizeof(PacketEventHeader)) {
+                auto* header = reinterpret_cast<const PacketEventHeader*>(&mBuffer[entry.Offset]);
+                entry.PID = header->PID;
+                entry.SockHash = header->SockHash;
+            }
+        }
+        std::stable_sort(mEntries.begin(), mEntries.end(), [](const Entry& left, const Entry& right) {
+            return left.PID != right.PID ? left.PID < right.PID : left.SockHash < right.SockHash;
+        });
+        for (const auto& entry : mEntries) {
+            func(prepareEvent(entry), static_cast<size_t>(entry.Len));
+        }
+    }
+
+private:
+    struct Entry {
+        uint32_t PID;
+        uint32_t SockHash;
+        uint32_t Offset;
+        uint32_t Len;
+    };
+
+    char* prepareEvent(const Entry& entry) {
+        char* event = &mBuffer[entry.Offset];
+        if (entry.Len >= sizeof(PacketEventHeader) + sizeof(PacketEventData)) {
+            auto* data = reinterpret_cast<PacketEventData*>(event + sizeof(PacketEventHeader));
+            data->Buffer = event + sizeof(PacketEventHeader) + sizeof(PacketEventData);
+        }
+        return event;
+    }
+
+    size_t mMaxEvents;
+    size_t mMaxBytes;
+    std::vector<Entry> mEntries;
+    std::string mBuffer;
+};
+
+} // namespace logtail
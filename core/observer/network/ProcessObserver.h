@@ -69,9 +69,13 @@ public:
 
     ProtocolEventAggregators* GetAggregator() { return mAllAggregator; }
 
-    void SetProcessGroup(ContainerProcessGroupPtr& groupPtr) {
+    /**
+     * @brief SetProcessGroup binds the process to its group, events are aggregated by the group's aggregators of the
+     * NetworkObserver worker which owns the process.
+     */
+    void SetProcessGroup(ContainerProcessGroupPtr& groupPtr, size_t workerIndex) {
         mProcessGroupPtr = groupPtr;
-        mAllAggregator = &mProcessGroupPtr->mAggregator;
+        mAllAggregator = mProcessGroupPtr->GetWorkerAggregator(workerIndex);
     }
 
     /**
@@ -0,0 +1,125 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LatencySketch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace logtail {
+
+constexpr double LatencySketch::kRelativeAccuracy;
+constexpr int32_t LatencySketch::kMaxBuckets;
+
+double LatencySketch::GetBucketValue(int32_t index) {
+    static const double sGamma = (1 + kRelativeAccuracy) / (1 - kRelativeAccuracy);
+    // values of bucket index are in (gamma^(index-1), gamma^index], this is the one with the least relative error
+    return 2 * std::pow(sGamma, index) / (1 + sGamma);
+}
+
+int32_t LatencySketch::Extend(int32_t minIndex, int32_t maxIndex) {
+    if (mBuckets.empty()) {
+        mMinIndex = std::max(minIndex, maxIndex - kMaxBuckets + 1);
+        mBuckets.assign(maxIndex - mMinIndex + 1, 0);
+        return std::max(minIndex, mMinIndex);
+    }
+    int32_t newMaxIndex = std::max(maxIndex, mMinIndex + static_cast<int32_t>(mBuckets.size()) - 1);
+    int32_t newMinIndex = std::max(std::min(minIndex, mMinIndex), newMaxIndex - kMaxBuckets + 1);
+    // buckets below newMinIndex are collapsed into it
+    static thread_local std::vector<uint32_t> sBuckets;
+    sBuckets.assign(newMaxIndex - newMinIndex + 1, 0);
+    for (size_t i = 0; i < mBuckets.size(); ++i) {
+        int32_t index = std::max(mMinIndex + static_cast<int32_t>(i), newMinIndex);
+        sBuckets[index - newMinIndex] += mBuckets[i];
+    }
+    mBuckets.swap(sBuckets);
+    mMinIndex = newMinIndex;
+    return std::max(minIndex, mMinIndex);
+}
+
+void LatencySketch::Merge(const LatencySketch& other) {
+    mCount += other.mCount;
+    mZeroCount += other.mZeroCount;
+    if (other.mBuckets.empty()) {
+        return;
+    }
+    int32_t otherMaxIndex = other.mMinIndex + static_cast<int32_t>(other.mBuckets.size()) - 1;
+    Extend(other.mMinIndex, otherMaxIndex);
+    for (size_t i = 0; i < other.mBuckets.size(); ++i) {
+        int32_t index = std::max(other.mMinIndex + static_cast<int32_t>(i), mMinIndex);
+        mBuckets[index - mMinIndex] += other.mBuckets[i];
+    }
+}
+
+double LatencySketch::GetQuantile(double quantile) const {
+    if (mCount == 0) {
+        return 0;
+    }
+    quantile = std::min(std::max(quantile, 0.0), 1.0);
+    uint64_t rank = static_cast<uint64_t>(quantile * (mCount - 1));
+    if (rank < mZeroCount) {
+        return 0;
+    }
+    uint64_t seen = mZeroCount;
+    for (size_t i = 0; i < mBuckets.size(); ++i) {
+        seen += mBuckets[i];
+        if (seen > rank) {
+            return GetBucketValue(mMinIndex + static_cast<int32_t>(i));
+        }
+    }
+    return GetBucketValue(mMinIndex + static_cast<int32_t>(mBuckets.size()) - 1);
+}
+
+std::string LatencySketch::Serialize() const {
+    std::ostringstream oss;
+    oss << kRelativeAccuracy << '|' << mZeroCount << '|' << mMinIndex << '|';
+    for (size_t i = 0; i < mBuckets.size(); ++i) {
+        if (i > 0) {
+            oss << ',';
+        }
+        if (mBuckets[i] > 0) {
+            oss << mBuckets[i];
+        }
+    }
+    return oss.str();
+}
+
+bool LatencySketch::Deserialize(const std::string& data) {
+    Clear();
+    std::istringstream iss(data);
+    double accuracy = 0;
+    char sep = 0;
+    if (!(iss >> accuracy >> sep) || sep != '|' || std::abs(accuracy - kRelativeAccuracy) > 1e-9) {
+        return false;
+    }
+    if (!(iss >> mZeroCount >> sep) || sep != '|' || !(iss >> mMinIndex >> sep) || sep != '|') {
+        Clear();
+        return false;
+    }
+    mCount = mZeroCount;
+    std::string bucket;
+    while (std::getline(iss, bucket, ',')) {
+        uint32_t count = bucket.empty() ? 0 : static_cast<uint32_t>(std::strtoul(bucket.c_str(), nullptr, 10));
+        mBuckets.push_back(count);
+        mCount += count;
+    }
+    if (mBuckets.size() > static_cast<size_t>(kMaxBuckets)) {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace logtail
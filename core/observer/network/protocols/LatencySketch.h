@@ -0,0 +1,103 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace logtail {
+
+/**
+ * LatencySketch estimates quantiles of latencies with bounded relative error, it is a DDSketch.
+ * A value v is counted in bucket ceil(log(v) / log(gamma)), gamma = (1 + a) / (1 - a), so the estimated value of a
+ * bucket is within relative error a of every value in it. Buckets are kept as contiguous counts and at most
+ * kMaxBuckets of them, lowest buckets are collapsed when more are needed, which keeps high quantiles accurate.
+ * With a = 2%, 512 buckets cover latencies across 8 orders of magnitude, e.g. from 1us to 100s in ns, in at most
+ * 2KB, only buckets between the lowest and the highest values seen are allocated.
+ * Sketches are mergeable, merging gives the same result as adding all values to one sketch.
+ */
+class LatencySketch {
+public:
+    static constexpr double kRelativeAccuracy = 0.02;
+    static constexpr int32_t kMaxBuckets = 512;
+
+    void Add(int64_t value) {
+        ++mCount;
+        if (value <= 0) {
+            ++mZeroCount;
+            return;
+        }
+        int32_t offset = GetBucketIndex(value) - mMinIndex;
+        if (offset < 0 || offset >= static_cast<int32_t>(mBuckets.size())) {
+            // low values are counted in the lowest bucket directly once all buckets are used
+            offset = offset < 0 && mBuckets.size() == static_cast<size_t>(kMaxBuckets)
+                ? 0
+                : Extend(offset + mMinIndex, offset + mMinIndex) - mMinIndex;
+        }
+        ++mBuckets[offset];
+    }
+
+    void Merge(const LatencySketch& other);
+
+    void Clear() {
+        // keep capacity, results are reused by ProtocolEventAggTable
+        mBuckets.clear();
+        mMinIndex = 0;
+        mZeroCount = 0;
+        mCount = 0;
+    }
+
+    bool IsEmpty() const { return mCount == 0; }
+    uint64_t GetCount() const { return mCount; }
+
+    /**
+     * @param quantile in [0, 1].
+     * @return the estimated value, or 0 if the sketch is empty.
+     */
+    double GetQuantile(double quantile) const;
+
+    /**
+     * Serialize writes the sketch as "<relative accuracy>|<zero count>|<min index>|<count>,<count>,...", zero counts
+     * are written as empty strings.
+     */
+    std::string Serialize() const;
+    bool Deserialize(const std::string& data);
+
+private:
+    static int32_t GetBucketIndex(int64_t value) {
+        static const double sMultiplier = 1.0 / std::log((1 + kRelativeAccuracy) / (1 - kRelativeAccuracy));
+        return static_cast<int32_t>(std::ceil(std::log(static_cast<double>(value)) * sMultiplier));
+    }
+    static double GetBucketValue(int32_t index);
+
+    // Extend makes buckets cover [minIndex, maxIndex] as far as kMaxBuckets allows, and returns the index values of
+    // minIndex should be counted in, which is higher than minIndex if low buckets are collapsed.
+    int32_t Extend(int32_t minIndex, int32_t maxIndex);
+
+    std::vector<uint32_t> mBuckets;
+    int32_t mMinIndex = 0;
+    uint64_t mZeroCount = 0;
+    uint64_t mCount = 0;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class LatencySketchUnittest;
+#endif
+};
+
+} // namespace logtail
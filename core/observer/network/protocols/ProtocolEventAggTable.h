@@ -0,0 +1,165 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace logtail {
+
+/**
+ * ProtocolEventAggTable is an open addressing hash table of aggregation items, with linear probing.
+ * Items are stored inline and compared by their full keys, so keys with the same hash are never merged. Hashes are
+ * kept in a separate array, most probes only touch it. The table grows up to 2 * maxSize slots and holds at most
+ * maxSize items, items removed keep their memory for the next key in the same slot.
+ * @tparam ProtocolEventAggItem has a Key member comparable by ==, and Clear().
+ */
+template <typename ProtocolEventAggItem>
+class ProtocolEventAggTable {
+public:
+    explicit ProtocolEventAggTable(size_t maxSize) : mMaxSize(maxSize) {}
+
+    size_t Size() const { return mSize; }
+    size_t MaxSize() const { return mMaxSize; }
+
+    /**
+     * @return the item of key, or nullptr if key is absent.
+     */
+    template <typename ProtocolEventKey>
+    ProtocolEventAggItem* Find(const ProtocolEventKey& key, uint64_t hash) {
+        if (mSize == 0) {
+            return nullptr;
+        }
+        uint64_t tag = ToTag(hash);
+        for (size_t pos = tag & mMask;; pos = (pos + 1) & mMask) {
+            if (mTags[pos] == kEmptyTag) {
+                return nullptr;
+            }
+            if (mTags[pos] == tag && mItems[pos].Key == key) {
+                return &mItems[pos];
+            }
+        }
+    }
+
+    /**
+     * Insert adds an absent key with an empty aggregation result.
+     * @return the new item, or nullptr if the table is full.
+     */
+    template <typename ProtocolEventKey>
+    ProtocolEventAggItem* Insert(ProtocolEventKey&& key, uint64_t hash) {
+        if (mSize >= mMaxSize) {
+            return nullptr;
+        }
+        if ((mSize + 1) * 2 > mTags.size()) {
+            Rehash(std::max(kMinCapacity, mTags.size() * 2));
+        }
+        uint64_t tag = ToTag(hash);
+        size_t pos = tag & mMask;
+        while (mTags[pos] != kEmptyTag) {
+            pos = (pos + 1) & mMask;
+        }
+        mTags[pos] = tag;
+        mItems[pos].Clear();
+        mItems[pos].Key = std::forward<ProtocolEventKey>(key);
+        ++mSize;
+        return &mItems[pos];
+    }
+
+    /**
+     * Retain calls func for every item and removes the items func returns false for.
+     */
+    template <typename Func>
+    void Retain(Func func) {
+        size_t removed = 0;
+        for (size_t pos = 0; pos < mTags.size(); ++pos) {
+            if (mTags[pos] != kEmptyTag && !func(mItems[pos])) {
+                mTags[pos] = kEmptyTag;
+                ++removed;
+            }
+        }
+        if (removed > 0) {
+            mSize -= removed;
+            Compact();
+        }
+    }
+
+private:
+    static constexpr uint64_t kEmptyTag = 0;
+    static constexpr size_t kMinCapacity = 64;
+
+    // tags of used slots are never 0, the lowest bit is lost which only costs a few more key comparisons
+    static uint64_t ToTag(uint64_t hash) { return hash | 1; }
+
+    void Rehash(size_t capacity) {
+        std::vector<uint64_t> tags(capacity, kEmptyTag);
+        std::vector<ProtocolEventAggItem> items(capacity);
+        size_t mask = capacity - 1;
+        for (size_t pos = 0; pos < mTags.size(); ++pos) {
+            if (mTags[pos] == kEmptyTag) {
+                continue;
+            }
+            size_t newPos = mTags[pos] & mask;
+            while (tags[newPos] != kEmptyTag) {
+                newPos = (newPos + 1) & mask;
+            }
+            tags[newPos] = mTags[pos];
+            std::swap(items[newPos], mItems[pos]);
+        }
+        mTags.swap(tags);
+        mItems.swap(items);
+        mMask = mask;
+    }
+
+    // Compact moves items back after slots are emptied, so that probe sequences have no holes. Slots are visited
+    // starting from an empty one, so every item before the current one is already in its final place.
+    void Compact() {
+        size_t start = 0;
+        while (mTags[start] != kEmptyTag) {
+            ++start;
+        }
+        for (size_t i = 1; i <= mTags.size(); ++i) {
+            size_t pos = (start + i) & mMask;
+            if (mTags[pos] == kEmptyTag) {
+                continue;
+            }
+            size_t target = mTags[pos] & mMask;
+            while (target != pos && mTags[target] != kEmptyTag) {
+                target = (target + 1) & mMask;
+            }
+            if (target != pos) {
+                mTags[target] = mTags[pos];
+                mTags[pos] = kEmptyTag;
+                std::swap(mItems[target], mItems[pos]);
+            }
+        }
+    }
+
+    size_t mMaxSize;
+    size_t mSize = 0;
+    size_t mMask = 0;
+    std::vector<uint64_t> mTags;
+    std::vector<ProtocolEventAggItem> mItems;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class ProtocolUtilUnittest;
+#endif
+};
+
+} // namespace logtail
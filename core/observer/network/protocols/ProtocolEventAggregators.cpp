@@ -60,4 +60,26 @@ void ProtocolEventAggregators::FlushOutMetrics(uint64_t timeNano,
     }
 }
 
+void ProtocolEventAggregators::MergeFrom(ProtocolEventAggregators& other) {
+    if (other.mDNSAggregators != nullptr) {
+        GetDNSAggregator()->MergeFrom(*other.mDNSAggregators);
+    }
+
+    if (other.mHTTPAggregators != nullptr) {
+        GetHTTPAggregator()->MergeFrom(*other.mHTTPAggregators);
+    }
+
+    if (other.mMySQLAggregators != nullptr) {
+        GetMySQLAggregator()->MergeFrom(*other.mMySQLAggregators);
+    }
+
+    if (other.mRedisAggregators != nullptr) {
+        GetRedisAggregator()->MergeFrom(*other.mRedisAggregators);
+    }
+
+    if (other.mPgSQLAggregators != nullptr) {
+        GetPgSQLAggregator()->MergeFrom(*other.mPgSQLAggregators);
+    }
+}
+
 } // namespace logtail
@@ -111,6 +111,11 @@ public:
                          std::vector<std::pair<std::string, std::string>>& globalTags,
                          uint64_t interval);
 
+    /**
+     * MergeFrom moves the results of all protocols in other into this, see CommonProtocolEventAggregator::MergeFrom.
+     */
+    void MergeFrom(ProtocolEventAggregators& other);
+
 protected:
     DNSProtocolEventAggregator* mDNSAggregators = NULL;
     HTTPProtocolEventAggregator* mHTTPAggregators = NULL;
@@ -25,6 +25,8 @@
 
 namespace logtail {
 
+// value of the fields of aggregation keys which stand for all keys beyond the aggregator size limit
+static const std::string kOverflowAggValue = "__other__";
 
 /**
  * Common hash key for metrics aggregation
@@ -37,6 +39,7 @@ struct CommonAggKey {
           ConnId(other.ConnId),
           RemotePort(other.RemotePort),
           LocalPort(other.LocalPort),
+          Pid(other.Pid),
           Role(other.Role),
           RemoteIp(std::move(other.RemoteIp)),
           LocalIp(std::move(other.LocalIp)) {}
@@ -49,6 +52,7 @@ struct CommonAggKey {
         this->LocalPort = other.LocalPort;
         this->LocalIp = std::move(other.LocalIp);
         this->ConnId = other.ConnId;
+        this->Pid = other.Pid;
         return *this;
     }
     explicit CommonAggKey(PacketEventHeader* header)
@@ -63,6 +67,21 @@ struct CommonAggKey {
         HashVal = XXH32(&this->Role, sizeof(Role), HashVal);
     }
 
+    bool operator==(const CommonAggKey& other) const {
+        return HashVal == other.HashVal && ConnId == other.ConnId && RemotePort == other.RemotePort
+            && LocalPort == other.LocalPort && Pid == other.Pid && Role == other.Role && RemoteIp == other.RemoteIp
+            && LocalIp == other.LocalIp;
+    }
+
+    // ResetToOverflow keeps only the role, for the aggregation of connections beyond the aggregator size limit.
+    void ResetToOverflow() {
+        PacketRoleType role = Role;
+        *this = CommonAggKey();
+        Role = role;
+        RemoteIp = kOverflowAggValue;
+        LocalIp = kOverflowAggValue;
+    }
+
     friend std::ostream& operator<<(std::ostream& Os, const CommonAggKey& Key) {
         Os << "HashVal: " << Key.HashVal << " ConnId: " << Key.ConnId << " RemotePort: " << Key.RemotePort
            << " LocalPort: " << Key.LocalPort << " Role: " << PacketRoleTypeToString(Key.Role)
@@ -130,6 +149,17 @@ struct DBAggKey {
         hashValue = XXH32(&this->Status, sizeof(this->Status), hashValue);
         return hashValue;
     }
+    bool operator==(const DBAggKey& other) const {
+        return Status == other.Status && ConnKey == other.ConnKey && QueryCmd == other.QueryCmd
+            && Query == other.Query && Version == other.Version;
+    }
+    void ResetToOverflow() {
+        ConnKey.ResetToOverflow();
+        QueryCmd.clear();
+        Query = kOverflowAggValue;
+        Version.clear();
+        Status = -1;
+    }
     void ToPB(sls_logs::Log* log) const {
         AddAnyLogContent(log, observer::kVersion, Version);
         AddAnyLogContent(log, observer::kQueryCmd, QueryCmd);
@@ -194,6 +224,20 @@ struct RequestAggKey {
         hashValue = XXH32(&this->RespStatus, sizeof(this->RespStatus), hashValue);
         return hashValue;
     }
+    bool operator==(const RequestAggKey& other) const {
+        return RespCode == other.RespCode && RespStatus == other.RespStatus && ConnKey == other.ConnKey
+            && ReqType == other.ReqType && ReqDomain == other.ReqDomain && ReqResource == other.ReqResource
+            && Version == other.Version;
+    }
+    void ResetToOverflow() {
+        ConnKey.ResetToOverflow();
+        ReqType.clear();
+        ReqDomain.clear();
+        ReqResource = kOverflowAggValue;
+        Version.clear();
+        RespCode = -1;
+        RespStatus = -1;
+    }
     void ToPB(sls_logs::Log* log) const {
         AddAnyLogContent(log, observer::kReqType, ReqType);
         AddAnyLogContent(log, observer::kReqDomain, ReqDomain);
@@ -23,6 +23,9 @@
 #include "LogtailAlarm.h"
 #include "metas/ServiceMetaCache.h"
 #include "Logger.h"
+#include "network/protocols/LatencySketch.h"
+#include "network/protocols/ProtocolEventAggTable.h"
+#include <array>
 #include <unordered_map>
 #include <ostream>
 
@@ -82,6 +85,7 @@ struct CommonProtocolAggResult {
         TotalLatencyNs = 0;
         TotalReqBytes = 0;
         TotalRespBytes = 0;
+        Latency.Clear();
     }
 
     bool IsEmpty() const { return TotalCount == 0; }
@@ -91,6 +95,7 @@ struct CommonProtocolAggResult {
         TotalLatencyNs += info.LatencyNs;
         TotalReqBytes += info.ReqBytes;
         TotalRespBytes += info.RespBytes;
+        Latency.Add(info.LatencyNs);
     }
 
     void Merge(CommonProtocolAggResult& aggResult) {
@@ -98,6 +103,7 @@ struct CommonProtocolAggResult {
         TotalLatencyNs += aggResult.TotalLatencyNs;
         TotalReqBytes += aggResult.TotalReqBytes;
         TotalRespBytes += aggResult.TotalRespBytes;
+        Latency.Merge(aggResult.Latency);
     }
 
     void ToPB(sls_logs::Log* log) const {
@@ -105,13 +111,18 @@ struct CommonProtocolAggResult {
         AddAnyLogContent(log, observer::kLatencyNs, TotalLatencyNs);
         AddAnyLogContent(log, observer::kReqBytes, TotalReqBytes);
         AddAnyLogContent(log, observer::kRespBytes, TotalRespBytes);
-        AddAnyLogContent(log, observer::kTdigestLatency, std::string("xxxxx"));
+        AddAnyLogContent(log, observer::kLatencyP50Ns, static_cast<int64_t>(Latency.GetQuantile(0.5)));
+        AddAnyLogContent(log, observer::kLatencyP90Ns, static_cast<int64_t>(Latency.GetQuantile(0.9)));
+        AddAnyLogContent(log, observer::kLatencyP99Ns, static_cast<int64_t>(Latency.GetQuantile(0.99)));
+        // the field keeps its name, the sketch can be merged by the backend across instances and intervals
+        AddAnyLogContent(log, observer::kTdigestLatency, Latency.Serialize());
     }
 
     int64_t TotalCount{0};
     int64_t TotalLatencyNs{0};
     int64_t TotalReqBytes{0};
     int64_t TotalRespBytes{0};
+    LatencySketch Latency;
 };
 
 
@@ -137,88 +148,26 @@ struct CommonProtocolEventAggItem {
     ProtocolEventAggResult AggResult;
 };
 
-/**
- * Cache pool
- * @tparam ProtocolEventAggItem reused object.
- */
-template <typename ProtocolEventAggItem>
-class CommonProtocolEventAggItemManager {
-public:
-    explicit CommonProtocolEventAggItemManager(size_t maxCount = 128) : mMaxCount(maxCount) {}
-
-    ~CommonProtocolEventAggItemManager() {
-        for (auto iter = mUnUsed.begin(); iter != mUnUsed.end(); ++iter) {
-            delete *iter;
-        }
-    }
-
-    /**
-     * Create an new object or reuse the cached object.
-     * @return an protocol metrics event aggregate node.
-     */
-    template <typename ProtocolEventKey>
-    ProtocolEventAggItem* Create(ProtocolEventKey&& event) {
-        ProtocolEventAggItem* item;
-        if (mUnUsed.empty()) {
-            item = new ProtocolEventAggItem();
-            item->Key = std::move(event);
-            return item;
-        }
-        item = mUnUsed.back();
-        item->Clear();
-        item->Key = std::move(event);
-        mUnUsed.pop_back();
-        return item;
-    }
-
-    /**
-     * Delete object when cache is full, or else would cache it.
-     * @param item deleting object.
-     */
-    void Delete(ProtocolEventAggItem* item) {
-        if (mUnUsed.size() < mMaxCount) {
-            mUnUsed.push_back(item);
-            return;
-        }
-        delete item;
-    }
-
-private:
-    size_t mMaxCount;
-    std::deque<ProtocolEventAggItem*> mUnUsed;
-};
-
 // 通用的协议的聚类器实现
-template <typename ProtocolEvent, typename ProtocolEventAggItem, typename ProtocolEventAggItemManager>
+template <typename ProtocolEvent, typename ProtocolEventAggItem>
 class CommonProtocolEventAggregator {
 public:
     CommonProtocolEventAggregator(uint32_t maxClientAggSize, uint32_t maxServerAggSize)
-        : mClientAggMaxSize(maxClientAggSize), mServerAggMaxSize(maxServerAggSize) {}
+        : mClientAggMaxSize(maxClientAggSize),
+          mServerAggMaxSize(maxServerAggSize),
+          mProtocolEventAggTable(std::max(maxClientAggSize, maxServerAggSize)) {}
 
-    ~CommonProtocolEventAggregator() {
-        for (auto iter = mProtocolEventAggMap.begin(); iter != mProtocolEventAggMap.end(); ++iter) {
-            mAggItemManager.Delete(iter->second);
-        }
-    }
     bool AddEvent(ProtocolEvent&& event) {
-        auto key = event.Key;
-        auto hashVal = key.Hash();
-        auto findRst = mProtocolEventAggMap.find(hashVal);
-        if (findRst == mProtocolEventAggMap.end()) {
+        auto hashVal = event.Key.Hash();
+        auto item = mProtocolEventAggTable.Find(event.Key, hashVal);
+        if (item == nullptr) {
             if (isFull(event.Key.ConnKey.Role)) {
-                static uint32_t sLastDropTime{0};
-                auto now = time(nullptr);
-                LOG_DEBUG(sLogger, ("aggregator is full, some events would be dropped", event.Key.ToString()));
-                if (now - sLastDropTime > 60) {
-                    sLastDropTime = now;
-                    LOG_ERROR(sLogger, ("aggregator is full, some events would be dropped", event.Key.ProtocolType()));
-                }
-                return false;
+                item = getOverflowItem(event);
+            } else {
+                item = mProtocolEventAggTable.Insert(std::move(event.Key), hashVal);
             }
-            auto item = mAggItemManager.Create(std::move(event.Key));
-            findRst = mProtocolEventAggMap.insert(std::make_pair(hashVal, item)).first;
         }
-        findRst->second->AddEventInfo(event.Info);
+        item->AddEventInfo(event.Info);
         return true;
     }
 
@@ -226,20 +175,53 @@ public:
                    const std::string& tags,
                    google::protobuf::RepeatedPtrField<sls_logs::Log_Content>& globalTags,
                    uint64_t interval) {
-        for (auto iter = mProtocolEventAggMap.begin(); iter != mProtocolEventAggMap.end();) {
-            if (iter->second->AggResult.IsEmpty()) {
-                mAggItemManager.Delete(iter->second);
-                iter = mProtocolEventAggMap.erase(iter);
-            } else {
-                sls_logs::Log newLog;
-                newLog.mutable_contents()->CopyFrom(globalTags);
-                AddAnyLogContent(&newLog, observer::kLocalInfo, tags);
-                AddAnyLogContent(&newLog, observer::kInterval, interval);
-                iter->second->ToPB(&newLog);
-                iter->second->Clear(); // wait for next clear
-                allData.push_back(std::move(newLog));
-                ++iter;
+        auto flushItem = [&](ProtocolEventAggItem& item) {
+            if (item.AggResult.IsEmpty()) {
+                return false;
+            }
+            sls_logs::Log newLog;
+            newLog.mutable_contents()->CopyFrom(globalTags);
+            AddAnyLogContent(&newLog, observer::kLocalInfo, tags);
+            AddAnyLogContent(&newLog, observer::kInterval, interval);
+            item.ToPB(&newLog);
+            item.Clear(); // wait for next clear
+            allData.push_back(std::move(newLog));
+            return true;
+        };
+        mProtocolEventAggTable.Retain(flushItem);
+        for (auto& item : mOverflowItems) {
+            flushItem(item);
+        }
+    }
+
+    /**
+     * MergeFrom moves the aggregation results of other into this aggregator, keys which do not fit any more are
+     * merged into the overflow items. Like FlushLogs, other keeps the keys of non empty items for the next interval.
+     */
+    void MergeFrom(CommonProtocolEventAggregator& other) {
+        other.mProtocolEventAggTable.Retain([&](ProtocolEventAggItem& otherItem) {
+            if (otherItem.AggResult.IsEmpty()) {
+                return false;
+            }
+            auto hashVal = otherItem.Key.Hash();
+            auto item = mProtocolEventAggTable.Find(otherItem.Key, hashVal);
+            if (item == nullptr) {
+                if (isFull(otherItem.Key.ConnKey.Role)) {
+                    item = &mergeOverflowItem(otherItem, static_cast<size_t>(otherItem.Key.ConnKey.Role));
+                } else {
+                    item = mProtocolEventAggTable.Insert(otherItem.Key, hashVal);
+                }
+            }
+            item->Merge(otherItem);
+            otherItem.Clear();
+            return true;
+        });
+        for (size_t i = 0; i < other.mOverflowItems.size(); ++i) {
+            if (other.mOverflowItems[i].AggResult.IsEmpty()) {
+                continue;
             }
+            mergeOverflowItem(other.mOverflowItems[i], i).Merge(other.mOverflowItems[i]);
+            other.mOverflowItems[i].Clear();
         }
     }
 
@@ -247,17 +229,51 @@ public:
 private:
     bool isFull(PacketRoleType role) {
         if (role == PacketRoleType::Client) {
-            return this->mProtocolEventAggMap.size() >= mClientAggMaxSize;
+            return this->mProtocolEventAggTable.Size() >= mClientAggMaxSize;
         }
         if (role == PacketRoleType::Server) {
-            return this->mProtocolEventAggMap.size() >= mServerAggMaxSize;
+            return this->mProtocolEventAggTable.Size() >= mServerAggMaxSize;
         }
         return true;
     }
-    ProtocolEventAggItemManager mAggItemManager;
-    std::unordered_map<uint64_t, ProtocolEventAggItem*> mProtocolEventAggMap;
+
+    // Events of new keys are aggregated by role into an overflow item once the aggregator is full, so that totals
+    // are still right when there are too many distinct keys.
+    ProtocolEventAggItem* getOverflowItem(ProtocolEvent& event) {
+        auto& item = mOverflowItems[static_cast<size_t>(event.Key.ConnKey.Role) % mOverflowItems.size()];
+        if (item.AggResult.IsEmpty()) {
+            static uint32_t sLastOverflowTime{0};
+            auto now = time(nullptr);
+            LOG_DEBUG(sLogger, ("aggregator is full, events are aggregated as others", event.Key.ToString()));
+            if (now - sLastOverflowTime > 60) {
+                sLastOverflowTime = now;
+                LOG_WARNING(sLogger,
+                            ("aggregator is full, events are aggregated as others", event.Key.ProtocolType()));
+            }
+            item.Key = std::move(event.Key);
+            item.Key.ResetToOverflow();
+        }
+        return &item;
+    }
+
+    ProtocolEventAggItem& mergeOverflowItem(const ProtocolEventAggItem& otherItem, size_t index) {
+        auto& item = mOverflowItems[index % mOverflowItems.size()];
+        if (item.AggResult.IsEmpty()) {
+            item.Key = otherItem.Key;
+            item.Key.ResetToOverflow();
+        }
+        return item;
+    }
+
     uint32_t mClientAggMaxSize;
     uint32_t mServerAggMaxSize;
+    ProtocolEventAggTable<ProtocolEventAggItem> mProtocolEventAggTable;
+    // indexed by PacketRoleType
+    std::array<ProtocolEventAggItem, 3> mOverflowItems;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class ProtocolUtilUnittest;
+#endif
 };
 
 /**
@@ -283,13 +299,17 @@ public:
     }
 
     // Only add event fail returns false;
-    bool InsertReq(std::function<void(reqType* req)> configFunc) {
+    // configFunc is called as configFunc(reqType*), it is a template parameter so that capturing lambdas are not
+    // copied into a std::function on the heap for every packet.
+    template <typename ConfigFunc>
+    bool InsertReq(ConfigFunc configFunc) {
         configFunc(GetReqPos());
         return TryStitcherByReq();
     }
 
     // Only add event fail returns false;
-    bool InsertResp(std::function<void(respType* resp)> configFunc) {
+    template <typename ConfigFunc>
+    bool InsertResp(ConfigFunc configFunc) {
         configFunc(GetRespPos());
         return TryStitcherByResp();
     }
@@ -343,10 +363,9 @@ private:
         if (resp == nullptr) {
             return true;
         }
-        eventType event;
         bool success = true;
-        if (this->mConvertEventFunc != nullptr && this->mConvertEventFunc(req, resp, event)) {
-            success = this->mAggregators->AddEvent(std::move(event));
+        if (this->mConvertEventFunc != nullptr && this->mConvertEventFunc(req, resp, mEvent)) {
+            success = this->mAggregators->AddEvent(std::move(mEvent));
         }
         ++this->mHeadRequestsIdx;
         ++this->mHeadResponsesIdx;
@@ -377,13 +396,12 @@ private:
         if (req == nullptr) {
             return true;
         }
-        eventType event;
         bool success = true;
-        if (this->mConvertEventFunc != nullptr && this->mConvertEventFunc(req, resp, event)) {
+        if (this->mConvertEventFunc != nullptr && this->mConvertEventFunc(req, resp, mEvent)) {
             LOG_TRACE(sLogger,
                       ("head_req", this->mHeadRequestsIdx)("tail_req", this->mTailRequestsIdx)(
                           "head_resp", this->mHeadRequestsIdx)("tail_resp", this->mTailResponsesIdx));
-            success = this->mAggregators->AddEvent(std::move(event));
+            success = this->mAggregators->AddEvent(std::move(mEvent));
         }
         ++this->mHeadRequestsIdx;
         ++this->mHeadResponsesIdx;
@@ -431,6 +449,8 @@ private:
     aggregatorType* mAggregators;
 
     std::function<bool(reqType* req, respType* resp, eventType&)> mConvertEventFunc;
+    // reused by every stitched pair, so converters assigning strings keep their capacity and do not allocate
+    eventType mEvent;
 
     friend class ProtocolUtilUnittest;
 };
@@ -23,9 +23,6 @@ namespace logtail {
 using DNSProtocolEventKey = RequestAggKey<ProtocolType_DNS>;
 using DNSProtocolEvent = CommonProtocolEvent<DNSProtocolEventKey>;
 using DNSProtocolEventAggItem = CommonProtocolEventAggItem<DNSProtocolEventKey, CommonProtocolAggResult>;
-using DNSProtocolEventAggItemManager = CommonProtocolEventAggItemManager<DNSProtocolEventAggItem>;
-using DNSProtocolEventAggregator = CommonProtocolEventAggregator<DNSProtocolEvent,
-                                                                 DNSProtocolEventAggItem,
-                                                                 DNSProtocolEventAggItemManager>;
+using DNSProtocolEventAggregator = CommonProtocolEventAggregator<DNSProtocolEvent, DNSProtocolEventAggItem>;
 
 } // namespace logtail
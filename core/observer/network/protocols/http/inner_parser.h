@@ -45,7 +45,8 @@ struct HTTPResponsePacket {
 struct HTTPCommonPacket {
     int version;
     size_t headersNum{50};
-    struct phr_header headers[50]{};
+    // filled by picohttpparser up to headersNum, not cleared for every packet
+    struct phr_header headers[50];
 };
 
 struct Packet {
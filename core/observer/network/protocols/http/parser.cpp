@@ -99,22 +99,24 @@ ParseResult HTTPProtocolParser::OnPacket(PacketType pktType,
 
     bool insertSuccess = true;
     if (msgType == MessageType_Request) {
-        std::string host = parser.ReadHeaderVal("Host").ToString();
-        if (host.empty()) {
-            if (pktType == PacketType_Out) {
-                host = SockAddressToString(header->DstAddr);
-            } else {
-                host = SockAddressToString(header->SrcAddr);
-            }
-        }
-        int pos = parser.packet.msg.req.url.Find('?');
-        std::string url = std::string(parser.packet.msg.req.url.mPtr, pos == -1 ? parser.packet.msg.req.url.mLen : pos);
+        static const std::string sHostName("Host");
+        SlsStringPiece host = parser.ReadHeaderVal(sHostName);
+        const SlsStringPiece& url = parser.packet.msg.req.url;
+        int pos = url.Find('?');
         insertSuccess = mCache.InsertReq([&](HTTPRequestInfo* req) {
             req->TimeNano = header->TimeNano;
-            req->Method = parser.packet.msg.req.method.ToString();
-            req->URL = std::move(url);
-            req->Version = std::to_string(parser.packet.common.version);
-            req->Host = std::move(host);
+            req->Method = ParseHTTPMethod(parser.packet.msg.req.method);
+            if (req->Method == HTTPMethod_Unknown) {
+                req->UnknownMethod.assign(parser.packet.msg.req.method.mPtr, parser.packet.msg.req.method.mLen);
+            }
+            req->URL.assign(url.mPtr, pos == -1 ? url.mLen : pos);
+            req->MinorVersion = parser.packet.common.version;
+            if (host.mLen > 0) {
+                req->Host.assign(host.mPtr, host.mLen);
+            } else {
+                // the same addresses as SockAddressToString(header->DstAddr / SrcAddr), formatted once in mKey
+                req->Host = pktType == PacketType_Out ? mKey.RemoteIp : mKey.LocalIp;
+            }
             req->ReqBytes = pktRealSize;
             LOG_TRACE(sLogger, ("http insert req hash", header->SockHash)("data", req->ToString()));
         });
@@ -129,6 +131,71 @@ ParseResult HTTPProtocolParser::OnPacket(PacketType pktType,
     return insertSuccess ? ParseResult_OK : ParseResult_Drop;
 }
 
+HTTPMethod ParseHTTPMethod(const SlsStringPiece& method) {
+    // dispatch on the length first, so at most two comparisons are made
+    switch (method.mLen) {
+        case 3:
+            if (memcmp(method.mPtr, "GET", 3) == 0) {
+                return HTTPMethod_GET;
+            }
+            if (memcmp(method.mPtr, "PUT", 3) == 0) {
+                return HTTPMethod_PUT;
+            }
+            break;
+        case 4:
+            if (memcmp(method.mPtr, "POST", 4) == 0) {
+                return HTTPMethod_POST;
+            }
+            if (memcmp(method.mPtr, "HEAD", 4) == 0) {
+                return HTTPMethod_HEAD;
+            }
+            break;
+        case 5:
+            if (memcmp(method.mPtr, "PATCH", 5) == 0) {
+                return HTTPMethod_PATCH;
+            }
+            if (memcmp(method.mPtr, "TRACE", 5) == 0) {
+                return HTTPMethod_TRACE;
+            }
+            break;
+        case 6:
+            if (memcmp(method.mPtr, "DELETE", 6) == 0) {
+                return HTTPMethod_DELETE;
+            }
+            break;
+        case 7:
+            if (memcmp(method.mPtr, "OPTIONS", 7) == 0) {
+                return HTTPMethod_OPTIONS;
+            }
+            if (memcmp(method.mPtr, "CONNECT", 7) == 0) {
+                return HTTPMethod_CONNECT;
+            }
+            break;
+        default:
+            break;
+    }
+    return HTTPMethod_Unknown;
+}
+
+const std::string& HTTPMethodToString(HTTPMethod method) {
+    static const std::string sMethods[] = {
+        "", "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"};
+    if (method < HTTPMethod_Unknown || method > HTTPMethod_PATCH) {
+        return sMethods[HTTPMethod_Unknown];
+    }
+    return sMethods[method];
+}
+
+const std::string& HTTPVersionToString(int minorVersion) {
+    // the minor version is reported, picohttpparser only accepts HTTP/1.x with a single digit minor version
+    static const std::string sVersions[] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9"};
+    static const std::string sUnknown;
+    if (minorVersion < 0 || minorVersion > 9) {
+        return sUnknown;
+    }
+    return sVersions[minorVersion];
+}
+
 bool HTTPProtocolParser::GarbageCollection(size_t size_limit_bytes, uint64_t expireTimeNs) {
     return mCache.GarbageCollection(expireTimeNs);
 }
@@ -24,17 +24,42 @@
 
 namespace logtail {
 
+enum HTTPMethod {
+    HTTPMethod_Unknown,
+    HTTPMethod_GET,
+    HTTPMethod_HEAD,
+    HTTPMethod_POST,
+    HTTPMethod_PUT,
+    HTTPMethod_DELETE,
+    HTTPMethod_CONNECT,
+    HTTPMethod_OPTIONS,
+    HTTPMethod_TRACE,
+    HTTPMethod_PATCH,
+};
+
+HTTPMethod ParseHTTPMethod(const SlsStringPiece& method);
+const std::string& HTTPMethodToString(HTTPMethod method);
+const std::string& HTTPVersionToString(int minorVersion);
+
+// Requests wait in the cache for responses from later packets, so the fields which come from the packet are
+// copied, into strings which are reused by the next request of the slot and seldom allocate.
 struct HTTPRequestInfo {
     uint64_t TimeNano;
-    std::string Method;
+    HTTPMethod Method;
+    // only set for methods out of HTTPMethod
+    std::string UnknownMethod;
     std::string URL;
-    std::string Version;
+    int MinorVersion;
     std::string Host;
     int32_t ReqBytes;
 
+    const std::string& MethodString() const {
+        return Method == HTTPMethod_Unknown ? UnknownMethod : HTTPMethodToString(Method);
+    }
+
     friend std::ostream& operator<<(std::ostream& os, const HTTPRequestInfo& info) {
-        os << "TimeNano: " << info.TimeNano << " Method: " << info.Method << " URL: " << info.URL
-           << " Version: " << info.Version << " Host: " << info.Host << " ReqBytes: " << info.ReqBytes;
+        os << "TimeNano: " << info.TimeNano << " Method: " << info.MethodString() << " URL: " << info.URL
+           << " Version: " << info.MinorVersion << " Host: " << info.Host << " ReqBytes: " << info.ReqBytes;
         return os;
     }
 
@@ -76,10 +101,11 @@ public:
                 }
                 event.Info.ReqBytes = requestInfo->ReqBytes;
                 event.Info.RespBytes = responseInfo->RespBytes;
-                event.Key.ReqType = std::move(requestInfo->Method);
-                event.Key.ReqDomain = std::move(requestInfo->Host);
-                event.Key.ReqResource = std::move(requestInfo->URL);
-                event.Key.Version = std::move(requestInfo->Version);
+                // assigned but not moved, so both the request slot and the event keep their buffers
+                event.Key.ReqType = requestInfo->MethodString();
+                event.Key.ReqDomain = requestInfo->Host;
+                event.Key.ReqResource = requestInfo->URL;
+                event.Key.Version = HTTPVersionToString(requestInfo->MinorVersion);
                 event.Key.RespCode = responseInfo->RespCode;
                 event.Key.ConnKey = mKey;
                 return true;
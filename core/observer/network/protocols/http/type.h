@@ -28,9 +28,6 @@ namespace logtail {
 using HTTPProtocolEventKey = RequestAggKey<ProtocolType_HTTP>;
 using HTTPProtocolEvent = CommonProtocolEvent<HTTPProtocolEventKey>;
 using HTTPProtocolEventAggItem = CommonProtocolEventAggItem<HTTPProtocolEventKey, CommonProtocolAggResult>;
-using HTTPProtocolEventAggItemManager = CommonProtocolEventAggItemManager<HTTPProtocolEventAggItem>;
-using HTTPProtocolEventAggregator = CommonProtocolEventAggregator<HTTPProtocolEvent,
-                                                                  HTTPProtocolEventAggItem,
-                                                                  HTTPProtocolEventAggItemManager>;
+using HTTPProtocolEventAggregator = CommonProtocolEventAggregator<HTTPProtocolEvent, HTTPProtocolEventAggItem>;
 
 } // namespace logtail
@@ -23,8 +23,5 @@ namespace logtail {
 using MySQLProtocolEventKey = DBAggKey<ProtocolType_MySQL>;
 using MySQLProtocolEvent = CommonProtocolEvent<MySQLProtocolEventKey>;
 using MySQLProtocolEventAggItem = CommonProtocolEventAggItem<MySQLProtocolEventKey, CommonProtocolAggResult>;
-using MySQLProtocolEventAggItemManager = CommonProtocolEventAggItemManager<MySQLProtocolEventAggItem>;
-using MySQLProtocolEventAggregator = CommonProtocolEventAggregator<MySQLProtocolEvent,
-                                                                   MySQLProtocolEventAggItem,
-                                                                   MySQLProtocolEventAggItemManager>;
+using MySQLProtocolEventAggregator = CommonProtocolEventAggregator<MySQLProtocolEvent, MySQLProtocolEventAggItem>;
 } // namespace logtail
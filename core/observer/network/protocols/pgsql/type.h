@@ -23,7 +23,5 @@ namespace logtail {
 using PgSQLProtocolEventKey = DBAggKey<ProtocolType_PgSQL>;
 using PgSQLProtocolEvent = CommonProtocolEvent<PgSQLProtocolEventKey>;
 using PgSQLProtocolEventAggItem = CommonProtocolEventAggItem<PgSQLProtocolEventKey, CommonProtocolAggResult>;
-using PgSQLProtocolEventAggItemManager = CommonProtocolEventAggItemManager<PgSQLProtocolEventAggItem>;
-using PgSQLProtocolEventAggregator
-    = CommonProtocolEventAggregator<PgSQLProtocolEvent, PgSQLProtocolEventAggItem, PgSQLProtocolEventAggItemManager>;
+using PgSQLProtocolEventAggregator = CommonProtocolEventAggregator<PgSQLProtocolEvent, PgSQLProtocolEventAggItem>;
 } // namespace logtail
@@ -24,7 +24,5 @@ namespace logtail {
 using RedisProtocolEventKey = DBAggKey<ProtocolType_Redis>;
 using RedisProtocolEvent = CommonProtocolEvent<RedisProtocolEventKey>;
 using RedisProtocolEventAggItem = CommonProtocolEventAggItem<RedisProtocolEventKey, CommonProtocolAggResult>;
-using RedisProtocolEventAggItemManager = CommonProtocolEventAggItemManager<RedisProtocolEventAggItem>;
-using RedisProtocolEventAggregator
-    = CommonProtocolEventAggregator<RedisProtocolEvent, RedisProtocolEventAggItem, RedisProtocolEventAggItemManager>;
+using RedisProtocolEventAggregator = CommonProtocolEventAggregator<RedisProtocolEvent, RedisProtocolEventAggItem>;
 } // namespace logtail
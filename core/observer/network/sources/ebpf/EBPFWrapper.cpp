@@ -36,6 +36,10 @@ DEFINE_FLAG_INT64(
 DEFINE_FLAG_STRING(sls_observer_ebpf_host_path,
                    "the backup real host path for store libebpf.so",
                    "/etc/ilogtail/ebpf/");
+DEFINE_FLAG_INT32(sls_observer_ebpf_batch_size, "max events polled from ebpf and processed as a batch", 512);
+DEFINE_FLAG_INT32(sls_observer_ebpf_batch_max_bytes,
+                  "max bytes of ebpf events in a batch, the batch is processed when it is exceeded",
+                  4 * 1024 * 1024);
 
 static const std::string kLowkernelCentosName = "CentOS";
 static const uint16_t kLowkernelCentosMinVersion = 7006;
@@ -328,7 +332,13 @@ bool EBPFWrapper::loadEbpfLib(int64_t kernelVersion, std::string& soPath) {
     return true;
 }
 
-bool EBPFWrapper::Init(std::function<int(StringPiece)> processor) {
+EBPFWrapper::EBPFWrapper(NetworkConfig* config)
+    : mConfig(config),
+      mPacketBatch(static_cast<size_t>(std::max(INT32_FLAG(sls_observer_ebpf_batch_size), 1)),
+                   static_cast<size_t>(std::max(INT32_FLAG(sls_observer_ebpf_batch_max_bytes), 0))) {
+}
+
+bool EBPFWrapper::Init(std::function<int(PacketEventBatch&)> processor) {
     if (mInitSuccess) {
         return true;
     }
@@ -432,6 +442,7 @@ int32_t EBPFWrapper::ProcessPackets(int32_t maxProcessPackets, int32_t maxProces
         return -1;
     }
     auto res = g_ebpf_poll_events_func(maxProcessPackets, &this->holdOnFlag);
+    FlushPacketBatch();
     if (res < 0 && res != -100) {
         LOG_ERROR(sLogger, ("pull ebpf events", "failed")("error", "unknown polling result")("result", res));
         LogtailAlarm::GetInstance()->SendAlarm(OBSERVER_RUNTIME_ALARM,
@@ -586,6 +597,16 @@ bool EBPFWrapper::ConvertCtrlToPacketHeader(struct conn_ctrl_event_t* event, Pac
     return true;
 }
 
+void EBPFWrapper::FlushPacketBatch() {
+    if (mPacketBatch.Empty()) {
+        return;
+    }
+    if (mPacketProcessor) {
+        mPacketProcessor(mPacketBatch);
+    }
+    mPacketBatch.Clear();
+}
+
 void EBPFWrapper::OnData(struct conn_data_event_t* event) {
     if (event->attr.msg_buf_size > CONN_DATA_MAX_SIZE) {
         LOG_WARNING(sLogger, ("module", "ebpf")("error", "invalid ebpf data event")("size", event->attr.msg_buf_size));
@@ -595,15 +616,21 @@ void EBPFWrapper::OnData(struct conn_data_event_t* event) {
         return;
     }
     // convert data event to PacketEvent
-    auto* header = (PacketEventHeader*)(&mPacketDataBuffer.at(0));
-    SocketCategory socketCategory = ConvertDataToPacketHeader(event, header);
-    EBPF_CONNECTION_FILTER(socketCategory, header->DstAddr, event->attr.conn_id, event->attr.addr);
+    PacketEventHeader eventHeader;
+    SocketCategory socketCategory = ConvertDataToPacketHeader(event, &eventHeader);
+    EBPF_CONNECTION_FILTER(socketCategory, eventHeader.DstAddr, event->attr.conn_id, event->attr.addr);
+    // Kafka protocol would first read 4Byte data, so kernel use try_to_prepend to identify this condition.
+    // But this operation is an optional choose for Mysql protocol. So, MySQL protocol would also append 4Bytes
+    // when the length_header is positive number.
+    int32_t prependLen = event->attr.try_to_prepend || isAppendMySQLMsg(event) ? 4 : 0;
+    char* packet = mPacketBatch.Append(sizeof(PacketEventHeader) + sizeof(PacketEventData) + prependLen
+                                       + event->attr.msg_buf_size);
+    auto* header = reinterpret_cast<PacketEventHeader*>(packet);
+    *header = eventHeader;
     header->TimeNano = event->attr.ts + mDeltaTimeNs;
-    PacketEventData* data = (PacketEventData*)(&mPacketDataBuffer.at(0) + sizeof(PacketEventHeader));
+    auto* data = reinterpret_cast<PacketEventData*>(packet + sizeof(PacketEventHeader));
     data->PktType = (PacketType)event->attr.direction;
     data->PtlType = (ProtocolType)event->attr.protocol;
-    data->BufferLen = event->attr.msg_buf_size;
-    data->RealLen = event->attr.org_msg_size;
     if (header->RoleType == PacketRoleType::Unknown) {
         data->MsgType = InferRequestOrResponse(data->PktType, header);
         header->RoleType = InferServerOrClient(data->PktType, data->MsgType);
@@ -631,32 +658,32 @@ void EBPFWrapper::OnData(struct conn_data_event_t* event) {
             "hash", header->SockHash)("raw_data", std::string(event->msg, event->attr.msg_buf_size))
 
     );
-    // Kafka protocol would first read 4Byte data, so kernel use try_to_prepend to identify this condition.
-    // But this operation is an optional choose for Mysql protocol. So, MySQL protocol would also append 4Bytes
-    // when the length_header is positive number.
-    if (event->attr.try_to_prepend || isAppendMySQLMsg(event)) {
-        data->Buffer = &mPacketDataBuffer.at(0) + sizeof(PacketEventHeader) + sizeof(PacketEventData);
-        data->BufferLen = event->attr.msg_buf_size + 4;
-        data->RealLen = event->attr.org_msg_size + 4;
+    // the payload is copied, the event is only valid in the callback
+    data->Buffer = packet + sizeof(PacketEventHeader) + sizeof(PacketEventData);
+    data->BufferLen = event->attr.msg_buf_size + prependLen;
+    data->RealLen = event->attr.org_msg_size + prependLen;
+    if (prependLen > 0) {
         *(uint32_t*)data->Buffer = event->attr.length_header;
         memcpy(data->Buffer + 4, event->msg, event->attr.msg_buf_size);
         LOG_TRACE(sLogger, ("data event append data", charToHexString(data->Buffer, data->BufferLen, data->BufferLen)));
     } else {
-        data->Buffer = event->msg;
-        data->BufferLen = event->attr.msg_buf_size;
-        data->RealLen = event->attr.org_msg_size;
+        memcpy(data->Buffer, event->msg, event->attr.msg_buf_size);
     }
-    if (mPacketProcessor) {
-        mPacketProcessor(StringPiece(mPacketDataBuffer.data(), sizeof(PacketEventHeader) + sizeof(PacketEventData)));
+    if (mPacketBatch.IsFull()) {
+        FlushPacketBatch();
     }
 }
 
 void EBPFWrapper::OnCtrl(struct conn_ctrl_event_t* event) {
-    PacketEventHeader* header = (PacketEventHeader*)(&mPacketDataBuffer.at(0));
-    header->TimeNano = event->ts + mDeltaTimeNs;
-    ConvertCtrlToPacketHeader(event, header);
-    if (mPacketProcessor) {
-        mPacketProcessor(StringPiece(mPacketDataBuffer.data(), sizeof(PacketEventHeader)));
+    static auto sConnManager = ConnectionMetaManager::GetInstance();
+    // the fd may be used by another socket than the cached one
+    sConnManager->OnConnectionChanged(event->conn_id.tgid, event->conn_id.fd);
+    PacketEventHeader header;
+    header.TimeNano = event->ts + mDeltaTimeNs;
+    ConvertCtrlToPacketHeader(event, &header);
+    memcpy(mPacketBatch.Append(sizeof(PacketEventHeader)), &header, sizeof(header));
+    if (mPacketBatch.IsFull()) {
+        FlushPacketBatch();
     }
 }
 
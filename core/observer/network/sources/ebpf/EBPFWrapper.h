@@ -24,6 +24,7 @@
 #include "observer/interface/helper.h"
 #include "metas/ConnectionMetaManager.h"
 #include "common/StringPiece.h"
+#include "network/PacketEventBatch.h"
 
 // ::ffff:127.0.0.1
 const uint64_t local_addr_bind_inet6[2] = {0, 72058143793676288};
@@ -52,9 +53,7 @@ const uint64_t local_addr_bind_inet6[2] = {0, 72058143793676288};
 namespace logtail {
 class EBPFWrapper {
 public:
-    explicit EBPFWrapper(NetworkConfig* config) : mConfig(config) {
-        mPacketDataBuffer.resize(CONN_DATA_MAX_SIZE + 4096);
-    }
+    explicit EBPFWrapper(NetworkConfig* config);
 
     ~EBPFWrapper() { Stop(); }
 
@@ -64,7 +63,7 @@ public:
         return sWrapper;
     }
 
-    bool Init(std::function<int(StringPiece)> processor);
+    bool Init(std::function<int(PacketEventBatch&)> processor);
 
     bool Start();
 
@@ -74,6 +73,10 @@ public:
 
     void Resume() { holdOnFlag = 0; }
 
+    /**
+     * ProcessPackets polls at most maxProcessPackets events, which are passed to the processor as batches.
+     * @return the count of polled events, or negative on errors.
+     */
     int32_t ProcessPackets(int32_t maxProcessPackets, int32_t maxProcessDurationMs);
 
     NetStaticticsMap& GetStatistics() { return mStatistics; }
@@ -102,14 +105,16 @@ protected:
 
 private:
     static uint64_t readStat(uint64_t pid);
+    void FlushPacketBatch();
 
 private:
     NetworkConfig* mConfig;
     DynamicLibLoader* mEBPFLib = NULL;
-    std::function<int(StringPiece)> mPacketProcessor;
+    std::function<int(PacketEventBatch&)> mPacketProcessor;
     std::int32_t holdOnFlag{0};
     NetStaticticsMap mStatistics;
-    std::string mPacketDataBuffer;
+    // events are decoded into the batch in callbacks of a poll, and processed after the poll or when it is full
+    PacketEventBatch mPacketBatch;
     bool mInitSuccess = false;
     bool mStartSuccess = false;
     uint64_t mDeltaTimeNs = 0;
@@ -25,7 +25,12 @@ using namespace std;
 namespace logtail {
 
 const unordered_set<string> GlobalConfig::sNativeParam
-    = {"TopicType", "TopicFormat", "ProcessPriority", "EnableTimestampNanosecond", "UsingOldContentTag"};
+    = {"TopicType",
+       "TopicFormat",
+       "ProcessPriority",
+       "SchedulingWeight",
+       "EnableTimestampNanosecond",
+       "UsingOldContentTag"};
 
 bool GlobalConfig::Init(const Json::Value& config, const PipelineContext& ctx, Json::Value& extendedParams) {
     const string moduleName = "global";
@@ -119,6 +124,32 @@ bool GlobalConfig::Init(const Json::Value& config, const PipelineContext& ctx, J
         mProcessPriority = priority;
     }
 
+    // SchedulingWeight
+    uint32_t weight = 1;
+    if (!GetOptionalUIntParam(config, "SchedulingWeight", weight, errorMsg)) {
+        PARAM_WARNING_DEFAULT(ctx.GetLogger(),
+                              ctx.GetAlarm(),
+                              errorMsg,
+                              mSchedulingWeight,
+                              moduleName,
+                              ctx.GetConfigName(),
+                              ctx.GetProjectName(),
+                              ctx.GetLogstoreName(),
+                              ctx.GetRegion());
+    } else if (weight == 0 || weight > MAX_SCHEDULING_WEIGHT) {
+        PARAM_WARNING_DEFAULT(ctx.GetLogger(),
+                              ctx.GetAlarm(),
+                              "uint param SchedulingWeight is not valid",
+                              mSchedulingWeight,
+                              moduleName,
+                              ctx.GetConfigName(),
+                              ctx.GetProjectName(),
+                              ctx.GetLogstoreName(),
+                              ctx.GetRegion());
+    } else {
+        mSchedulingWeight = weight;
+    }
+
     // EnableTimestampNanosecond
     if (!GetOptionalBoolParam(config, "EnableTimestampNanosecond", mEnableTimestampNanosecond, errorMsg)) {
         PARAM_WARNING_DEFAULT(ctx.GetLogger(),
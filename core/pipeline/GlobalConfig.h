@@ -36,6 +36,8 @@ struct GlobalConfig {
     TopicType mTopicType = TopicType::NONE;
     std::string mTopicFormat;
     uint32_t mProcessPriority = 0;
+    // share of process and send bandwidth relative to other logstores when they compete
+    uint32_t mSchedulingWeight = 1;
     bool mEnableTimestampNanosecond = false;
     bool mUsingOldContentTag = false;
 };
@@ -23,12 +23,14 @@
 #include "common/ParamExtractor.h"
 #include "flusher/FlusherSLS.h"
 #include "go_pipeline/LogtailPlugin.h"
+#include "monitor/MetricConstants.h"
 #include "plugin/PluginRegistry.h"
 #include "processor/ProcessorParseApsaraNative.h"
 #include "processor/ProcessorSplitLogStringNative.h"
 #include "processor/ProcessorSplitMultilineLogStringNative.h"
 #include "processor/ProcessorTagNative.h"
 #include "processor/daemon/LogProcess.h"
+#include "sender/Sender.h"
 
 // for special treatment
 #include "file_server/MultilineOptions.h"
@@ -237,6 +239,21 @@ bool Pipeline::Init(Config&& config) {
     } else {
         LogProcess::GetInstance()->DeletePriorityWithHoldOn(mContext.GetLogstoreKey());
     }
+    LogProcess::GetInstance()->SetWeightWithHoldOn(mContext.GetLogstoreKey(), global.mSchedulingWeight);
+    if (mContext.GetSLSInfo() != nullptr) {
+        Sender::Instance()->SetLogstoreWeight(mContext.GetLogstoreKey(), global.mSchedulingWeight);
+    }
+
+    MetricLabels labels;
+    labels.emplace_back(std::make_pair("project", mContext.GetProjectName()));
+    labels.emplace_back(std::make_pair("logstore", mContext.GetLogstoreName()));
+    labels.emplace_back(std::make_pair("region", mContext.GetRegion()));
+    labels.emplace_back(std::make_pair("config_name", mName));
+    WriteMetrics::GetInstance()->PrepareMetricsRecordRef(mMetricsRecordRef, std::move(labels));
+    mProcessQueuePopTotal = mMetricsRecordRef.CreateCounter(METRIC_PROCESS_QUEUE_POP_TOTAL);
+    mProcessQueuePopSizeBytes = mMetricsRecordRef.CreateCounter(METRIC_PROCESS_QUEUE_POP_SIZE_BYTES);
+    mProcessQueueLatencyMs = mMetricsRecordRef.CreateCounter(METRIC_PROCESS_QUEUE_LATENCY_MS);
+    mProcessQueueLatencyHistogramMs = mMetricsRecordRef.CreateHistogram(METRIC_PROCESS_QUEUE_LATENCY_HISTOGRAM_MS);
 
     if (inputFile && inputFile->mExactlyOnceConcurrency > 0) {
         if (IsFlushingThroughGoPipeline()) {
@@ -344,6 +361,16 @@ void Pipeline::CopyNativeGlobalParamToGoPipeline(Json::Value& pipeline) {
     }
 }
 
+void Pipeline::OnProcessQueuePop(uint64_t sizeBytes, uint64_t latencyMs) const {
+    if (!mProcessQueuePopTotal) {
+        return;
+    }
+    mProcessQueuePopTotal->Add(1);
+    mProcessQueuePopSizeBytes->Add(sizeBytes);
+    mProcessQueueLatencyMs->Add(latencyMs);
+    mProcessQueueLatencyHistogramMs->Observe(latencyMs);
+}
+
 bool Pipeline::LoadGoPipelines() const {
     // TODO：将下面的代码替换成批量原子Load。
     // note:
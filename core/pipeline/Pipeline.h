@@ -25,6 +25,7 @@
 
 #include "config/Config.h"
 #include "models/PipelineEventGroup.h"
+#include "monitor/LogtailMetric.h"
 #include "pipeline/PipelineContext.h"
 #include "plugin/instance/FlusherInstance.h"
 #include "plugin/instance/InputInstance.h"
@@ -49,6 +50,8 @@ public:
         return mPluginCntMap;
     }
     bool LoadGoPipelines() const; // 应当放在private，过渡期间放在public
+    // called by process threads for every buffer popped from the process queue
+    void OnProcessQueuePop(uint64_t sizeBytes, uint64_t latencyMs) const;
 
     // only for input_observer_network for compatability
     const std::vector<std::unique_ptr<InputInstance>>& GetInputs() const { return mInputs; }
@@ -68,6 +71,11 @@ private:
     mutable PipelineContext mContext;
     std::unordered_map<std::string, std::unordered_map<std::string, uint32_t>> mPluginCntMap;
     std::unique_ptr<Json::Value> mConfig;
+    mutable MetricsRecordRef mMetricsRecordRef;
+    CounterPtr mProcessQueuePopTotal;
+    CounterPtr mProcessQueuePopSizeBytes;
+    CounterPtr mProcessQueueLatencyMs;
+    HistogramPtr mProcessQueueLatencyHistogramMs;
 
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class PipelineMock;
@@ -14,6 +14,8 @@
 
 #include "plugin/instance/FlusherInstance.h"
 
+#include "monitor/MetricConstants.h"
+
 namespace logtail {
 bool FlusherInstance::Init(const Json::Value& config, PipelineContext& context, Json::Value& optionalGoPipeline) {
     mPlugin->SetContext(context);
@@ -21,7 +23,20 @@ bool FlusherInstance::Init(const Json::Value& config, PipelineContext& context,
     if (!mPlugin->Init(config, optionalGoPipeline)) {
         return false;
     }
+
+    mFlusherInRecordsTotal = mPlugin->GetMetricsRecordRef().CreateCounter(METRIC_FLUSHER_IN_RECORDS_TOTAL);
+    mFlusherInSizeBytes = mPlugin->GetMetricsRecordRef().CreateCounter(METRIC_FLUSHER_IN_SIZE_BYTES);
+    mFlusherLatencyUs = mPlugin->GetMetricsRecordRef().CreateHistogram(METRIC_FLUSHER_LATENCY_US);
     return true;
 }
 
+void FlusherInstance::OnFlush(uint64_t records, uint64_t sizeBytes, uint64_t latencyUs) const {
+    if (!mFlusherInRecordsTotal) {
+        return;
+    }
+    mFlusherInRecordsTotal->Add(records);
+    mFlusherInSizeBytes->Add(sizeBytes);
+    mFlusherLatencyUs->Observe(latencyUs);
+}
+
 } // namespace logtail
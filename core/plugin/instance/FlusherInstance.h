@@ -20,6 +20,7 @@
 
 #include <json/json.h>
 
+#include "monitor/LogtailMetric.h"
 #include "plugin/instance/PluginInstance.h"
 #include "plugin/interface/Flusher.h"
 #include "pipeline/PipelineContext.h"
@@ -36,9 +37,19 @@ public:
     bool Init(const Json::Value& config, PipelineContext& context, Json::Value& optionalGoPipeline);
     bool Start() { return mPlugin->Start(); }
     bool Stop(bool isPipelineRemoving) { return mPlugin->Stop(isPipelineRemoving); }
+    // called by process threads for every log group handed to the flusher
+    void OnFlush(uint64_t records, uint64_t sizeBytes, uint64_t latencyUs) const;
 
 private:
     std::unique_ptr<Flusher> mPlugin;
+
+    CounterPtr mFlusherInRecordsTotal;
+    CounterPtr mFlusherInSizeBytes;
+    HistogramPtr mFlusherLatencyUs;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class FlusherInstanceUnittest;
+#endif
 };
 
 } // namespace logtail
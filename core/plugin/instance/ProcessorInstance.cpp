@@ -16,12 +16,17 @@
 
 #include "plugin/instance/ProcessorInstance.h"
 
+#include <chrono>
 #include <cstdint>
 
-#include "common/TimeUtil.h"
+#include "common/Flags.h"
 #include "logger/Logger.h"
 #include "monitor/MetricConstants.h"
 
+DEFINE_FLAG_INT32(plugin_metrics_size_sample_interval,
+                  "measure the bytes in and out of plugins for one in this many calls, 0 to disable",
+                  16);
+
 namespace logtail {
 
 bool ProcessorInstance::Init(const Json::Value& config, PipelineContext& context) {
@@ -35,27 +40,56 @@ bool ProcessorInstance::Init(const Json::Value& config, PipelineContext& context
     mProcInRecordsTotal = mPlugin->GetMetricsRecordRef().CreateCounter(METRIC_PROC_IN_RECORDS_TOTAL);
     mProcOutRecordsTotal = mPlugin->GetMetricsRecordRef().CreateCounter(METRIC_PROC_OUT_RECORDS_TOTAL);
     mProcTimeMS = mPlugin->GetMetricsRecordRef().CreateCounter(METRIC_PROC_TIME_MS);
+    mProcInRecordsSizeBytes = mPlugin->GetMetricsRecordRef().CreateCounter(METRIC_PROC_IN_RECORDS_SIZE_BYTES);
+    mProcOutRecordsSizeBytes = mPlugin->GetMetricsRecordRef().CreateCounter(METRIC_PROC_OUT_RECORDS_SIZE_BYTES);
+    mProcLatencyUs = mPlugin->GetMetricsRecordRef().CreateHistogram(METRIC_PROC_LATENCY_US);
 
     return true;
 }
 
+// SampleEventGroupSize returns whether the sizes of this call should be measured, which walks all contents and would
+// cost as much as a cheap processor if done for every call.
+static bool SampleEventGroupSize() {
+    static thread_local uint32_t sCallCount = 0;
+    int32_t interval = INT32_FLAG(plugin_metrics_size_sample_interval);
+    return interval > 0 && ++sCallCount % interval == 0;
+}
+
+static uint64_t EventGroupListSizeBytes(std::vector<PipelineEventGroup>& logGroupList) {
+    uint64_t size = 0;
+    for (auto& logGroup : logGroupList) {
+        size += logGroup.EventGroupSizeBytes();
+    }
+    return size;
+}
+
 void ProcessorInstance::Process(std::vector<PipelineEventGroup>& logGroupList) {
     if (logGroupList.empty()) {
         return;
-    } 
+    }
     for (const auto& logGroup : logGroupList) {
         mProcInRecordsTotal->Add(logGroup.GetEvents().size());
     }
+    bool sampleSize = SampleEventGroupSize();
+    if (sampleSize) {
+        mProcInRecordsSizeBytes->Add(EventGroupListSizeBytes(logGroupList)
+                                     * INT32_FLAG(plugin_metrics_size_sample_interval));
+    }
 
-    uint64_t startTime = GetCurrentTimeInMicroSeconds();
+    auto startTime = std::chrono::steady_clock::now();
     mPlugin->Process(logGroupList);
-    uint64_t durationTime = GetCurrentTimeInMicroSeconds() - startTime;
-
+    uint64_t durationTime
+        = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
     mProcTimeMS->Add(durationTime);
+    mProcLatencyUs->Observe(durationTime);
 
     for (const auto& logGroup : logGroupList) {
         mProcOutRecordsTotal->Add(logGroup.GetEvents().size());
-    }    
+    }
+    if (sampleSize) {
+        mProcOutRecordsSizeBytes->Add(EventGroupListSizeBytes(logGroupList)
+                                      * INT32_FLAG(plugin_metrics_size_sample_interval));
+    }
 }
 
 } // namespace logtail
@@ -42,9 +42,11 @@ private:
 
     CounterPtr mProcInRecordsTotal;
     CounterPtr mProcOutRecordsTotal;
-    // CounterPtr mProcInRecordsSizeBytes;
-    // CounterPtr mProcOutRecordsSizeBytes;
+    // sizes are measured for one in plugin_metrics_size_sample_interval calls and scaled up
+    CounterPtr mProcInRecordsSizeBytes;
+    CounterPtr mProcOutRecordsSizeBytes;
     CounterPtr mProcTimeMS;
+    HistogramPtr mProcLatencyUs;
 
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class ProcessorInstanceUnittest;
@@ -31,8 +31,10 @@
 #include "config_manager/ConfigManager.h"
 #include "monitor/LogtailAlarm.h"
 #include "monitor/Monitor.h"
+#include "monitor/SamplingProfiler.h"
 #include "PollingModify.h"
 #include "PollingEventQueue.h"
+#include "PollingStatPool.h"
 #include "file_server/FileServer.h"
 
 // Control the check frequency to call ClearUnavailableFileAndDir.
@@ -99,9 +101,10 @@ void PollingDirFile::Resume() {
 }
 
 void PollingDirFile::CheckConfigPollingStatCount(const int32_t lastStatCount,
+                                                 const PollingContext& ctx,
                                                  const FileDiscoveryConfig& config,
                                                  bool isDockerConfig) {
-    auto diffCount = mStatCount - lastStatCount;
+    auto diffCount = ctx.mStatCount - lastStatCount;
     if (diffCount <= INT32_FLAG(polling_max_stat_count_per_config))
         return;
 
@@ -110,18 +113,20 @@ void PollingDirFile::CheckConfigPollingStatCount(const int32_t lastStatCount,
         msgBase += "docker ";
     msgBase += "config has exceeded limit";
 
+    int32_t totalCount = mStatCount;
     LOG_WARNING(sLogger,
-                (msgBase, diffCount)(config.first->GetBasePath(), mStatCount)(config.second->GetProjectName(),
+                (msgBase, diffCount)(config.first->GetBasePath(), totalCount)(config.second->GetProjectName(),
                                                                               config.second->GetLogstoreName()));
     LogtailAlarm::GetInstance()->SendAlarm(STAT_LIMIT_ALARM,
                                            msgBase + ", current count: " + ToString(diffCount) + " total count:"
-                                               + ToString(mStatCount) + " path: " + config.first->GetBasePath(),
+                                               + ToString(totalCount) + " path: " + config.first->GetBasePath(),
                                            config.second->GetProjectName(),
                                            config.second->GetLogstoreName(),
                                            config.second->GetRegion());
 }
 
 void PollingDirFile::Polling() {
+    SamplingProfiler::SetThreadRole("polling_dir");
     LOG_INFO(sLogger, ("polling discovery", "started"));
     mHoldOnFlag = false;
     while (mRuningFlag) {
@@ -129,8 +134,8 @@ void PollingDirFile::Polling() {
         {
             PTScopedLock thradLock(mPollingThreadLock);
             mStatCount = 0;
-            mNewFileVec.clear();
             ++mCurrentRound;
+            uint64_t roundStartTime = GetCurrentTimeInMilliSeconds();
 
             // Get a copy of config list from ConfigManager.
             // PollingDirFile has to be held on at first because raw pointers are used here.
@@ -151,87 +156,66 @@ void PollingDirFile::Polling() {
                 LogtailMonitor::GetInstance()->UpdateMetric("polling_dir_cache", mDirCacheMap.size());
                 LogtailMonitor::GetInstance()->UpdateMetric("polling_file_cache", mFileCacheMap.size());
             }
-
-            // Iterate all normal configs, make sure stat count will not exceed limit.
-            for (auto itr = sortedConfigs.begin();
-                 itr != sortedConfigs.end() && mStatCount <= INT32_FLAG(polling_max_stat_count);
-                 ++itr) {
-                if (!mRuningFlag || mHoldOnFlag)
-                    break;
-
-                const FileDiscoveryOptions* config = itr->first;
-                const PipelineContext* ctx = itr->second;
-                if (!config->IsContainerDiscoveryEnabled()) {
-                    fsutil::PathStat baseDirStat;
-                    if (!fsutil::PathStat::stat(config->GetBasePath(), baseDirStat)) {
-                        LOG_DEBUG(sLogger,
-                                  ("get base dir info error: ", config->GetBasePath())(ctx->GetProjectName(),
-                                                                                       ctx->GetLogstoreName()));
+            LogtailMonitor::GetInstance()->UpdateMetric("polling_dir_snapshot", mDirSnapshotCache.Size());
+
+            // All normal configs are polled before wildcard configs, each container path of a config is a task.
+            vector<PollingTask> tasks;
+            for (const auto* configs : {&sortedConfigs, &wildcardConfigs}) {
+                for (const auto& config : *configs) {
+                    bool isWildcard = configs == &wildcardConfigs;
+                    if (!config.first->IsContainerDiscoveryEnabled()) {
+                        tasks.push_back(
+                            {&config,
+                             isWildcard ? config.first->GetWildcardPaths()[0] : config.first->GetBasePath(),
+                             isWildcard,
+                             false});
                         continue;
                     }
-
-                    int32_t lastConfigStatCount = mStatCount;
-                    if (!PollingNormalConfigPath(*itr, config->GetBasePath(), string(), baseDirStat, 0)) {
-                        LOG_DEBUG(sLogger,
-                                  ("logPath in config not exist", config->GetBasePath())(ctx->GetProjectName(),
-                                                                                         ctx->GetLogstoreName()));
-                    }
-                    CheckConfigPollingStatCount(lastConfigStatCount, *itr, false);
-                } else {
-                    for (size_t i = 0; i < config->GetContainerInfo()->size(); ++i) {
-                        const string& basePath = (*config->GetContainerInfo())[i].mContainerPath;
-                        fsutil::PathStat baseDirStat;
-                        if (!fsutil::PathStat::stat(basePath.c_str(), baseDirStat)) {
-                            LOG_DEBUG(sLogger,
-                                      ("get docker base dir info error: ", basePath)(ctx->GetProjectName(),
-                                                                                     ctx->GetLogstoreName()));
-                            continue;
-                        }
-                        int32_t lastConfigStatCount = mStatCount;
-                        if (!PollingNormalConfigPath(*itr, basePath, string(), baseDirStat, 0)) {
-                            LOG_DEBUG(sLogger,
-                                      ("docker logPath in config not exist", basePath)(ctx->GetProjectName(),
-                                                                                       ctx->GetLogstoreName()));
-                        }
-                        CheckConfigPollingStatCount(lastConfigStatCount, *itr, true);
+                    for (const auto& containerInfo : *config.first->GetContainerInfo()) {
+                        tasks.push_back({&config, containerInfo.mContainerPath, isWildcard, true});
                     }
                 }
             }
 
-            // Iterate all wildcard configs, make sure stat count will not exceed limit.
-            for (auto itr = wildcardConfigs.begin();
-                 itr != wildcardConfigs.end() && mStatCount <= INT32_FLAG(polling_max_stat_count);
-                 ++itr) {
-                if (!mRuningFlag || mHoldOnFlag)
-                    break;
-
-                const FileDiscoveryOptions* config = itr->first;
-                const PipelineContext* ctx = itr->second;
-                if (!config->IsContainerDiscoveryEnabled()) {
-                    int32_t lastConfigStatCount = mStatCount;
-                    if (!PollingWildcardConfigPath(*itr, config->GetWildcardPaths()[0], 0)) {
-                        LOG_DEBUG(sLogger,
-                                  ("can not find matched path in config, Wildcard begin logPath",
-                                   config->GetBasePath())(ctx->GetProjectName(), ctx->GetLogstoreName()));
-                    }
-                    CheckConfigPollingStatCount(lastConfigStatCount, *itr, false);
-                } else {
-                    for (size_t i = 0; i < config->GetContainerInfo()->size(); ++i) {
-                        const string& baseWildcardPath = (*config->GetContainerInfo())[i].mContainerPath;
-                        int32_t lastConfigStatCount = mStatCount;
-                        if (!PollingWildcardConfigPath(*itr, baseWildcardPath, 0)) {
-                            LOG_DEBUG(sLogger,
-                                      ("can not find matched path in config, "
-                                       "Wildcard begin logPath ",
-                                       baseWildcardPath)(ctx->GetProjectName(), ctx->GetLogstoreName()));
-                        }
-                        CheckConfigPollingStatCount(lastConfigStatCount, *itr, true);
+            // Partitions are polled by workers of PollingStatPool, each of them walks its own directory trees
+            // with its own context, and results are merged when all of them are done. Normal tasks of all
+            // partitions are polled before any wildcard task, so that wildcard configs can not use up the stat
+            // budget of normal ones.
+            auto partitions = PartitionTasks(tasks);
+            vector<PollingContext> contexts(partitions.size());
+            for (bool wildcardPhase : {false, true}) {
+                PollingStatPool::GetInstance()->Run(partitions.size(), [&](size_t idx) {
+                    PollingContext& ctx = contexts[idx];
+                    ctx.mOwner = idx + 1;
+                    for (size_t taskIdx : partitions[idx]) {
+                        if (tasks[taskIdx].mIsWildcard != wildcardPhase)
+                            continue;
+                        if (!mRuningFlag || mHoldOnFlag || !PollingConfigTask(tasks[taskIdx], ctx))
+                            break;
                     }
-                }
+                });
+            }
+
+            int32_t readDirCount = 0;
+            vector<SplitedFilePath> newFileVec;
+            for (auto& ctx : contexts) {
+                readDirCount += ctx.mReadDirCount;
+                newFileVec.insert(newFileVec.end(), ctx.mNewFileVec.begin(), ctx.mNewFileVec.end());
+            }
+            uint64_t curTime = GetCurrentTimeInMilliSeconds();
+            LOG_DEBUG(sLogger,
+                      ("dir file polling done, round", mCurrentRound)("stat count", mStatCount.load())(
+                          "read dir count", readDirCount)("partition count", partitions.size())(
+                          "cost ms", curTime - roundStartTime));
+            // Rounds per second, sleep between rounds included, shows how fast new files can be found.
+            if (mLastRoundStartTime > 0 && roundStartTime > mLastRoundStartTime) {
+                LogtailMonitor::GetInstance()->UpdateMetric("polling_dir_round_per_sec",
+                                                            1000.0 / (roundStartTime - mLastRoundStartTime));
             }
+            mLastRoundStartTime = roundStartTime;
 
             // Add collected new files to PollingModify.
-            PollingModify::GetInstance()->AddNewFile(mNewFileVec);
+            PollingModify::GetInstance()->AddNewFile(newFileVec);
 
             // Check cache, clear unavailable and overtime items.
             if (mCurrentRound % INT32_FLAG(check_not_exist_file_dir_round) == 0) {
@@ -248,6 +232,75 @@ void PollingDirFile::Polling() {
     LOG_DEBUG(sLogger, ("dir file polling thread done", ""));
 }
 
+std::vector<std::vector<size_t>> PollingDirFile::PartitionTasks(const std::vector<PollingTask>& tasks) {
+    vector<size_t> sortedIdx(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        sortedIdx[i] = i;
+    }
+    // The separator is compared as the smallest character, so that paths under a root follow the root directly,
+    // e.g. /a, /a/b, /a-b rather than /a, /a-b, /a/b.
+    auto charKey = [](char c) { return c == PATH_SEPARATOR[0] ? 0 : static_cast<unsigned char>(c) + 1; };
+    sort(sortedIdx.begin(), sortedIdx.end(), [&](size_t l, size_t r) {
+        const string& left = tasks[l].mPath;
+        const string& right = tasks[r].mPath;
+        return lexicographical_compare(left.begin(),
+                                       left.end(),
+                                       right.begin(),
+                                       right.end(),
+                                       [&](char lc, char rc) { return charKey(lc) < charKey(rc); });
+    });
+
+    // A path which is not under the current root starts a new partition.
+    vector<vector<size_t>> partitions;
+    const string* root = nullptr;
+    for (size_t idx : sortedIdx) {
+        const string& path = tasks[idx].mPath;
+        bool isNested = root != nullptr && StartWith(path, *root)
+            && (path.size() == root->size() || root->empty() || root->back() == PATH_SEPARATOR[0]
+                || path[root->size()] == PATH_SEPARATOR[0]);
+        if (!isNested) {
+            root = &path;
+            partitions.emplace_back();
+        }
+        partitions.back().push_back(idx);
+    }
+    for (auto& partition : partitions) {
+        sort(partition.begin(), partition.end());
+    }
+    return partitions;
+}
+
+bool PollingDirFile::PollingConfigTask(const PollingTask& task, PollingContext& ctx) {
+    if (mStatCount > INT32_FLAG(polling_max_stat_count))
+        return false;
+
+    const FileDiscoveryConfig& config = *task.mConfig;
+    const PipelineContext* pipelineCtx = config.second;
+    int32_t lastConfigStatCount = ctx.mStatCount;
+    if (task.mIsWildcard) {
+        if (!PollingWildcardConfigPath(config, task.mPath, 0, ctx)) {
+            LOG_DEBUG(sLogger,
+                      ("can not find matched path in config, Wildcard begin logPath",
+                       task.mPath)(pipelineCtx->GetProjectName(), pipelineCtx->GetLogstoreName()));
+        }
+    } else {
+        fsutil::PathStat baseDirStat;
+        if (!fsutil::PathStat::stat(task.mPath, baseDirStat)) {
+            LOG_DEBUG(sLogger,
+                      ("get base dir info error: ", task.mPath)("container", task.mIsContainer)(
+                          pipelineCtx->GetProjectName(), pipelineCtx->GetLogstoreName()));
+            return true;
+        }
+        if (!PollingNormalConfigPath(config, task.mPath, string(), baseDirStat, 0, ctx)) {
+            LOG_DEBUG(sLogger,
+                      ("logPath in config not exist", task.mPath)("container", task.mIsContainer)(
+                          pipelineCtx->GetProjectName(), pipelineCtx->GetLogstoreName()));
+        }
+    }
+    CheckConfigPollingStatCount(lastConfigStatCount, ctx, config, task.mIsContainer);
+    return true;
+}
+
 // Last Modified Time (LMD) of directory changes when a file or a subdirectory is added,
 // removed or renamed. Howerver, modifying the content of a file within it will not update
 // LMD, and add/remove/rename file/directory in its subdirectory will also not upadte LMD.
@@ -297,13 +350,22 @@ bool PollingDirFile::CheckAndUpdateFileMatchCache(const string& fileDir,
 
     bool newFlag = false;
     string filePath = PathJoin(fileDir, fileName);
-    FileCheckCacheMap::iterator iter = mFileCacheMap.find(filePath);
     int32_t curTime = time(NULL);
-    if (iter == mFileCacheMap.end()) {
-        bool matchFlag = needFindBestMatch
-            ? ConfigManager::GetInstance()->FindBestMatch(fileDir, fileName).first != nullptr
-            : true;
+    bool matchFlag = true;
+    {
+        ScopedSpinLock lock(mCacheLock);
+        if (mFileCacheMap.find(filePath) != mFileCacheMap.end()) {
+            needFindBestMatch = false;
+        }
+    }
+    // Matching is done out of the lock which is shared by all workers.
+    if (needFindBestMatch) {
+        matchFlag = ConfigManager::GetInstance()->FindBestMatch(fileDir, fileName).first != nullptr;
+    }
 
+    ScopedSpinLock lock(mCacheLock);
+    FileCheckCacheMap::iterator iter = mFileCacheMap.find(filePath);
+    if (iter == mFileCacheMap.end()) {
         DirFileCache& fileCache = mFileCacheMap[filePath];
         fileCache.SetConfigMatched(matchFlag);
         fileCache.SetCheckRound(mCurrentRound);
@@ -345,7 +407,8 @@ bool PollingDirFile::PollingNormalConfigPath(const FileDiscoveryConfig& pConfig,
                                              const string& srcPath,
                                              const string& obj,
                                              const fsutil::PathStat& statBuf,
-                                             int depth) {
+                                             int depth,
+                                             PollingContext& ctx) {
     if (pConfig.first->mMaxDirSearchDepth >= 0 && depth > pConfig.first->mMaxDirSearchDepth)
         return false;
     if (pConfig.first->mPreservedDirDepth >= 0 && depth > pConfig.first->mPreservedDirDepth)
@@ -363,9 +426,23 @@ bool PollingDirFile::PollingNormalConfigPath(const FileDiscoveryConfig& pConfig,
         PollingEventQueue::GetInstance()->PushEvent(new Event(srcPath, obj, EVENT_CREATE | EVENT_ISDIR, -1, 0));
     }
 
-    // Iterate directories and files in dirPath.
-    fsutil::Dir dir(dirPath);
-    if (!dir.Open()) {
+    // Iterate directories and files in dirPath, entries read by last round are reused if the directory is unchanged.
+    int64_t sec, nsec;
+    statBuf.GetLastWriteTime(sec, nsec);
+    bool loaded = false;
+    DirSnapshot privateSnapshot;
+    DirSnapshot* snapshot = mDirSnapshotCache.Get(dirPath,
+                                                  statBuf.GetDevInode(),
+                                                  NANO_CONVERTING * sec + nsec,
+                                                  statBuf.GetLinkCount(),
+                                                  mCurrentRound,
+                                                  ctx.mOwner,
+                                                  privateSnapshot,
+                                                  loaded);
+    if (loaded) {
+        ++ctx.mReadDirCount;
+    }
+    if (snapshot == nullptr) {
         auto err = GetErrno();
         if (fsutil::Dir::IsENOENT(err)) {
             LOG_DEBUG(sLogger, ("Open dir error, ENOENT, dir", dirPath.c_str()));
@@ -380,71 +457,80 @@ bool PollingDirFile::PollingNormalConfigPath(const FileDiscoveryConfig& pConfig,
         }
         return true;
     }
+    uint64_t matchEpoch = ConfigManager::GetInstance()->GetFileMatchEpoch();
+    if (snapshot->GetMatchEpoch() != matchEpoch) {
+        snapshot->ResetMatchStatus(matchEpoch);
+    }
     int32_t nowStatCount = 0;
-    fsutil::Entry ent;
-    while ((ent = dir.ReadNext(false))) {
+    for (size_t idx = 0; idx < snapshot->Size(); ++idx) {
         if (!mRuningFlag || mHoldOnFlag)
             break;
 
-        if (++mStatCount % INT32_FLAG(dirfile_stat_count) == 0) {
+        // If the type of item is raw directory or file, use MatchDirPattern or FindBestMatch
+        // to check if there are configs that match it.
+        DirSnapshot::Entry& ent = snapshot->At(idx);
+        auto entName = snapshot->GetName(ent);
+        bool needCheckDirMatch = true;
+        bool needFindBestMatch = true;
+        if (ent.mType == DirSnapshot::EntryType::REG_FILE) {
+            // The result is kept in the snapshot, so files of unchanged directories which no config matches
+            // need neither matching nor stat.
+            needFindBestMatch = false;
+            if (ent.mMatch == DirSnapshot::MatchStatus::UNKNOWN) {
+                ent.mMatch = ConfigManager::GetInstance()->FindBestMatch(dirPath, entName).first
+                    ? DirSnapshot::MatchStatus::MATCHED
+                    : DirSnapshot::MatchStatus::UNMATCHED;
+            }
+            if (ent.mMatch == DirSnapshot::MatchStatus::UNMATCHED) {
+                continue;
+            }
+        }
+        string item = PathJoin(dirPath, entName);
+        if (ent.mType == DirSnapshot::EntryType::DIR) {
+            // Have to call MatchDirPattern, because we have no idea which config matches
+            // the directory according to cache.
+            // TODO: Refactor directory cache, maintain all configs that match the directory.
+            needCheckDirMatch = false;
+            if (pConfig.first->IsDirectoryInBlacklist(item)) {
+                continue;
+            }
+        }
+        // Otherwise, it is a symbolic link or its type is unknown, resolve it by stat.
+
+        if (++ctx.mStatCount % INT32_FLAG(dirfile_stat_count) == 0) {
             usleep(INT32_FLAG(dirfile_stat_sleep) * 1000);
         }
 
-        if (mStatCount > INT32_FLAG(polling_max_stat_count)) {
+        // The limit is a budget of all workers, only the one which uses it up reports.
+        int32_t totalStatCount = ++mStatCount;
+        if (totalStatCount > INT32_FLAG(polling_max_stat_count)) {
+            if (totalStatCount > INT32_FLAG(polling_max_stat_count) + 1) {
+                break;
+            }
             LOG_WARNING(sLogger,
-                        ("total dir's polling stat count is exceeded", nowStatCount)(dirPath, mStatCount)(
+                        ("total dir's polling stat count is exceeded", nowStatCount)(dirPath, totalStatCount)(
                             pConfig.second->GetProjectName(), pConfig.second->GetLogstoreName()));
             LogtailAlarm::GetInstance()->SendAlarm(
                 STAT_LIMIT_ALARM,
                 string("total dir's polling stat count is exceeded, now count:") + ToString(nowStatCount)
-                    + " total count:" + ToString(mStatCount) + " path: " + dirPath + " project:"
+                    + " total count:" + ToString(totalStatCount) + " path: " + dirPath + " project:"
                     + pConfig.second->GetProjectName() + " logstore:" + pConfig.second->GetLogstoreName());
             break;
         }
 
         if (++nowStatCount > INT32_FLAG(polling_max_stat_count_per_dir)) {
             LOG_WARNING(sLogger,
-                        ("this dir's polling stat count is exceeded", nowStatCount)(dirPath, mStatCount)(
+                        ("this dir's polling stat count is exceeded", nowStatCount)(dirPath, totalStatCount)(
                             pConfig.second->GetProjectName(), pConfig.second->GetLogstoreName()));
             LogtailAlarm::GetInstance()->SendAlarm(
                 STAT_LIMIT_ALARM,
                 string("this dir's polling stat count is exceeded, now count:") + ToString(nowStatCount)
-                    + " total count:" + ToString(mStatCount) + " path: " + dirPath
+                    + " total count:" + ToString(totalStatCount) + " path: " + dirPath
                     + " project:" + pConfig.second->GetProjectName() + " logstore:" + pConfig.second->GetLogstoreName(),
                 pConfig.second->GetRegion());
             break;
         }
 
-        // If the type of item is raw directory or file, use MatchDirPattern or FindBestMatch
-        // to check if there are configs that match it.
-        auto entName = ent.Name();
-        string item = PathJoin(dirPath, entName);
-        bool needCheckDirMatch = true;
-        bool needFindBestMatch = true;
-        if (ent.IsDir()) {
-            // Have to call MatchDirPattern, because we have no idea which config matches
-            // the directory according to cache.
-            // TODO: Refactor directory cache, maintain all configs that match the directory.
-            needCheckDirMatch = false;
-            if (pConfig.first->IsDirectoryInBlacklist(item)) {
-                continue;
-            }
-        } else if (ent.IsRegFile()) {
-            // TODO: Add file cache looking up here: we can skip the file if it is in cache
-            // and the match flag is false (no config matches it).
-            // There is a cache in FindBestMatch, so the overhead is acceptable now.
-            needFindBestMatch = false;
-            if (!ConfigManager::GetInstance()->FindBestMatch(dirPath, entName).first) {
-                continue;
-            }
-        } else {
-            // Symbolic link should be passed, while other types file should ignore.
-            if (!ent.IsSymbolic()) {
-                LOG_DEBUG(sLogger, ("should ignore, other type file", item.c_str()));
-                continue;
-            }
-        }
-
         // Mainly for symbolic (Linux), we need to use stat to dig out the real type.
         fsutil::PathStat buf;
         if (!fsutil::PathStat::stat(item, buf)) {
@@ -452,17 +538,17 @@ bool PollingDirFile::PollingNormalConfigPath(const FileDiscoveryConfig& pConfig,
             continue;
         }
 
-        // For directory, poll recursively; for file, update cache and add to mNewFileVec so that
+        // For directory, poll recursively; for file, update cache and add to new files of @ctx so that
         // it can be pushed to PollingModify at the end of polling.
         // If needCheckDirMatch or needFindBestMatch is true, that means the item is a symbolic link.
         // We should check file type again to make sure that the original file which linked by
         // a symbolic file is DIR or REG.
         if (buf.IsDir() && (!needCheckDirMatch || !pConfig.first->IsDirectoryInBlacklist(item))) {
-            PollingNormalConfigPath(pConfig, dirPath, entName, buf, depth + 1);
+            PollingNormalConfigPath(pConfig, dirPath, entName, buf, depth + 1, ctx);
         } else if (buf.IsRegFile()) {
             if (CheckAndUpdateFileMatchCache(dirPath, entName, buf, needFindBestMatch)) {
                 LOG_DEBUG(sLogger, ("add to modify event", entName)("round", mCurrentRound));
-                mNewFileVec.push_back(SplitedFilePath(dirPath, entName));
+                ctx.mNewFileVec.push_back(SplitedFilePath(dirPath, entName));
             }
         } else {
             // Ignore other file type.
@@ -477,7 +563,10 @@ bool PollingDirFile::PollingNormalConfigPath(const FileDiscoveryConfig& pConfig,
 // PollingWildcardConfigPath will iterate mWildcardPaths one by one, and according to
 // corresponding value in mConstWildcardPaths, call PollingNormalConfigPath or call
 // PollingWildcardConfigPath recursively.
-bool PollingDirFile::PollingWildcardConfigPath(const FileDiscoveryConfig& pConfig, const string& dirPath, int depth) {
+bool PollingDirFile::PollingWildcardConfigPath(const FileDiscoveryConfig& pConfig,
+                                               const string& dirPath,
+                                               int depth,
+                                               PollingContext& ctx) {
     if (AppConfig::GetInstance()->IsHostPathMatchBlacklist(dirPath)) {
         LOG_INFO(sLogger, ("ignore path matching host path blacklist", dirPath));
         return false;
@@ -520,17 +609,17 @@ bool PollingDirFile::PollingWildcardConfigPath(const FileDiscoveryConfig& pConfi
         // call PollingNormalConfigPath to iterate remaining content.
         // Otherwise, call PollingWildcardConfigPath to deal with remaining parts.
         if (finish) {
-            PollingNormalConfigPath(pConfig, item, string(), baseDirStat, 0);
+            PollingNormalConfigPath(pConfig, item, string(), baseDirStat, 0, ctx);
         } else {
-            PollingWildcardConfigPath(pConfig, item, depth + 1);
+            PollingWildcardConfigPath(pConfig, item, depth + 1, ctx);
         }
         return true;
     }
 
     // Current part is not constant (normal) path, so we have to iterate and match one by one.
     bool hasMatchFlag = false;
-    fsutil::Dir dir(dirPath);
-    if (!dir.Open()) {
+    DirSnapshot dir;
+    if (!dir.Load(dirPath)) {
         auto err = GetErrno();
         if (fsutil::Dir::IsENOENT(err)) {
             LOG_DEBUG(sLogger, ("Open dir fail, ENOENT, dir", dirPath.c_str()));
@@ -545,12 +634,18 @@ bool PollingDirFile::PollingWildcardConfigPath(const FileDiscoveryConfig& pConfi
         }
         return true;
     }
-    fsutil::Entry ent;
+    ++ctx.mReadDirCount;
     int32_t dirCount = 0;
-    while ((ent = dir.ReadNext(false))) {
+    for (size_t idx = 0; idx < dir.Size(); ++idx) {
         if (!mRuningFlag || mHoldOnFlag)
             break;
 
+        // Only directories are matched against the next part, files need no stat.
+        const DirSnapshot::Entry& ent = dir.At(idx);
+        if (ent.mType == DirSnapshot::EntryType::REG_FILE) {
+            continue;
+        }
+
         if (dirCount >= INT32_FLAG(wildcard_max_sub_dir_count)) {
             LOG_WARNING(sLogger,
                         ("too many sub directoried for path",
@@ -558,22 +653,26 @@ bool PollingDirFile::PollingWildcardConfigPath(const FileDiscoveryConfig& pConfi
             break;
         }
 
-        if (++mStatCount % INT32_FLAG(dirfile_stat_count) == 0)
+        if (++ctx.mStatCount % INT32_FLAG(dirfile_stat_count) == 0)
             usleep(INT32_FLAG(dirfile_stat_sleep) * 1000);
 
-        if (mStatCount > INT32_FLAG(polling_max_stat_count)) {
+        int32_t totalStatCount = ++mStatCount;
+        if (totalStatCount > INT32_FLAG(polling_max_stat_count)) {
+            if (totalStatCount > INT32_FLAG(polling_max_stat_count) + 1) {
+                break;
+            }
             LOG_WARNING(sLogger,
-                        ("total dir's polling stat count is exceeded",
-                         "")(dirPath, mStatCount)(pConfig.second->GetProjectName(), pConfig.second->GetLogstoreName()));
+                        ("total dir's polling stat count is exceeded", "")(dirPath, totalStatCount)(
+                            pConfig.second->GetProjectName(), pConfig.second->GetLogstoreName()));
             LogtailAlarm::GetInstance()->SendAlarm(
                 STAT_LIMIT_ALARM,
-                string("total dir's polling stat count is exceeded, total count:" + ToString(mStatCount)
+                string("total dir's polling stat count is exceeded, total count:" + ToString(totalStatCount)
                        + " path: " + dirPath + " project:" + pConfig.second->GetProjectName()
                        + " logstore:" + pConfig.second->GetLogstoreName()));
             break;
         }
 
-        auto entName = ent.Name();
+        auto entName = dir.GetName(ent);
         string item = PathJoin(dirPath, entName);
         fsutil::PathStat buf;
         if (!fsutil::PathStat::stat(item, buf)) {
@@ -603,9 +702,9 @@ bool PollingDirFile::PollingWildcardConfigPath(const FileDiscoveryConfig& pConfi
                 == 0) {
                 if (finish) {
                     hasMatchFlag = true;
-                    PollingNormalConfigPath(pConfig, item, string(), buf, 0);
+                    PollingNormalConfigPath(pConfig, item, string(), buf, 0, ctx);
                 } else {
-                    hasMatchFlag |= PollingWildcardConfigPath(pConfig, item, depth + 1);
+                    hasMatchFlag |= PollingWildcardConfigPath(pConfig, item, depth + 1, ctx);
                 }
             }
         }
@@ -668,6 +767,8 @@ void PollingDirFile::ClearUnavailableFileAndDir() {
     // resources (LogInput::ProcessEvent -> EventDispatcher::UnregisterAllDir).
     std::vector<Event*> eventVec;
 
+    // It is called after all workers of the round are done.
+    mDirSnapshotCache.RemoveUnchecked(mCurrentRound, INT32_FLAG(delete_dir_file_round));
     {
         ScopedSpinLock lock(mCacheLock);
         for (auto iter = mDirCacheMap.begin(); iter != mDirCacheMap.end();) {
@@ -697,6 +798,7 @@ void PollingDirFile::ClearUnavailableFileAndDir() {
 PollingDirFile::PollingDirFile() {
     mStatCount = 0;
     mCurrentRound = 0;
+    mLastRoundStartTime = 0;
 }
 
 PollingDirFile::~PollingDirFile() {
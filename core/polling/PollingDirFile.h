@@ -15,11 +15,13 @@
  */
 
 #pragma once
+#include <atomic>
 #include <map>
 #include "common/LogRunnable.h"
 #include "common/Lock.h"
 #include "common/Thread.h"
 #include "PollingCache.h"
+#include "PollingDirSnapshot.h"
 #include "file_server/FileDiscoveryOptions.h"
 
 namespace logtail {
@@ -46,8 +48,8 @@ public:
     void ClearCache() {
         mDirCacheMap.clear();
         mFileCacheMap.clear();
+        mDirSnapshotCache.Clear();
         mStatCount = 0;
-        mNewFileVec.clear();
         mCurrentRound = 0;
     }
 
@@ -55,8 +57,35 @@ private:
     PollingDirFile();
     ~PollingDirFile();
 
+    // PollingTask is a config path to poll in a round.
+    struct PollingTask {
+        const FileDiscoveryConfig* mConfig;
+        // Base path for normal config, or the path before the first wildcard for wildcard config.
+        std::string mPath;
+        bool mIsWildcard;
+        bool mIsContainer;
+    };
+
+    // PollingContext keeps the state of a worker which polls a partition of tasks.
+    struct PollingContext {
+        // Partitions are numbered from 1, it is the owner id of directory snapshots.
+        uint64_t mOwner = 0;
+        // Stat count of this partition, the global budget is mStatCount.
+        int32_t mStatCount = 0;
+        int32_t mReadDirCount = 0;
+        // New files found in current round, will be pushed to PollingModify.
+        std::vector<SplitedFilePath> mNewFileVec;
+    };
+
     void Polling();
 
+    // PartitionTasks groups tasks whose paths are nested, so that different partitions walk disjoint directory
+    // trees and can be polled by different workers. Tasks in a partition keep their order.
+    static std::vector<std::vector<size_t>> PartitionTasks(const std::vector<PollingTask>& tasks);
+
+    // PollingConfigTask polls a task, it returns false if the stat budget of this round is used up.
+    bool PollingConfigTask(const PollingTask& task, PollingContext& ctx);
+
     // PollingNormalConfigPath polls config with normal base path recursively.
     // @config: config to poll.
     // @srcPath+@obj: directory path to poll, for base directory, @obj is empty.
@@ -68,12 +97,16 @@ private:
                                  const std::string& srcPath,
                                  const std::string& obj,
                                  const fsutil::PathStat& statBuf,
-                                 int depth);
+                                 int depth,
+                                 PollingContext& ctx);
 
     // PollingWildcardConfigPath polls config with wildcard base path recursively.
     // It will use PollingNormalConfigPath to poll if the path becomes normal.
     // @return true if at least one directory was found during polling.
-    bool PollingWildcardConfigPath(const FileDiscoveryConfig& pConfig, const std::string& dirPath, int depth);
+    bool PollingWildcardConfigPath(const FileDiscoveryConfig& pConfig,
+                                   const std::string& dirPath,
+                                   int depth,
+                                   PollingContext& ctx);
 
     // CheckAndUpdateDirMatchCache updates dir cache (add if not existing).
     // The caller of this method should make sure that there is at least one config matches
@@ -106,8 +139,10 @@ private:
 
     // CheckConfigPollingStatCount checks if the stat count of @config exceeds limit.
     // If true, logs and alarms.
-    void
-    CheckConfigPollingStatCount(const int32_t lastStatCount, const FileDiscoveryConfig& config, bool isDockerConfig);
+    void CheckConfigPollingStatCount(const int32_t lastStatCount,
+                                     const PollingContext& ctx,
+                                     const FileDiscoveryConfig& config,
+                                     bool isDockerConfig);
 
 private:
     PTMutex mPollingThreadLock;
@@ -126,13 +161,16 @@ private:
     SpinLock mCacheLock;
     DirCheckCacheMap mDirCacheMap;
     FileCheckCacheMap mFileCacheMap;
+    // Entries of polled directories.
+    DirSnapshotCache mDirSnapshotCache;
 
-    // Record how much times stat is called, if it exceeds limit, stop polling.
-    int32_t mStatCount;
-    // Record new files found in current round, will be pushed to PollingModify.
-    std::vector<SplitedFilePath> mNewFileVec;
+    // Record how much times stat is called by all workers, if it exceeds limit, stop polling.
+    // Entries which need no stat, e.g. files of unchanged directories that no config matches, are not counted.
+    std::atomic<int32_t> mStatCount;
     // The sequence number of current round, uint64_t is used to avoid overflow.
     uint64_t mCurrentRound;
+    // Start time of last round in milliseconds, to calculate the round rate.
+    uint64_t mLastRoundStartTime;
 
 #ifdef APSARA_UNIT_TEST_MAIN
     friend class PollingUnittest;
@@ -0,0 +1,206 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PollingDirSnapshot.h"
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include "common/FileSystemUtil.h"
+#include "common/Flags.h"
+#include "common/TimeUtil.h"
+
+DEFINE_FLAG_INT32(polling_dir_read_buffer_size, "buffer size to read entries of a directory by one call", 256 * 1024);
+
+namespace logtail {
+
+static const int64_t NANO_CONVERTING = 1000000000;
+
+#if defined(__linux__)
+// The layout of entries returned by getdents64, which glibc does not declare.
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+bool DirSnapshot::Load(const std::string& dirPath) {
+    mEntries.clear();
+    mNames.clear();
+#if defined(__linux__)
+    // readdir fills a 32KB buffer by each getdents64 call, large directories take much fewer calls with a larger one.
+    // Directories are read by several polling workers, each of them reuses its own buffer.
+    thread_local std::vector<char> buffer;
+    int fd = open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    buffer.resize(std::max(INT32_FLAG(polling_dir_read_buffer_size), 4096));
+    while (true) {
+        long size = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (size < 0) {
+            int err = errno;
+            close(fd);
+            errno = err;
+            return false;
+        }
+        if (size == 0) {
+            break;
+        }
+        for (long pos = 0; pos < size;) {
+            auto ent = reinterpret_cast<const LinuxDirent64*>(buffer.data() + pos);
+            pos += ent->d_reclen;
+            if (ent->d_name[0] == '.') {
+                continue;
+            }
+            EntryType type = EntryType::UNRESOLVED;
+            switch (ent->d_type) {
+                case DT_FIFO:
+                case DT_CHR:
+                case DT_BLK:
+                case DT_SOCK:
+                case DT_WHT:
+                    continue;
+                case DT_DIR:
+                    type = EntryType::DIR;
+                    break;
+                case DT_REG:
+                    type = EntryType::REG_FILE;
+                    break;
+                default:
+                    // DT_LNK, DT_UNKNOWN and unknown new types.
+                    break;
+            }
+            AddEntry(ent->d_name, strlen(ent->d_name), type);
+        }
+    }
+    close(fd);
+#elif defined(_MSC_VER)
+    fsutil::Dir dir(dirPath);
+    if (!dir.Open()) {
+        return false;
+    }
+    fsutil::Entry ent;
+    while ((ent = dir.ReadNext(false))) {
+        EntryType type = EntryType::UNRESOLVED;
+        if (ent.IsDir()) {
+            type = EntryType::DIR;
+        } else if (ent.IsRegFile()) {
+            type = EntryType::REG_FILE;
+        } else if (!ent.IsSymbolic()) {
+            continue;
+        }
+        auto name = ent.Name();
+        AddEntry(name.data(), name.size(), type);
+    }
+#endif
+    mEntries.shrink_to_fit();
+    mNames.shrink_to_fit();
+    return true;
+}
+
+void DirSnapshot::AddEntry(const char* name, size_t size, EntryType type) {
+    Entry entry;
+    entry.mNameOffset = static_cast<uint32_t>(mNames.size());
+    entry.mNameSize = static_cast<uint16_t>(size);
+    entry.mType = type;
+    mNames.append(name, size);
+    mEntries.push_back(entry);
+}
+
+void DirSnapshot::SetDirStat(int64_t modifyTime, uint64_t linkCount, int64_t loadTime) {
+    mModifyTime = modifyTime;
+    mLinkCount = linkCount;
+    mStable = loadTime - modifyTime > NANO_CONVERTING;
+}
+
+void DirSnapshot::ResetMatchStatus(uint64_t matchEpoch) {
+    for (auto& entry : mEntries) {
+        entry.mMatch = MatchStatus::UNKNOWN;
+    }
+    mMatchEpoch = matchEpoch;
+}
+
+DirSnapshot* DirSnapshotCache::Get(const std::string& dirPath,
+                                   const DevInode& devInode,
+                                   int64_t modifyTime,
+                                   uint64_t linkCount,
+                                   uint64_t curRound,
+                                   uint64_t owner,
+                                   DirSnapshot& privateSnapshot,
+                                   bool& loaded) {
+    loaded = false;
+    DirSnapshot* snapshot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto iter = mSnapshots.find(devInode);
+        if (iter != mSnapshots.end() && iter->second.GetLastCheckRound() == curRound) {
+            if (iter->second.GetOwner() == owner) {
+                return &iter->second;
+            }
+            snapshot = &privateSnapshot;
+        } else if (iter != mSnapshots.end() && iter->second.IsUnchanged(modifyTime, linkCount)) {
+            iter->second.SetCheckRound(curRound, owner);
+            return &iter->second;
+        } else {
+            // Claim it before reading, so that other owners do not touch it.
+            snapshot = iter != mSnapshots.end() ? &iter->second : &mSnapshots[devInode];
+            snapshot->SetCheckRound(curRound, owner);
+        }
+    }
+
+    int64_t loadTime = static_cast<int64_t>(GetCurrentTimeInNanoSeconds());
+    if (!snapshot->Load(dirPath)) {
+        int err = errno;
+        if (snapshot != &privateSnapshot) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSnapshots.erase(devInode);
+        }
+        errno = err;
+        return nullptr;
+    }
+    snapshot->SetDirStat(modifyTime, linkCount, loadTime);
+    loaded = true;
+    return snapshot;
+}
+
+void DirSnapshotCache::RemoveUnchecked(uint64_t curRound, uint64_t rounds) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto iter = mSnapshots.begin(); iter != mSnapshots.end();) {
+        if (curRound - iter->second.GetLastCheckRound() > rounds) {
+            iter = mSnapshots.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+size_t DirSnapshotCache::GetMemorySize() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t size = 0;
+    for (const auto& item : mSnapshots) {
+        size += sizeof(item) + item.second.GetMemorySize();
+    }
+    return size;
+}
+
+} // namespace logtail
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/DevInode.h"
+
+namespace logtail {
+
+// DirSnapshot is the entry list of a directory read by the last polling round.
+//
+// The list of a directory only changes when its modify time changes, so the snapshot can be reused by later rounds
+// instead of reading the directory again, as long as the modify time and link count of the directory are the same.
+// Names of all entries share one buffer, so that a snapshot costs two allocations however many entries it has.
+class DirSnapshot {
+public:
+    enum class EntryType : uint8_t {
+        DIR,
+        REG_FILE,
+        // Symbolic links and entries whose type is not reported by the filesystem, they have to be resolved by stat.
+        UNRESOLVED,
+    };
+
+    // MatchStatus caches whether a config matches a regular file, it is valid as long as
+    // ConfigManager::GetFileMatchEpoch does not change.
+    enum class MatchStatus : uint8_t { UNKNOWN, MATCHED, UNMATCHED };
+
+    struct Entry {
+        uint32_t mNameOffset = 0;
+        uint16_t mNameSize = 0;
+        EntryType mType = EntryType::UNRESOLVED;
+        MatchStatus mMatch = MatchStatus::UNKNOWN;
+    };
+
+    // Load reads all entries of dirPath except hidden ones. On failure, errno is kept for the caller.
+    bool Load(const std::string& dirPath);
+
+    // IsUnchanged returns true if a directory with modifyTime and linkCount has the same entries as the snapshot.
+    bool IsUnchanged(int64_t modifyTime, uint64_t linkCount) const {
+        return mStable && modifyTime == mModifyTime && linkCount == mLinkCount;
+    }
+    // SetDirStat records the stat of the directory when it is loaded.
+    // Changes within the timestamp granularity of the filesystem do not update the modify time, so a snapshot loaded
+    // shortly after the last change is not trusted.
+    void SetDirStat(int64_t modifyTime, uint64_t linkCount, int64_t loadTime);
+
+    size_t Size() const { return mEntries.size(); }
+    Entry& At(size_t idx) { return mEntries[idx]; }
+    std::string GetName(const Entry& entry) const { return mNames.substr(entry.mNameOffset, entry.mNameSize); }
+
+    void ResetMatchStatus(uint64_t matchEpoch);
+    uint64_t GetMatchEpoch() const { return mMatchEpoch; }
+
+    // SetCheckRound records the round and the owner which checks the snapshot.
+    void SetCheckRound(uint64_t curRound, uint64_t owner = 0) {
+        mLastCheckRound = curRound;
+        mOwner = owner;
+    }
+    uint64_t GetLastCheckRound() const { return mLastCheckRound; }
+    uint64_t GetOwner() const { return mOwner; }
+
+    size_t GetMemorySize() const { return mEntries.capacity() * sizeof(Entry) + mNames.capacity(); }
+
+private:
+    void AddEntry(const char* name, size_t size, EntryType type);
+
+    std::vector<Entry> mEntries;
+    std::string mNames;
+    // Last modified time on filesystem in nanoseconds.
+    int64_t mModifyTime = -1;
+    uint64_t mLinkCount = 0;
+    bool mStable = false;
+    uint64_t mMatchEpoch = 0;
+    uint64_t mLastCheckRound = 0;
+    uint64_t mOwner = 0;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class PollingDirSnapshotUnittest;
+#endif
+};
+
+// DirSnapshotCache keeps snapshots of polled directories by dev and inode, so that a renamed directory keeps its
+// snapshot and no path strings are stored.
+//
+// Directories are polled by several workers in a round, each of them is an owner. A cached snapshot is claimed by
+// the first owner which checks it in a round, and only that owner reads or changes it until the round ends, so
+// entries can be iterated without lock. Others, which reach the directory through another path (e.g. a symbolic
+// link), read it into a private snapshot instead.
+class DirSnapshotCache {
+public:
+    // Get returns the snapshot of the directory (nullptr if it can not be read), the directory is only read if it has
+    // changed since the snapshot was loaded. A directory polled more than once in a round by an owner is read once.
+    // @owner: id of the caller, snapshots claimed by other owners in this round are not returned.
+    // @privateSnapshot: the directory is read into it if the snapshot is claimed by another owner.
+    // @loaded: set to true if the directory is read.
+    DirSnapshot* Get(const std::string& dirPath,
+                     const DevInode& devInode,
+                     int64_t modifyTime,
+                     uint64_t linkCount,
+                     uint64_t curRound,
+                     uint64_t owner,
+                     DirSnapshot& privateSnapshot,
+                     bool& loaded);
+
+    // RemoveUnchecked removes snapshots which are not checked in the last rounds.
+    // It must not be called when a round is in progress, because snapshots returned by Get are used without lock.
+    void RemoveUnchecked(uint64_t curRound, uint64_t rounds);
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSnapshots.clear();
+    }
+    size_t Size() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mSnapshots.size();
+    }
+    size_t GetMemorySize() const;
+
+private:
+    // Only guards the map and the round and owner of snapshots, elements are never moved by insertion.
+    mutable std::mutex mMutex;
+    std::unordered_map<DevInode, DirSnapshot, DevInodeHash> mSnapshots;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class PollingDirSnapshotUnittest;
+#endif
+};
+
+} // namespace logtail
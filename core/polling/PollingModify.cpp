@@ -14,6 +14,7 @@
 
 #include "PollingModify.h"
 #include "PollingEventQueue.h"
+#include "PollingStatPool.h"
 #if defined(__linux__)
 #include <sys/file.h>
 #endif
@@ -26,6 +27,7 @@
 #include "logger/Logger.h"
 #include "monitor/LogtailAlarm.h"
 #include "monitor/Monitor.h"
+#include "monitor/SamplingProfiler.h"
 
 using namespace std;
 
@@ -35,6 +37,7 @@ DEFINE_FLAG_INT32(modify_stat_count, "sleep when dir file stat count up to", 100
 DEFINE_FLAG_INT32(modify_stat_sleepMs, "sleep time when dir file stat up to 1000, ms", 10);
 DEFINE_FLAG_INT32(modify_cache_max, "max modify chache size, if exceed, delete 0.2 oldest", 100000);
 DEFINE_FLAG_INT32(modify_cache_make_space_interval, "second", 600);
+DEFINE_FLAG_INT32(polling_modify_chunk_size, "min count of files checked by a polling worker at a time", 1000);
 
 namespace logtail {
 
@@ -235,60 +238,95 @@ bool PollingModify::UpdateDeletedFile(const SplitedFilePath& filePath,
     return false;
 }
 
+void PollingModify::PollingChunk(std::vector<ModifyCheckCacheMap::iterator>& items,
+                                 size_t begin,
+                                 size_t end,
+                                 std::vector<Event*>& eventVec,
+                                 std::vector<SplitedFilePath>& deletedFileVec) {
+    int32_t statCount = 0;
+    for (size_t idx = begin; idx < end; ++idx) {
+        if (!mRuningFlag || mHoldOnFlag)
+            break;
+
+        const SplitedFilePath& filePath = items[idx]->first;
+        ModifyCheckCache& modifyCache = items[idx]->second;
+        fsutil::PathStat logFileStat;
+        if (!fsutil::PathStat::stat(PathJoin(filePath.mFileDir, filePath.mFileName), logFileStat)) {
+            if (errno == ENOENT) {
+                LOG_DEBUG(sLogger, ("file deleted", PathJoin(filePath.mFileDir, filePath.mFileName)));
+                if (UpdateDeletedFile(filePath, modifyCache, eventVec)) {
+                    deletedFileVec.push_back(filePath);
+                }
+            } else {
+                LOG_DEBUG(sLogger, ("get file info error", PathJoin(filePath.mFileDir, filePath.mFileName)));
+            }
+        } else {
+            int64_t sec, nsec;
+            logFileStat.GetLastWriteTime(sec, nsec);
+            timespec mtim{sec, nsec};
+            auto devInode = logFileStat.GetDevInode();
+            UpdateFile(
+                filePath, modifyCache, devInode.dev, devInode.inode, logFileStat.GetFileSize(), mtim, eventVec);
+        }
+
+        ++statCount;
+        if (statCount % INT32_FLAG(modify_stat_count) == 0) {
+            usleep(1000 * INT32_FLAG(modify_stat_sleepMs));
+        }
+    }
+}
+
 void PollingModify::Polling() {
+    SamplingProfiler::SetThreadRole("polling_modify");
     LOG_INFO(sLogger, ("polling modify", "started"));
     mHoldOnFlag = false;
+    uint64_t lastRoundStartTime = 0;
     while (mRuningFlag) {
         {
             PTScopedLock threadLock(mPollingThreadLock);
+            uint64_t roundStartTime = GetCurrentTimeInMilliSeconds();
             LoadFileNameInQueues();
 
-            vector<SplitedFilePath> deletedFileVec;
-            vector<Event*> pollingEventVec;
-            int32_t statCount = 0;
             LogtailMonitor::GetInstance()->UpdateMetric("polling_modify_size", mModifyCacheMap.size());
+            // Files are split into chunks in path order, so files of a directory are mostly checked by one worker.
+            // Each chunk only updates its own cache items, events are merged in order after all chunks are done.
+            vector<ModifyCheckCacheMap::iterator> items;
+            items.reserve(mModifyCacheMap.size());
             for (auto iter = mModifyCacheMap.begin(); iter != mModifyCacheMap.end(); ++iter) {
-                if (!mRuningFlag || mHoldOnFlag)
-                    break;
-
-                const SplitedFilePath& filePath = iter->first;
-                ModifyCheckCache& modifyCache = iter->second;
-                fsutil::PathStat logFileStat;
-                if (!fsutil::PathStat::stat(PathJoin(filePath.mFileDir, filePath.mFileName), logFileStat)) {
-                    if (errno == ENOENT) {
-                        LOG_DEBUG(sLogger, ("file deleted", PathJoin(filePath.mFileDir, filePath.mFileName)));
-                        if (UpdateDeletedFile(filePath, modifyCache, pollingEventVec)) {
-                            deletedFileVec.push_back(filePath);
-                        }
-                    } else {
-                        LOG_DEBUG(sLogger, ("get file info error", PathJoin(filePath.mFileDir, filePath.mFileName)));
-                    }
-                } else {
-                    int64_t sec, nsec;
-                    logFileStat.GetLastWriteTime(sec, nsec);
-                    timespec mtim{sec, nsec};
-                    auto devInode = logFileStat.GetDevInode();
-                    UpdateFile(filePath,
-                               modifyCache,
-                               devInode.dev,
-                               devInode.inode,
-                               logFileStat.GetFileSize(),
-                               mtim,
-                               pollingEventVec);
-                }
-
-                ++statCount;
-                if (statCount % INT32_FLAG(modify_stat_count) == 0) {
-                    usleep(1000 * INT32_FLAG(modify_stat_sleepMs));
-                }
+                items.push_back(iter);
             }
+            size_t chunkSize = max(static_cast<size_t>(max(INT32_FLAG(polling_modify_chunk_size), 1)),
+                                   items.size() / (PollingStatPool::GetInstance()->GetThreadCount() * 4) + 1);
+            size_t chunkCount = (items.size() + chunkSize - 1) / chunkSize;
+            vector<vector<Event*>> chunkEventVecs(chunkCount);
+            vector<vector<SplitedFilePath>> chunkDeletedFileVecs(chunkCount);
+            PollingStatPool::GetInstance()->Run(chunkCount, [&](size_t idx) {
+                PollingChunk(items,
+                             idx * chunkSize,
+                             min(items.size(), (idx + 1) * chunkSize),
+                             chunkEventVecs[idx],
+                             chunkDeletedFileVecs[idx]);
+            });
 
+            vector<Event*> pollingEventVec;
+            for (auto& eventVec : chunkEventVecs) {
+                pollingEventVec.insert(pollingEventVec.end(), eventVec.begin(), eventVec.end());
+            }
             if (pollingEventVec.size() > 0) {
                 PollingEventQueue::GetInstance()->PushEvent(pollingEventVec);
             }
-            for (size_t i = 0; i < deletedFileVec.size(); ++i) {
-                mModifyCacheMap.erase(deletedFileVec[i]);
+            for (auto& deletedFileVec : chunkDeletedFileVecs) {
+                for (size_t i = 0; i < deletedFileVec.size(); ++i) {
+                    mModifyCacheMap.erase(deletedFileVec[i]);
+                }
+            }
+
+            // Rounds per second, sleep between rounds included, shows how fast modifications can be found.
+            if (lastRoundStartTime > 0 && roundStartTime > lastRoundStartTime) {
+                LogtailMonitor::GetInstance()->UpdateMetric("polling_modify_round_per_sec",
+                                                            1000.0 / (roundStartTime - lastRoundStartTime));
             }
+            lastRoundStartTime = roundStartTime;
         }
 
         // Sleep for a while, by default, 1s.
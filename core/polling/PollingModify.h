@@ -61,6 +61,14 @@ private:
 
     void Polling();
 
+    // PollingChunk checks files [@begin, @end) of @items, which is run by workers of PollingStatPool.
+    // Created events are pushed to @eventVec, and files to remove from cache are pushed to @deletedFileVec.
+    void PollingChunk(std::vector<ModifyCheckCacheMap::iterator>& items,
+                      size_t begin,
+                      size_t end,
+                      std::vector<Event*>& eventVec,
+                      std::vector<SplitedFilePath>& deletedFileVec);
+
     // MakeSpaceForNewFile tries to release some space from modify cache
     // for LoadFileNameInQueues to add new files.
     void MakeSpaceForNewFile();
@@ -0,0 +1,89 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PollingStatPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include "common/Flags.h"
+#include "logger/Logger.h"
+
+DEFINE_FLAG_INT32(polling_stat_thread_count,
+                  "number of threads to stat files and directories in polling, 1 means polling threads stat by "
+                  "themselves",
+                  4);
+
+namespace logtail {
+
+size_t PollingStatPool::GetThreadCount() const {
+    // The value is read once, changing the flag at runtime does not resize the pool.
+    static const size_t sThreadCount = static_cast<size_t>(std::max(INT32_FLAG(polling_stat_thread_count), 1));
+    return sThreadCount;
+}
+
+void PollingStatPool::Run(size_t taskCount, const std::function<void(size_t)>& func) {
+    size_t helperCount = std::min(GetThreadCount(), taskCount);
+    helperCount = helperCount > 0 ? helperCount - 1 : 0;
+    if (helperCount == 0) {
+        for (size_t idx = 0; idx < taskCount; ++idx) {
+            func(idx);
+        }
+        return;
+    }
+    std::call_once(mStartFlag, [this]() {
+        // The calling thread takes tasks too, so the pool needs one thread less.
+        mPool.reset(new ThreadPool(GetThreadCount() - 1));
+        mPool->Start();
+        LOG_INFO(sLogger, ("polling stat pool", "started")("thread count", GetThreadCount()));
+    });
+
+    // Helpers may start after all tasks are done when workers are busy with another caller, so the state they
+    // use is shared, and only helpers which have started are waited for.
+    struct RunState {
+        std::atomic<size_t> mNextTask{0};
+        std::mutex mMutex;
+        std::condition_variable mCond;
+        bool mClosed = false;
+        size_t mRunningHelpers = 0;
+    };
+    auto state = std::make_shared<RunState>();
+    const std::function<void(size_t)>* task = &func;
+    auto takeTasks = [state, task, taskCount]() {
+        for (size_t idx = state->mNextTask++; idx < taskCount; idx = state->mNextTask++) {
+            (*task)(idx);
+        }
+    };
+    for (size_t i = 0; i < helperCount; ++i) {
+        mPool->Add([state, takeTasks]() {
+            {
+                std::lock_guard<std::mutex> lock(state->mMutex);
+                if (state->mClosed) {
+                    return;
+                }
+                ++state->mRunningHelpers;
+            }
+            takeTasks();
+            std::lock_guard<std::mutex> lock(state->mMutex);
+            if (--state->mRunningHelpers == 0) {
+                state->mCond.notify_one();
+            }
+        });
+    }
+    takeTasks();
+    std::unique_lock<std::mutex> lock(state->mMutex);
+    state->mClosed = true;
+    state->mCond.wait(lock, [&state]() { return state->mRunningHelpers == 0; });
+}
+
+} // namespace logtail
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "common/ThreadPool.h"
+
+namespace logtail {
+
+// PollingStatPool runs the stat heavy work of polling threads on a bounded number of workers, so that polling
+// on filesystems with slow stat (NFS, overlay, etc) is not limited by the latency of a single thread.
+// It is shared by PollingDirFile and PollingModify, the number of threads is controlled by flag
+// polling_stat_thread_count, and with 1 thread all tasks run on the calling thread in order.
+class PollingStatPool {
+public:
+    static PollingStatPool* GetInstance() {
+        static PollingStatPool* ptr = new PollingStatPool();
+        return ptr;
+    }
+
+    // Run calls func(0) ... func(taskCount - 1) and returns after all of them are done.
+    // Tasks are taken in order by the calling thread and pool workers, so each task must only touch its own state
+    // or state protected by locks.
+    void Run(size_t taskCount, const std::function<void(size_t)>& func);
+
+    // GetThreadCount returns how many threads (calling thread included) can run tasks at the same time.
+    size_t GetThreadCount() const;
+
+private:
+    PollingStatPool() = default;
+    ~PollingStatPool() = default;
+
+    std::once_flag mStartFlag;
+    std::unique_ptr<ThreadPool> mPool;
+};
+
+} // namespace logtail
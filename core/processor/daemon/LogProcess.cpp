@@ -27,6 +27,7 @@
 #include "common/Constants.h"
 #include "common/LogFileCollectOffsetIndicator.h"
 #include "common/LogGroupContext.h"
+#include "common/MemoryBudget.h"
 #include "common/LogtailCommonFlags.h"
 #include "common/StringTools.h"
 #include "common/TimeUtil.h"
@@ -40,8 +41,10 @@
 #include "monitor/LogFileProfiler.h"
 #include "monitor/LogIntegrity.h"
 #include "monitor/LogLineCount.h"
+#include "monitor/LogtailMetric.h"
 #include "monitor/LogtailAlarm.h"
 #include "monitor/Monitor.h"
+#include "monitor/SamplingProfiler.h"
 #include "pipeline/PipelineManager.h"
 #include "sdk/Client.h"
 #include "sender/Sender.h"
@@ -56,6 +59,10 @@ using namespace std;
 DEFINE_FLAG_INT32(process_buffer_count_upperlimit_perthread, "", 25);
 DEFINE_FLAG_INT32(merge_send_packet_interval, "", 1);
 DEFINE_FLAG_INT32(debug_logprocess_queue_flag, "0 disable, 1 true, 2 false", 0);
+DEFINE_FLAG_INT32(process_queue_drr_quantum_bytes,
+                  "bytes a logstore earns per round when dispatching buffers to process threads, weighted by "
+                  "SchedulingWeight",
+                  512 * 1024);
 #if defined(_MSC_VER)
 // On Windows, if Chinese config base path is used, the log path will be converted to GBK,
 // so the __tag__.__path__ have to be converted back to UTF8 to avoid bad display.
@@ -112,6 +119,7 @@ void LogProcess::Start() {
 }
 
 bool LogProcess::PushBuffer(LogBuffer* buffer, int32_t retryTimes) {
+    buffer->enqueueTimeMs = GetCurrentTimeInMilliSeconds();
     int32_t retry = 0;
     while (true) {
         retry++;
@@ -136,6 +144,10 @@ bool LogProcess::IsValidToReadLog(const LogstoreFeedBackKey& logstoreKey) {
     if (INT32_FLAG(debug_logprocess_queue_flag) > 0) {
         return INT32_FLAG(debug_logprocess_queue_flag) == 1;
     }
+    // Buffered data has used up the memory budget, blocked readers are retried when their block event times out.
+    if (MemoryBudget::GetInstance()->IsExceeded()) {
+        return false;
+    }
     return mLogFeedbackQueue.IsValidToPush(logstoreKey);
 }
 
@@ -152,6 +164,10 @@ void LogProcess::DeletePriorityWithHoldOn(const LogstoreFeedBackKey& logstoreKey
     mLogFeedbackQueue.DeletePriorityNoLock(logstoreKey);
 }
 
+void LogProcess::SetWeightWithHoldOn(const LogstoreFeedBackKey& logstoreKey, uint32_t weight) {
+    mLogFeedbackQueue.SetWeightNoLock(logstoreKey, weight);
+}
+
 void LogProcess::HoldOn() {
     LOG_INFO(sLogger, ("process daemon pause", "starts"));
     mAccessProcessThreadRWL.lock();
@@ -204,12 +220,14 @@ bool LogProcess::FlushOut(int32_t waitMs) {
 }
 
 void* LogProcess::ProcessLoop(int32_t threadNo) {
+    SamplingProfiler::SetThreadRole("process");
     LOG_DEBUG(sLogger, ("LogProcessThread", "Start")("threadNo", threadNo));
     LogstoreFeedBackKey logstoreKey = 0;
     static int32_t lastMergeTime = 0;
-    static atomic_int s_processCount{0};
-    static atomic_long s_processBytes{0};
-    static atomic_int s_processLines{0};
+    // all process threads add to these, so they are sharded counters rather than plain atomics
+    static Counter s_processCount("process_count", 0);
+    static Counter s_processBytes("process_bytes", 0);
+    static Counter s_processLines("process_lines", 0);
     // only thread 0 update metric
     int32_t lastUpdateMetricTime = time(NULL);
 #ifdef LOGTAIL_DEBUG_FLAG
@@ -232,14 +250,13 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
         if (threadNo == 0 && curTime - lastUpdateMetricTime >= 40) {
             static auto sMonitor = LogtailMonitor::GetInstance();
 
-            // atomic counter will be negative if process speed is too fast.
-            sMonitor->UpdateMetric("process_tps", 1.0 * s_processCount / (curTime - lastUpdateMetricTime));
-            sMonitor->UpdateMetric("process_bytes_ps", 1.0 * s_processBytes / (curTime - lastUpdateMetricTime));
-            sMonitor->UpdateMetric("process_lines_ps", 1.0 * s_processLines / (curTime - lastUpdateMetricTime));
+            sMonitor->UpdateMetric("process_tps",
+                                   1.0 * s_processCount.GetAndReset() / (curTime - lastUpdateMetricTime));
+            sMonitor->UpdateMetric("process_bytes_ps",
+                                   1.0 * s_processBytes.GetAndReset() / (curTime - lastUpdateMetricTime));
+            sMonitor->UpdateMetric("process_lines_ps",
+                                   1.0 * s_processLines.GetAndReset() / (curTime - lastUpdateMetricTime));
             lastUpdateMetricTime = curTime;
-            s_processCount = 0;
-            s_processBytes = 0;
-            s_processLines = 0;
 
             // update process queue status
             int32_t invalidCount = 0;
@@ -286,9 +303,9 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
         {
             ReadLock lock(mAccessProcessThreadRWL);
             mThreadFlags[threadNo] = true;
-            s_processCount++;
+            s_processCount.Add(1);
             uint64_t readBytes = logBuffer->rawBuffer.size() + 1; // may not be accurate if input is not utf8
-            s_processBytes += readBytes;
+            s_processBytes.Add(readBytes);
             LogFileReaderPtr logFileReader = logBuffer->logFileReader;
             auto convertedPath = logFileReader->GetConvertedPath();
             auto hostLogPath = logFileReader->GetHostLogPath();
@@ -307,6 +324,9 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                              "logstore", logFileReader->GetLogstore()));
                 continue;
             }
+            uint64_t nowMs = GetCurrentTimeInMilliSeconds();
+            pipeline->OnProcessQueuePop(logBuffer->rawBuffer.size(),
+                                        nowMs > logBuffer->enqueueTimeMs ? nowMs - logBuffer->enqueueTimeMs : 0);
 
             std::vector<std::unique_ptr<sls_logs::LogGroup>> logGroupList;
             ProcessProfile profile;
@@ -327,7 +347,7 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                 logSize += pLogGroup->logs_size();
             }
             // add lines count
-            s_processLines += profile.splitLines;
+            s_processLines.Add(profile.splitLines);
             // check whether processing is too slow
             if (parseEndTime - parseStartTime > 1) {
                 LogtailAlarm::GetInstance()->SendAlarm(
@@ -374,6 +394,7 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                 }
                 sls_logs::SlsCompressType compressType = sdk::Client::GetCompressType(compressStr);
 
+                uint64_t flushStartTimeUs = GetCurrentTimeInMicroSeconds();
                 for (auto& pLogGroup : logGroupList) {
                     LogGroupContext context(flusherSLS->mRegion,
                                             projectName,
@@ -407,6 +428,11 @@ void* LogProcess::ProcessLoop(int32_t threadNo) {
                                       "project", projectName)("logstore", category)("filename", convertedPath));
                     }
                 }
+                uint64_t flushEndTimeUs = GetCurrentTimeInMicroSeconds();
+                pipeline->GetFlushers()[0]->OnFlush(
+                    logSize,
+                    profile.logGroupSize,
+                    flushEndTimeUs > flushStartTimeUs ? flushEndTimeUs - flushStartTimeUs : 0);
 
                 LogFileProfiler::GetInstance()->AddProfilingData(pipeline->Name(),
                                                                  pipeline->GetContext().GetRegion(),
@@ -15,6 +15,7 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <atomic>
 #include <boost/regex.hpp>
 #include <map>
@@ -22,6 +23,7 @@
 #include <vector>
 #include <unordered_map>
 #include <utility>
+#include "common/Flags.h"
 #include "common/LogstoreFeedbackQueue.h"
 #include "common/LogRunnable.h"
 #include "common/Thread.h"
@@ -30,11 +32,21 @@
 #include "pipeline/PipelineContext.h"
 #include "reader/LogFileReader.h"
 
+DECLARE_FLAG_INT32(process_queue_drr_quantum_bytes);
+
 namespace logtail {
 // forward declaration
 struct LogBuffer;
 class PipelineEventGroup;
 
+// Buffers are scheduled across logstores by bytes, so that a logstore with large buffers can not take more than its
+// share of process threads.
+template <>
+struct QueueItemCost<LogBuffer*> {
+    static size_t Get(LogBuffer* const& item) { return item->rawBuffer.size(); }
+    static size_t Quantum() { return std::max(INT32_FLAG(process_queue_drr_quantum_bytes), 1); }
+};
+
 class LogProcess : public LogRunnable {
 public:
     static LogProcess* GetInstance() {
@@ -65,6 +77,10 @@ public:
     // must not call this when processer is working
     void DeletePriorityWithHoldOn(const LogstoreFeedBackKey& logstoreKey);
 
+    // call it after holdon or processor not started
+    // must not call this when processer is working
+    void SetWeightWithHoldOn(const LogstoreFeedBackKey& logstoreKey, uint32_t weight);
+
     // process thread hold on should after input thread hold on
     // because process hold on will lock mLogFeedbackQueue, if input thread not hold on first,
     // input thread may try to lock mLogFeedbackQueue by call IsValidToReadLog or PushBuffer,
@@ -0,0 +1,132 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "GloablFileDescriptorManager.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "common/Flags.h"
+#include "common/MemoryBudget.h"
+#include "logger/Logger.h"
+#include "reader/LogFileReader.h"
+
+DEFINE_FLAG_INT32(reader_fd_evict_high_watermark,
+                  "percent of max_reader_open_files, idle files are closed when open files exceed it",
+                  90);
+DEFINE_FLAG_INT32(reader_fd_evict_low_watermark,
+                  "percent of max_reader_open_files, idle files are closed until open files are below it",
+                  80);
+DEFINE_FLAG_INT32(reader_fd_evict_count_on_memory_pressure,
+                  "max number of idle files closed at once when the memory budget is used up",
+                  100);
+DECLARE_FLAG_INT32(max_reader_open_files);
+
+namespace logtail {
+
+void GloablFileDescriptorManager::OnFileOpen(LogFileReader* reader) {
+    ++mOpenFileSize;
+    ++mOpenCount;
+    std::lock_guard<std::mutex> lock(mLruMux);
+    auto iter = mLruIndex.find(reader);
+    if (iter != mLruIndex.end()) {
+        mLruList.erase(iter->second);
+    }
+    mLruList.push_front(LruItem{reader, reader->weak_from_this()});
+    mLruIndex[reader] = mLruList.begin();
+}
+
+void GloablFileDescriptorManager::OnFileAccess(LogFileReader* reader, bool avoidedOpen) {
+    if (avoidedOpen) {
+        ++mAvoidedOpenCount;
+    }
+    std::lock_guard<std::mutex> lock(mLruMux);
+    auto iter = mLruIndex.find(reader);
+    if (iter != mLruIndex.end()) {
+        mLruList.splice(mLruList.begin(), mLruList, iter->second);
+    }
+}
+
+void GloablFileDescriptorManager::OnFileClose(LogFileReader* reader) {
+    --mOpenFileSize;
+    std::lock_guard<std::mutex> lock(mLruMux);
+    auto iter = mLruIndex.find(reader);
+    if (iter != mLruIndex.end()) {
+        mLruList.erase(iter->second);
+        mLruIndex.erase(iter);
+    }
+}
+
+bool GloablFileDescriptorManager::IsUnderPressure() const {
+    int64_t lowWatermark = (int64_t)INT32_FLAG(max_reader_open_files) * INT32_FLAG(reader_fd_evict_low_watermark) / 100;
+    return mOpenFileSize > lowWatermark || MemoryBudget::GetInstance()->IsExceeded();
+}
+
+size_t GloablFileDescriptorManager::EvictOnPressure() {
+    int64_t maxOpenFiles = INT32_FLAG(max_reader_open_files);
+    int64_t openFiles = mOpenFileSize;
+    size_t count = 0;
+    if (openFiles > maxOpenFiles * INT32_FLAG(reader_fd_evict_high_watermark) / 100) {
+        count = openFiles - maxOpenFiles * INT32_FLAG(reader_fd_evict_low_watermark) / 100;
+    }
+    if (MemoryBudget::GetInstance()->IsExceeded()) {
+        count = std::max(count, (size_t)INT32_FLAG(reader_fd_evict_count_on_memory_pressure));
+    }
+    if (count == 0) {
+        return 0;
+    }
+    size_t evictCount = EvictIdleFiles(count);
+    if (evictCount > 0) {
+        LOG_INFO(sLogger,
+                 ("close idle files", "open files or memory budget under pressure")("expected count", count)(
+                     "closed count", evictCount)("open files", mOpenFileSize)("max open files", maxOpenFiles));
+    }
+    return evictCount;
+}
+
+size_t GloablFileDescriptorManager::EvictIdleFiles(size_t count) {
+    // Busy files met from the tail are kept, scanning stops after some of them so that a full list is not scanned
+    // on every call.
+    const size_t maxScanCount = count * 4 + 16;
+    std::vector<std::shared_ptr<LogFileReader>> candidates;
+    {
+        std::lock_guard<std::mutex> lock(mLruMux);
+        for (auto iter = mLruList.rbegin(); iter != mLruList.rend() && candidates.size() < maxScanCount; ++iter) {
+            std::shared_ptr<LogFileReader> reader = iter->mWeakReader.lock();
+            if (reader) {
+                candidates.emplace_back(std::move(reader));
+            }
+        }
+    }
+    // Close outside the lock, CloseFilePtr calls OnFileClose. Candidates hold readers so that they are not
+    // destructed meanwhile.
+    size_t evictCount = 0;
+    for (auto& reader : candidates) {
+        if (evictCount >= count) {
+            break;
+        }
+        // a queued reader is found by its file name only when it is open, see ModifyHandler::HandleTimeOut
+        LogFileReaderPtrArray* readerArray = reader->GetReaderArray();
+        if (readerArray != nullptr && readerArray->size() > 1) {
+            continue;
+        }
+        if (reader->CloseIdleFilePtr("the file is least recently used and open files or memory are under pressure")) {
+            ++evictCount;
+        }
+    }
+    mEvictCount += evictCount;
+    return evictCount;
+}
+
+} // namespace logtail
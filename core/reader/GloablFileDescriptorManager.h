@@ -16,11 +16,21 @@
 
 #pragma once
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace logtail {
 
 class LogFileReader;
 
+// GloablFileDescriptorManager keeps files opened by readers in LRU order, so that files stay open while they are
+// used and the least recently used idle ones are closed when the number of open files or the memory budget comes
+// under pressure, instead of closing every file on a fixed timeout and opening it again on the next write.
+// A closed file is opened again lazily by its reader, which checks dev inode and signature.
 class GloablFileDescriptorManager {
 public:
     static GloablFileDescriptorManager* GetInstance() {
@@ -28,14 +38,53 @@ public:
         return &singleton;
     }
 
-    void OnFileOpen(LogFileReader*) { ++mOpenFileSize; }
-
-    void OnFileClose(LogFileReader*) { --mOpenFileSize; }
+    void OnFileOpen(LogFileReader* reader);
+    // OnFileAccess is called when an open file is used again. @avoidedOpen is true if the file has been unused for
+    // longer than the close timeout of its reader, so that it would have been closed and opened again.
+    void OnFileAccess(LogFileReader* reader, bool avoidedOpen);
+    void OnFileClose(LogFileReader* reader);
 
     int32_t GetOpenedFilePtrSize() { return mOpenFileSize; }
 
+    // IsUnderPressure returns true if open files exceed the low watermark or the memory budget is used up.
+    bool IsUnderPressure() const;
+
+    // EvictOnPressure closes least recently used idle files when open files exceed the high watermark, until they
+    // are below the low watermark, or some of them when the memory budget is used up. It returns the number of files
+    // closed. Readers are used without locks, so it must only be called when no reader is being read. The caller
+    // limits how often it is called, idle files are scanned each time open files or memory are under pressure.
+    size_t EvictOnPressure();
+
+    // EvictIdleFiles closes at most count least recently used files which have been read to end, and whose reader
+    // is the only one in its reader queue. It returns the number of files closed, with the same limit as above.
+    size_t EvictIdleFiles(size_t count);
+
+    // Counters since start, for metrics.
+    uint64_t GetOpenCount() const { return mOpenCount; }
+    uint64_t GetAvoidedOpenCount() const { return mAvoidedOpenCount; }
+    uint64_t GetEvictCount() const { return mEvictCount; }
+
 private:
+    GloablFileDescriptorManager() = default;
+
     std::atomic_int mOpenFileSize{0};
+    std::atomic<uint64_t> mOpenCount{0};
+    std::atomic<uint64_t> mAvoidedOpenCount{0};
+    std::atomic<uint64_t> mEvictCount{0};
+
+    struct LruItem {
+        LogFileReader* mReader;
+        // Readers not owned by shared_ptr can not be evicted.
+        std::weak_ptr<LogFileReader> mWeakReader;
+    };
+    // Files are opened and closed by reader threads, the list is most recently used first.
+    std::mutex mLruMux;
+    std::list<LruItem> mLruList;
+    std::unordered_map<LogFileReader*, std::list<LruItem>::iterator> mLruIndex;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+    friend class FileDescriptorCacheUnittest;
+#endif
 };
 
-} // namespace logtail
\ No newline at end of file
+} // namespace logtail
@@ -1087,6 +1087,7 @@ void LogFileReader::OnOpenFileError() {
 }
 
 bool LogFileReader::UpdateFilePtr() {
+    time_t prevUpdateTime = mLastUpdateTime;
     // move last update time before check IsValidToPush
     mLastUpdateTime = time(NULL);
     if (mLogFileOp.IsOpen() == false) {
@@ -1192,33 +1193,46 @@ bool LogFileReader::UpdateFilePtr() {
                      "last file position", mLastFilePos));
         return false;
     }
+    // the file would have been closed on timeout if it was not kept open, see CloseTimeoutFilePtr
+    GloablFileDescriptorManager::GetInstance()->OnFileAccess(
+        this, mLastUpdateTime - prevUpdateTime > (time_t)mReaderConfig.first->mCloseUnusedReaderIntervalSec);
     return true;
 }
 
-bool LogFileReader::CloseTimeoutFilePtr(int32_t curTime) {
+bool LogFileReader::CloseTimeoutFilePtr(int32_t curTime, bool removedOnly) {
     int32_t timeOut = (int32_t)(mReaderConfig.first->mCloseUnusedReaderIntervalSec / 100.f * (100 + rand() % 50));
     if (mLogFileOp.IsOpen() && curTime - mLastUpdateTime > timeOut) {
-        fsutil::PathStat buf;
-        if (mLogFileOp.Stat(buf) != 0) {
-            return false;
-        }
-        if ((int64_t)buf.GetFileSize() == mLastFilePos) {
-            LOG_INFO(sLogger,
-                     ("close the file",
-                      "current log file has not been updated for some time and has been read")("project", GetProject())(
-                         "logstore", GetLogstore())("config", GetConfigName())("log reader queue name", mHostLogPath)(
-                         "file device", ToString(mDevInode.dev))("file inode", ToString(mDevInode.inode))(
-                         "file signature", mLastFileSignatureHash)("file signature size", mLastFileSignatureSize)(
-                         "file size", mLastFileSize)("last file position", mLastFilePos));
-            CloseFilePtr();
-            // delete item in LogFileCollectOffsetIndicator map
-            LogFileCollectOffsetIndicator::GetInstance()->DeleteItem(mHostLogPath, mDevInode);
-            return true;
-        }
+        return CloseIdleFilePtr("current log file has not been updated for some time and has been read", removedOnly);
     }
     return false;
 }
 
+bool LogFileReader::CloseIdleFilePtr(const std::string& reason, bool removedOnly) {
+    if (!mLogFileOp.IsOpen()) {
+        return false;
+    }
+    fsutil::PathStat buf;
+    if (mLogFileOp.Stat(buf) != 0) {
+        return false;
+    }
+    if ((int64_t)buf.GetFileSize() != mLastFilePos) {
+        return false;
+    }
+    if (removedOnly && buf.GetLinkCount() > 0) {
+        return false;
+    }
+    LOG_INFO(sLogger,
+             ("close the file", reason)("project", GetProject())("logstore", GetLogstore())("config", GetConfigName())(
+                 "log reader queue name", mHostLogPath)("file device", ToString(mDevInode.dev))(
+                 "file inode", ToString(mDevInode.inode))("file signature", mLastFileSignatureHash)(
+                 "file signature size", mLastFileSignatureSize)("file size", mLastFileSize)("last file position",
+                                                                                            mLastFilePos));
+    CloseFilePtr();
+    // delete item in LogFileCollectOffsetIndicator map
+    LogFileCollectOffsetIndicator::GetInstance()->DeleteItem(mHostLogPath, mDevInode);
+    return true;
+}
+
 void LogFileReader::CloseFilePtr() {
     if (mLogFileOp.IsOpen()) {
         mCache.shrink_to_fit();
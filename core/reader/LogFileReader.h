@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <deque>
+#include <memory>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -77,7 +78,7 @@ typedef std::deque<LogFileReaderPtr> LogFileReaderPtrArray;
  * "SingleLineLog_1\nSingleLineLog_2\nSingleLineLog_3\n" -> "SingleLineLog_1\nSingleLineLog_2\nSingleLineLog_3\0"
  * "SingleLineLog_1\nSingleLineLog_2\nxxx" -> "SingleLineLog_1\nSingleLineLog_2\0"
  */
-class LogFileReader {
+class LogFileReader : public std::enable_shared_from_this<LogFileReader> {
 public:
     enum FileCompareResult {
         FileCompareResult_DevInodeChange,
@@ -210,7 +211,13 @@ public:
     // if update file ptr return false, then we should delete this reader
     bool UpdateFilePtr();
 
-    bool CloseTimeoutFilePtr(int32_t curTime);
+    // CloseTimeoutFilePtr closes the file if it has been read to end and not updated for a while. If @removedOnly,
+    // it is only closed when it has been removed from the disk.
+    bool CloseTimeoutFilePtr(int32_t curTime, bool removedOnly = false);
+
+    // CloseIdleFilePtr closes the file if it has been read to end, @reason is logged. If @removedOnly, it is only
+    // closed when it has been removed from the disk.
+    bool CloseIdleFilePtr(const std::string& reason, bool removedOnly = false);
 
     bool CheckDevInode();
 
@@ -591,6 +598,7 @@ private:
     friend class LogSplitNoDiscardUnmatchUnittest;
     friend class RemoveLastIncompleteLogMultilineUnittest;
     friend class LogFileReaderCheckpointUnittest;
+    friend class FileDescriptorCacheUnittest;
 
 protected:
     void UpdateReaderManual();
@@ -607,6 +615,8 @@ struct LogBuffer : public SourceBuffer {
     // Current buffer's offset in file, for log position meta feature.
     uint64_t readOffset = 0;
     uint64_t readLength = 0;
+    // Time in ms when the buffer is pushed into the process queue.
+    uint64_t enqueueTimeMs = 0;
 
     LogBuffer() {}
     void SetDependecy(const LogFileReaderPtr& reader) { logFileReader = reader; }
@@ -19,6 +19,7 @@
 #include <memory>
 #include <list>
 #include "models/StringView.h"
+#include "common/MemoryBudget.h"
 
 namespace logtail {
 
@@ -54,10 +55,12 @@ public:
         mAllocatedChunks.push_back(mAllocPtr);
         mFreeBytesInChunk = mChunkSize;
         mAllocated = mChunkSize;
+        MemoryBudget::GetInstance()->Charge(mAllocated);
     }
 
     ~BufferAllocator()
     {
+        MemoryBudget::GetInstance()->Release(mAllocated);
         for(size_t i = 0 ; i < mAllocatedChunks.size() ; i++) {
             delete[] mAllocatedChunks[i];
         }
@@ -73,6 +76,7 @@ public:
         mAllocPtr = mAllocatedChunks[0];
         mChunkSize = mFirstChunkSize;
         mFreeBytesInChunk = mChunkSize;
+        MemoryBudget::GetInstance()->Release(mAllocated - mChunkSize);
         mAllocated = mChunkSize;
         mUsed = 0;
     }
@@ -117,6 +121,7 @@ private:
             mem = new uint8_t[bytes];
             mAllocatedChunks.push_back(mem);
             mAllocated += bytes;
+            MemoryBudget::GetInstance()->Charge(bytes);
         } else {
             /*
              * Here we intentionally waste some space in the current chunk.
@@ -129,6 +134,7 @@ private:
             mAllocPtr = mem + bytes;
             mFreeBytesInChunk = mChunkSize - bytes;
             mAllocated += mChunkSize;
+            MemoryBudget::GetInstance()->Charge(mChunkSize);
         }
 
         mUsed += bytes;
@@ -396,8 +396,16 @@ namespace sdk {
         string contentMd5;
         string signature;
         string osstream;
+        osstream.reserve(256);
         if (!content.empty()) {
-            contentMd5 = CalcMD5(content);
+            // Content-MD5 header is always computed from the same body by the caller, reuse it to avoid hashing
+            // the whole body twice per request.
+            map<string, string>::const_iterator md5Iter = httpHeader.find(CONTENT_MD5);
+            if (md5Iter != httpHeader.end() && !md5Iter->second.empty()) {
+                contentMd5 = md5Iter->second;
+            } else {
+                contentMd5 = CalcMD5(content);
+            }
         }
         string contentType;
         map<string, string>::iterator iter = httpHeader.find(CONTENT_TYPE);
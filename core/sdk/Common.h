@@ -358,7 +358,7 @@ namespace sdk {
               mUrl(url),
               mQueryString(queryString),
               mHeader(header),
-              mBody(body),
+              mBody(&body),
               mTimeout(timeout),
               mInterface(intf),
               mHTTPSFlag(httpsFlag),
@@ -376,7 +376,8 @@ namespace sdk {
         std::string mUrl;
         std::string mQueryString;
         std::map<std::string, std::string> mHeader;
-        std::string mBody;
+        // The body is not copied, the caller must keep it alive until the callback is invoked.
+        const std::string* mBody = NULL;
         int32_t mTimeout = 15;
         std::string mInterface;
         bool mHTTPSFlag = false;
@@ -21,6 +21,15 @@
 #include "logger/Logger.h"
 #include "app_config/AppConfig.h"
 #include "common/TimeUtil.h"
+#include "common/Flags.h"
+
+DECLARE_FLAG_BOOL(sdk_enable_http2_multiplexing);
+DEFINE_FLAG_INT32(sdk_max_host_connections,
+                  "max connections per endpoint in the async send connection pool, 0 means unlimited",
+                  0);
+DEFINE_FLAG_INT32(sdk_max_cached_connections,
+                  "max idle connections kept in the async send connection pool, 0 means curl default",
+                  0);
 
 using namespace std;
 
@@ -40,6 +49,7 @@ namespace sdk {
                           const std::string& intf,
                           const bool httpsFlag,
                           curl_slist*& headers);
+    void UpdateDnsCacheAddressStatus(CURL* curl, const std::string& host, CURLcode res);
 
 
     CurlAsynInstance::CurlAsynInstance() {
@@ -55,6 +65,20 @@ namespace sdk {
         }
     }
 
+    static void SetMultiHandlerOptions(CURLM* multi_handle) {
+        // Connections are cached by the multi handler and reused by later requests to the same endpoint, with
+        // HTTP/2 enabled, requests to one endpoint are multiplexed over a single connection when possible.
+        if (BOOL_FLAG(sdk_enable_http2_multiplexing)) {
+            curl_multi_setopt(multi_handle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        }
+        if (INT32_FLAG(sdk_max_host_connections) > 0) {
+            curl_multi_setopt(multi_handle, CURLMOPT_MAX_HOST_CONNECTIONS, (long)INT32_FLAG(sdk_max_host_connections));
+        }
+        if (INT32_FLAG(sdk_max_cached_connections) > 0) {
+            curl_multi_setopt(multi_handle, CURLMOPT_MAXCONNECTS, (long)INT32_FLAG(sdk_max_cached_connections));
+        }
+    }
+
     static bool AddRequestToMultiHandler(CURLM* multi_handle, AsynRequest* request) {
         curl_slist* headers = NULL;
         CURL* curl = PackCurlRequest(request->mHTTPMethod,
@@ -63,7 +87,7 @@ namespace sdk {
                                      request->mUrl,
                                      request->mQueryString,
                                      request->mHeader,
-                                     request->mBody,
+                                     *request->mBody,
                                      request->mTimeout,
                                      request->mCallBack->mHTTPMessage,
                                      request->mInterface,
@@ -88,6 +112,7 @@ namespace sdk {
     }
 
     static void on_handle_done(CURL* curl, curl_slist* headers, AsynRequest* request, CURLcode res) {
+        UpdateDnsCacheAddressStatus(curl, request->mHost, res);
         if (headers != NULL) {
             curl_slist_free_all(headers);
         }
@@ -185,12 +210,37 @@ namespace sdk {
         }
     }
 
+    void CurlAsynInstance::AddRequest(AsynRequest* request) {
+        mRequestQueue.push(request);
+#if LIBCURL_VERSION_NUM >= 0x074400
+        CURLM* multi_handle = mMultiHandler.load();
+        if (multi_handle != NULL) {
+            curl_multi_wakeup(multi_handle);
+        }
+#endif
+    }
+
+    int CurlAsynInstance::AddPendingRequests(CURLM* multi_handle) {
+        std::queue<AsynRequest*> requests;
+        mRequestQueue.swap_all(requests);
+        int added = 0;
+        while (!requests.empty()) {
+            if (AddRequestToMultiHandler(multi_handle, requests.front())) {
+                ++added;
+            }
+            requests.pop();
+        }
+        return added;
+    }
+
     void CurlAsynInstance::Run() {
         CURLM* multi_handle = curl_multi_init();
         if (multi_handle == NULL) {
             LOG_ERROR(sLogger, ("Init multi curl error", ""));
             return;
         }
+        SetMultiHandlerOptions(multi_handle);
+        mMultiHandler = multi_handle;
         while (true) {
             AsynRequest* request = NULL;
             if (mRequestQueue.wait_and_pop(request)) {
@@ -211,6 +261,24 @@ namespace sdk {
             curl_multi_perform(multi_handle, &still_running);
             check_multi_info(multi_handle);
 
+            int added = AddPendingRequests(multi_handle);
+            if (added > 0) {
+                still_running += added;
+                continue;
+            }
+            if (still_running == 0) {
+                break;
+            }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+            // Blocks until a transfer is ready or AddRequest wakes us up, so new requests never wait for
+            // the poll timeout.
+            CURLMcode pc = curl_multi_poll(multi_handle, NULL, 0, 1000, NULL);
+            if (pc != CURLM_OK) {
+                LOG_ERROR(sLogger, ("curl_multi_poll failed, code", pc));
+                break;
+            }
+#else
             struct timeval timeout;
             int rc; /* select() return code */
             CURLMcode mc; /* curl_multi_fdset() return code */
@@ -252,13 +320,6 @@ namespace sdk {
            no fds ready yet so we call select(0, ...) --or Sleep() on Windows--
            to sleep 100ms, which is the minimum suggested value in the
            curl_multi_fdset() doc. */
-            AsynRequest* request = NULL;
-            if (mRequestQueue.try_pop(request)) {
-                if (AddRequestToMultiHandler(multi_handle, request)) {
-                    ++still_running;
-                    continue;
-                }
-            }
             if (maxfd == -1) {
 #ifdef _WIN32
                 Sleep(100);
@@ -285,6 +346,7 @@ namespace sdk {
                     needRead = true; */
                     break;
             }
+#endif
         }
         return true;
     }
@@ -17,6 +17,7 @@
 #pragma once
 #include "Common.h"
 #include <queue>
+#include <atomic>
 #include <boost/thread.hpp>
 #include <curl/curl.h>
 
@@ -56,6 +57,12 @@ namespace sdk {
                 return the_queue.empty();
             }
 
+            // swap_all moves all pending items out with a single lock acquisition.
+            void swap_all(std::queue<Data>& popped_values) {
+                boost::mutex::scoped_lock lock(the_mutex);
+                the_queue.swap(popped_values);
+            }
+
             bool try_pop(Data& popped_value) {
                 boost::mutex::scoped_lock lock(the_mutex);
                 if (the_queue.empty()) {
@@ -82,15 +89,20 @@ namespace sdk {
             }
         };
 
-        void AddRequest(AsynRequest* request) { mRequestQueue.push(request); }
+        void AddRequest(AsynRequest* request);
 
         void Run();
 
         bool MultiHandlerLoop(CURLM* multiHandler);
 
     private:
+        // Moves all queued requests into the multi handler, returns the number of requests added.
+        int AddPendingRequests(CURLM* multiHandler);
+
         RequestQueue<AsynRequest*> mRequestQueue;
         std::vector<boost::thread*> mMainThreads;
+        // Multi handler owned by the running thread, used to wake up curl_multi_poll when new requests arrive.
+        std::atomic<CURLM*> mMultiHandler{NULL};
     };
 
 } // namespace sdk
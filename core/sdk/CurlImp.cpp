@@ -17,7 +17,13 @@
 #include "CurlAsynInstance.h"
 #include "DNSCache.h"
 #include "app_config/AppConfig.h"
+#include "common/Flags.h"
 #include <curl/curl.h>
+#include <algorithm>
+
+DEFINE_FLAG_BOOL(sdk_enable_http2_multiplexing,
+                 "negotiate HTTP/2 over https and multiplex requests to the same endpoint on one connection",
+                 true);
 
 using namespace std;
 
@@ -73,6 +79,21 @@ namespace sdk {
         return sizes;
     }
 
+    void UpdateDnsCacheAddressStatus(CURL* curl, const std::string& host, CURLcode res) {
+        if (!AppConfig::GetInstance()->IsHostIPReplacePolicyEnabled()) {
+            return;
+        }
+        char* ip = NULL;
+        if (curl_easy_getinfo(curl, CURLINFO_PRIMARY_IP, &ip) != CURLE_OK || ip == NULL || ip[0] == '\0') {
+            return;
+        }
+        double connectTime = 0.0;
+        curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME, &connectTime);
+        uint32_t latencyMs = connectTime > 0.0 ? std::max<uint32_t>((uint32_t)(connectTime * 1000), 1) : 0;
+        bool success = res != CURLE_COULDNT_CONNECT && !(res == CURLE_OPERATION_TIMEDOUT && connectTime == 0.0);
+        DnsCache::GetInstance()->UpdateAddressStatus(host, ip, latencyMs, success);
+    }
+
     CURL* PackCurlRequest(const std::string& httpMethod,
                           const std::string& host,
                           const int32_t port,
@@ -120,10 +141,18 @@ namespace sdk {
         curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1);
         curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1);
         curl_easy_setopt(curl, CURLOPT_NETRC, CURL_NETRC_IGNORED);
+        // Keep pooled connections alive between bursts so that they can be reused.
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
 
         if (httpsFlag) {
             curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
             curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+            if (BOOL_FLAG(sdk_enable_http2_multiplexing)) {
+                // Falls back to HTTP/1.1 if the server or libcurl does not support HTTP/2.
+                curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+                // Prefer waiting for an existing connection to multiplex on rather than opening a new one.
+                curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+            }
         }
         curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout);
         if (!intf.empty()) {
@@ -156,6 +185,7 @@ namespace sdk {
         }
 
         CURLcode res = curl_easy_perform(curl);
+        UpdateDnsCacheAddressStatus(curl, host, res);
         if (headers != NULL) {
             curl_slist_free_all(headers);
         }
@@ -13,98 +13,270 @@
 // limitations under the License.
 
 #include "DNSCache.h"
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #if defined(__linux__)
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <sys/socket.h>
 #elif defined(_MSC_VER)
 #include <WinSock2.h>
 #include <ws2tcpip.h>
 #endif
+#include "common/Flags.h"
+#include "logger/Logger.h"
+
+DEFINE_FLAG_INT32(dns_cache_ttl_sec, "ttl of resolved hosts when the resolver does not give one", 60);
+DEFINE_FLAG_INT32(dns_cache_negative_ttl_sec, "interval to retry resolving a host after failure", 5);
+DEFINE_FLAG_INT32(dns_cache_address_fail_cooldown_sec,
+                  "an address which failed to connect is not selected within this interval if others are available",
+                  30);
+DEFINE_FLAG_INT32(dns_cache_idle_timeout_sec, "hosts not looked up within this interval are removed", 1800);
 
 namespace logtail {
 namespace sdk {
 
-    // ParseHost only supports IPv4 now.
-    bool DnsCache::ParseHost(const char* host, std::string& ip) {
-#if defined(__linux__)
-        struct sockaddr_in addr;
-        memset(&addr, 0, sizeof(addr));
-        addr.sin_family = AF_INET;
-
-        char* buffer = NULL;
-        if (host && host[0]) {
-            if (IsRawIp(host)) {
-                if ((addr.sin_addr.s_addr = inet_addr(host)) == INADDR_NONE)
-                    return false;
+    DnsCache::DnsCache(const Resolver& resolver, bool startThread) : mResolver(resolver) {
+        if (startThread) {
+            mResolveThread = std::thread(&DnsCache::Run, this);
+        }
+    }
+
+    DnsCache::~DnsCache() {
+        {
+            std::lock_guard<std::mutex> lock(mDnsCacheLock);
+            mStopFlag = true;
+        }
+        mCond.notify_all();
+        if (mResolveThread.joinable()) {
+            mResolveThread.join();
+        }
+    }
+
+    void DnsCache::SetResolver(const Resolver& resolver) {
+        std::lock_guard<std::mutex> lock(mDnsCacheLock);
+        mResolver = resolver;
+    }
+
+    bool DnsCache::GetAddress(const std::string& host, std::string& address, int32_t now) {
+        if (host.empty()) {
+            return false;
+        }
+        if (IsRawIp(host.c_str())) {
+            address = host;
+            return true;
+        }
+        bool scheduled = false;
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(mDnsCacheLock);
+            HostEntry& entry = mDnsCacheData[host];
+            entry.mLastAccessTime = now;
+            if (entry.mExpireTime <= now && !entry.mResolving) {
+                entry.mResolving = true;
+                mPendingHosts.push_back(host);
+                scheduled = true;
+            }
+            found = SelectAddress(entry, now, address);
+        }
+        if (scheduled) {
+            mCond.notify_one();
+        }
+        return found;
+    }
+
+    bool DnsCache::UpdateHostInDnsCache(const std::string& host, std::string& address) {
+        if (host.empty()) {
+            return false;
+        }
+        if (IsRawIp(host.c_str())) {
+            address = host;
+            return true;
+        }
+        Resolver resolver;
+        {
+            std::lock_guard<std::mutex> lock(mDnsCacheLock);
+            resolver = mResolver;
+        }
+        std::vector<std::string> addresses;
+        int32_t ttlSec = 0;
+        bool success = resolver(host, addresses, ttlSec);
+        int32_t now = time(NULL);
+        UpdateEntry(host, success, addresses, ttlSec, now);
+        if (!success) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mDnsCacheLock);
+        return SelectAddress(mDnsCacheData[host], now, address);
+    }
+
+    void DnsCache::UpdateAddressStatus(
+        const std::string& host, const std::string& address, uint32_t latencyMs, bool success, int32_t now) {
+        std::lock_guard<std::mutex> lock(mDnsCacheLock);
+        auto iter = mDnsCacheData.find(host);
+        if (iter == mDnsCacheData.end()) {
+            return;
+        }
+        for (auto& info : iter->second.mAddresses) {
+            if (info.mAddress != address) {
+                continue;
+            }
+            if (success) {
+                info.mFailCount = 0;
+                // Reused connections carry no connect latency sample.
+                if (latencyMs > 0) {
+                    info.mLatencyMs
+                        = info.mLatencyMs == 0.0 ? latencyMs : info.mLatencyMs + (latencyMs - info.mLatencyMs) / 4.0;
+                }
             } else {
-                int bufferLen = 2048;
-                int rc, res;
-                struct hostent* hp = NULL;
-                struct hostent h;
-                while (true) {
-                    buffer = new char[bufferLen];
-                    res = gethostbyname_r(host, &h, buffer, bufferLen, &hp, &rc);
-                    if (res == ERANGE) {
-                        if (buffer != NULL)
-                            delete[] buffer;
-                        bufferLen *= 4;
-                        if (bufferLen > 32768) // 32KB
-                            return false;
-                        continue;
-                    }
-                    if (res != 0 || hp == NULL || hp->h_addr == NULL) {
-                        if (buffer != NULL)
-                            delete[] buffer;
-                        return false;
-                    } else
-                        break;
+                ++info.mFailCount;
+                info.mLastFailTime = now;
+            }
+            return;
+        }
+    }
+
+    bool DnsCache::SelectAddress(const HostEntry& entry, int32_t now, std::string& address) const {
+        // Addresses without latency samples rank first so that every address gets probed.
+        const AddressInfo* best = NULL;
+        const AddressInfo* bestFailed = NULL;
+        for (const auto& info : entry.mAddresses) {
+            if (info.mFailCount > 0 && now - info.mLastFailTime < INT32_FLAG(dns_cache_address_fail_cooldown_sec)) {
+                if (bestFailed == NULL || info.mFailCount < bestFailed->mFailCount) {
+                    bestFailed = &info;
                 }
-                addr.sin_addr.s_addr = *((in_addr_t*)(hp->h_addr));
+                continue;
+            }
+            if (best == NULL || info.mLatencyMs < best->mLatencyMs) {
+                best = &info;
             }
-        } else {
-            addr.sin_addr.s_addr = htonl(INADDR_ANY);
         }
-        ip = inet_ntoa(addr.sin_addr);
-        if (buffer != NULL)
-            delete[] buffer;
+        if (best == NULL) {
+            best = bestFailed;
+        }
+        if (best == NULL) {
+            return false;
+        }
+        address = best->mAddress;
         return true;
-#elif defined(_MSC_VER)
-        struct sockaddr_in addr;
-        memset(&addr, 0, sizeof(addr));
-        addr.sin_family = AF_INET;
-        if (host && host[0]) {
-            if (IsRawIp(host)) {
-                if ((addr.sin_addr.s_addr = inet_addr(host)) == INADDR_NONE)
-                    return false;
+    }
+
+    void DnsCache::UpdateEntry(const std::string& host,
+                               bool success,
+                               const std::vector<std::string>& addresses,
+                               int32_t ttlSec,
+                               int32_t now) {
+        std::lock_guard<std::mutex> lock(mDnsCacheLock);
+        HostEntry& entry = mDnsCacheData[host];
+        entry.mResolving = false;
+        if (!success || addresses.empty()) {
+            // Keep serving the last known addresses, they are more likely to work than the host name.
+            entry.mExpireTime = now + INT32_FLAG(dns_cache_negative_ttl_sec);
+            LOG_WARNING(sLogger, ("resolve host failed", host)("cached addresses", entry.mAddresses.size()));
+            return;
+        }
+        std::vector<AddressInfo> infos;
+        infos.reserve(addresses.size());
+        for (const auto& address : addresses) {
+            auto iter = std::find_if(entry.mAddresses.begin(),
+                                     entry.mAddresses.end(),
+                                     [&address](const AddressInfo& info) { return info.mAddress == address; });
+            if (iter != entry.mAddresses.end()) {
+                infos.push_back(*iter);
             } else {
-                addrinfo hints;
-                struct addrinfo* result = NULL;
-                std::memset(&hints, 0, sizeof(hints));
-                auto ret = ::getaddrinfo(host, NULL, &hints, &result);
-                if (ret != 0) {
-                    return false;
+                AddressInfo info;
+                info.mAddress = address;
+                infos.push_back(info);
+            }
+        }
+        entry.mAddresses.swap(infos);
+        entry.mExpireTime = now + (ttlSec > 0 ? ttlSec : INT32_FLAG(dns_cache_ttl_sec));
+    }
+
+    size_t DnsCache::ProcessPendingHosts(int32_t now) {
+        size_t count = 0;
+        while (true) {
+            std::string host;
+            Resolver resolver;
+            {
+                std::lock_guard<std::mutex> lock(mDnsCacheLock);
+                if (mPendingHosts.empty() || mStopFlag) {
+                    break;
                 }
+                host = mPendingHosts.front();
+                mPendingHosts.pop_front();
+                resolver = mResolver;
+            }
+            std::vector<std::string> addresses;
+            int32_t ttlSec = 0;
+            bool success = resolver(host, addresses, ttlSec);
+            UpdateEntry(host, success, addresses, ttlSec, now);
+            ++count;
+        }
+        return count;
+    }
 
-                bool found = false;
-                for (auto ptr = result; ptr != NULL; ptr = ptr->ai_next) {
-                    if (AF_INET == ptr->ai_family) {
-                        addr.sin_addr = ((struct sockaddr_in*)ptr->ai_addr)->sin_addr;
-                        found = true;
-                        break;
-                    }
+    void DnsCache::RemoveIdleEntries(int32_t now) {
+        std::lock_guard<std::mutex> lock(mDnsCacheLock);
+        if (now - mLastCleanupTime < 60) {
+            return;
+        }
+        mLastCleanupTime = now;
+        for (auto iter = mDnsCacheData.begin(); iter != mDnsCacheData.end();) {
+            if (!iter->second.mResolving
+                && now - iter->second.mLastAccessTime > INT32_FLAG(dns_cache_idle_timeout_sec)) {
+                iter = mDnsCacheData.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    void DnsCache::Run() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mDnsCacheLock);
+                mCond.wait_for(lock, std::chrono::seconds(60), [this]() {
+                    return mStopFlag || !mPendingHosts.empty();
+                });
+                if (mStopFlag) {
+                    break;
                 }
-                freeaddrinfo(result);
-                if (!found)
-                    return false;
             }
-        } else {
-            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+            ProcessPendingHosts(time(NULL));
+            RemoveIdleEntries(time(NULL));
         }
-        ip = inet_ntoa(addr.sin_addr);
-        return true;
-#endif
+    }
+
+    // SystemResolve only supports IPv4 now, the TTL is not exposed by getaddrinfo so the default one is used.
+    bool DnsCache::SystemResolve(const std::string& host, std::vector<std::string>& addresses, int32_t& ttlSec) {
+        ttlSec = 0;
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = NULL;
+        if (::getaddrinfo(host.c_str(), NULL, &hints, &result) != 0) {
+            return false;
+        }
+        char buffer[INET_ADDRSTRLEN];
+        for (addrinfo* ptr = result; ptr != NULL; ptr = ptr->ai_next) {
+            if (ptr->ai_family != AF_INET) {
+                continue;
+            }
+            const in_addr& addr = ((sockaddr_in*)ptr->ai_addr)->sin_addr;
+            if (inet_ntop(AF_INET, (void*)&addr, buffer, sizeof(buffer)) == NULL) {
+                continue;
+            }
+            std::string address(buffer);
+            if (std::find(addresses.begin(), addresses.end(), address) == addresses.end()) {
+                addresses.push_back(address);
+            }
+        }
+        freeaddrinfo(result);
+        return !addresses.empty();
     }
 
 } // namespace sdk
-} // namespace logtail
\ No newline at end of file
+} // namespace logtail
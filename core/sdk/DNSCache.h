@@ -17,69 +17,72 @@
 #pragma once
 #include <ctime>
 #include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
-#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace logtail {
 namespace sdk {
 
+    // DnsCache resolves hosts in a background thread so that lookups from the send path never block on DNS.
+    // - Positive answers are kept for their TTL, failures are cached for a shorter negative TTL.
+    // - Expired entries keep serving their last addresses until the refresh finishes.
+    // - A host may have several addresses. The one with the lowest connect latency reported by
+    //   UpdateAddressStatus is returned, and addresses which failed recently are skipped.
     class DnsCache {
-        int32_t mUpdateTime;
-        int32_t mDnsTTL;
-        std::mutex mDnsCacheLock;
-        std::map<std::string, std::pair<std::string, int32_t>> mDnsCacheData;
-
     public:
+        // Resolver returns all addresses of host and the TTL of the answer, ttlSec <= 0 means the default TTL.
+        typedef std::function<bool(const std::string& host, std::vector<std::string>& addresses, int32_t& ttlSec)>
+            Resolver;
+
         static DnsCache* GetInstance() {
-            static DnsCache singleton;
+            static DnsCache singleton(&DnsCache::SystemResolve, true);
             return &singleton;
         }
 
-        bool UpdateHostInDnsCache(const std::string& host, std::string& address) {
-            int32_t currentTime = time(NULL);
-            bool status = false;
-            std::lock_guard<std::mutex> lock(mDnsCacheLock);
-
-            auto itr = mDnsCacheData.find(host);
-            if (itr == mDnsCacheData.end() || currentTime - (itr->second).second >= 3) {
-                if (ParseHost(host.c_str(), address)) {
-                    status = true;
-                    mDnsCacheData[host] = std::make_pair(address, currentTime);
-                } else {
-                    if (itr == mDnsCacheData.end()) {
-                        mDnsCacheData[host] = std::make_pair(host, currentTime);
-                    } else {
-                        mDnsCacheData[host] = std::make_pair((itr->second).first, currentTime);
-                    }
-                }
-            }
-
-            return status;
+        // GetIPFromDnsCache never blocks: if host is not resolved yet or its entry is expired, a refresh is
+        // scheduled, and false is returned when no address is known yet so that the caller uses host itself.
+        bool GetIPFromDnsCache(const std::string& host, std::string& address) {
+            return GetAddress(host, address, time(NULL));
         }
 
-        bool GetIPFromDnsCache(const std::string& host, std::string& address) {
-            bool found = false;
-            {
-                std::lock_guard<std::mutex> lock(mDnsCacheLock);
-                if (!RemoveTimeOutDnsCache()) // not time out
-                {
-                    auto itr = mDnsCacheData.find(host);
-                    if (itr != mDnsCacheData.end()) {
-                        address = (itr->second).first;
-                        found = true;
-                    }
-                }
-            }
-            if (!found) // time out or not found
-                return UpdateHostInDnsCache(host, address);
-            return found;
+        // UpdateHostInDnsCache resolves host synchronously and updates the cache, only for callers out of the
+        // send path which need the answer immediately.
+        bool UpdateHostInDnsCache(const std::string& host, std::string& address);
+
+        // UpdateAddressStatus feeds the result of a connection to address back to the cache for address ranking,
+        // latencyMs is the connect latency and 0 if the connection was reused.
+        void
+        UpdateAddressStatus(const std::string& host, const std::string& address, uint32_t latencyMs, bool success) {
+            UpdateAddressStatus(host, address, latencyMs, success, time(NULL));
         }
 
+        void SetResolver(const Resolver& resolver);
+
     private:
-        DnsCache(const int32_t ttlSeconds = 60 * 10) : mUpdateTime(time(NULL)), mDnsTTL(ttlSeconds) {}
-        ~DnsCache() = default;
+        struct AddressInfo {
+            std::string mAddress;
+            double mLatencyMs = 0.0;
+            uint32_t mFailCount = 0;
+            int32_t mLastFailTime = 0;
+        };
+
+        struct HostEntry {
+            std::vector<AddressInfo> mAddresses;
+            int32_t mExpireTime = 0;
+            int32_t mLastAccessTime = 0;
+            bool mResolving = false;
+        };
 
-        bool IsRawIp(const char* host) {
+        DnsCache(const Resolver& resolver, bool startThread);
+        ~DnsCache();
+
+        static bool IsRawIp(const char* host) {
             unsigned char c, *p;
             p = (unsigned char*)host;
             while ((c = (*p++)) != '\0') {
@@ -89,19 +92,35 @@ namespace sdk {
             return true;
         }
 
-        bool ParseHost(const char* host, std::string& ip);
+        static bool SystemResolve(const std::string& host, std::vector<std::string>& addresses, int32_t& ttlSec);
 
-        bool RemoveTimeOutDnsCache() {
-            int32_t currentTime = time(NULL);
-            bool isTimeOut = false;
-            if (currentTime - mUpdateTime >= mDnsTTL) {
-                isTimeOut = true;
-                mDnsCacheData.clear();
-                mUpdateTime = currentTime;
-            }
-            return isTimeOut;
-        }
+        bool GetAddress(const std::string& host, std::string& address, int32_t now);
+        void UpdateAddressStatus(
+            const std::string& host, const std::string& address, uint32_t latencyMs, bool success, int32_t now);
+        // Resolves all scheduled hosts, returns the number of hosts resolved.
+        size_t ProcessPendingHosts(int32_t now);
+        void UpdateEntry(const std::string& host,
+                         bool success,
+                         const std::vector<std::string>& addresses,
+                         int32_t ttlSec,
+                         int32_t now);
+        void RemoveIdleEntries(int32_t now);
+        bool SelectAddress(const HostEntry& entry, int32_t now, std::string& address) const;
+        void Run();
+
+        std::mutex mDnsCacheLock;
+        std::condition_variable mCond;
+        std::unordered_map<std::string, HostEntry> mDnsCacheData;
+        std::deque<std::string> mPendingHosts;
+        int32_t mLastCleanupTime = 0;
+        Resolver mResolver;
+        bool mStopFlag = false;
+        std::thread mResolveThread;
+
+#ifdef APSARA_UNIT_TEST_MAIN
+        friend class DnsCacheUnittest;
+#endif
     };
 
 } // namespace sdk
-} // namespace logtail
\ No newline at end of file
+} // namespace logtail
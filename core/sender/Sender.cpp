@@ -25,6 +25,7 @@
 #endif
 #include "app_config/AppConfig.h"
 #include "application/Application.h"
+#include "checkpoint/CheckpointManagerV2.h"
 #include "common/CompressTools.h"
 #include "common/Constants.h"
 #include "common/EndpointUtil.h"
@@ -47,6 +48,7 @@
 #include "monitor/LogLineCount.h"
 #include "monitor/LogtailAlarm.h"
 #include "monitor/Monitor.h"
+#include "monitor/SamplingProfiler.h"
 #include "processor/daemon/LogProcess.h"
 #include "sdk/Client.h"
 #include "sdk/Exception.h"
@@ -106,6 +108,7 @@ DEFINE_FLAG_INT32(log_expire_time, "log expire time", 24 * 3600);
 
 DECLARE_FLAG_STRING(default_access_key_id);
 DECLARE_FLAG_STRING(default_access_key);
+DECLARE_FLAG_BOOL(enable_adaptive_send_concurrency);
 
 namespace logtail {
 const string Sender::BUFFER_FILE_NAME_PREFIX = "logtail_buffer_file_";
@@ -694,6 +697,8 @@ bool Sender::Init(void) {
     mFlushLog = false;
     mBufferDivideTime = time(NULL);
     mCheckPeriod = INT32_FLAG(buffer_check_period);
+    // exactly once data waits for its checkpoint to be committed before sending
+    CheckpointManagerV2::SetCommitListener([this]() { mSenderQueue.Signal(); });
     mSendBufferThreadId = CreateThread([this]() { DaemonBufferSender(); });
     mSendLastTime[0] = 0;
     mSendLastTime[1] = 0;
@@ -763,6 +768,21 @@ void Sender::SetFeedBackInterface(LogstoreFeedBackInterface* pProcessInterface)
 }
 
 void Sender::OnSendDone(LoggroupTimeValue* mDataPtr, LogstoreSenderInfo::SendResult sendRst) {
+    if (BOOL_FLAG(enable_adaptive_send_concurrency) && mDataPtr != NULL) {
+        PTScopedLock lock(mRegionEndpointEntryMapLock);
+        auto iter = mRegionEndpointEntryMap.find(mDataPtr->mRegion);
+        if (iter != mRegionEndpointEntryMap.end()) {
+            auto& limiter = iter->second->mConcurrencyLimiter;
+            // Network and server errors have been reported by ResetRegionConcurrency already.
+            if (sendRst == LogstoreSenderInfo::SendResult_OK && mDataPtr->mLastSendTimeInMs > 0) {
+                uint64_t nowMs = GetCurrentTimeInMilliSeconds();
+                limiter.OnSuccess(nowMs > mDataPtr->mLastSendTimeInMs ? nowMs - mDataPtr->mLastSendTimeInMs : 0,
+                                  nowMs);
+            } else {
+                limiter.OnRelease();
+            }
+        }
+    }
     mSenderQueue.OnLoggroupSendDone(mDataPtr, sendRst);
 }
 
@@ -1076,6 +1096,7 @@ bool Sender::ReadNextEncryption(int32_t& pos,
 }
 
 void Sender::DaemonBufferSender() {
+    SamplingProfiler::SetThreadRole("sender_buffer");
     mBufferSenderThreadIsRunning = true;
     LOG_DEBUG(sLogger, ("SendBufferThread", "start"));
     while (mBufferSenderThreadIsRunning) {
@@ -1393,6 +1414,7 @@ bool Sender::IsSecondaryBufferEmpty() {
 }
 
 void Sender::DaemonSender() {
+    SamplingProfiler::SetThreadRole("sender");
     LOG_INFO(sLogger, ("SendThread", "start"));
     int32_t lastUpdateMetricTime = time(NULL);
     int32_t sendBufferCount = 0;
@@ -1416,11 +1438,23 @@ void Sender::DaemonSender() {
             {
                 PTScopedLock lock(mRegionEndpointEntryMapLock);
                 for (auto iter = mRegionEndpointEntryMap.begin(); iter != mRegionEndpointEntryMap.end(); ++iter) {
-                    regionConcurrencyLimits.insert(std::make_pair(iter->first, iter->second->mConcurrency));
+                    int32_t limit = BOOL_FLAG(enable_adaptive_send_concurrency)
+                        ? (int32_t)iter->second->mConcurrencyLimiter.GetQuota()
+                        : iter->second->mConcurrency;
+                    regionConcurrencyLimits.insert(std::make_pair(iter->first, limit));
                 }
             }
 
             mSenderQueue.CheckAndPopAllItem(logGroupToSend, curTime, singleBatchMapFull, regionConcurrencyLimits);
+            if (BOOL_FLAG(enable_adaptive_send_concurrency) && !logGroupToSend.empty()) {
+                PTScopedLock lock(mRegionEndpointEntryMapLock);
+                for (auto data : logGroupToSend) {
+                    auto iter = mRegionEndpointEntryMap.find(data->mRegion);
+                    if (iter != mRegionEndpointEntryMap.end()) {
+                        iter->second->mConcurrencyLimiter.OnSend();
+                    }
+                }
+            }
 
 #ifdef LOGTAIL_DEBUG_FLAG
             if (logGroupToSend.size() > 0) {
@@ -1476,6 +1510,9 @@ void Sender::DaemonSender() {
             // Collect at most 15 stats, similar to Linux load 1,5,15.
             static SlidingWindowCounter sNetErrCounter = CreateLoadCounter();
             sMonitor->UpdateMetric("net_err_stat", sNetErrCounter.Add(gNetworkErrorCount.exchange(0)));
+            if (BOOL_FLAG(enable_adaptive_send_concurrency)) {
+                sMonitor->UpdateMetric("region_send_concurrency", GetRegionConcurrencyStatus());
+            }
         }
 
         ///////////////////////////////////////
@@ -1788,7 +1825,7 @@ void Sender::AddEndpointEntry(const std::string& region, const std::string& endp
     std::unordered_map<std::string, RegionEndpointEntry*>::iterator iter = mRegionEndpointEntryMap.find(region);
     RegionEndpointEntry* entryPtr;
     if (iter == mRegionEndpointEntryMap.end()) {
-        entryPtr = new RegionEndpointEntry();
+        entryPtr = new RegionEndpointEntry(AppConfig::GetInstance()->GetSendRequestConcurrency());
         mRegionEndpointEntryMap.insert(std::make_pair(region, entryPtr));
         // if (!isDefault && region.size() > 2) {
         //     string possibleMainRegion = region.substr(0, region.size() - 2);
@@ -2123,6 +2160,7 @@ void Sender::SendToNetAsync(LoggroupTimeValue* dataPtr) {
 
     SendClosure* sendClosure = new SendClosure;
     dataPtr->mLastSendTime = curTime;
+    dataPtr->mLastSendTimeInMs = GetCurrentTimeInMilliSeconds();
     sendClosure->mDataPtr = dataPtr;
     LOG_DEBUG(sLogger,
               ("region", dataPtr->mRegion)("endpoint", dataPtr->mCurrentEndpoint)("project", dataPtr->mProjectName)(
@@ -2522,7 +2560,8 @@ void Sender::IncreaseRegionConcurrency(const std::string& region) {
 
     auto regionInfo = iter->second;
     regionInfo->mContinuousErrorCount = 0;
-    if (-1 == regionInfo->mConcurrency)
+    // Adaptive limiter is increased in OnSendDone where the rtt is known.
+    if (BOOL_FLAG(enable_adaptive_send_concurrency) || -1 == regionInfo->mConcurrency)
         return;
     if (++regionInfo->mConcurrency >= AppConfig::GetInstance()->GetSendRequestConcurrency()) {
         LOG_INFO(sLogger, ("Set region concurrency to unlimited", region));
@@ -2537,6 +2576,10 @@ void Sender::ResetRegionConcurrency(const std::string& region) {
         return;
 
     auto regionInfo = iter->second;
+    if (BOOL_FLAG(enable_adaptive_send_concurrency)) {
+        regionInfo->mConcurrencyLimiter.OnCongestion(GetCurrentTimeInMilliSeconds());
+        return;
+    }
     if (++regionInfo->mContinuousErrorCount >= INT32_FLAG(reset_region_concurrency_error_count)) {
         auto oldConcurrency = regionInfo->mConcurrency;
         regionInfo->mConcurrency
@@ -2551,6 +2594,26 @@ void Sender::ResetRegionConcurrency(const std::string& region) {
     }
 }
 
+std::string Sender::GetRegionConcurrencyStatus() {
+    std::string status;
+    PTScopedLock lock(mRegionEndpointEntryMapLock);
+    for (auto iter = mRegionEndpointEntryMap.begin(); iter != mRegionEndpointEntryMap.end(); ++iter) {
+        const auto& limiter = iter->second->mConcurrencyLimiter;
+        if (!status.empty()) {
+            status.append(",");
+        }
+        status.append(iter->first)
+            .append(":")
+            .append(ToString(limiter.GetInFlight()))
+            .append("/")
+            .append(ToString(limiter.GetLimit()))
+            .append("/")
+            .append(ToString(limiter.GetSmoothedRtt()))
+            .append("ms");
+    }
+    return status;
+}
+
 bool Sender::FlushOut(int32_t time_interval_in_mili_seconds) {
     static Aggregator* aggregator = Aggregator::GetInstance();
     aggregator->FlushReadyBuffer();
@@ -2682,6 +2745,10 @@ void Sender::SetLogstoreFlowControl(const LogstoreFeedBackKey& logstoreKey,
     mSenderQueue.SetLogstoreFlowControl(logstoreKey, maxSendBytesPerSecond, expireTime);
 }
 
+void Sender::SetLogstoreWeight(const LogstoreFeedBackKey& logstoreKey, uint32_t weight) {
+    mSenderQueue.SetLogstoreWeight(logstoreKey, weight);
+}
+
 
 SlsClientInfo::SlsClientInfo(sdk::Client* client, int32_t updateTime) {
     sendClient = client;
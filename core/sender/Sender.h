@@ -71,8 +71,11 @@ struct RegionEndpointEntry {
     int32_t mConcurrency = -1;
     // To avoid occasional error.
     int32_t mContinuousErrorCount = 0;
+    // Limits in-flight requests of region instead of mConcurrency when enable_adaptive_send_concurrency is set.
+    ConcurrencyLimiter mConcurrencyLimiter;
 
-    RegionEndpointEntry() {
+    explicit RegionEndpointEntry(uint32_t maxConcurrency)
+        : mConcurrencyLimiter(1, maxConcurrency, maxConcurrency) {
         mDefaultEndpoint.clear();
         mEndpointDetailMap.clear();
     }
@@ -450,6 +453,8 @@ public:
 
     void IncreaseRegionConcurrency(const std::string& region);
     void ResetRegionConcurrency(const std::string& region);
+    // Returns "region:inflight/limit/srtt" of all regions, used by monitor.
+    std::string GetRegionConcurrencyStatus();
 
     int32_t GetSendingBufferCount();
 
@@ -467,6 +472,7 @@ public:
     LogstoreSenderStatistics GetSenderStatistics(const LogstoreFeedBackKey& key);
     void
     SetLogstoreFlowControl(const LogstoreFeedBackKey& logstoreKey, int32_t maxSendBytesPerSecond, int32_t expireTime);
+    void SetLogstoreWeight(const LogstoreFeedBackKey& logstoreKey, uint32_t weight);
     bool SendPb(const FlusherSLS* pConfig,
                 char* pbBuffer,
                 int32_t pbSize,
@@ -0,0 +1,110 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "app_config/AppConfig.h"
+#include "checkpoint/CheckPointManager.h"
+#include "common/Flags.h"
+#include "common/RuntimeUtil.h"
+#include "common/TimeUtil.h"
+#include "logger/Logger.h"
+
+DECLARE_FLAG_BOOL(enable_binary_checkpoint);
+DECLARE_FLAG_INT32(check_point_max_count);
+DECLARE_FLAG_INT32(file_check_point_time_out);
+
+using namespace std;
+
+namespace logtail {
+
+// CheckpointBenchmark compares dumping and loading file checkpoints through the json file and the checkpoint log.
+class CheckpointBenchmark {
+public:
+    static void Run(int32_t count) {
+        CheckPointManager* manager = CheckPointManager::Instance();
+        string jsonPath = GetProcessExecutionDir() + "checkpoint_benchmark.json";
+        AppConfig::GetInstance()->mCheckPointFilePath = jsonPath;
+        INT32_FLAG(check_point_max_count) = count;
+        remove(jsonPath.c_str());
+        remove((jsonPath + ".bin").c_str());
+
+        BOOL_FLAG(enable_binary_checkpoint) = false;
+        Fill(manager, count, 0);
+        uint64_t jsonDump = Measure([&]() { manager->DumpCheckPointToLocal(); });
+        manager->RemoveAllCheckPoint();
+        uint64_t jsonLoad = Measure([&]() { manager->LoadCheckPoint(); });
+        manager->RemoveAllCheckPoint();
+
+        BOOL_FLAG(enable_binary_checkpoint) = true;
+        manager->mCheckpointLog.reset();
+        remove(jsonPath.c_str());
+        Fill(manager, count, 0);
+        uint64_t binaryFullDump = Measure([&]() { manager->DumpCheckPointToLocal(); });
+        manager->RemoveAllCheckPoint();
+        // 1% of files are written between dumps
+        Fill(manager, count, 100);
+        uint64_t binaryIncrementalDump = Measure([&]() { manager->DumpCheckPointToLocal(); });
+        manager->RemoveAllCheckPoint();
+        manager->mCheckpointLog.reset();
+        uint64_t binaryLoad = Measure([&]() { manager->LoadCheckPoint(); });
+        size_t loaded = manager->GetAllFileCheckPoint().size();
+        manager->RemoveAllCheckPoint();
+        manager->mCheckpointLog.reset();
+        remove((jsonPath + ".bin").c_str());
+
+        cout << "checkpoints: " << count << endl;
+        cout << "  json dump: " << jsonDump << "ms, json load: " << jsonLoad << "ms" << endl;
+        cout << "  binary full dump: " << binaryFullDump << "ms, incremental dump: " << binaryIncrementalDump
+             << "ms, load: " << binaryLoad << "ms, loaded: " << loaded << endl;
+    }
+
+private:
+    // Fill adds checkpoints like readers dump them, every modifyStep-th one has moved forward if modifyStep > 0.
+    static void Fill(CheckPointManager* manager, int32_t count, int32_t modifyStep) {
+        int32_t now = time(NULL);
+        for (int32_t i = 0; i < count; ++i) {
+            int64_t offset = 1024 * i + (modifyStep > 0 && i % modifyStep == 0 ? 4096 : 0);
+            string fileName = "/var/lib/kubelet/pods/pod" + to_string(i / 10) + "/volumes/logs/app" + to_string(i)
+                + ".log";
+            CheckPoint* cpt = new CheckPoint(
+                fileName, offset, 1024, i, DevInode(64769, i + 1), "config" + to_string(i % 100), "", false, false, false);
+            cpt->mLastUpdateTime = now - INT32_FLAG(file_check_point_time_out) / 2;
+            manager->AddCheckPoint(cpt);
+        }
+    }
+
+    template <typename Func>
+    static uint64_t Measure(Func func) {
+        uint64_t start = GetCurrentTimeInMilliSeconds();
+        func();
+        return GetCurrentTimeInMilliSeconds() - start;
+    }
+};
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+    logtail::CheckpointBenchmark::Run(100000);
+    logtail::CheckpointBenchmark::Run(1000000);
+    return 0;
+}
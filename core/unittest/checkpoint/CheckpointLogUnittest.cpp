@@ -0,0 +1,277 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "checkpoint/CheckpointLog.h"
+#include "checkpoint/CheckPointManager.h"
+#include "common/FileSystemUtil.h"
+#include "common/Flags.h"
+#include "unittest/Unittest.h"
+
+DECLARE_FLAG_INT32(checkpoint_log_compact_ratio);
+DECLARE_FLAG_INT32(checkpoint_log_compact_min_bytes);
+DECLARE_FLAG_BOOL(enable_binary_checkpoint);
+DECLARE_FLAG_INT32(file_check_point_time_out);
+
+using namespace std;
+
+namespace logtail {
+
+class CheckpointLogUnittest : public ::testing::Test {
+public:
+    void TestDumpAndLoad();
+    void TestIncrementalDump();
+    void TestCompaction();
+    void TestTornTail();
+    void TestCheckPointManager();
+    void TestImportJson();
+
+protected:
+    static void SetUpTestCase() {
+        sRootDir = GetProcessExecutionDir() + "CheckpointLogUnittest";
+        bfs::remove_all(sRootDir);
+        bfs::create_directories(sRootDir);
+    }
+
+    static void TearDownTestCase() { bfs::remove_all(sRootDir); }
+
+    void SetUp() override {
+        mLogPath = sRootDir + PATH_SEPARATOR + "checkpoint.bin";
+        bfs::remove(mLogPath);
+    }
+
+    void Dump(CheckpointLog& log, const map<string, string>& records) {
+        log.BeginDump();
+        for (const auto& item : records) {
+            log.Put(item.first, item.second);
+        }
+        APSARA_TEST_TRUE(log.EndDump());
+    }
+
+    map<string, string> Load() {
+        CheckpointLog log(mLogPath);
+        unordered_map<string, string> records;
+        APSARA_TEST_TRUE(log.Load(records));
+        return map<string, string>(records.begin(), records.end());
+    }
+
+    static string sRootDir;
+    string mLogPath;
+};
+
+string CheckpointLogUnittest::sRootDir;
+
+UNIT_TEST_CASE(CheckpointLogUnittest, TestDumpAndLoad);
+UNIT_TEST_CASE(CheckpointLogUnittest, TestIncrementalDump);
+UNIT_TEST_CASE(CheckpointLogUnittest, TestCompaction);
+UNIT_TEST_CASE(CheckpointLogUnittest, TestTornTail);
+UNIT_TEST_CASE(CheckpointLogUnittest, TestCheckPointManager);
+UNIT_TEST_CASE(CheckpointLogUnittest, TestImportJson);
+
+void CheckpointLogUnittest::TestDumpAndLoad() {
+    CheckpointLog log(mLogPath);
+    APSARA_TEST_FALSE(log.Exists());
+    map<string, string> records = {{"a", "1"}, {"b", string("\0\1\2", 3)}, {"c", ""}};
+    Dump(log, records);
+    APSARA_TEST_TRUE(log.Exists());
+    APSARA_TEST_EQUAL(3U, log.GetLastDumpRecordCount());
+    APSARA_TEST_TRUE(records == Load());
+}
+
+void CheckpointLogUnittest::TestIncrementalDump() {
+    CheckpointLog log(mLogPath);
+    map<string, string> records = {{"a", "1"}, {"b", "2"}, {"c", "3"}};
+    Dump(log, records);
+    uint64_t size = log.GetFileSize();
+
+    // unchanged records are not written
+    Dump(log, records);
+    APSARA_TEST_EQUAL(0U, log.GetLastDumpRecordCount());
+    APSARA_TEST_EQUAL(size, log.GetFileSize());
+
+    // one update, one deletion and one insertion
+    records["a"] = "11";
+    records.erase("b");
+    records["d"] = "4";
+    Dump(log, records);
+    APSARA_TEST_EQUAL(3U, log.GetLastDumpRecordCount());
+    APSARA_TEST_TRUE(records == Load());
+
+    // the loaded log continues incrementally
+    CheckpointLog reopened(mLogPath);
+    unordered_map<string, string> loaded;
+    APSARA_TEST_TRUE(reopened.Load(loaded));
+    records["c"] = "33";
+    Dump(reopened, records);
+    APSARA_TEST_EQUAL(1U, reopened.GetLastDumpRecordCount());
+    APSARA_TEST_TRUE(records == Load());
+}
+
+void CheckpointLogUnittest::TestCompaction() {
+    int32_t minBytes = INT32_FLAG(checkpoint_log_compact_min_bytes);
+    int32_t ratio = INT32_FLAG(checkpoint_log_compact_ratio);
+    INT32_FLAG(checkpoint_log_compact_min_bytes) = 0;
+    INT32_FLAG(checkpoint_log_compact_ratio) = 2;
+
+    CheckpointLog log(mLogPath);
+    map<string, string> records = {{"a", "0"}, {"b", "0"}};
+    Dump(log, records);
+    uint64_t fullSize = log.GetFileSize();
+    for (int i = 1; i < 20; ++i) {
+        records["a"] = to_string(i % 10);
+        Dump(log, records);
+        APSARA_TEST_TRUE(log.GetFileSize() <= fullSize * 3);
+    }
+    APSARA_TEST_TRUE(records == Load());
+
+    INT32_FLAG(checkpoint_log_compact_min_bytes) = minBytes;
+    INT32_FLAG(checkpoint_log_compact_ratio) = ratio;
+}
+
+void CheckpointLogUnittest::TestTornTail() {
+    map<string, string> records = {{"a", "1"}, {"b", "2"}};
+    {
+        CheckpointLog log(mLogPath);
+        Dump(log, records);
+        map<string, string> updated = records;
+        updated["a"] = "11";
+        Dump(log, updated);
+    }
+    // crash in the middle of the last append
+    bfs::resize_file(mLogPath, bfs::file_size(mLogPath) - 1);
+    CheckpointLog log(mLogPath);
+    unordered_map<string, string> loaded;
+    APSARA_TEST_TRUE(log.Load(loaded));
+    map<string, string> sorted(loaded.begin(), loaded.end());
+    APSARA_TEST_TRUE(records == sorted);
+    // the log is rewritten instead of appended after the broken record
+    records["c"] = "3";
+    Dump(log, records);
+    APSARA_TEST_EQUAL(3U, log.GetLastDumpRecordCount());
+    APSARA_TEST_TRUE(records == Load());
+
+    // corrupted header
+    OverwriteFile(mLogPath, "not a checkpoint log");
+    CheckpointLog invalid(mLogPath);
+    APSARA_TEST_FALSE(invalid.Load(loaded));
+}
+
+void CheckpointLogUnittest::TestCheckPointManager() {
+    CheckPointManager* manager = CheckPointManager::Instance();
+    manager->RemoveAllCheckPoint();
+    manager->mCheckpointLog.reset(new CheckpointLog(mLogPath));
+
+    DevInode devInode(1, 2);
+    manager->AddCheckPoint(
+        new CheckPoint("/var/log/a.log", 100, 1024, 12345, devInode, "config", "/var/log/a.log.1", true, false, true));
+    manager->AddCheckPoint(
+        new CheckPoint("/var/log/a.log", 200, 1024, 12345, devInode, "config2", "", false, true, false));
+    manager->AddDirCheckPoint("/var/log/sub");
+    // timed out dir checkpoints are dropped on load as from the json file
+    manager->AddDirCheckPoint("/var/old/sub");
+    DirCheckPointPtr oldDir;
+    manager->GetDirCheckPoint("/var/old", oldDir);
+    oldDir->mUpdateTime = time(NULL) - INT32_FLAG(file_check_point_time_out) - 1;
+    manager->ResetLastDumpTime();
+    APSARA_TEST_TRUE(manager->DumpBinaryCheckPoint());
+    manager->RemoveAllCheckPoint();
+
+    manager->mCheckpointLog.reset(new CheckpointLog(mLogPath));
+    APSARA_TEST_TRUE(manager->LoadBinaryCheckPoint());
+    APSARA_TEST_EQUAL(2U, manager->GetAllFileCheckPoint().size());
+    CheckPointPtr cpt;
+    APSARA_TEST_TRUE(manager->GetCheckPoint(devInode, "config", cpt));
+    APSARA_TEST_EQUAL("/var/log/a.log", cpt->mFileName);
+    APSARA_TEST_EQUAL("/var/log/a.log.1", cpt->mRealFileName);
+    APSARA_TEST_EQUAL(100, cpt->mOffset);
+    APSARA_TEST_EQUAL(1024U, cpt->mSignatureSize);
+    APSARA_TEST_EQUAL(12345U, cpt->mSignatureHash);
+    APSARA_TEST_TRUE(cpt->mFileOpenFlag);
+    APSARA_TEST_FALSE(cpt->mContainerStopped);
+    APSARA_TEST_TRUE(cpt->mLastForceRead);
+    APSARA_TEST_TRUE(manager->GetCheckPoint(devInode, "config2", cpt));
+    APSARA_TEST_EQUAL(200, cpt->mOffset);
+    APSARA_TEST_TRUE(cpt->mContainerStopped);
+    DirCheckPointPtr dir;
+    APSARA_TEST_TRUE(manager->GetDirCheckPoint("/var/log", dir));
+    APSARA_TEST_EQUAL(1U, dir->mSubDir.count("/var/log/sub"));
+    APSARA_TEST_FALSE(manager->GetDirCheckPoint("/var/old", dir));
+
+    // only the changed checkpoint and the meta record are written
+    manager->GetCheckPoint(devInode, "config", cpt);
+    cpt->mOffset = 300;
+    manager->mLastDumpTime += 1;
+    APSARA_TEST_TRUE(manager->DumpBinaryCheckPoint());
+    APSARA_TEST_EQUAL(2U, manager->mCheckpointLog->GetLastDumpRecordCount());
+    manager->RemoveAllCheckPoint();
+    manager->mCheckpointLog.reset();
+}
+
+void CheckpointLogUnittest::TestImportJson() {
+    CheckPointManager* manager = CheckPointManager::Instance();
+    manager->RemoveAllCheckPoint();
+    string jsonPath = sRootDir + PATH_SEPARATOR + "checkpoint.json";
+    AppConfig::GetInstance()->mCheckPointFilePath = jsonPath;
+    manager->mCheckpointLog.reset();
+
+    DevInode devInode(1, 3);
+    manager->AddCheckPoint(new CheckPoint("/var/log/b.log", 100, 10, 1, devInode, "config", "", false, false, false));
+    BOOL_FLAG(enable_binary_checkpoint) = false;
+    APSARA_TEST_TRUE(manager->DumpCheckPointToLocal());
+    manager->RemoveAllCheckPoint();
+    APSARA_TEST_TRUE(CheckExistance(jsonPath));
+
+    // no checkpoint log yet, the json file is loaded and imported by the next dump
+    BOOL_FLAG(enable_binary_checkpoint) = true;
+    manager->LoadCheckPoint();
+    APSARA_TEST_EQUAL(1U, manager->GetAllFileCheckPoint().size());
+    APSARA_TEST_TRUE(manager->DumpCheckPointToLocal());
+    manager->RemoveAllCheckPoint();
+    APSARA_TEST_FALSE(CheckExistance(jsonPath));
+    APSARA_TEST_TRUE(CheckExistance(jsonPath + ".bin"));
+
+    manager->mCheckpointLog.reset();
+    manager->LoadCheckPoint();
+    CheckPointPtr cpt;
+    APSARA_TEST_TRUE(manager->GetCheckPoint(devInode, "config", cpt));
+    APSARA_TEST_EQUAL(100, cpt->mOffset);
+
+    // turning the flag off loads the log, and the next dump exports it back to the json file
+    cpt->mOffset = 200;
+    APSARA_TEST_TRUE(manager->DumpCheckPointToLocal());
+    manager->RemoveAllCheckPoint();
+    BOOL_FLAG(enable_binary_checkpoint) = false;
+    manager->mCheckpointLog.reset();
+    manager->LoadCheckPoint();
+    APSARA_TEST_TRUE(manager->GetCheckPoint(devInode, "config", cpt));
+    APSARA_TEST_EQUAL(200, cpt->mOffset);
+    APSARA_TEST_TRUE(manager->DumpCheckPointToLocal());
+    APSARA_TEST_TRUE(CheckExistance(jsonPath));
+    APSARA_TEST_FALSE(CheckExistance(jsonPath + ".bin"));
+    manager->RemoveAllCheckPoint();
+    manager->LoadCheckPoint();
+    APSARA_TEST_TRUE(manager->GetCheckPoint(devInode, "config", cpt));
+    APSARA_TEST_EQUAL(200, cpt->mOffset);
+    manager->RemoveAllCheckPoint();
+    manager->mCheckpointLog.reset();
+    remove(jsonPath.c_str());
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
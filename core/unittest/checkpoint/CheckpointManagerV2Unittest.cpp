@@ -21,6 +21,7 @@
 DECLARE_FLAG_INT32(logtail_checkpoint_check_gc_interval_sec);
 DECLARE_FLAG_INT32(logtail_checkpoint_expired_threshold_sec);
 DECLARE_FLAG_INT32(logtail_checkpoint_gc_threshold_sec);
+DECLARE_FLAG_INT32(logtail_checkpoint_group_commit_window_ms);
 
 namespace logtail {
 
@@ -54,6 +55,8 @@ public:
     void TestExtractPrimaryKeyFromRangeKey();
 
     void TestMarkGC();
+
+    void TestGroupCommit();
 };
 
 UNIT_TEST_CASE(CheckpointManagerV2Unittest, TestBaseMethod);
@@ -61,6 +64,7 @@ UNIT_TEST_CASE(CheckpointManagerV2Unittest, TestProtobufMethod);
 UNIT_TEST_CASE(CheckpointManagerV2Unittest, TestScanCheckpoints);
 UNIT_TEST_CASE(CheckpointManagerV2Unittest, TestExtractPrimaryKeyFromRangeKey);
 UNIT_TEST_CASE(CheckpointManagerV2Unittest, TestMarkGC);
+UNIT_TEST_CASE(CheckpointManagerV2Unittest, TestGroupCommit);
 
 void CheckpointManagerV2Unittest::TestBaseMethod() {
     CheckpointManagerV2 m;
@@ -342,6 +346,55 @@ void CheckpointManagerV2Unittest::TestMarkGC() {
     }
 }
 
+void CheckpointManagerV2Unittest::TestGroupCommit() {
+    auto bakWindow = INT32_FLAG(logtail_checkpoint_group_commit_window_ms);
+    // long enough to check buffered writes before the commit thread runs
+    INT32_FLAG(logtail_checkpoint_group_commit_window_ms) = 60 * 1000;
+    {
+        CheckpointManagerV2 m;
+        m.rebuild();
+
+        RangeCheckpointPB rgCpt;
+        rgCpt.set_hash_key(kPrimaryKey);
+        rgCpt.set_sequence_id(1);
+        rgCpt.set_committed(false);
+        const std::string key = m.MakeRangeKey(kPrimaryKey, 0);
+        uint64_t seq = 0;
+        EXPECT_TRUE(m.SetPB(key, rgCpt, &seq));
+        EXPECT_FALSE(m.IsCommitted(seq));
+
+        // buffered writes are visible to reads but not in the database yet
+        RangeCheckpointPB readCpt;
+        EXPECT_TRUE(m.GetPB(key, readCpt));
+        EXPECT_EQ(1U, readCpt.sequence_id());
+        std::string value;
+        EXPECT_FALSE(m.readDatabase(key, value));
+
+        // writes of the same key before the commit are collapsed into the same batch
+        rgCpt.set_committed(true);
+        uint64_t seq2 = 0;
+        EXPECT_TRUE(m.SetPB(key, rgCpt, &seq2));
+        EXPECT_EQ(seq, seq2);
+
+        m.Flush();
+        EXPECT_TRUE(m.IsCommitted(seq));
+        EXPECT_TRUE(m.readDatabase(key, value));
+        EXPECT_TRUE(readCpt.ParseFromString(value));
+        EXPECT_TRUE(readCpt.committed());
+
+        // the next write belongs to the next batch
+        EXPECT_TRUE(m.SetPB(key, rgCpt, &seq2));
+        EXPECT_EQ(seq + 1, seq2);
+        EXPECT_FALSE(m.IsCommitted(seq2));
+
+        // deletion commits buffered writes first, so they can not bring the key back
+        m.DeleteCheckpoints(std::vector<std::string>{key});
+        EXPECT_TRUE(m.IsCommitted(seq2));
+        EXPECT_FALSE(m.GetPB(key, readCpt));
+    }
+    INT32_FLAG(logtail_checkpoint_group_commit_window_ms) = bakWindow;
+}
+
 } // namespace logtail
 
 UNIT_TEST_MAIN
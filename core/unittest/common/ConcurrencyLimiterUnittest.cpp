@@ -0,0 +1,165 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <queue>
+#include "unittest/Unittest.h"
+#include "common/ConcurrencyLimiter.h"
+
+namespace logtail {
+
+// FakeServer models a backend which handles `capacity` requests in parallel with `baseLatencyMs`, every extra
+// in-flight request queues and adds `queueLatencyMs`. Requests beyond `quota` in flight are rejected.
+struct FakeServer {
+    uint32_t capacity;
+    uint64_t baseLatencyMs;
+    uint64_t queueLatencyMs;
+    uint32_t quota;
+
+    uint64_t Latency(uint32_t inflight) const {
+        return baseLatencyMs + (inflight > capacity ? (inflight - capacity) * queueLatencyMs : 0);
+    }
+};
+
+class ConcurrencyLimiterUnittest : public ::testing::Test {
+public:
+    void TestSlowStart();
+    void TestCongestion();
+    void TestInFlight();
+    void TestConvergeOnLatency();
+    void TestConvergeOnQuota();
+
+private:
+    struct Completion {
+        uint64_t time;
+        uint64_t rtt;
+        bool success;
+        bool operator>(const Completion& rhs) const { return time > rhs.time; }
+    };
+
+    // Run always saturates the limiter against server for durationMs and returns the average limit of the
+    // last half of the run.
+    double Run(ConcurrencyLimiter& limiter, const FakeServer& server, uint64_t durationMs) {
+        std::priority_queue<Completion, std::vector<Completion>, std::greater<Completion>> pending;
+        double limitSum = 0;
+        uint64_t samples = 0;
+        for (uint64_t now = 1; now <= durationMs; ++now) {
+            while (!pending.empty() && pending.top().time <= now) {
+                Completion c = pending.top();
+                pending.pop();
+                if (c.success) {
+                    limiter.OnSuccess(c.rtt, now);
+                } else {
+                    limiter.OnCongestion(now);
+                    limiter.OnRelease();
+                }
+            }
+            while (limiter.IsValidToSend()) {
+                limiter.OnSend();
+                uint32_t inflight = limiter.GetInFlight();
+                bool success = inflight <= server.quota;
+                uint64_t rtt = success ? server.Latency(inflight) : server.baseLatencyMs;
+                pending.push(Completion{now + rtt, rtt, success});
+            }
+            if (now > durationMs / 2) {
+                limitSum += limiter.GetLimit();
+                ++samples;
+            }
+        }
+        return limitSum / samples;
+    }
+};
+
+UNIT_TEST_CASE(ConcurrencyLimiterUnittest, TestSlowStart);
+UNIT_TEST_CASE(ConcurrencyLimiterUnittest, TestCongestion);
+UNIT_TEST_CASE(ConcurrencyLimiterUnittest, TestInFlight);
+UNIT_TEST_CASE(ConcurrencyLimiterUnittest, TestConvergeOnLatency);
+UNIT_TEST_CASE(ConcurrencyLimiterUnittest, TestConvergeOnQuota);
+
+void ConcurrencyLimiterUnittest::TestSlowStart() {
+    ConcurrencyLimiter limiter(1, 64, 4);
+    APSARA_TEST_EQUAL(4U, limiter.GetLimit());
+    for (int i = 0; i < 4; ++i) {
+        limiter.OnSend();
+    }
+    APSARA_TEST_FALSE(limiter.IsValidToSend());
+    for (int i = 0; i < 4; ++i) {
+        limiter.OnSuccess(10, 100);
+    }
+    // Each success adds one during slow start.
+    APSARA_TEST_EQUAL(8U, limiter.GetLimit());
+    for (int i = 0; i < 100; ++i) {
+        limiter.OnSend();
+        limiter.OnSuccess(10, 100 + i);
+    }
+    APSARA_TEST_EQUAL(64U, limiter.GetLimit());
+}
+
+void ConcurrencyLimiterUnittest::TestCongestion() {
+    ConcurrencyLimiter limiter(2, 64, 32);
+    limiter.OnSend();
+    limiter.OnSuccess(100, 1000);
+    APSARA_TEST_EQUAL(33U, limiter.GetLimit());
+    limiter.OnCongestion(1000);
+    APSARA_TEST_EQUAL(16U, limiter.GetLimit());
+    // Errors from the same window only count once.
+    limiter.OnCongestion(1050);
+    APSARA_TEST_EQUAL(16U, limiter.GetLimit());
+    limiter.OnCongestion(1100);
+    APSARA_TEST_EQUAL(8U, limiter.GetLimit());
+    // Additive increase after congestion.
+    for (int i = 0; i < 8; ++i) {
+        limiter.OnSend();
+        limiter.OnSuccess(100, 1200);
+    }
+    APSARA_TEST_EQUAL(9U, limiter.GetLimit());
+    for (int i = 0; i < 10; ++i) {
+        limiter.OnCongestion(2000 + i * 200);
+    }
+    APSARA_TEST_EQUAL(2U, limiter.GetLimit());
+}
+
+void ConcurrencyLimiterUnittest::TestInFlight() {
+    ConcurrencyLimiter limiter(1, 8, 2);
+    limiter.OnSend();
+    APSARA_TEST_EQUAL(1U, limiter.GetQuota());
+    limiter.OnSend();
+    APSARA_TEST_EQUAL(0U, limiter.GetQuota());
+    limiter.OnCongestion(10);
+    APSARA_TEST_EQUAL(2U, limiter.GetInFlight());
+    limiter.OnRelease();
+    limiter.OnRelease();
+    limiter.OnRelease();
+    APSARA_TEST_EQUAL(0U, limiter.GetInFlight());
+}
+
+void ConcurrencyLimiterUnittest::TestConvergeOnLatency() {
+    FakeServer server{32, 50, 5, 100000};
+    ConcurrencyLimiter limiter(1, 512, 16);
+    double avgLimit = Run(limiter, server, 60 * 1000);
+    // Latency doubles at 42 in flight, the limit should stay around there instead of reaching 512.
+    APSARA_TEST_TRUE_DESC(avgLimit >= 16 && avgLimit <= 64, avgLimit);
+    APSARA_TEST_EQUAL(50U, limiter.GetMinRtt());
+}
+
+void ConcurrencyLimiterUnittest::TestConvergeOnQuota() {
+    FakeServer server{1000, 50, 0, 40};
+    ConcurrencyLimiter limiter(1, 512, 16);
+    double avgLimit = Run(limiter, server, 60 * 1000);
+    // AIMD saw-tooth between quota / 2 and quota.
+    APSARA_TEST_TRUE_DESC(avgLimit >= 20 && avgLimit <= 45, avgLimit);
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
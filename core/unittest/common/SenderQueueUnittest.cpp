@@ -12,12 +12,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <map>
 #include "unittest/Unittest.h"
 #include "common/LogstoreSenderQueue.h"
 #include "common/FileSystemUtil.h"
 #include "sender/SenderQueueParam.h"
 #include "aggregator/Aggregator.h"
 #include "app_config/AppConfig.h"
+#include "checkpoint/CheckpointManagerV2.h"
+
+DECLARE_FLAG_INT32(logtail_checkpoint_group_commit_window_ms);
+DECLARE_FLAG_BOOL(enable_adaptive_send_concurrency);
 
 namespace logtail {
 
@@ -32,12 +37,28 @@ public:
         }
         bfs::create_directories(kTestRootDir);
         AppConfig::GetInstance()->SetLogtailSysConfDir(kTestRootDir + PATH_SEPARATOR);
+        // checkpoints are committed by Flush only
+        INT32_FLAG(logtail_checkpoint_group_commit_window_ms) = 3600 * 1000;
     }
 
     void TestExactlyOnceQueue();
+    void TestExactlyOnceWaitCheckpointCommit();
+    void TestDeficitRoundRobinByWeight();
+    void TestDeficitRoundRobinByBytes();
+    void TestAdaptiveConcurrencyInFlight();
 };
 
 UNIT_TEST_CASE(SenderQueueUnittest, TestExactlyOnceQueue);
+UNIT_TEST_CASE(SenderQueueUnittest, TestExactlyOnceWaitCheckpointCommit);
+UNIT_TEST_CASE(SenderQueueUnittest, TestDeficitRoundRobinByWeight);
+UNIT_TEST_CASE(SenderQueueUnittest, TestDeficitRoundRobinByBytes);
+UNIT_TEST_CASE(SenderQueueUnittest, TestAdaptiveConcurrencyInFlight);
+
+class AlwaysValidFeedBack : public LogstoreFeedBackInterface {
+public:
+    void FeedBack(const LogstoreFeedBackKey& key) override {}
+    bool IsValidToPush(const LogstoreFeedBackKey& key) override { return true; }
+};
 
 void SenderQueueUnittest::TestExactlyOnceQueue() {
     {
@@ -103,6 +124,116 @@ void SenderQueueUnittest::TestExactlyOnceQueue() {
     }
 }
 
+void SenderQueueUnittest::TestExactlyOnceWaitCheckpointCommit() {
+    LogstoreSenderQueue<SenderQueueParam> senderQueue;
+    std::vector<RangeCheckpointPtr> checkpoints(1);
+    auto& cpt = checkpoints[0];
+    cpt = std::make_shared<RangeCheckpoint>();
+    cpt->index = 0;
+    cpt->key = "cpt_commit";
+    cpt->data.set_hash_key("");
+    cpt->data.set_sequence_id(1);
+    cpt->data.set_read_offset(0);
+    cpt->data.set_read_length(10);
+
+    const LogstoreFeedBackKey kFbKey = 0;
+    senderQueue.ConvertToExactlyOnceQueue(kFbKey, checkpoints);
+    auto data = new LoggroupTimeValue();
+    data->mLogstoreKey = kFbKey;
+    data->mLogGroupContext.mExactlyOnceCheckpoint = cpt;
+    EXPECT_TRUE(senderQueue.PushItem(kFbKey, data));
+    EXPECT_FALSE(cpt->IsPersisted());
+
+    std::vector<LoggroupTimeValue*> items;
+    std::unordered_map<std::string, int> regionConcurrencyLimits;
+    bool fullFlag = false;
+    // the prepared checkpoint is not committed yet
+    senderQueue.CheckAndPopAllItem(items, time(NULL), fullFlag, regionConcurrencyLimits);
+    EXPECT_TRUE(items.empty());
+
+    CheckpointManagerV2::GetInstance()->Flush();
+    EXPECT_TRUE(cpt->IsPersisted());
+    senderQueue.CheckAndPopAllItem(items, time(NULL), fullFlag, regionConcurrencyLimits);
+    EXPECT_EQ(1U, items.size());
+    senderQueue.OnLoggroupSendDone(data, LogstoreSenderInfo::SendResult_OK);
+}
+
+void SenderQueueUnittest::TestDeficitRoundRobinByWeight() {
+    LogstoreFeedbackQueue<int> queue;
+    AlwaysValidFeedBack checkObj;
+    queue.SetWeightNoLock(1, 3);
+    for (int i = 0; i < 40; ++i) {
+        queue.PushItem(1, 1);
+        queue.PushItem(2, 2);
+    }
+    LogstoreFeedBackKey startKey = 0;
+    std::map<int, int> popCount;
+    for (int i = 0; i < 40; ++i) {
+        int item = 0;
+        APSARA_TEST_TRUE(queue.CheckAndPopNextItem(startKey, item, &checkObj, 0, 1));
+        ++popCount[item];
+    }
+    // Logstore 1 gets three times the turns of logstore 2.
+    APSARA_TEST_TRUE_DESC(popCount[1] >= 29 && popCount[1] <= 31, popCount[1]);
+    APSARA_TEST_EQUAL(40, popCount[1] + popCount[2]);
+}
+
+void SenderQueueUnittest::TestDeficitRoundRobinByBytes() {
+    // Logstore 1 sends 1MB log groups and logstore 2 64KB ones, they share 8 concurrent requests of the region.
+    const int32_t kSizes[] = {0, 1024 * 1024, 64 * 1024};
+    LogstoreSenderQueue<SenderQueueParam> senderQueue;
+    auto pushItem = [&](LogstoreFeedBackKey key) {
+        auto data = new LoggroupTimeValue(
+            "project", "logstore", "config", "", false, "", "region", LOGGROUP_COMPRESSED, 1, kSizes[key], 0, "", key);
+        APSARA_TEST_TRUE(senderQueue.PushItem(key, data));
+    };
+    for (int i = 0; i < 16; ++i) {
+        pushItem(1);
+        pushItem(2);
+    }
+    int64_t sentBytes[3] = {0, 0, 0};
+    for (int round = 0; round < 40; ++round) {
+        std::vector<LoggroupTimeValue*> items;
+        std::unordered_map<std::string, int> regionConcurrencyLimits{{"region", 8}};
+        bool fullFlag = false;
+        senderQueue.CheckAndPopAllItem(items, time(NULL), fullFlag, regionConcurrencyLimits);
+        APSARA_TEST_TRUE(items.size() <= 8U);
+        for (auto item : items) {
+            LogstoreFeedBackKey key = item->mLogstoreKey;
+            sentBytes[key] += item->mRawSize;
+            senderQueue.OnLoggroupSendDone(item, LogstoreSenderInfo::SendResult_OK);
+            pushItem(key);
+        }
+    }
+    // Without deficit round robin logstore 1 takes all requests whenever it goes first.
+    double ratio = (double)sentBytes[1] / sentBytes[2];
+    APSARA_TEST_TRUE_DESC(ratio >= 0.5 && ratio <= 2.0, ratio);
+}
+
+void SenderQueueUnittest::TestAdaptiveConcurrencyInFlight() {
+    BOOL_FLAG(enable_adaptive_send_concurrency) = true;
+    LogstoreSenderInfo info;
+    info.SetRegion("region");
+    LogstoreSenderStatistics statistics;
+
+    // a request finished without a known send time, e.g. sent in debug mode, still releases its slot
+    info.ConcurrencyDec();
+    info.ConcurrencyDec();
+    APSARA_TEST_EQUAL(info.mConcurrencyLimiter.GetInFlight(), 2U);
+    info.RecordSendResult(LogstoreSenderInfo::SendResult_OK, statistics, 0);
+    APSARA_TEST_EQUAL(info.mConcurrencyLimiter.GetInFlight(), 1U);
+    info.RecordSendResult(LogstoreSenderInfo::SendResult_OK, statistics, GetCurrentTimeInMilliSeconds());
+    APSARA_TEST_EQUAL(info.mConcurrencyLimiter.GetInFlight(), 0U);
+
+    // region recover finishes no request
+    info.ConcurrencyDec();
+    info.mNetworkValidFlag = false;
+    APSARA_TEST_TRUE(info.OnRegionRecover("region"));
+    APSARA_TEST_TRUE(info.mNetworkValidFlag);
+    APSARA_TEST_EQUAL(info.mConcurrencyLimiter.GetInFlight(), 1U);
+    BOOL_FLAG(enable_adaptive_send_concurrency) = false;
+}
+
 } // namespace logtail
 
-UNIT_TEST_MAIN
\ No newline at end of file
+UNIT_TEST_MAIN
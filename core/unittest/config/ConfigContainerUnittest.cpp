@@ -73,9 +73,42 @@ public:
         APSARA_TEST_EQUAL_FATAL(event->GetType(), EVENT_ISDIR | EVENT_CONTAINER_STOPPED);
         delete event;
     }
+
+    void TestUpdateContainerPathsInvalidatesMatchCache() {
+        LOG_INFO(sLogger, ("TestUpdateContainerPathsInvalidatesMatchCache() begin", time(NULL)));
+        ConfigManager* manager = ConfigManager::GetInstance();
+        FileDiscoveryOptions config;
+        config.SetEnableContainerDiscoveryFlag(true);
+        FileServer::GetInstance()->AddFileDiscoveryConfig("test-config-path", &config, nullptr);
+
+        // Case: adding a container path drops the cached matches
+        uint64_t epoch = manager->GetFileMatchEpoch();
+        std::string params = R"""({
+  "ID":"123456",
+  "Path":"/logtail_host/lib/var/docker/123456"
+})""";
+        manager->UpdateContainerPath(new DockerContainerPathCmd("test-config-path", false, params, false));
+        manager->DoUpdateContainerPaths();
+        APSARA_TEST_TRUE_FATAL(manager->GetFileMatchEpoch() > epoch);
+
+        // Case: deleting a container path drops the cached matches
+        epoch = manager->GetFileMatchEpoch();
+        manager->UpdateContainerPath(new DockerContainerPathCmd("test-config-path", true, params, false));
+        manager->DoUpdateContainerPaths();
+        APSARA_TEST_TRUE_FATAL(manager->GetFileMatchEpoch() > epoch);
+
+        // Case: a failed cmd keeps the cached matches
+        epoch = manager->GetFileMatchEpoch();
+        manager->UpdateContainerPath(new DockerContainerPathCmd("test-config-path", false, "invalid", false));
+        manager->DoUpdateContainerPaths();
+        APSARA_TEST_EQUAL_FATAL(manager->GetFileMatchEpoch(), epoch);
+
+        FileServer::GetInstance()->RemoveFileDiscoveryConfig("test-config-path");
+    }
 };
 
 APSARA_UNIT_TEST_CASE(ConfigContainerUnittest, TestGetContainerStoppedEvents, 0);
+APSARA_UNIT_TEST_CASE(ConfigContainerUnittest, TestUpdateContainerPathsInvalidatesMatchCache, 0);
 } // end of namespace logtail
 
 int main(int argc, char** argv) {
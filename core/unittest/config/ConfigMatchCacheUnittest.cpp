@@ -0,0 +1,144 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include "config_manager/ConfigMatchCache.h"
+#include "pipeline/PipelineContext.h"
+#include "unittest/Unittest.h"
+
+using namespace std;
+
+namespace logtail {
+
+class ConfigMatchCacheUnittest : public testing::Test {
+public:
+    void TestLRUEviction();
+    void TestGeneration();
+    void TestInvalidatePath();
+
+protected:
+    FileDiscoveryConfig AddConfig(const string& name, const string& filePath) {
+        Json::Value configJson;
+        configJson["FilePaths"].append(Json::Value(filePath));
+        unique_ptr<FileDiscoveryOptions> options(new FileDiscoveryOptions());
+        APSARA_TEST_TRUE(options->Init(configJson, mCtx, "test"));
+        FileDiscoveryConfig config = make_pair(options.get(), &mCtx);
+        mOptions.push_back(std::move(options));
+        mIndex.Add(name, config);
+        return config;
+    }
+
+    void Put(ConfigMatchCache<FileDiscoveryConfig>& cache,
+             const string& path,
+             const string& name,
+             const FileDiscoveryConfig& config,
+             size_t capacity = 100) {
+        ConfigMatchCache<FileDiscoveryConfig>::Dependencies deps;
+        if (config.first != nullptr) {
+            deps.emplace_back(config.first, mIndex.GetGeneration(config.first));
+        }
+        cache.Put(path + '<' + name, path.size(), config, 0, std::move(deps), capacity);
+    }
+
+    bool Get(ConfigMatchCache<FileDiscoveryConfig>& cache, const string& path, const string& name) {
+        FileDiscoveryConfig config(nullptr, nullptr);
+        int32_t alarmTime = 0;
+        return cache.Get(path + '<' + name, mIndex, config, alarmTime);
+    }
+
+    PipelineContext mCtx;
+    vector<unique_ptr<FileDiscoveryOptions>> mOptions;
+    FileDiscoveryIndex mIndex;
+};
+
+UNIT_TEST_CASE(ConfigMatchCacheUnittest, TestLRUEviction);
+UNIT_TEST_CASE(ConfigMatchCacheUnittest, TestGeneration);
+UNIT_TEST_CASE(ConfigMatchCacheUnittest, TestInvalidatePath);
+
+void ConfigMatchCacheUnittest::TestLRUEviction() {
+    auto config = AddConfig("app", "/home/admin/*.log");
+    ConfigMatchCache<FileDiscoveryConfig> cache("test", 1);
+    Put(cache, "/home/admin", "a.log", config, 2);
+    Put(cache, "/home/admin", "b.log", config, 2);
+    // a.log becomes the most recently used one, so b.log is evicted
+    APSARA_TEST_TRUE(Get(cache, "/home/admin", "a.log"));
+    Put(cache, "/home/admin", "c.log", config, 2);
+    APSARA_TEST_EQUAL(2U, cache.Size());
+    APSARA_TEST_TRUE(Get(cache, "/home/admin", "a.log"));
+    APSARA_TEST_FALSE(Get(cache, "/home/admin", "b.log"));
+    APSARA_TEST_TRUE(Get(cache, "/home/admin", "c.log"));
+    APSARA_TEST_EQUAL(1U, cache.mEvictTotal->GetValue());
+    APSARA_TEST_EQUAL(3U, cache.mHitTotal->GetValue());
+    APSARA_TEST_EQUAL(1U, cache.mMissTotal->GetValue());
+
+    // replacing an entry does not evict others
+    Put(cache, "/home/admin", "c.log", config, 2);
+    APSARA_TEST_EQUAL(2U, cache.Size());
+    APSARA_TEST_EQUAL(1U, cache.mEvictTotal->GetValue());
+
+    // capacity is split among shards
+    ConfigMatchCache<FileDiscoveryConfig> shardedCache("test", 4);
+    for (int i = 0; i < 100; ++i) {
+        Put(shardedCache, "/home/admin", to_string(i) + ".log", config, 40);
+    }
+    APSARA_TEST_TRUE(shardedCache.Size() <= 40U);
+}
+
+void ConfigMatchCacheUnittest::TestGeneration() {
+    auto app = AddConfig("app", "/home/admin/app/*.log");
+    auto other = AddConfig("other", "/var/log/*.log");
+    ConfigMatchCache<FileDiscoveryConfig> cache("test");
+    Put(cache, "/home/admin/app", "a.log", app);
+    Put(cache, "/var/log", "a.log", other);
+    Put(cache, "/tmp", "a.log", make_pair(nullptr, nullptr));
+
+    // only entries of the removed config are stale
+    mIndex.Remove("app");
+    APSARA_TEST_FALSE(Get(cache, "/home/admin/app", "a.log"));
+    APSARA_TEST_TRUE(Get(cache, "/var/log", "a.log"));
+    APSARA_TEST_TRUE(Get(cache, "/tmp", "a.log"));
+    APSARA_TEST_EQUAL(2U, cache.Size());
+
+    // re-adding the same options gets a new generation
+    mIndex.Add("other", other);
+    APSARA_TEST_FALSE(Get(cache, "/var/log", "a.log"));
+    APSARA_TEST_TRUE(Get(cache, "/tmp", "a.log"));
+}
+
+void ConfigMatchCacheUnittest::TestInvalidatePath() {
+    auto config = AddConfig("app", "/home/admin/*.log");
+    ConfigMatchCache<FileDiscoveryConfig> cache("test");
+    Put(cache, "/home/admin", "a.log", config);
+    Put(cache, "/home/admin/app", "a.log", config);
+    Put(cache, "/home/admin2", "a.log", config);
+    Put(cache, "/home", "a.log", config);
+
+    cache.InvalidatePath("/home/admin");
+    APSARA_TEST_FALSE(Get(cache, "/home/admin", "a.log"));
+    APSARA_TEST_FALSE(Get(cache, "/home/admin/app", "a.log"));
+    APSARA_TEST_TRUE(Get(cache, "/home/admin2", "a.log"));
+    APSARA_TEST_TRUE(Get(cache, "/home", "a.log"));
+
+    cache.InvalidatePath("/");
+    APSARA_TEST_EQUAL(0U, cache.Size());
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
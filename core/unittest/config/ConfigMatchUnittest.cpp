@@ -260,7 +260,7 @@ public:
             ConfigManager::GetInstance()->FindMatchWithForceFlag(allConfig, gRootDir + PS + "A" + PS + "B", "test.Log");
             APSARA_TEST_EQUAL(allConfig.size(), (size_t)2);
         }
-        ConfigManager::GetInstance()->mCacheFileAllConfigMap.clear();
+        ConfigManager::GetInstance()->mCacheFileAllConfigMap.Clear();
         {
             vector<FileDiscoveryConfig> allConfig;
             ConfigManager::GetInstance()->FindAllMatch(allConfig, gRootDir + PS + "A" + PS + "B", "test.Log");
@@ -0,0 +1,119 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "event/CoalescingEventQueue.h"
+#include "event/Event.h"
+#include "unittest/Unittest.h"
+
+using namespace std;
+
+namespace logtail {
+
+class CoalescingEventQueueUnittest : public ::testing::Test {
+public:
+    void TestCoalesceModify();
+    void TestKeepOrder();
+    void TestUnrelatedBarrier();
+    void TestStalePending();
+
+protected:
+    static Event* NewEvent(const string& source, const string& object, EventType type, uint64_t inode = 1) {
+        return new Event(source, object, type, 0, 0, 1, inode);
+    }
+
+    static vector<EventType> PopAllTypes(CoalescingEventQueue& queue) {
+        vector<EventType> types;
+        Event* ev = nullptr;
+        while ((ev = queue.Pop()) != nullptr) {
+            types.push_back(ev->GetType());
+            delete ev;
+        }
+        return types;
+    }
+};
+
+UNIT_TEST_CASE(CoalescingEventQueueUnittest, TestCoalesceModify);
+UNIT_TEST_CASE(CoalescingEventQueueUnittest, TestKeepOrder);
+UNIT_TEST_CASE(CoalescingEventQueueUnittest, TestUnrelatedBarrier);
+UNIT_TEST_CASE(CoalescingEventQueueUnittest, TestStalePending);
+
+void CoalescingEventQueueUnittest::TestCoalesceModify() {
+    CoalescingEventQueue queue;
+    for (int i = 0; i < 100; ++i) {
+        APSARA_TEST_EQUAL(i == 0, queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY)));
+    }
+    // another file, inode or config is not merged
+    APSARA_TEST_TRUE(queue.Push(NewEvent("/log", "b.log", EVENT_MODIFY)));
+    APSARA_TEST_TRUE(queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY, 2)));
+    Event* ev = NewEvent("/log", "a.log", EVENT_MODIFY);
+    ev->SetConfigName("config");
+    APSARA_TEST_TRUE(queue.Push(ev));
+    APSARA_TEST_EQUAL(4U, queue.Size());
+    APSARA_TEST_EQUAL(103U, queue.GetPushCount());
+    APSARA_TEST_EQUAL(99U, queue.GetCoalescedCount());
+
+    // a new MODIFY is queued once the pending one is popped
+    delete queue.Pop();
+    APSARA_TEST_TRUE(queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY)));
+    APSARA_TEST_FALSE(queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY)));
+    APSARA_TEST_EQUAL(4U, queue.Size());
+}
+
+void CoalescingEventQueueUnittest::TestKeepOrder() {
+    CoalescingEventQueue queue;
+    queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY));
+    queue.Push(NewEvent("/log", "a.log", EVENT_DELETE));
+    queue.Push(NewEvent("/log", "a.log", EVENT_CREATE));
+    // not merged into the MODIFY before DELETE and CREATE
+    APSARA_TEST_TRUE(queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY)));
+    APSARA_TEST_FALSE(queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY)));
+    // events of directories affect all files
+    queue.Push(NewEvent("/", "log", EVENT_MOVE_FROM | EVENT_ISDIR));
+    APSARA_TEST_TRUE(queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY)));
+    vector<EventType> expected{
+        EVENT_MODIFY, EVENT_DELETE, EVENT_CREATE, EVENT_MODIFY, EVENT_MOVE_FROM | EVENT_ISDIR, EVENT_MODIFY};
+    APSARA_TEST_TRUE(PopAllTypes(queue) == expected);
+}
+
+void CoalescingEventQueueUnittest::TestUnrelatedBarrier() {
+    CoalescingEventQueue queue;
+    queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY));
+    // events of files in other directories do not stop merging
+    queue.Push(NewEvent("/other", "b.log", EVENT_CREATE));
+    APSARA_TEST_FALSE(queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY)));
+    // but events of files in the same directory do, e.g. renaming another file to it
+    queue.Push(NewEvent("/log", "c.log", EVENT_MOVE_FROM));
+    APSARA_TEST_TRUE(queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY)));
+    APSARA_TEST_EQUAL(4U, queue.Size());
+}
+
+void CoalescingEventQueueUnittest::TestStalePending() {
+    CoalescingEventQueue queue;
+    queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY));
+    queue.Push(NewEvent("/log", "a.log", EVENT_DELETE));
+    queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY));
+    // popping the first MODIFY does not drop the pending state of the second one
+    delete queue.Pop();
+    APSARA_TEST_FALSE(queue.Push(NewEvent("/log", "a.log", EVENT_MODIFY)));
+    vector<EventType> expected{EVENT_DELETE, EVENT_MODIFY};
+    APSARA_TEST_TRUE(PopAllTypes(queue) == expected);
+    APSARA_TEST_TRUE(queue.Empty());
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -128,9 +128,56 @@ public:
         createModifyHandler.Handle(event2);
         APSARA_TEST_EQUAL_FATAL(pHanlder->handle_count, 1);
     }
+
+    void TestSelectShard() {
+        LOG_INFO(sLogger, ("TestSelectShard() begin", time(NULL)));
+        CreateModifyHandler createModifyHandler(&mCreateHandler);
+        createModifyHandler.mShardModifyHandlerPtrMaps.resize(3);
+        MockModifyHandler* pHanlder = new MockModifyHandler(); // released by ~CreateModifyHandler
+        createModifyHandler.mShardModifyHandlerPtrMaps[1].insert(std::make_pair(mConfigName, pHanlder));
+        // a.log (inode 100) has been rotated to a.log.1, only existence of readers is checked
+        pHanlder->mDevInodeReaderMap[DevInode(1, 100)] = LogFileReaderPtr();
+        pHanlder->mNameReaderMap["a.log"].push_back(LogFileReaderPtr());
+
+        DevInode devInode;
+        Event rotatedEvent("/root/log", "a.log.1", EVENT_MODIFY, 0, 0, 1, 100);
+        APSARA_TEST_EQUAL(createModifyHandler.SelectShard(rotatedEvent, devInode), 2U);
+        APSARA_TEST_TRUE(devInode == DevInode(1, 100));
+        // new a.log joins readers of the rotated file
+        Event newFileEvent("/root/log", "a.log", EVENT_MODIFY, 0, 0, 1, 200);
+        APSARA_TEST_EQUAL(createModifyHandler.SelectShard(newFileEvent, devInode), 2U);
+        // other files are sharded by dev inode
+        Event otherEvent("/root/log", "b.log", EVENT_MODIFY, 0, 0, 1, 300);
+        size_t shard = createModifyHandler.SelectShard(otherEvent, devInode);
+        APSARA_TEST_TRUE(shard < 4U);
+        for (int i = 0; i < 10; ++i) {
+            APSARA_TEST_EQUAL(createModifyHandler.SelectShard(otherEvent, devInode), shard);
+        }
+        // file which can not be stat
+        Event notExistEvent("/not_exist", "c.log", EVENT_MODIFY, 0);
+        APSARA_TEST_EQUAL(createModifyHandler.SelectShard(notExistEvent, devInode), 0U);
+        APSARA_TEST_FALSE(devInode.IsValid());
+    }
+
+    void TestDeleteEventToAllShards() {
+        LOG_INFO(sLogger, ("TestDeleteEventToAllShards() begin", time(NULL)));
+        CreateModifyHandler createModifyHandler(&mCreateHandler);
+        createModifyHandler.mShardModifyHandlerPtrMaps.resize(1);
+        MockModifyHandler* pHanlder0 = new MockModifyHandler(); // released by ~CreateModifyHandler
+        MockModifyHandler* pHanlder1 = new MockModifyHandler();
+        createModifyHandler.mModifyHandlerPtrMap.insert(std::make_pair(mConfigName, pHanlder0));
+        createModifyHandler.mShardModifyHandlerPtrMaps[0].insert(std::make_pair(mConfigName, pHanlder1));
+
+        Event event("/root/log", "test-0.log", EVENT_DELETE, 0);
+        createModifyHandler.Handle(event);
+        APSARA_TEST_EQUAL(pHanlder0->handle_count, 1);
+        APSARA_TEST_EQUAL(pHanlder1->handle_count, 1);
+    }
 };
 
 APSARA_UNIT_TEST_CASE(CreateModifyHandlerUnittest, TestHandleContainerStoppedEvent, 0);
+APSARA_UNIT_TEST_CASE(CreateModifyHandlerUnittest, TestSelectShard, 0);
+APSARA_UNIT_TEST_CASE(CreateModifyHandlerUnittest, TestDeleteEventToAllShards, 0);
 } // end of namespace logtail
 
 int main(int argc, char** argv) {
@@ -18,23 +18,63 @@
 #include <stdlib.h>
 #include <string>
 #include <memory>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include "common/Flags.h"
 #include "common/FileSystemUtil.h"
+#include "controller/EventDispatcher.h"
 #include "polling/PollingEventQueue.h"
 #include "event/Event.h"
+#include "event_handler/EventHandler.h"
 #include "event_handler/LogInput.h"
 using namespace std;
 
 DECLARE_FLAG_STRING(ilogtail_config);
 
 namespace logtail {
+// MockCreateModifyHandler records the events handled in order, file events are put to the shards listed for their
+// file names, the last one is kept once the others are used.
+class MockCreateModifyHandler : public CreateModifyHandler {
+public:
+    static const size_t kNoShard = SIZE_MAX;
+    struct Record {
+        size_t mShard;
+        uint64_t mInode;
+        thread::id mThread;
+    };
+
+    MockCreateModifyHandler() : CreateModifyHandler(nullptr) {}
+    void Handle(const Event& event) override {
+        lock_guard<mutex> lock(mMux);
+        mRecords.push_back({kNoShard, event.GetInode(), this_thread::get_id()});
+    }
+    size_t SelectShard(const Event& event, DevInode& devInode) override {
+        devInode = DevInode(event.GetDev(), event.GetInode());
+        lock_guard<mutex> lock(mMux);
+        auto& shards = mFileShards[event.GetObject()];
+        size_t shard = shards.front();
+        if (shards.size() > 1) {
+            shards.pop_front();
+        }
+        return shard;
+    }
+    void HandleInShard(const Event& event, size_t shard) override {
+        lock_guard<mutex> lock(mMux);
+        mRecords.push_back({shard, event.GetInode(), this_thread::get_id()});
+    }
+
+    mutex mMux;
+    unordered_map<string, deque<size_t>> mFileShards;
+    vector<Record> mRecords;
+};
+
 class LogInputUnittest : public ::testing::Test {
 protected:
     void SetUp() override {}
     void TearDown() override {
-        LogInput::GetInstance()->mModifyEventSet.clear();
-        std::queue<Event*> empty;
-        std::swap(LogInput::GetInstance()->mInotifyEventQueue, empty);
+        LogInput::GetInstance()->mInotifyEventQueue.Clear();
     }
 
 public:
@@ -43,7 +83,7 @@ public:
         Event* event0 = new Event("/source", "object1", EVENT_MODIFY, 0);
         PollingEventQueue::GetInstance()->PushEvent(event0);
         LogInput::GetInstance()->TryReadEvents(true);
-        APSARA_TEST_EQUAL_FATAL(LogInput::GetInstance()->mInotifyEventQueue.size(), 1L);
+        APSARA_TEST_EQUAL_FATAL(LogInput::GetInstance()->mInotifyEventQueue.Size(), 1L);
         Event* ev = LogInput::GetInstance()->PopEventQueue();
         APSARA_TEST_EQUAL_FATAL(ev, event0);
         delete ev;
@@ -58,14 +98,89 @@ public:
         Event* event2 = new Event("/source", "object1", EVENT_MODIFY, 0);
         PollingEventQueue::GetInstance()->PushEvent(event2);
         LogInput::GetInstance()->TryReadEvents(true);
-        APSARA_TEST_EQUAL_FATAL(LogInput::GetInstance()->mInotifyEventQueue.size(), 1L);
+        APSARA_TEST_EQUAL_FATAL(LogInput::GetInstance()->mInotifyEventQueue.Size(), 1L);
         Event* ev = LogInput::GetInstance()->PopEventQueue();
         delete ev;
     }
+
+    void TestProcessEventBatchOrder() {
+        LOG_INFO(sLogger, ("TestProcessEventBatchOrder() begin", time(NULL)));
+        const string dir = "/log_input_shard_test";
+        const int wd = 1000000;
+        MockCreateModifyHandler handler;
+        handler.mFileShards["a.log"] = {1};
+        handler.mFileShards["b.log"] = {2};
+        handler.mFileShards["c.log"] = {3};
+        // d.log is rotated and created again in another shard
+        handler.mFileShards["d.log"] = {1, 2};
+        EventDispatcher* dispatcher = EventDispatcher::GetInstance();
+        dispatcher->mPathWdMap[dir] = wd;
+        dispatcher->mWdDirInfoMap[wd] = new DirInfo(dir, 0, false, &handler);
+        LogInput* logInput = LogInput::GetInstance();
+        auto shardEventVecs = std::move(logInput->mShardEventVecs);
+        logInput->mShardEventVecs.resize(4);
+
+        // the inode of an event is its order, events of different inodes are not coalesced
+        vector<pair<string, EventType>> files = {{"a.log", EVENT_MODIFY},
+                                                 {"b.log", EVENT_MODIFY},
+                                                 {"a.log", EVENT_MODIFY},
+                                                 {"c.log", EVENT_MODIFY},
+                                                 {"d.log", EVENT_MODIFY},
+                                                 {"a.log", EVENT_MODIFY},
+                                                 {"d.log", EVENT_MODIFY},
+                                                 {"x.log", EVENT_CREATE},
+                                                 {"a.log", EVENT_MODIFY},
+                                                 {"b.log", EVENT_MODIFY},
+                                                 {"a.log", EVENT_MODIFY}};
+        vector<Event*> events;
+        for (size_t i = 0; i < files.size(); ++i) {
+            events.push_back(new Event(dir, files[i].first, files[i].second, wd, 0, 1, i + 1));
+        }
+        logInput->PushEventQueue(events);
+        APSARA_TEST_EQUAL(logInput->ProcessEventBatch(dispatcher), (int32_t)files.size());
+
+        APSARA_TEST_EQUAL_FATAL(handler.mRecords.size(), files.size());
+        vector<size_t> pos(files.size() + 1);
+        vector<size_t> shards(files.size() + 1);
+        for (size_t i = 0; i < handler.mRecords.size(); ++i) {
+            const auto& record = handler.mRecords[i];
+            pos[record.mInode] = i;
+            shards[record.mInode] = record.mShard;
+            // shard 0 is handled by the calling thread, others by shard threads
+            APSARA_TEST_EQUAL(record.mThread == this_thread::get_id(),
+                              record.mShard == 0 || record.mShard == MockCreateModifyHandler::kNoShard);
+        }
+        // events of a file are handled by its shard in order
+        APSARA_TEST_EQUAL(shards[1], 1U);
+        APSARA_TEST_EQUAL(shards[2], 2U);
+        APSARA_TEST_EQUAL(shards[4], 3U);
+        APSARA_TEST_TRUE(pos[1] < pos[3] && pos[3] < pos[6] && pos[6] < pos[9] && pos[9] < pos[11]);
+        APSARA_TEST_TRUE(pos[2] < pos[10]);
+        // the new d.log is handled after events of the old one are done
+        APSARA_TEST_EQUAL(shards[5], 1U);
+        APSARA_TEST_EQUAL(shards[7], 2U);
+        APSARA_TEST_TRUE(pos[5] < pos[7]);
+        // the CREATE event is a barrier for all shards
+        APSARA_TEST_EQUAL(shards[8], MockCreateModifyHandler::kNoShard);
+        for (size_t inode = 1; inode <= files.size(); ++inode) {
+            if (inode != 8) {
+                APSARA_TEST_EQUAL(inode < 8, pos[inode] < pos[8]);
+            }
+        }
+        for (const auto& vec : logInput->mShardEventVecs) {
+            APSARA_TEST_TRUE(vec.empty());
+        }
+
+        logInput->mShardEventVecs = std::move(shardEventVecs);
+        delete dispatcher->mWdDirInfoMap[wd];
+        dispatcher->mWdDirInfoMap.erase(wd);
+        dispatcher->mPathWdMap.erase(dir);
+    }
 };
 
 APSARA_UNIT_TEST_CASE(LogInputUnittest, TestTryReadEventsPollingEvents, 0);
 APSARA_UNIT_TEST_CASE(LogInputUnittest, TestTryReadEventsDuplicatedEvents, 0);
+APSARA_UNIT_TEST_CASE(LogInputUnittest, TestProcessEventBatchOrder, 0);
 } // end of namespace logtail
 
 int main(int argc, char** argv) {
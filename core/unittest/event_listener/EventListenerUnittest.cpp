@@ -0,0 +1,221 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <sys/fanotify.h>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "event/Event.h"
+#include "event_listener/EventListener_Linux.h"
+#include "logger/Logger.h"
+#include "unittest/Unittest.h"
+
+using namespace std;
+
+namespace logtail {
+
+class EventListenerUnittest : public ::testing::Test {
+public:
+    void TestAddFanotifyDir();
+    void TestFanotifyIdWrapAround();
+    void TestParseFanotifyEvents();
+
+protected:
+    void SetUp() override {
+        mListener = EventListener::GetInstance();
+        mListener->mFanotifyDirMap.clear();
+        mListener->mFanotifyIdMap.clear();
+        mListener->mNextFanotifyId = 0;
+    }
+
+    void TearDown() override {
+        mListener->mFanotifyDirMap.clear();
+        mListener->mFanotifyIdMap.clear();
+        mListener->mNextFanotifyId = 0;
+    }
+
+#if defined(FAN_REPORT_DFID_NAME)
+    static fsid_t MakeFsid(int fsid) {
+        fsid_t id;
+        memset(&id, 0, sizeof(id));
+        id.__val[0] = fsid;
+        return id;
+    }
+
+    // MakeDirKey returns the key of a directory the same as EventListener builds from its fsid and file handle.
+    static string MakeDirKey(int fsid, int handleType, const string& handle) {
+        fsid_t id = MakeFsid(fsid);
+        string key(reinterpret_cast<const char*>(&id), sizeof(id));
+        key.append(reinterpret_cast<const char*>(&handleType), sizeof(handleType));
+        key.append(handle);
+        return key;
+    }
+
+    // AppendEvent appends an event reported with the file handle of its parent directory and name to buf, the same
+    // as read from a fanotify fd initialized with FAN_REPORT_DFID_NAME.
+    static void
+    AppendEvent(string& buf, uint64_t mask, int fsid, int handleType, const string& handle, const char* name) {
+        size_t infoLen = sizeof(struct fanotify_event_info_fid) + sizeof(struct file_handle) + handle.size();
+        if (name != nullptr) {
+            infoLen += strlen(name) + 1;
+        }
+        // info records are padded to 4 bytes by the kernel
+        infoLen = (infoLen + 3) & ~size_t(3);
+        string event(sizeof(struct fanotify_event_metadata) + infoLen, '\0');
+
+        auto metadata = reinterpret_cast<struct fanotify_event_metadata*>(&event[0]);
+        metadata->event_len = event.size();
+        metadata->vers = FANOTIFY_METADATA_VERSION;
+        metadata->metadata_len = sizeof(struct fanotify_event_metadata);
+        metadata->mask = mask;
+        metadata->fd = FAN_NOFD;
+        auto fid = reinterpret_cast<struct fanotify_event_info_fid*>(&event[metadata->metadata_len]);
+        fid->hdr.info_type = name != nullptr ? FAN_EVENT_INFO_TYPE_DFID_NAME : FAN_EVENT_INFO_TYPE_DFID;
+        fid->hdr.len = infoLen;
+        fsid_t id = MakeFsid(fsid);
+        memcpy(&fid->fsid, &id, sizeof(id));
+        auto fh = reinterpret_cast<struct file_handle*>(fid->handle);
+        fh->handle_bytes = handle.size();
+        fh->handle_type = handleType;
+        memcpy(fh->f_handle, handle.data(), handle.size());
+        if (name != nullptr) {
+            strcpy(reinterpret_cast<char*>(fh->f_handle) + handle.size(), name);
+        }
+        buf.append(event);
+    }
+#endif
+
+    EventListener* mListener = nullptr;
+};
+
+UNIT_TEST_CASE(EventListenerUnittest, TestAddFanotifyDir);
+UNIT_TEST_CASE(EventListenerUnittest, TestFanotifyIdWrapAround);
+UNIT_TEST_CASE(EventListenerUnittest, TestParseFanotifyEvents);
+
+void EventListenerUnittest::TestAddFanotifyDir() {
+#if defined(FAN_REPORT_DFID_NAME)
+    string keyA = MakeDirKey(1, 1, "dir-a");
+    string keyB = MakeDirKey(1, 1, "dir-b");
+    // the same handle on another filesystem is another directory
+    string keyC = MakeDirKey(2, 1, "dir-a");
+    int wdA = mListener->AddFanotifyDir(keyA);
+    int wdB = mListener->AddFanotifyDir(keyB);
+    int wdC = mListener->AddFanotifyDir(keyC);
+    APSARA_TEST_TRUE(EventListener::IsFanotifyID(wdA));
+    APSARA_TEST_TRUE(EventListener::IsFanotifyID(wdB));
+    APSARA_TEST_TRUE(EventListener::IsFanotifyID(wdC));
+    APSARA_TEST_NOT_EQUAL(wdA, wdB);
+    APSARA_TEST_NOT_EQUAL(wdA, wdC);
+    APSARA_TEST_NOT_EQUAL(wdB, wdC);
+    // a directory referred by several paths has one id
+    APSARA_TEST_EQUAL(mListener->AddFanotifyDir(keyA), wdA);
+    APSARA_TEST_EQUAL(mListener->mFanotifyIdMap[wdA], keyA);
+    APSARA_TEST_EQUAL(mListener->mFanotifyDirMap[keyB], wdB);
+
+    APSARA_TEST_TRUE(mListener->RemoveWatch(wdA));
+    APSARA_TEST_FALSE(mListener->RemoveWatch(wdA));
+    APSARA_TEST_EQUAL(mListener->mFanotifyDirMap.count(keyA), 0U);
+    APSARA_TEST_EQUAL(mListener->mFanotifyIdMap.count(wdA), 0U);
+    // a directory watched again gets a new id
+    int wdA2 = mListener->AddFanotifyDir(keyA);
+    APSARA_TEST_NOT_EQUAL(wdA2, wdA);
+    APSARA_TEST_EQUAL(mListener->mFanotifyIdMap[wdA2], keyA);
+#endif
+}
+
+void EventListenerUnittest::TestFanotifyIdWrapAround() {
+#if defined(FAN_REPORT_DFID_NAME)
+    const int idBase = 1 << 30;
+    int wd0 = mListener->AddFanotifyDir(MakeDirKey(1, 1, "dir-0"));
+    int wd1 = mListener->AddFanotifyDir(MakeDirKey(1, 1, "dir-1"));
+    APSARA_TEST_EQUAL(wd0, idBase);
+    APSARA_TEST_EQUAL(wd1, idBase + 1);
+    APSARA_TEST_TRUE(mListener->RemoveWatch(wd0));
+
+    mListener->mNextFanotifyId = INT_MAX - idBase - 1;
+    int wdLast = mListener->AddFanotifyDir(MakeDirKey(1, 1, "dir-last"));
+    APSARA_TEST_EQUAL(wdLast, INT_MAX - 1);
+    // ids wrap around, the removed id is reused and the live one is skipped
+    int wdWrapped = mListener->AddFanotifyDir(MakeDirKey(1, 1, "dir-wrapped"));
+    APSARA_TEST_EQUAL(wdWrapped, idBase);
+    int wdNext = mListener->AddFanotifyDir(MakeDirKey(1, 1, "dir-next"));
+    APSARA_TEST_EQUAL(wdNext, idBase + 2);
+    APSARA_TEST_EQUAL(mListener->mFanotifyIdMap[wd1], MakeDirKey(1, 1, "dir-1"));
+    APSARA_TEST_EQUAL(mListener->mFanotifyIdMap.size(), 4U);
+    APSARA_TEST_EQUAL(mListener->mFanotifyDirMap.size(), 4U);
+#endif
+}
+
+void EventListenerUnittest::TestParseFanotifyEvents() {
+#if defined(FAN_REPORT_DFID_NAME)
+    int wd = mListener->AddFanotifyDir(MakeDirKey(1, 1, "dir-a"));
+    int wdDir = mListener->AddFanotifyDir(MakeDirKey(1, 2, "dir-b-longer-handle"));
+
+    string buf;
+    AppendEvent(buf, FAN_CREATE, 1, 1, "dir-a", "a.log");
+    AppendEvent(buf, FAN_MODIFY, 1, 1, "dir-a", "a.log");
+    // not watched, neither the handle nor the fsid matches
+    AppendEvent(buf, FAN_MODIFY, 1, 1, "dir-c", "c.log");
+    AppendEvent(buf, FAN_MODIFY, 3, 1, "dir-a", "a.log");
+    // events of the directory itself
+    AppendEvent(buf, FAN_DELETE_SELF | FAN_ONDIR, 1, 2, "dir-b-longer-handle", ".");
+    AppendEvent(buf, FAN_MOVED_TO | FAN_ONDIR, 1, 2, "dir-b-longer-handle", nullptr);
+
+    vector<Event*> events;
+    mListener->ParseFanotifyEvents(buf.data(), buf.size(), events);
+    APSARA_TEST_EQUAL_FATAL(events.size(), 4U);
+    APSARA_TEST_EQUAL(events[0]->GetWd(), wd);
+    APSARA_TEST_EQUAL(events[0]->GetObject(), "a.log");
+    APSARA_TEST_EQUAL(events[0]->GetType(), EVENT_CREATE);
+    APSARA_TEST_EQUAL(events[0]->GetSource(), "");
+    APSARA_TEST_EQUAL(events[1]->GetWd(), wd);
+    APSARA_TEST_EQUAL(events[1]->GetType(), EVENT_MODIFY);
+    APSARA_TEST_EQUAL(events[2]->GetWd(), wdDir);
+    APSARA_TEST_EQUAL(events[2]->GetObject(), "");
+    APSARA_TEST_EQUAL(events[2]->GetType(), EVENT_TIMEOUT | EVENT_ISDIR);
+    APSARA_TEST_EQUAL(events[3]->GetWd(), wdDir);
+    APSARA_TEST_EQUAL(events[3]->GetObject(), "");
+    APSARA_TEST_EQUAL(events[3]->GetType(), EVENT_MOVE_TO | EVENT_ISDIR);
+    for (auto event : events) {
+        delete event;
+    }
+    events.clear();
+
+    // events of a removed directory are dropped
+    APSARA_TEST_TRUE(mListener->RemoveWatch(wd));
+    mListener->ParseFanotifyEvents(buf.data(), buf.size(), events);
+    APSARA_TEST_EQUAL_FATAL(events.size(), 2U);
+    APSARA_TEST_EQUAL(events[0]->GetWd(), wdDir);
+    APSARA_TEST_EQUAL(events[1]->GetWd(), wdDir);
+    for (auto event : events) {
+        delete event;
+    }
+    events.clear();
+
+    // a truncated event is not parsed
+    mListener->ParseFanotifyEvents(buf.data(), sizeof(struct fanotify_event_metadata) - 1, events);
+    APSARA_TEST_TRUE(events.empty());
+#endif
+}
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include "common/TimeUtil.h"
+#include "file_server/FileDiscoveryIndex.h"
+#include "logger/Logger.h"
+#include "pipeline/PipelineContext.h"
+
+using namespace std;
+using namespace logtail;
+
+// Synthetic config set like a node running many pods: each config collects one app, some by wildcard paths.
+static void BuildConfigs(int configCount,
+                         PipelineContext& ctx,
+                         vector<unique_ptr<FileDiscoveryOptions>>& options,
+                         vector<FileDiscoveryConfig>& configs,
+                         FileDiscoveryIndex& index) {
+    for (int i = 0; i < configCount; ++i) {
+        string filePath;
+        switch (i % 4) {
+            case 0:
+                filePath = "/home/admin/app" + to_string(i) + "/logs/*.log";
+                break;
+            case 1:
+                filePath = "/var/log/service" + to_string(i) + "/**/*.log";
+                break;
+            case 2:
+                filePath = "/data/team" + to_string(i % 20) + "/*/app" + to_string(i) + "/*.log";
+                break;
+            default:
+                filePath = "/opt/app" + to_string(i) + "/log/access*.log";
+                break;
+        }
+        Json::Value configJson;
+        configJson["FilePaths"].append(Json::Value(filePath));
+        configJson["MaxDirSearchDepth"] = Json::Value(i % 4 == 1 ? 3 : 0);
+        unique_ptr<FileDiscoveryOptions> option(new FileDiscoveryOptions());
+        if (!option->Init(configJson, ctx, "bench")) {
+            continue;
+        }
+        configs.emplace_back(option.get(), &ctx);
+        index.Add("config" + to_string(i), configs.back());
+        options.push_back(std::move(option));
+    }
+}
+
+static void BM_FindAllMatch(int configCount, int pathCount) {
+    PipelineContext ctx;
+    vector<unique_ptr<FileDiscoveryOptions>> options;
+    vector<FileDiscoveryConfig> configs;
+    FileDiscoveryIndex index;
+    BuildConfigs(configCount, ctx, options, configs, index);
+
+    vector<string> paths;
+    for (int i = 0; i < pathCount; ++i) {
+        int app = i % configCount;
+        switch (i % 5) {
+            case 0:
+                paths.push_back("/home/admin/app" + to_string(app) + "/logs");
+                break;
+            case 1:
+                paths.push_back("/var/log/service" + to_string(app) + "/pod" + to_string(i) + "/container");
+                break;
+            case 2:
+                paths.push_back("/data/team" + to_string(app % 20) + "/ns" + to_string(i) + "/app" + to_string(app));
+                break;
+            case 3:
+                paths.push_back("/opt/app" + to_string(app) + "/log");
+                break;
+            default:
+                // new directories created by container churn which match nothing
+                paths.push_back("/var/lib/containers/overlay/" + to_string(i) + "/merged/tmp");
+                break;
+        }
+    }
+
+    size_t scanMatches = 0;
+    uint64_t startTime = GetCurrentTimeInMicroSeconds();
+    for (const auto& path : paths) {
+        for (const auto& config : configs) {
+            if (config.first->IsMatch(path, "access.log")) {
+                ++scanMatches;
+            }
+        }
+    }
+    uint64_t scanTime = GetCurrentTimeInMicroSeconds() - startTime;
+
+    size_t indexMatches = 0;
+    vector<FileDiscoveryConfig> candidates;
+    startTime = GetCurrentTimeInMicroSeconds();
+    for (const auto& path : paths) {
+        candidates.clear();
+        index.FindCandidates(path, candidates);
+        for (const auto& config : candidates) {
+            if (config.first->IsMatch(path, "access.log")) {
+                ++indexMatches;
+            }
+        }
+    }
+    uint64_t indexTime = GetCurrentTimeInMicroSeconds() - startTime;
+
+    cout << "configs: " << configs.size() << " paths: " << paths.size() << endl;
+    cout << "full scan: " << scanTime << "us, matches: " << scanMatches << endl;
+    cout << "index: " << indexTime << "us, matches: " << indexMatches << endl;
+}
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+
+    BM_FindAllMatch(100, 10000);
+    BM_FindAllMatch(800, 10000);
+    BM_FindAllMatch(3000, 10000);
+    return 0;
+}
@@ -0,0 +1,161 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include "file_server/FileDiscoveryIndex.h"
+#include "pipeline/PipelineContext.h"
+#include "unittest/Unittest.h"
+
+using namespace std;
+
+namespace logtail {
+
+class FileDiscoveryIndexUnittest : public testing::Test {
+public:
+    void TestFindCandidates();
+    void TestRemove();
+    void TestSameMatchAsFullScan();
+
+protected:
+    FileDiscoveryConfig AddConfig(const string& name, const string& filePath, int32_t maxDepth = 0) {
+        Json::Value configJson;
+        configJson["FilePaths"].append(Json::Value(filePath));
+        configJson["MaxDirSearchDepth"] = Json::Value(maxDepth);
+        unique_ptr<FileDiscoveryOptions> options(new FileDiscoveryOptions());
+        APSARA_TEST_TRUE(options->Init(configJson, mCtx, "test"));
+        FileDiscoveryConfig config = make_pair(options.get(), &mCtx);
+        mOptions.push_back(std::move(options));
+        mIndex.Add(name, config);
+        return config;
+    }
+
+    vector<const FileDiscoveryOptions*> FindCandidates(const string& path) {
+        vector<FileDiscoveryConfig> candidates;
+        mIndex.FindCandidates(path, candidates);
+        vector<const FileDiscoveryOptions*> res;
+        for (const auto& item : candidates) {
+            res.push_back(item.first);
+        }
+        sort(res.begin(), res.end());
+        return res;
+    }
+
+    PipelineContext mCtx;
+    vector<unique_ptr<FileDiscoveryOptions>> mOptions;
+    FileDiscoveryIndex mIndex;
+};
+
+UNIT_TEST_CASE(FileDiscoveryIndexUnittest, TestFindCandidates);
+UNIT_TEST_CASE(FileDiscoveryIndexUnittest, TestRemove);
+UNIT_TEST_CASE(FileDiscoveryIndexUnittest, TestSameMatchAsFullScan);
+
+void FileDiscoveryIndexUnittest::TestFindCandidates() {
+    auto app = AddConfig("app", "/home/admin/app/*.log", 3);
+    auto admin = AddConfig("admin", "/home/admin/*.log", -1);
+    auto wildcard = AddConfig("wildcard", "/home/*/logs/*.log");
+    auto other = AddConfig("other", "/var/log/*.log");
+    APSARA_TEST_EQUAL(4U, mIndex.Size());
+
+    vector<const FileDiscoveryOptions*> expected = {app.first, admin.first, wildcard.first};
+    sort(expected.begin(), expected.end());
+    APSARA_TEST_TRUE(expected == FindCandidates("/home/admin/app/sub"));
+    expected = {admin.first, wildcard.first};
+    sort(expected.begin(), expected.end());
+    APSARA_TEST_TRUE(expected == FindCandidates("/home/admin/application"));
+    APSARA_TEST_TRUE(expected == FindCandidates("/home//admin/"));
+    expected = {wildcard.first};
+    APSARA_TEST_TRUE(expected == FindCandidates("/home"));
+    expected = {other.first};
+    APSARA_TEST_TRUE(expected == FindCandidates("/var/log"));
+    APSARA_TEST_TRUE(FindCandidates("/var/lib/log").empty());
+    APSARA_TEST_TRUE(FindCandidates("/").empty());
+
+    // Configs with container discovery are always candidates.
+    Json::Value configJson;
+    configJson["FilePaths"].append(Json::Value("/app/*.log"));
+    unique_ptr<FileDiscoveryOptions> options(new FileDiscoveryOptions());
+    APSARA_TEST_TRUE(options->Init(configJson, mCtx, "test"));
+    options->SetEnableContainerDiscoveryFlag(true);
+    mIndex.Add("container", make_pair(options.get(), &mCtx));
+    expected = {options.get()};
+    APSARA_TEST_TRUE(expected == FindCandidates("/var/lib/log"));
+}
+
+void FileDiscoveryIndexUnittest::TestRemove() {
+    auto first = AddConfig("first", "/home/admin/*.log");
+    auto second = AddConfig("second", "/home/admin/*.log");
+    mIndex.Remove("first");
+    vector<const FileDiscoveryOptions*> expected = {second.first};
+    APSARA_TEST_TRUE(expected == FindCandidates("/home/admin"));
+    // Adding again with the same name replaces the old config.
+    auto replaced = AddConfig("second", "/var/log/*.log");
+    APSARA_TEST_TRUE(FindCandidates("/home/admin").empty());
+    expected = {replaced.first};
+    APSARA_TEST_TRUE(expected == FindCandidates("/var/log"));
+    mIndex.Remove("second");
+    mIndex.Remove("not_exist");
+    APSARA_TEST_EQUAL(0U, mIndex.Size());
+    APSARA_TEST_TRUE(FindCandidates("/var/log").empty());
+}
+
+void FileDiscoveryIndexUnittest::TestSameMatchAsFullScan() {
+    const vector<string> filePaths = {"/home/admin/*.log",
+                                      "/home/admin/app/access.log",
+                                      "/home/*/logs/*.log",
+                                      "/home/admin/*/logs/*.log",
+                                      "/var/log/**/*.log",
+                                      "/var/log/nginx/*.log",
+                                      "/data/app?/log/*.txt",
+                                      "/*.log"};
+    vector<FileDiscoveryConfig> all;
+    for (size_t i = 0; i < filePaths.size(); ++i) {
+        all.push_back(AddConfig("config" + to_string(i), filePaths[i], i % 3 == 0 ? -1 : (int32_t)i));
+    }
+    const vector<string> dirs = {"/",
+                                 "/home",
+                                 "/home/admin",
+                                 "/home/admin/app",
+                                 "/home/admin/app/logs",
+                                 "/home/admin/app/logs/a/b/c/d",
+                                 "/home/other/logs",
+                                 "/var/log",
+                                 "/var/log/nginx",
+                                 "/var/log/nginx/a/b",
+                                 "/var/logs",
+                                 "/data/app1/log",
+                                 "/data/app12/log"};
+    const vector<string> names = {"", "access.log", "a.txt", "b"};
+    for (const auto& dir : dirs) {
+        vector<FileDiscoveryConfig> candidates;
+        mIndex.FindCandidates(dir, candidates);
+        for (const auto& name : names) {
+            for (const auto& config : all) {
+                if (config.first->IsMatch(dir, name)) {
+                    bool found = find(candidates.begin(), candidates.end(), config) != candidates.end();
+                    APSARA_TEST_TRUE_DESC(found, dir + " " + name + " " + config.first->GetBasePath());
+                }
+            }
+        }
+    }
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,95 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "go_pipeline/FlatLogGroup.h"
+#include "logger/Logger.h"
+
+using namespace std;
+
+namespace logtail {
+
+// FlatLogGroupBenchmark measures the groups/s the C++ side of the Go pipeline bridge encodes, with protobuf as
+// ProcessLogGroup did and with the flat format. The Go side is measured by BenchmarkLogGroupUnmarshal in
+// pkg/protocol/sls_logs_flat_test.go.
+class FlatLogGroupBenchmark {
+public:
+    static void Run(uint32_t logCount, uint32_t contentCount, uint32_t groups) {
+        sls_logs::LogGroup logGroup;
+        logGroup.set_category("logstore");
+        logGroup.set_source("192.168.0.1");
+        for (uint32_t i = 0; i < logCount; ++i) {
+            auto log = logGroup.add_logs();
+            log->set_time(1700000000 + i);
+            for (uint32_t j = 0; j < contentCount; ++j) {
+                auto content = log->add_contents();
+                content->set_key("key" + to_string(j));
+                content->set_value("value of log " + to_string(i) + " field " + to_string(j));
+            }
+        }
+        auto tag = logGroup.add_logtags();
+        tag->set_key("__path__");
+        tag->set_value("/var/log/app/access.log");
+
+        size_t pbBytes = 0;
+        uint64_t pbNs = Measure([&]() {
+            for (uint32_t i = 0; i < groups; ++i) {
+                // a new string per group, as ProcessLogGroup hands it to Go
+                string pb = logGroup.SerializeAsString();
+                pbBytes += pb.size();
+            }
+        });
+        size_t flatBytes = 0;
+        FlatLogGroupWriter writer;
+        uint64_t flatNs = Measure([&]() {
+            for (uint32_t i = 0; i < groups; ++i) {
+                if (!writer.Write(logGroup)) {
+                    cout << "write flat log group failed" << endl;
+                    return;
+                }
+                flatBytes += writer.Buffer().size();
+            }
+        });
+
+        cout << "logs: " << logCount << ", contents: " << contentCount << ", groups: " << groups << endl;
+        cout << "  protobuf: " << groups * 1e9 / pbNs << " groups/s, " << pbBytes / groups << " bytes/group" << endl;
+        cout << "  flat: " << groups * 1e9 / flatNs << " groups/s, " << flatBytes / groups << " bytes/group" << endl;
+    }
+
+private:
+    template <typename Func>
+    static uint64_t Measure(Func func) {
+        auto start = chrono::steady_clock::now();
+        func();
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+    logtail::FlatLogGroupBenchmark::Run(10, 5, 100000);
+    logtail::FlatLogGroupBenchmark::Run(100, 10, 10000);
+    logtail::FlatLogGroupBenchmark::Run(1000, 20, 1000);
+    return 0;
+}
@@ -0,0 +1,219 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "common/RuntimeUtil.h"
+#include "go_pipeline/FlatLogGroup.h"
+#include "logger/Logger.h"
+#include "unittest/Unittest.h"
+
+using namespace std;
+
+namespace logtail {
+
+class FlatLogGroupUnittest : public ::testing::Test {
+public:
+    void TestWrite();
+    void TestEmptyStrings();
+    void TestValuesNotSupported();
+    void TestReuseBuffer();
+    void TestGolden();
+
+private:
+    template <typename T>
+    static T Read(const string& buffer, size_t offset) {
+        T record;
+        memcpy(&record, buffer.data() + offset, sizeof(T));
+        return record;
+    }
+
+    static string Str(const string& buffer, const FlatString& flat) {
+        if (flat.offset + flat.len > buffer.size()) {
+            return "<out of buffer>";
+        }
+        return buffer.substr(flat.offset, flat.len);
+    }
+
+    static void AddLog(sls_logs::LogGroup& logGroup, uint32_t time, size_t contentCount) {
+        auto log = logGroup.add_logs();
+        log->set_time(time);
+        for (size_t i = 0; i < contentCount; ++i) {
+            auto content = log->add_contents();
+            content->set_key("key" + to_string(i));
+            content->set_value("value" + to_string(time) + "_" + to_string(i));
+        }
+    }
+
+    static void AddContent(sls_logs::Log* log, const string& key, const string& value) {
+        auto content = log->add_contents();
+        content->set_key(key);
+        content->set_value(value);
+    }
+};
+
+void FlatLogGroupUnittest::TestWrite() {
+    sls_logs::LogGroup logGroup;
+    logGroup.set_category("logstore");
+    logGroup.set_topic("topic");
+    logGroup.set_source("192.168.0.1");
+    AddLog(logGroup, 100, 2);
+    AddLog(logGroup, 101, 0);
+    AddLog(logGroup, 102, 1);
+    logGroup.mutable_logs(2)->set_time_ns(999);
+    auto tag = logGroup.add_logtags();
+    tag->set_key("__path__");
+    tag->set_value("/var/log/a.log");
+
+    FlatLogGroupWriter writer;
+    APSARA_TEST_TRUE_FATAL(writer.Write(logGroup));
+    const string& buffer = writer.Buffer();
+
+    auto header = Read<FlatLogGroupHeader>(buffer, 0);
+    APSARA_TEST_EQUAL(kFlatLogGroupMagic, header.magic);
+    APSARA_TEST_EQUAL(3U, header.logCount);
+    APSARA_TEST_EQUAL(3U, header.contentCount);
+    APSARA_TEST_EQUAL(1U, header.tagCount);
+    APSARA_TEST_EQUAL("logstore", Str(buffer, header.category));
+    APSARA_TEST_EQUAL("topic", Str(buffer, header.topic));
+    APSARA_TEST_EQUAL("192.168.0.1", Str(buffer, header.source));
+    APSARA_TEST_EQUAL("", Str(buffer, header.machineUUID));
+
+    size_t offset = sizeof(FlatLogGroupHeader);
+    uint32_t expectedContentCounts[] = {2, 0, 1};
+    for (uint32_t i = 0; i < 3; ++i) {
+        auto log = Read<FlatLog>(buffer, offset);
+        APSARA_TEST_EQUAL(100 + i, log.time);
+        APSARA_TEST_EQUAL(expectedContentCounts[i], log.contentCount);
+        APSARA_TEST_EQUAL(i == 2 ? 1U : 0U, log.hasTimeNs);
+        APSARA_TEST_EQUAL(i == 2 ? 999U : 0U, log.timeNs);
+        offset += sizeof(FlatLog);
+    }
+    const char* expectedContents[][2] = {{"key0", "value100_0"}, {"key1", "value100_1"}, {"key0", "value102_0"}};
+    for (auto& expected : expectedContents) {
+        auto pair = Read<FlatPair>(buffer, offset);
+        APSARA_TEST_EQUAL(expected[0], Str(buffer, pair.key));
+        APSARA_TEST_EQUAL(expected[1], Str(buffer, pair.value));
+        offset += sizeof(FlatPair);
+    }
+    auto pair = Read<FlatPair>(buffer, offset);
+    APSARA_TEST_EQUAL("__path__", Str(buffer, pair.key));
+    APSARA_TEST_EQUAL("/var/log/a.log", Str(buffer, pair.value));
+    offset += sizeof(FlatPair);
+
+    // all records are followed by the strings, with nothing left over
+    size_t stringBytes = strlen("logstore") + strlen("topic") + strlen("192.168.0.1") + strlen("__path__")
+        + strlen("/var/log/a.log");
+    for (auto& expected : expectedContents) {
+        stringBytes += strlen(expected[0]) + strlen(expected[1]);
+    }
+    APSARA_TEST_EQUAL(offset + stringBytes, buffer.size());
+}
+
+void FlatLogGroupUnittest::TestEmptyStrings() {
+    sls_logs::LogGroup logGroup;
+    auto log = logGroup.add_logs();
+    log->set_time(1);
+    auto content = log->add_contents();
+    content->set_key("");
+    content->set_value("");
+
+    FlatLogGroupWriter writer;
+    APSARA_TEST_TRUE_FATAL(writer.Write(logGroup));
+    const string& buffer = writer.Buffer();
+    APSARA_TEST_EQUAL(sizeof(FlatLogGroupHeader) + sizeof(FlatLog) + sizeof(FlatPair), buffer.size());
+    auto pair = Read<FlatPair>(buffer, sizeof(FlatLogGroupHeader) + sizeof(FlatLog));
+    APSARA_TEST_EQUAL(0U, pair.key.len);
+    APSARA_TEST_EQUAL(0U, pair.value.len);
+}
+
+void FlatLogGroupUnittest::TestValuesNotSupported() {
+    sls_logs::LogGroup logGroup;
+    AddLog(logGroup, 1, 1);
+    logGroup.mutable_logs(0)->add_values("value");
+    FlatLogGroupWriter writer;
+    APSARA_TEST_FALSE(writer.Write(logGroup));
+}
+
+void FlatLogGroupUnittest::TestReuseBuffer() {
+    sls_logs::LogGroup largeGroup;
+    for (uint32_t i = 0; i < 100; ++i) {
+        AddLog(largeGroup, i, 10);
+    }
+    sls_logs::LogGroup smallGroup;
+    AddLog(smallGroup, 1, 1);
+
+    FlatLogGroupWriter writer;
+    APSARA_TEST_TRUE_FATAL(writer.Write(largeGroup));
+    const char* data = writer.Buffer().data();
+    APSARA_TEST_TRUE_FATAL(writer.Write(smallGroup));
+    APSARA_TEST_EQUAL(data, writer.Buffer().data());
+    APSARA_TEST_EQUAL(sizeof(FlatLogGroupHeader) + sizeof(FlatLog) + sizeof(FlatPair) + strlen("key0value1_0"),
+                      writer.Buffer().size());
+    APSARA_TEST_TRUE_FATAL(writer.Write(largeGroup));
+    APSARA_TEST_EQUAL(data, writer.Buffer().data());
+}
+
+// TestGolden checks the writer against flat_log_group.golden, which TestLogGroupFlatGolden in
+// pkg/protocol/sls_logs_flat_test.go decodes, so the two sides cannot drift apart. The group must be kept the same as
+// newFlatGoldenLogGroup there.
+void FlatLogGroupUnittest::TestGolden() {
+    sls_logs::LogGroup logGroup;
+    logGroup.set_category("logstore");
+    logGroup.set_topic("topic");
+    logGroup.set_source("192.168.0.1");
+    logGroup.set_machineuuid("machine-uuid");
+    auto log = logGroup.add_logs();
+    log->set_time(1700000000);
+    log->set_time_ns(123456789);
+    AddContent(log, "method", "GET");
+    AddContent(log, "status", "200");
+    logGroup.add_logs()->set_time(1700000001);
+    log = logGroup.add_logs();
+    log->set_time(1700000002);
+    AddContent(log, "", "");
+    AddContent(log, "msg", "\xe4\xb8\xad\xe6\x96\x87 text");
+    auto tag = logGroup.add_logtags();
+    tag->set_key("__path__");
+    tag->set_value("/var/log/app/access.log");
+    tag = logGroup.add_logtags();
+    tag->set_key("__hostname__");
+    tag->set_value("host-0");
+
+    ifstream fin(GetProcessExecutionDir() + "testDataSet/flat_log_group.golden", ios::binary);
+    APSARA_TEST_TRUE_FATAL(fin.good());
+    string golden((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+
+    FlatLogGroupWriter writer;
+    APSARA_TEST_TRUE_FATAL(writer.Write(logGroup));
+    APSARA_TEST_EQUAL(golden.size(), writer.Buffer().size());
+    APSARA_TEST_TRUE(golden == writer.Buffer());
+}
+
+UNIT_TEST_CASE(FlatLogGroupUnittest, TestWrite);
+UNIT_TEST_CASE(FlatLogGroupUnittest, TestEmptyStrings);
+UNIT_TEST_CASE(FlatLogGroupUnittest, TestValuesNotSupported);
+UNIT_TEST_CASE(FlatLogGroupUnittest, TestReuseBuffer);
+UNIT_TEST_CASE(FlatLogGroupUnittest, TestGolden);
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
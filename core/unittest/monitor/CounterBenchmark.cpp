@@ -0,0 +1,84 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "logger/Logger.h"
+#include "monitor/LogtailMetric.h"
+
+using namespace std;
+
+namespace logtail {
+
+// CounterBenchmark measures adding to one counter from many threads at once, with a single atomic as Counter used
+// to be and with the sharded Counter.
+class CounterBenchmark {
+public:
+    static void Run(uint32_t threadCount, uint32_t addsPerThread) {
+        atomic_long single(0);
+        uint64_t singleNs = Measure(threadCount, [&]() {
+            for (uint32_t i = 0; i < addsPerThread; ++i) {
+                single += 1;
+            }
+        });
+        Counter sharded("benchmark", 0);
+        uint64_t shardedNs = Measure(threadCount, [&]() {
+            for (uint32_t i = 0; i < addsPerThread; ++i) {
+                sharded.Add(1);
+            }
+        });
+        if (static_cast<uint64_t>(single) != sharded.GetValue()) {
+            cout << "counters differ: " << single << " " << sharded.GetValue() << endl;
+            return;
+        }
+
+        uint64_t adds = static_cast<uint64_t>(threadCount) * addsPerThread;
+        cout << "threads: " << threadCount << ", adds: " << adds << endl;
+        cout << "  atomic: " << static_cast<double>(singleNs) / adds
+             << "ns/add, sharded: " << static_cast<double>(shardedNs) / adds << "ns/add" << endl;
+    }
+
+private:
+    template <typename Func>
+    static uint64_t Measure(uint32_t threadCount, Func func) {
+        vector<thread> threads;
+        auto start = chrono::steady_clock::now();
+        for (uint32_t i = 0; i < threadCount; ++i) {
+            threads.emplace_back(func);
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+    for (uint32_t threadCount : {1, 2, 4, 8, 16}) {
+        logtail::CounterBenchmark::Run(threadCount, 10000000);
+    }
+    return 0;
+}
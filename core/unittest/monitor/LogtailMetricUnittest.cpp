@@ -40,11 +40,19 @@ public:
     void TestCreateMetricAutoDelete();
     void TestCreateMetricAutoDeleteMultiThread();
     void TestCreateAndDeleteMetric();
+    void TestHistogram();
+    void TestHistogramMultiThread();
+    void TestHistogramExport();
+    void TestCounterMultiThread();
 };
 
 APSARA_UNIT_TEST_CASE(ILogtailMetricUnittest, TestCreateMetricAutoDelete, 0);
 APSARA_UNIT_TEST_CASE(ILogtailMetricUnittest, TestCreateMetricAutoDeleteMultiThread, 1);
 APSARA_UNIT_TEST_CASE(ILogtailMetricUnittest, TestCreateAndDeleteMetric, 2);
+APSARA_UNIT_TEST_CASE(ILogtailMetricUnittest, TestHistogram, 3);
+APSARA_UNIT_TEST_CASE(ILogtailMetricUnittest, TestHistogramMultiThread, 4);
+APSARA_UNIT_TEST_CASE(ILogtailMetricUnittest, TestHistogramExport, 5);
+APSARA_UNIT_TEST_CASE(ILogtailMetricUnittest, TestCounterMultiThread, 6);
 
 
 void ILogtailMetricUnittest::TestCreateMetricAutoDelete() {
@@ -328,6 +336,129 @@ void ILogtailMetricUnittest::TestCreateAndDeleteMetric() {
     delete fileMetric1;
 }
 
+void ILogtailMetricUnittest::TestHistogram() {
+    APSARA_TEST_EQUAL(Histogram::BucketIndex(0), 0);
+    APSARA_TEST_EQUAL(Histogram::BucketIndex(1), 1);
+    APSARA_TEST_EQUAL(Histogram::BucketIndex(2), 2);
+    APSARA_TEST_EQUAL(Histogram::BucketIndex(3), 2);
+    APSARA_TEST_EQUAL(Histogram::BucketIndex(1000), 10);
+    APSARA_TEST_EQUAL(Histogram::BucketIndex(UINT64_MAX), Histogram::kBucketCount - 1);
+
+    Histogram histogram("latency");
+    APSARA_TEST_EQUAL(histogram.GetQuantile(0.5), 0);
+    // 90 fast values in [64, 128) and 10 slow ones in [4096, 8192)
+    for (int i = 0; i < 90; ++i) {
+        histogram.Observe(100);
+    }
+    for (int i = 0; i < 10; ++i) {
+        histogram.Observe(5000);
+    }
+    APSARA_TEST_EQUAL(histogram.GetCount(), 100);
+    APSARA_TEST_EQUAL(histogram.GetSum(), 90 * 100 + 10 * 5000);
+    APSARA_TEST_EQUAL(histogram.GetQuantile(0.5), 127);
+    APSARA_TEST_EQUAL(histogram.GetQuantile(0.9), 127);
+    APSARA_TEST_EQUAL(histogram.GetQuantile(0.99), 8191);
+    histogram.Observe(UINT32_MAX);
+    APSARA_TEST_EQUAL(histogram.GetQuantile(1), 1ULL << (Histogram::kBucketCount - 2));
+
+    std::unique_ptr<Histogram> snapshot(histogram.CopyAndReset());
+    APSARA_TEST_EQUAL(snapshot->GetName(), "latency");
+    APSARA_TEST_EQUAL(snapshot->GetCount(), 101);
+    APSARA_TEST_EQUAL(snapshot->GetQuantile(0.5), 127);
+    APSARA_TEST_EQUAL(histogram.GetCount(), 0);
+    APSARA_TEST_EQUAL(histogram.GetSum(), 0);
+}
+
+void ILogtailMetricUnittest::TestHistogramMultiThread() {
+    HistogramPtr histogram = std::make_shared<Histogram>("latency");
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([histogram, i]() {
+            for (int j = 0; j < 10000; ++j) {
+                histogram->Observe(i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    APSARA_TEST_EQUAL(histogram->GetCount(), 80000);
+    APSARA_TEST_EQUAL(histogram->GetSum(), 10000 * (0 + 1 + 2 + 3 + 4 + 5 + 6 + 7));
+
+    {
+        HistogramTimer timer(histogram);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    APSARA_TEST_EQUAL(histogram->GetCount(), 80001);
+    APSARA_TEST_TRUE(histogram->GetSum() >= 10000 * 28 + 2000);
+
+    // the timer keeps the histogram, so it may outlive the pointer it is made from
+    {
+        HistogramPtr copy = histogram;
+        HistogramTimer timer(copy);
+        copy.reset();
+    }
+    APSARA_TEST_EQUAL(histogram->GetCount(), 80002);
+}
+
+void ILogtailMetricUnittest::TestHistogramExport() {
+    std::vector<std::pair<std::string, std::string>> labels;
+    labels.emplace_back(std::make_pair<std::string, std::string>("region", "cn-hangzhou"));
+    MetricsRecordRef metric;
+    WriteMetrics::GetInstance()->PrepareMetricsRecordRef(metric, std::move(labels));
+    HistogramPtr histogram = metric.CreateHistogram("proc_latency_us");
+    histogram->Observe(100);
+    histogram->Observe(300);
+
+    ReadMetrics::GetInstance()->UpdateMetrics();
+    // recorded values move to the snapshot
+    APSARA_TEST_EQUAL(histogram->GetCount(), 0);
+    std::map<std::string, sls_logs::LogGroup*> logGroupMap;
+    ReadMetrics::GetInstance()->ReadAsLogGroup(logGroupMap);
+    APSARA_TEST_EQUAL(logGroupMap.size(), 1);
+    sls_logs::LogGroup* logGroup = logGroupMap["cn-hangzhou"];
+    APSARA_TEST_TRUE_FATAL(logGroup != nullptr);
+    APSARA_TEST_EQUAL(logGroup->logs_size(), 1);
+    std::map<std::string, std::string> contents;
+    for (auto& content : logGroup->logs(0).contents()) {
+        contents[content.key()] = content.value();
+    }
+    APSARA_TEST_EQUAL(contents[VALUE_PREFIX + "proc_latency_us_count"], "2");
+    APSARA_TEST_EQUAL(contents[VALUE_PREFIX + "proc_latency_us_sum"], "400");
+    APSARA_TEST_EQUAL(contents[VALUE_PREFIX + "proc_latency_us_p50"], "127");
+    APSARA_TEST_EQUAL(contents[VALUE_PREFIX + "proc_latency_us_p90"], "511");
+    APSARA_TEST_EQUAL(contents[VALUE_PREFIX + "proc_latency_us_p99"], "511");
+    for (auto& item : logGroupMap) {
+        delete item.second;
+    }
+}
+
+void ILogtailMetricUnittest::TestCounterMultiThread() {
+    CounterPtr counter = std::make_shared<Counter>("in_records", 5);
+    APSARA_TEST_EQUAL(counter->GetValue(), 5);
+    // more threads than shards, so that some threads share a slot
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < Counter::kShardCount * 2; ++i) {
+        threads.emplace_back([counter]() {
+            for (int j = 0; j < 10000; ++j) {
+                counter->Add(2);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    APSARA_TEST_EQUAL(counter->GetValue(), 5 + Counter::kShardCount * 2 * 20000);
+
+    std::unique_ptr<Counter> snapshot(counter->CopyAndReset());
+    APSARA_TEST_EQUAL(snapshot->GetName(), "in_records");
+    APSARA_TEST_EQUAL(snapshot->GetValue(), 5 + Counter::kShardCount * 2 * 20000);
+    APSARA_TEST_EQUAL(counter->GetValue(), 0);
+    counter->Add(3);
+    APSARA_TEST_EQUAL(counter->GetAndReset(), 3);
+    APSARA_TEST_EQUAL(counter->GetValue(), 0);
+}
+
 } // namespace logtail
 
 int main(int argc, char** argv) {
@@ -0,0 +1,179 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "common/Flags.h"
+#include "common/RuntimeUtil.h"
+#include "logger/Logger.h"
+#include "monitor/SamplingProfiler.h"
+#include "unittest/Unittest.h"
+
+DECLARE_FLAG_INT32(sampling_profiler_hz);
+DECLARE_FLAG_INT32(sampling_profiler_max_stacks);
+DECLARE_FLAG_INT32(sampling_profiler_dump_interval);
+DECLARE_FLAG_STRING(sampling_profiler_file_name);
+
+using namespace std;
+
+namespace logtail {
+
+class SamplingProfilerUnittest : public ::testing::Test {
+public:
+    void TestAddSample();
+    void TestTableFull();
+    void TestTableReset();
+    void TestSetTimer();
+    void TestSampleThreads();
+
+protected:
+    void SetUp() override {
+        mProfiler = SamplingProfiler::GetInstance();
+        INT32_FLAG(sampling_profiler_max_stacks) = 64;
+        mProfiler->AllocateTables();
+        Clear();
+    }
+
+    void TearDown() override { Clear(); }
+
+private:
+    void Clear() {
+        mProfiler->ClearTable(0);
+        mProfiler->ClearTable(1);
+        mProfiler->mDroppedSamples = 0;
+    }
+
+    SamplingProfiler* mProfiler = nullptr;
+};
+
+void SamplingProfilerUnittest::TestAddSample() {
+    // leaf first, as unwound
+    uintptr_t stack1[] = {0x1000, 0x2000, 0x3000};
+    uintptr_t stack2[] = {0x1100, 0x2000, 0x3000};
+    mProfiler->AddSample("process", stack1, 3);
+    mProfiler->AddSample("process", stack1, 3);
+    mProfiler->AddSample("process", stack2, 3);
+    mProfiler->AddSample("sender", stack1, 3);
+
+    // callers are looked up one byte before their return address
+    APSARA_TEST_EQUAL(mProfiler->FoldStacks(),
+                      "process;0x2fff;0x1fff;0x1000 2\n"
+                      "process;0x2fff;0x1fff;0x1100 1\n"
+                      "sender;0x2fff;0x1fff;0x1000 1\n");
+    // only stacks sampled since the last fold are reported
+    APSARA_TEST_EQUAL(mProfiler->FoldStacks(), "");
+    mProfiler->AddSample("process", stack2, 3);
+    APSARA_TEST_EQUAL(mProfiler->FoldStacks(), "process;0x2fff;0x1fff;0x1100 1\n");
+    mProfiler->AddSample(nullptr, stack2, 1);
+    APSARA_TEST_EQUAL(mProfiler->FoldStacks(), "unnamed;0x1100 1\n");
+}
+
+void SamplingProfilerUnittest::TestTableFull() {
+    size_t stacks = mProfiler->mTableSize * 4;
+    for (uintptr_t pc = 1; pc <= stacks; ++pc) {
+        mProfiler->AddSample("process", &pc, 1);
+    }
+    // every stack is either kept or counted as dropped
+    istringstream folded(mProfiler->FoldStacks());
+    string line;
+    size_t lines = 0;
+    while (getline(folded, line)) {
+        ++lines;
+    }
+    APSARA_TEST_TRUE(lines <= mProfiler->mTableSize);
+    APSARA_TEST_EQUAL(lines + mProfiler->mDroppedSamples, stacks);
+}
+
+void SamplingProfilerUnittest::TestTableReset() {
+    size_t stacks = mProfiler->mTableSize * 4;
+    // both tables are filled and dumped
+    for (int round = 0; round < 2; ++round) {
+        for (uintptr_t pc = 1; pc <= stacks; ++pc) {
+            mProfiler->AddSample("process", &pc, 1);
+        }
+        APSARA_TEST_TRUE(mProfiler->mDroppedSamples > 0);
+        mProfiler->FoldStacks();
+    }
+
+    // stacks first sampled after a dump are kept
+    uint64_t dropped = mProfiler->mDroppedSamples;
+    uintptr_t pc = stacks + 1;
+    mProfiler->AddSample("process", &pc, 1);
+    APSARA_TEST_EQUAL(mProfiler->mDroppedSamples.load(), dropped);
+    char expected[64];
+    snprintf(expected, sizeof(expected), "process;0x%lx 1\n", static_cast<unsigned long>(pc));
+    APSARA_TEST_EQUAL(mProfiler->FoldStacks(), expected);
+}
+
+void SamplingProfilerUnittest::TestSetTimer() {
+#if defined(__linux__)
+    // a period of a second or more does not fit in tv_usec
+    APSARA_TEST_TRUE(mProfiler->SetTimer(1));
+    APSARA_TEST_TRUE(mProfiler->SetTimer(1000));
+    APSARA_TEST_TRUE(mProfiler->SetTimer(0));
+#endif
+}
+
+void SamplingProfilerUnittest::TestSampleThreads() {
+#if defined(__linux__)
+    INT32_FLAG(sampling_profiler_hz) = 1000;
+    INT32_FLAG(sampling_profiler_dump_interval) = 3600;
+    STRING_FLAG(sampling_profiler_file_name) = "sampling_profiler_unittest.folded";
+    string path = GetProcessExecutionDir() + STRING_FLAG(sampling_profiler_file_name);
+
+    atomic_bool running(true);
+    thread busy([&running]() {
+        SamplingProfiler::SetThreadRole("busy");
+        volatile uint64_t sum = 0;
+        while (running) {
+            sum = sum + 1;
+        }
+    });
+    APSARA_TEST_TRUE_FATAL(mProfiler->Start());
+    this_thread::sleep_for(chrono::milliseconds(500));
+    mProfiler->Dump();
+
+    APSARA_TEST_TRUE(mProfiler->mSamples > 0);
+    APSARA_TEST_TRUE(mProfiler->GetThreadCpuReport().find("busy:") != string::npos);
+    ifstream fin(path);
+    string content((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+    APSARA_TEST_TRUE(content.find("busy;") != string::npos);
+
+    running = false;
+    busy.join();
+    mProfiler->Stop();
+    APSARA_TEST_FALSE(mProfiler->IsRunning());
+    remove(path.c_str());
+#endif
+}
+
+UNIT_TEST_CASE(SamplingProfilerUnittest, TestAddSample);
+UNIT_TEST_CASE(SamplingProfilerUnittest, TestTableFull);
+UNIT_TEST_CASE(SamplingProfilerUnittest, TestTableReset);
+UNIT_TEST_CASE(SamplingProfilerUnittest, TestSetTimer);
+UNIT_TEST_CASE(SamplingProfilerUnittest, TestSampleThreads);
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
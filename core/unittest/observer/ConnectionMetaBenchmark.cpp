@@ -0,0 +1,163 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "logger/Logger.h"
+#include "metas/ConnectionMetaManager.h"
+#include "SyntheticProcTree.h"
+
+using namespace std;
+
+namespace logtail {
+
+// ConnectionMetaBenchmark looks up the connections of a synthetic /proc tree for some generations, once clearing all
+// caches every generation as the manager did before, and once with incremental scanning. Netlink cannot be fetched
+// from a synthetic tree, so a fetch is simulated by building the connection infos of the namespace, and a part of
+// the connections is replaced by new ones every generation. The update of the fetched infos is also measured alone,
+// the time netlink takes to dump the sockets is not included, as it is the same in both.
+class ConnectionMetaBenchmark {
+public:
+    static void Run(uint32_t pidCount, uint32_t fdCount, uint32_t generations, uint32_t churnPercent) {
+        SyntheticProcTree tree("/tmp/ilogtail_connection_meta_benchmark");
+        for (uint32_t pid = kFirstPid; pid < kFirstPid + pidCount; ++pid) {
+            tree.AddProcess(pid, 1000, kNetNsInode);
+            for (uint32_t fd = kFirstFd; fd < kFirstFd + fdCount; ++fd) {
+                tree.AddSocket(pid, fd, Inode(pid, fd, 0));
+            }
+        }
+        ConnectionMetaManager* manager = ConnectionMetaManager::GetInstance();
+        if (!manager->Init(tree.BasePath())) {
+            cout << "init connection meta manager failed" << endl;
+            return;
+        }
+
+        uint64_t fullNs = 0;
+        uint64_t incrementalNs = 0;
+        uint64_t fullUpdateNs = 0;
+        uint64_t incrementalUpdateNs = 0;
+        for (int incremental = 0; incremental < 2; ++incremental) {
+            Reset(manager);
+            const uint32_t churnFdCount = fdCount * churnPercent / 100;
+            for (uint32_t generation = 0; generation < generations; ++generation) {
+                // sockets replaced since the last generation, which are reported by connect and close events
+                for (uint32_t pid = kFirstPid; pid < kFirstPid + pidCount; ++pid) {
+                    for (uint32_t fd = kFirstFd; fd < kFirstFd + churnFdCount; ++fd) {
+                        tree.RemoveFd(pid, fd);
+                        tree.AddSocket(pid, fd, Inode(pid, fd, generation));
+                        manager->OnConnectionChanged(pid, fd);
+                    }
+                }
+                uint64_t ns = Measure([&]() {
+                    if (incremental) {
+                        manager->GarbageCollection();
+                    } else {
+                        Reset(manager);
+                    }
+                    NetNsConnections& netNs = manager->mNetNsConnections[kNetNsInode];
+                    netNs.FetchGeneration = manager->mGeneration;
+                    unordered_map<uint32_t, ConnectionInfo> infos;
+                    Fetch(pidCount, fdCount, churnFdCount, generation, infos);
+                    (incremental ? incrementalUpdateNs : fullUpdateNs)
+                        += Measure([&]() { manager->UpdateNetNsConnections(netNs, infos); });
+                    // sources look up a connection for several events
+                    for (int lookup = 0; lookup < 4; ++lookup) {
+                        for (uint32_t pid = kFirstPid; pid < kFirstPid + pidCount; ++pid) {
+                            for (uint32_t fd = kFirstFd; fd < kFirstFd + fdCount; ++fd) {
+                                if (manager->GetConnectionInfo(pid, fd) == nullptr) {
+                                    cout << "connection not found, pid " << pid << " fd " << fd << endl;
+                                    exit(1);
+                                }
+                            }
+                        }
+                    }
+                });
+                (incremental ? incrementalNs : fullNs) += ns;
+            }
+        }
+        Reset(manager);
+
+        uint64_t lookups = 4ULL * pidCount * fdCount * generations;
+        cout << "processes: " << pidCount << ", sockets: " << pidCount * fdCount << ", generations: " << generations
+             << ", churn: " << churnPercent << "%" << endl;
+        cout << "  full: " << fullNs / generations / 1000000.0 << "ms/generation, "
+             << static_cast<double>(fullNs) / lookups << "ns/lookup, "
+             << fullUpdateNs / generations / 1000000.0 << "ms/update" << endl;
+        cout << "  incremental: " << incrementalNs / generations / 1000000.0 << "ms/generation, "
+             << static_cast<double>(incrementalNs) / lookups << "ns/lookup, "
+             << incrementalUpdateNs / generations / 1000000.0 << "ms/update" << endl;
+    }
+
+private:
+    static const uint32_t kFirstPid = 10000;
+    static const uint32_t kFirstFd = 3;
+    static const uint32_t kNetNsInode = 4026531992;
+
+    static uint32_t Inode(uint32_t pid, uint32_t fd, uint32_t generation) {
+        return ((pid - kFirstPid) << 20) + (generation << 16) + fd;
+    }
+
+    // Fetch builds the connections like netlink returns them, sockets before churnFdCount are new in generation.
+    static void Fetch(uint32_t pidCount,
+                      uint32_t fdCount,
+                      uint32_t churnFdCount,
+                      uint32_t generation,
+                      unordered_map<uint32_t, ConnectionInfo>& infos) {
+        for (uint32_t pid = kFirstPid; pid < kFirstPid + pidCount; ++pid) {
+            for (uint32_t fd = kFirstFd; fd < kFirstFd + fdCount; ++fd) {
+                uint32_t inode = Inode(pid, fd, fd < kFirstFd + churnFdCount ? generation : 0);
+                ConnectionInfo& info = infos[inode];
+                info.family = AF_INET;
+                info.localAddr = SockAddress{.Type = SockAddressType_IPV4, .Addr = SockAddressDetail{.IPV4 = 0}};
+                info.remoteAddr = info.localAddr;
+                info.localPort = 8080;
+                info.remotePort = inode & 0xffff;
+                info.stat = TCPConnectionStat::Established;
+                info.role = PacketRoleType::Server;
+            }
+        }
+    }
+
+    static void Reset(ConnectionMetaManager* manager) {
+        manager->mConnectionMeta.clear();
+        manager->mNetNsConnections.clear();
+        manager->mProcessSockets.clear();
+    }
+
+    template <typename Func>
+    static uint64_t Measure(Func func) {
+        auto start = chrono::steady_clock::now();
+        func();
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+    logtail::ConnectionMetaBenchmark::Run(100, 100, 5, 1);
+    logtail::ConnectionMetaBenchmark::Run(200, 500, 5, 1);
+    logtail::ConnectionMetaBenchmark::Run(200, 500, 5, 10);
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "observer/network/protocols/LatencySketch.h"
+
+using namespace std;
+
+namespace logtail {
+
+// LatencySketchBenchmark measures the cost of updating a latency sketch per protocol event, and of merging and
+// serializing sketches per aggregated result.
+class LatencySketchBenchmark {
+public:
+    static void Run(size_t count) {
+        mt19937_64 rng(42);
+        lognormal_distribution<double> dist(log(500000.0), 1.0);
+        vector<int64_t> values(count);
+        for (auto& value : values) {
+            value = static_cast<int64_t>(dist(rng));
+        }
+
+        LatencySketch sketch;
+        uint64_t addNs = Measure([&]() {
+            for (int64_t value : values) {
+                sketch.Add(value);
+            }
+        });
+        LatencySketch merged;
+        const size_t mergeCount = 10000;
+        uint64_t mergeNs = Measure([&]() {
+            for (size_t i = 0; i < mergeCount; ++i) {
+                merged.Merge(sketch);
+            }
+        });
+        size_t size = 0;
+        uint64_t serializeNs = Measure([&]() {
+            for (size_t i = 0; i < mergeCount; ++i) {
+                size += sketch.Serialize().size();
+            }
+        });
+
+        cout << "events: " << count << endl;
+        cout << "  add: " << static_cast<double>(addNs) / count << "ns/event" << endl;
+        cout << "  merge: " << static_cast<double>(mergeNs) / mergeCount << "ns/sketch" << endl;
+        cout << "  serialize: " << static_cast<double>(serializeNs) / mergeCount
+             << "ns/sketch, size: " << size / mergeCount << " bytes" << endl;
+        cout << "  p50: " << sketch.GetQuantile(0.5) << ", p90: " << sketch.GetQuantile(0.9)
+             << ", p99: " << sketch.GetQuantile(0.99) << endl;
+    }
+
+private:
+    template <typename Func>
+    static uint64_t Measure(Func func) {
+        auto start = chrono::steady_clock::now();
+        func();
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+    logtail::LatencySketchBenchmark::Run(1000000);
+    logtail::LatencySketchBenchmark::Run(10000000);
+    return 0;
+}
@@ -0,0 +1,164 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "unittest/Unittest.h"
+#include "observer/network/protocols/LatencySketch.h"
+
+namespace logtail {
+
+class LatencySketchUnittest : public ::testing::Test {
+public:
+    void TestQuantileAccuracy();
+    void TestMerge();
+    void TestSerialize();
+    void TestCollapse();
+    void TestWideRange();
+    void TestZeroValues();
+
+private:
+    static double ExactQuantile(std::vector<int64_t> values, double quantile) {
+        std::sort(values.begin(), values.end());
+        return static_cast<double>(values[static_cast<size_t>(quantile * (values.size() - 1))]);
+    }
+};
+
+APSARA_UNIT_TEST_CASE(LatencySketchUnittest, TestQuantileAccuracy, 0);
+APSARA_UNIT_TEST_CASE(LatencySketchUnittest, TestMerge, 0);
+APSARA_UNIT_TEST_CASE(LatencySketchUnittest, TestSerialize, 0);
+APSARA_UNIT_TEST_CASE(LatencySketchUnittest, TestCollapse, 0);
+APSARA_UNIT_TEST_CASE(LatencySketchUnittest, TestWideRange, 0);
+APSARA_UNIT_TEST_CASE(LatencySketchUnittest, TestZeroValues, 0);
+
+void LatencySketchUnittest::TestQuantileAccuracy() {
+    // latencies between 100us and 5ms in ns, log normal like real request latencies
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> dist(std::log(500000.0), 0.6);
+    std::vector<int64_t> values;
+    LatencySketch sketch;
+    for (int i = 0; i < 100000; ++i) {
+        int64_t value = std::min<int64_t>(std::max<int64_t>(static_cast<int64_t>(dist(rng)), 100000), 5000000);
+        values.push_back(value);
+        sketch.Add(value);
+    }
+    APSARA_TEST_EQUAL(sketch.GetCount(), 100000UL);
+    for (double quantile : {0.5, 0.9, 0.99}) {
+        double exact = ExactQuantile(values, quantile);
+        double estimated = sketch.GetQuantile(quantile);
+        APSARA_TEST_TRUE_DESC(std::fabs(estimated - exact) <= exact * LatencySketch::kRelativeAccuracy * 1.01,
+                              std::to_string(quantile) + " " + std::to_string(exact) + " "
+                                  + std::to_string(estimated));
+    }
+}
+
+void LatencySketchUnittest::TestMerge() {
+    LatencySketch left, right, all;
+    for (int64_t i = 1; i <= 1000; ++i) {
+        (i % 3 == 0 ? left : right).Add(i * 1000);
+        all.Add(i * 1000);
+    }
+    left.Merge(right);
+    APSARA_TEST_EQUAL(left.GetCount(), all.GetCount());
+    APSARA_TEST_EQUAL(left.Serialize(), all.Serialize());
+
+    LatencySketch empty;
+    empty.Merge(all);
+    APSARA_TEST_EQUAL(empty.Serialize(), all.Serialize());
+    all.Merge(LatencySketch());
+    APSARA_TEST_EQUAL(empty.Serialize(), all.Serialize());
+}
+
+void LatencySketchUnittest::TestSerialize() {
+    LatencySketch sketch;
+    for (int64_t i = 0; i < 500; ++i) {
+        sketch.Add(i * i * 10);
+    }
+    std::string data = sketch.Serialize();
+    LatencySketch loaded;
+    APSARA_TEST_TRUE(loaded.Deserialize(data));
+    APSARA_TEST_EQUAL(loaded.GetCount(), sketch.GetCount());
+    APSARA_TEST_EQUAL(loaded.Serialize(), data);
+    APSARA_TEST_EQUAL(loaded.GetQuantile(0.9), sketch.GetQuantile(0.9));
+
+    LatencySketch empty;
+    APSARA_TEST_TRUE(loaded.Deserialize(empty.Serialize()));
+    APSARA_TEST_TRUE(loaded.IsEmpty());
+    APSARA_TEST_EQUAL(loaded.GetQuantile(0.5), 0.0);
+
+    APSARA_TEST_FALSE(loaded.Deserialize(""));
+    APSARA_TEST_FALSE(loaded.Deserialize("0.05|0|0|1"));
+    APSARA_TEST_FALSE(loaded.Deserialize("0.02|0|x|1"));
+}
+
+void LatencySketchUnittest::TestCollapse() {
+    // values across 9 orders of magnitude need more than kMaxBuckets buckets
+    LatencySketch sketch;
+    int64_t value = 1;
+    for (int i = 0; i < 10; ++i, value *= 10) {
+        for (int j = 0; j < 100; ++j) {
+            sketch.Add(value + j);
+        }
+    }
+    APSARA_TEST_EQUAL(sketch.GetCount(), 1000UL);
+    APSARA_TEST_TRUE(sketch.mBuckets.size() <= static_cast<size_t>(LatencySketch::kMaxBuckets));
+    // high quantiles keep their accuracy, low ones are collapsed upwards
+    double p99 = sketch.GetQuantile(0.99);
+    APSARA_TEST_TRUE(std::fabs(p99 - 1000000000.0) <= 1000000000.0 * LatencySketch::kRelativeAccuracy * 1.01);
+    APSARA_TEST_TRUE(sketch.GetQuantile(0.0) >= 1.0);
+}
+
+void LatencySketchUnittest::TestWideRange() {
+    // most requests take about 10us and a few about 50ms, e.g. cache hits and misses, p99 / p50 is above 1000
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> fast(std::log(10000.0), 0.3);
+    std::lognormal_distribution<double> slow(std::log(50000000.0), 0.3);
+    std::uniform_real_distribution<double> ratio(0.0, 1.0);
+    std::vector<int64_t> values;
+    LatencySketch sketch;
+    for (int i = 0; i < 100000; ++i) {
+        int64_t value = static_cast<int64_t>(ratio(rng) < 0.97 ? fast(rng) : slow(rng));
+        values.push_back(value);
+        sketch.Add(value);
+    }
+    APSARA_TEST_TRUE(ExactQuantile(values, 0.99) / ExactQuantile(values, 0.5) > 1000);
+    // no bucket is collapsed, so low quantiles are as accurate as high ones
+    APSARA_TEST_TRUE(sketch.mBuckets.size() < static_cast<size_t>(LatencySketch::kMaxBuckets));
+    for (double quantile : {0.0, 0.5, 0.9, 0.99, 1.0}) {
+        double exact = ExactQuantile(values, quantile);
+        double estimated = sketch.GetQuantile(quantile);
+        APSARA_TEST_TRUE_DESC(std::fabs(estimated - exact) <= exact * LatencySketch::kRelativeAccuracy * 1.01,
+                              std::to_string(quantile) + " " + std::to_string(exact) + " "
+                                  + std::to_string(estimated));
+    }
+}
+
+void LatencySketchUnittest::TestZeroValues() {
+    LatencySketch sketch;
+    sketch.Add(0);
+    sketch.Add(-5);
+    sketch.Add(1000);
+    APSARA_TEST_EQUAL(sketch.GetCount(), 3UL);
+    APSARA_TEST_EQUAL(sketch.GetQuantile(0.0), 0.0);
+    APSARA_TEST_EQUAL(sketch.GetQuantile(0.5), 0.0);
+    APSARA_TEST_TRUE(std::fabs(sketch.GetQuantile(1.0) - 1000.0) <= 1000.0 * LatencySketch::kRelativeAccuracy);
+    sketch.Clear();
+    APSARA_TEST_TRUE(sketch.IsEmpty());
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -17,6 +17,7 @@
 #include "unittest/Unittest.h"
 #include "metas/ConnectionMetaManager.h"
 #include "DynamicLibHelper.h"
+#include "SyntheticProcTree.h"
 
 namespace logtail {
 
@@ -66,22 +67,22 @@ public:
     void TestFetchInetConnections() {
         NetLinkProber prober(594114, 1, "/dev/proc/");
         ASSERT_TRUE(prober.Status() == 0);
-        std::unordered_map<uint32_t, ConnectionInfoPtr> infos;
+        std::unordered_map<uint32_t, ConnectionInfo> infos;
         prober.FetchInetConnections(infos);
-        for (const auto& item : infos) {
+        for (auto& item : infos) {
             std::cout << "inode:" << item.first << std::endl;
-            item.second->Print();
+            item.second.Print();
         }
     }
 
     void TestFetchUnixConnections() {
         NetLinkProber prober(594114, 1, "/dev/proc/");
         ASSERT_TRUE(prober.Status() == 0);
-        std::unordered_map<uint32_t, ConnectionInfoPtr> infos;
+        std::unordered_map<uint32_t, ConnectionInfo> infos;
         prober.FetchUnixConnections(infos);
-        for (const auto& item : infos) {
+        for (auto& item : infos) {
             std::cout << "inode:" << item.first << std::endl;
-            item.second->Print();
+            item.second.Print();
         }
     }
 
@@ -100,6 +101,86 @@ public:
             info->Print();
         }
     }
+
+    void TestIncrementalScan() {
+        const uint32_t netNsInode = 4026531992;
+        SyntheticProcTree tree("/tmp/ilogtail_connection_meta_proc");
+        tree.AddProcess(100, 1000, netNsInode);
+        tree.AddSocket(100, 3, 5001);
+        tree.AddSocket(100, 4, 5002);
+
+        auto manager = ConnectionMetaManager::GetInstance();
+        std::string procPath = manager->mBashProcPath;
+        bool fdDirSizeIsCount = manager->mFdDirSizeIsCount;
+        manager->mBashProcPath = tree.BasePath() + "/";
+        manager->mFdDirSizeIsCount = false;
+        // connections are given as fetched from netlink, which is not fetched again in the generation
+        NetNsConnections& netNs = manager->mNetNsConnections[netNsInode];
+        netNs.FetchGeneration = manager->mGeneration;
+        std::unordered_map<uint32_t, ConnectionInfo> infos{{5001, makeInfo(8080)}, {5002, makeInfo(8081)}};
+        APSARA_TEST_EQUAL(manager->UpdateNetNsConnections(netNs, infos), 2UL);
+
+        auto info = manager->GetConnectionInfo(100, 3);
+        APSARA_TEST_TRUE_FATAL(info != nullptr);
+        APSARA_TEST_EQUAL(info->localPort, 8080U);
+        APSARA_TEST_EQUAL(manager->mProcessSockets[100].FdInodes.size(), 1UL);
+
+        // fd 3 is reused by another socket, the cached inode is forgotten by the connect event
+        tree.RemoveFd(100, 3);
+        tree.AddSocket(100, 3, 5003);
+        manager->OnConnectionChanged(100, 3);
+        APSARA_TEST_TRUE(manager->GetConnectionInfo(100, 3) == nullptr);
+        APSARA_TEST_EQUAL(manager->mProcessSockets[100].FdInodes[3], 5003U);
+
+        // the fd count changes, so fds of the process are read again in the next generation
+        tree.AddSocket(100, 5, 5004);
+        manager->GarbageCollection();
+        APSARA_TEST_TRUE(manager->mProcessSockets[100].FdInodes.empty());
+
+        // only the difference of the next fetch is applied, the info of an unchanged connection is kept
+        netNs.FetchGeneration = manager->mGeneration;
+        ConnectionInfoPtr kept = manager->mConnectionMeta[5002];
+        infos = {{5002, makeInfo(8081)}, {5003, makeInfo(8082)}};
+        APSARA_TEST_EQUAL(manager->UpdateNetNsConnections(netNs, infos), 1UL);
+        APSARA_TEST_EQUAL(manager->mConnectionMeta.count(5001), 0UL);
+        APSARA_TEST_TRUE(manager->mConnectionMeta[5002] == kept);
+        APSARA_TEST_EQUAL(netNs.Inodes.size(), 2UL);
+        info = manager->GetConnectionInfo(100, 3);
+        APSARA_TEST_TRUE_FATAL(info != nullptr);
+        APSARA_TEST_EQUAL(info->localPort, 8082U);
+
+        // a connection whose state changed gets a new info, the one held by sources is not modified
+        netNs.FetchGeneration = manager->mGeneration;
+        infos[5002].stat = TCPConnectionStat::CloseWait;
+        APSARA_TEST_EQUAL(manager->UpdateNetNsConnections(netNs, infos), 1UL);
+        APSARA_TEST_TRUE(manager->mConnectionMeta[5002] != kept);
+        APSARA_TEST_TRUE(manager->mConnectionMeta[5002]->stat == TCPConnectionStat::CloseWait);
+        APSARA_TEST_TRUE(kept->stat == TCPConnectionStat::Established);
+
+        // the pid is used by a new process
+        tree.SetStartTime(100, 2000);
+        manager->GarbageCollection();
+        APSARA_TEST_EQUAL(manager->mProcessSockets.count(100), 0UL);
+
+        manager->mBashProcPath = procPath;
+        manager->mFdDirSizeIsCount = fdDirSizeIsCount;
+        manager->mProcessSockets.clear();
+        manager->mNetNsConnections.clear();
+        manager->mConnectionMeta.clear();
+    }
+
+private:
+    static ConnectionInfo makeInfo(uint32_t localPort) {
+        ConnectionInfo info{};
+        info.family = AF_INET;
+        info.localAddr = SockAddress{.Type = SockAddressType_IPV4, .Addr = SockAddressDetail{.IPV4 = 0}};
+        info.remoteAddr = info.localAddr;
+        info.localPort = localPort;
+        info.remotePort = 0;
+        info.stat = TCPConnectionStat::Established;
+        info.role = PacketRoleType::Server;
+        return info;
+    }
 };
 
 
@@ -109,6 +190,7 @@ public:
 //    APSARA_UNIT_TEST_CASE(ConnectionMetaUnitTest, TestFetchInetConnections, 0);
 //    APSARA_UNIT_TEST_CASE(ConnectionMetaUnitTest, TestFetchUnixConnections, 0);
 APSARA_UNIT_TEST_CASE(ConnectionMetaUnitTest, TestReadFdLink, 0);
+APSARA_UNIT_TEST_CASE(ConnectionMetaUnitTest, TestIncrementalScan, 0);
 //    APSARA_UNIT_TEST_CASE(ConnectionMetaUnitTest, TestIPV6, 0);
 
 } // namespace logtail
@@ -41,10 +41,11 @@ public:
         data->PtlType = ProtocolType_HTTP;
         mObserver->OnPacketEvent(packetType, sizeof(PacketEventHeader) + sizeof(PacketEventData));
 
-        APSARA_TEST_EQUAL_FATAL(mObserver->mAllProcesses.size(), size_t(1));
-        APSARA_TEST_EQUAL_FATAL(mObserver->mAllProcesses.begin()->first, 8);
-        APSARA_TEST_EQUAL_FATAL(mObserver->mAllProcesses.begin()->second->mAllConnections.size(), size_t(1));
-        ProtocolEventAggregators* agg = mObserver->mAllProcesses.begin()->second->GetAggregator();
+        APSARA_TEST_EQUAL_FATAL(mObserver->mWorkers[0]->mAllProcesses.size(), size_t(1));
+        APSARA_TEST_EQUAL_FATAL(mObserver->mWorkers[0]->mAllProcesses.begin()->first, 8);
+        APSARA_TEST_EQUAL_FATAL(mObserver->mWorkers[0]->mAllProcesses.begin()->second->mAllConnections.size(),
+                                size_t(1));
+        ProtocolEventAggregators* agg = mObserver->mWorkers[0]->mAllProcesses.begin()->second->GetAggregator();
         DNSProtocolEventAggregator* dnsAgg = agg->GetDNSAggregator();
         DNSProtocolEvent dnsEvent;
         dnsEvent.Info.ReqBytes = 100;
@@ -73,6 +74,58 @@ public:
         APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(log, "resp_bytes", "200"));
     }
 
+    void TestMergeWorkerAggregators() {
+        // a process whose connections are partitioned to two workers
+        mObserver->mWorkers.emplace_back(new NetworkObserverWorker(mObserver, 1));
+        ContainerProcessGroupManager* manager = ContainerProcessGroupManager::GetInstance();
+        ProcessMetaPtr meta = manager->GetProcessMeta(9);
+        ContainerProcessGroupPtr group = manager->GetContainerProcessGroupPtr(meta, 9);
+        for (size_t index = 0; index < 2; ++index) {
+            DNSProtocolEvent dnsEvent;
+            dnsEvent.Info.ReqBytes = 100;
+            dnsEvent.Info.RespBytes = 200;
+            dnsEvent.Info.LatencyNs = 300;
+            dnsEvent.Key.ReqResource = "cn-hangzhou.log.aliyuncs.com";
+            dnsEvent.Key.RespStatus = 1;
+            dnsEvent.Key.ConnKey.Role = PacketRoleType::Server;
+            group->GetWorkerAggregator(index)->GetDNSAggregator()->AddEvent(std::move(dnsEvent));
+        }
+
+        std::vector<sls_logs::Log> allData;
+        mObserver->FlushOutMetrics(allData);
+        mObserver->mWorkers.pop_back();
+        manager->OnProcessDestroy(meta.get(), 9);
+        APSARA_TEST_EQUAL(allData.size(), size_t(1));
+        sls_logs::Log* log = &allData[0];
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(log, "protocol", "dns"));
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(log, "count", "2"));
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(log, "req_bytes", "200"));
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(log, "resp_bytes", "400"));
+    }
+
+    void TestPartitionPacketEvent() {
+        mObserver->mWorkers.emplace_back(new NetworkObserverWorker(mObserver, 1));
+        mObserver->mPendingBatches.assign(2, nullptr);
+        mObserver->mWorkers[0]->Start(1, 16, 4096);
+        mObserver->mWorkers[1]->Start(1, 16, 4096);
+        for (uint32_t sockHash = 0; sockHash < 4; ++sockHash) {
+            char packet[sizeof(PacketEventHeader)];
+            PacketEventHeader* header = (PacketEventHeader*)packet;
+            memset(header, 0, sizeof(PacketEventHeader));
+            header->EventType = PacketEventType_Connected;
+            header->PID = 10;
+            header->SockHash = sockHash;
+            mObserver->PartitionPacketEvent(packet, sizeof(packet));
+        }
+        mObserver->SubmitPendingBatches();
+        mObserver->mWorkers[1]->Stop();
+        mObserver->mWorkers[0]->Stop();
+        // each worker observes the process for its own connections
+        APSARA_TEST_TRUE(mObserver->mWorkers[0]->HasProcess(10));
+        APSARA_TEST_TRUE(mObserver->mWorkers[1]->HasProcess(10));
+        mObserver->mWorkers.pop_back();
+        mObserver->mPendingBatches.clear();
+    }
 
     void TestJsonPacketToPB() {
         JsonNetPacketReader reader("/tmp/wireshark.json", "30.43.121.41", false, ProtocolType_DNS);
@@ -243,6 +296,8 @@ public:
 
 
 APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestToPB, 0);
+APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestMergeWorkerAggregators, 0);
+APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestPartitionPacketEvent, 0);
 //    APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestJsonNetPacketReader, 0);
 //    APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestJsonPacketToPB, 0);
 APSARA_UNIT_TEST_CASE(NetworkObserverUnittest, TestRawPacketUDPReader, 0);
@@ -0,0 +1,166 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "logger/Logger.h"
+#include "observer/network/NetworkObserver.h"
+#include "observer/network/PacketEventBatch.h"
+
+using namespace std;
+
+namespace logtail {
+
+// PacketEventBatchBenchmark replays packet events like the local file source does, once event by event through a
+// std::function as sources did before, and once in batches, which is how the ebpf source delivers events now.
+// Events are read from a dump file saved by sls_observer_network_save_filename if one is given, or generated as
+// http requests and responses of many connections interleaved.
+class PacketEventBatchBenchmark {
+public:
+    static void Run(const vector<string>& events, size_t batchSize) {
+        NetworkObserver* observer = NetworkObserver::GetInstance();
+        function<int(StringPiece)> processor
+            = bind(&NetworkObserver::OnPacketEventStringPiece, observer, placeholders::_1);
+        uint64_t singleNs = Measure([&]() {
+            for (const auto& event : events) {
+                // the buffer is reused for every event like the source did
+                sBuffer.assign(event);
+                void* packet = nullptr;
+                int32_t len = 0;
+                BufferToPacketEvent(&sBuffer[0], static_cast<int32_t>(sBuffer.size()), packet, len);
+                processor(StringPiece(static_cast<const char*>(packet), len));
+            }
+        });
+        Flush(observer);
+
+        PacketEventBatch batch(batchSize, 4 * 1024 * 1024);
+        function<int(PacketEventBatch&)> batchProcessor
+            = bind(&NetworkObserver::OnPacketEventBatch, observer, placeholders::_1);
+        uint64_t batchNs = Measure([&]() {
+            for (const auto& event : events) {
+                memcpy(batch.Append(event.size()), event.data(), event.size());
+                if (batch.IsFull()) {
+                    batchProcessor(batch);
+                    batch.Clear();
+                }
+            }
+            if (!batch.Empty()) {
+                batchProcessor(batch);
+                batch.Clear();
+            }
+        });
+        Flush(observer);
+
+        cout << "events: " << events.size() << ", batch size: " << batchSize << endl;
+        cout << "  single: " << static_cast<double>(singleNs) / events.size() << "ns/event, "
+             << events.size() * 1000.0 / singleNs << "M events/s" << endl;
+        cout << "  batch: " << static_cast<double>(batchNs) / events.size() << "ns/event, "
+             << events.size() * 1000.0 / batchNs << "M events/s" << endl;
+    }
+
+    // LoadDumpFile reads events saved by NetworkObserver, each one is a 4 bytes size followed by the event.
+    static bool LoadDumpFile(const string& path, vector<string>& events) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        uint32_t size = 0;
+        while (fread(&size, 1, 4, file) == 4) {
+            string event(size, '\0');
+            if (size == 0 || fread(&event[0], 1, size, file) != size) {
+                break;
+            }
+            events.push_back(std::move(event));
+        }
+        fclose(file);
+        return !events.empty();
+    }
+
+    static void Generate(size_t count, uint32_t pidCount, uint32_t connCount, vector<string>& events) {
+        const string request = "GET /api/v1/items HTTP/1.1\r\nHost: item.default.svc\r\nAccept: */*\r\n\r\n";
+        const string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\n\r\n{}";
+        uint64_t now = GetCurrentTimeInNanoSeconds();
+        for (size_t i = 0; i < count; ++i) {
+            // round robin on connections, so consecutive events rarely belong to the same process
+            uint32_t conn = static_cast<uint32_t>((i / 2) % (pidCount * connCount));
+            bool isRequest = i % 2 == 0;
+            const string& payload = isRequest ? request : response;
+            string event(sizeof(PacketEventHeader) + sizeof(PacketEventData) + payload.size(), '\0');
+            auto* header = reinterpret_cast<PacketEventHeader*>(&event[0]);
+            header->PID = 10000 + conn % pidCount;
+            header->SockHash = conn;
+            header->EventType = PacketEventType_Data;
+            header->RoleType = PacketRoleType::Server;
+            header->TimeNano = now + i * 1000;
+            header->SrcAddr = SockAddressFromString("10.0.0.1");
+            header->SrcPort = 8080;
+            header->DstAddr = SockAddressFromString("10.0.1." + to_string(conn % 250));
+            header->DstPort = static_cast<uint16_t>(30000 + conn);
+            auto* data = reinterpret_cast<PacketEventData*>(&event[0] + sizeof(PacketEventHeader));
+            data->PtlType = ProtocolType_HTTP;
+            data->MsgType = isRequest ? MessageType_Request : MessageType_Response;
+            data->PktType = isRequest ? PacketType_In : PacketType_Out;
+            data->BufferLen = static_cast<int32_t>(payload.size());
+            data->RealLen = data->BufferLen;
+            memcpy(&event[0] + sizeof(PacketEventHeader) + sizeof(PacketEventData), payload.data(), payload.size());
+            events.push_back(std::move(event));
+        }
+    }
+
+private:
+    static void Flush(NetworkObserver* observer) {
+        vector<sls_logs::Log> allData;
+        observer->FlushOutMetrics(allData);
+    }
+
+    template <typename Func>
+    static uint64_t Measure(Func func) {
+        auto start = chrono::steady_clock::now();
+        func();
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+
+    static string sBuffer;
+};
+
+string PacketEventBatchBenchmark::sBuffer;
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+    std::vector<std::string> events;
+    if (argc > 1) {
+        if (!logtail::PacketEventBatchBenchmark::LoadDumpFile(argv[1], events)) {
+            std::cout << "failed to load events from " << argv[1] << std::endl;
+            return 1;
+        }
+    } else {
+        logtail::PacketEventBatchBenchmark::Generate(1000000, 64, 16, events);
+    }
+    logtail::PacketEventBatchBenchmark::Run(events, 100);
+    logtail::PacketEventBatchBenchmark::Run(events, 512);
+    return 0;
+}
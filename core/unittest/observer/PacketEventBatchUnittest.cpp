@@ -0,0 +1,134 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include "unittest/Unittest.h"
+#include "observer/network/PacketEventBatch.h"
+
+namespace logtail {
+
+class PacketEventBatchUnittest : public ::testing::Test {
+public:
+    void TestGroupByConnection();
+    void TestPayload();
+    void TestFull();
+
+private:
+    static void AppendCtrl(PacketEventBatch& batch, uint32_t pid, uint32_t sockHash, uint64_t timeNano) {
+        PacketEventHeader header{};
+        header.PID = pid;
+        header.SockHash = sockHash;
+        header.EventType = PacketEventType_Connected;
+        header.TimeNano = timeNano;
+        memcpy(batch.Append(sizeof(header)), &header, sizeof(header));
+    }
+
+    static void AppendData(PacketEventBatch& batch, uint32_t pid, uint32_t sockHash, const std::string& payload) {
+        char* event = batch.Append(sizeof(PacketEventHeader) + sizeof(PacketEventData) + payload.size());
+        auto* header = reinterpret_cast<PacketEventHeader*>(event);
+        *header = PacketEventHeader{};
+        header->PID = pid;
+        header->SockHash = sockHash;
+        header->EventType = PacketEventType_Data;
+        auto* data = reinterpret_cast<PacketEventData*>(event + sizeof(PacketEventHeader));
+        data->BufferLen = static_cast<int32_t>(payload.size());
+        data->RealLen = data->BufferLen;
+        data->Buffer = nullptr;
+        memcpy(event + sizeof(PacketEventHeader) + sizeof(PacketEventData), payload.data(), payload.size());
+    }
+};
+
+APSARA_UNIT_TEST_CASE(PacketEventBatchUnittest, TestGroupByConnection, 0);
+APSARA_UNIT_TEST_CASE(PacketEventBatchUnittest, TestPayload, 0);
+APSARA_UNIT_TEST_CASE(PacketEventBatchUnittest, TestFull, 0);
+
+void PacketEventBatchUnittest::TestGroupByConnection() {
+    PacketEventBatch batch(100, 4096);
+    // connections of 2 processes interleaved, the time is the order in a connection
+    AppendCtrl(batch, 2, 20, 0);
+    AppendCtrl(batch, 1, 11, 0);
+    AppendCtrl(batch, 2, 20, 1);
+    AppendCtrl(batch, 1, 10, 0);
+    AppendCtrl(batch, 1, 11, 1);
+    AppendCtrl(batch, 2, 20, 2);
+    AppendCtrl(batch, 1, 10, 1);
+    APSARA_TEST_EQUAL(batch.Size(), 7UL);
+
+    std::vector<std::pair<uint32_t, uint32_t>> conns;
+    std::vector<uint64_t> times;
+    batch.ForEachGrouped([&](char* event, size_t len) {
+        APSARA_TEST_EQUAL(len, sizeof(PacketEventHeader));
+        auto* header = reinterpret_cast<PacketEventHeader*>(event);
+        conns.emplace_back(header->PID, header->SockHash);
+        times.push_back(header->TimeNano);
+    });
+    std::vector<std::pair<uint32_t, uint32_t>> expectedConns{
+        {1, 10}, {1, 10}, {1, 11}, {1, 11}, {2, 20}, {2, 20}, {2, 20}};
+    std::vector<uint64_t> expectedTimes{0, 1, 0, 1, 0, 1, 2};
+    APSARA_TEST_TRUE(conns == expectedConns);
+    APSARA_TEST_TRUE(times == expectedTimes);
+
+    batch.Clear();
+    APSARA_TEST_TRUE(batch.Empty());
+}
+
+void PacketEventBatchUnittest::TestPayload() {
+    // the buffer grows while events are appended, payload pointers must still be right
+    PacketEventBatch batch(100, 16);
+    std::vector<std::string> payloads;
+    for (int i = 0; i < 50; ++i) {
+        payloads.push_back("GET /" + std::to_string(i) + std::string(i, 'x') + " HTTP/1.1\r\n\r\n");
+        AppendData(batch, 1, 1, payloads.back());
+        if (i % 10 == 0) {
+            AppendCtrl(batch, 1, 1, i);
+        }
+    }
+    AppendData(batch, 1, 1, "dropped");
+    batch.RemoveLast();
+
+    size_t idx = 0;
+    batch.ForEachGrouped([&](char* event, size_t len) {
+        auto* header = reinterpret_cast<PacketEventHeader*>(event);
+        APSARA_TEST_EQUAL(reinterpret_cast<uintptr_t>(event) % 8, 0UL);
+        if (header->EventType != PacketEventType_Data) {
+            return;
+        }
+        auto* data = reinterpret_cast<PacketEventData*>(event + sizeof(PacketEventHeader));
+        APSARA_TEST_EQUAL(len, sizeof(PacketEventHeader) + sizeof(PacketEventData) + data->BufferLen);
+        APSARA_TEST_EQUAL(std::string(data->Buffer, data->BufferLen), payloads[idx]);
+        ++idx;
+    });
+    APSARA_TEST_EQUAL(idx, payloads.size());
+}
+
+void PacketEventBatchUnittest::TestFull() {
+    PacketEventBatch countLimited(3, 1024 * 1024);
+    for (int i = 0; i < 3; ++i) {
+        APSARA_TEST_FALSE(countLimited.IsFull());
+        AppendCtrl(countLimited, 1, 1, i);
+    }
+    APSARA_TEST_TRUE(countLimited.IsFull());
+
+    PacketEventBatch bytesLimited(100, 1024);
+    AppendData(bytesLimited, 1, 1, std::string(512, 'a'));
+    APSARA_TEST_FALSE(bytesLimited.IsFull());
+    AppendData(bytesLimited, 1, 1, std::string(512, 'a'));
+    APSARA_TEST_TRUE(bytesLimited.IsFull());
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,100 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "logger/Logger.h"
+#include "observer/network/protocols/http/type.h"
+
+using namespace std;
+
+namespace logtail {
+
+// ProtocolAggregatorBenchmark adds HTTP events with a given number of distinct keys to an aggregator, like the
+// parsers do, and flushes it like ProtocolEventAggregators does every interval.
+class ProtocolAggregatorBenchmark {
+public:
+    static void Run(size_t eventCount, size_t keyCount, uint32_t maxAggSize) {
+        vector<HTTPProtocolEvent> events(keyCount);
+        for (size_t i = 0; i < keyCount; ++i) {
+            auto& key = events[i].Key;
+            key.ConnKey.Role = i % 2 == 0 ? PacketRoleType::Client : PacketRoleType::Server;
+            key.ConnKey.Pid = static_cast<uint16_t>(1000 + i % 50);
+            key.ConnKey.ConnId = i % 500;
+            key.ConnKey.HashVal = key.ConnKey.ConnId * 31 + static_cast<uint64_t>(key.ConnKey.Role);
+            key.ConnKey.RemoteIp = "10.0." + to_string(i % 250) + "." + to_string(i % 7);
+            key.ConnKey.LocalIp = "192.168.0.1";
+            key.ConnKey.RemotePort = 8080;
+            key.ConnKey.LocalPort = static_cast<uint16_t>(30000 + i % 500);
+            key.ReqType = i % 3 == 0 ? "POST" : "GET";
+            key.ReqDomain = "service" + to_string(i % 20) + ".default.svc.cluster.local";
+            key.ReqResource = "/api/v1/resource/" + to_string(i);
+            key.Version = "1.1";
+            key.RespCode = 200;
+            key.RespStatus = 0;
+        }
+        mt19937 rng(42);
+        vector<uint32_t> order(eventCount);
+        for (auto& idx : order) {
+            idx = rng() % keyCount;
+        }
+
+        HTTPProtocolEventAggregator aggregator(maxAggSize, maxAggSize);
+        uint64_t addNs = Measure([&]() {
+            for (size_t i = 0; i < eventCount; ++i) {
+                HTTPProtocolEvent event(events[order[i]]);
+                event.Info.LatencyNs = 100000 + (i & 0xffff);
+                event.Info.ReqBytes = 512;
+                event.Info.RespBytes = 2048;
+                aggregator.AddEvent(std::move(event));
+            }
+        });
+        vector<sls_logs::Log> allData;
+        google::protobuf::RepeatedPtrField<sls_logs::Log_Content> tags;
+        uint64_t flushNs = Measure([&]() { aggregator.FlushLogs(allData, "", tags, 15); });
+
+        cout << "events: " << eventCount << ", keys: " << keyCount << ", max agg size: " << maxAggSize << endl;
+        cout << "  add: " << static_cast<double>(addNs) / eventCount << "ns/event, "
+             << eventCount * 1000.0 / addNs << "M events/s" << endl;
+        cout << "  flush: " << flushNs / 1000000.0 << "ms, logs: " << allData.size() << endl;
+    }
+
+private:
+    template <typename Func>
+    static uint64_t Measure(Func func) {
+        auto start = chrono::steady_clock::now();
+        func();
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+    logtail::ProtocolAggregatorBenchmark::Run(1000000, 100, 5000);
+    logtail::ProtocolAggregatorBenchmark::Run(1000000, 5000, 5000);
+    // more keys than the aggregator holds, the rest go to the overflow items
+    logtail::ProtocolAggregatorBenchmark::Run(1000000, 50000, 5000);
+    return 0;
+}
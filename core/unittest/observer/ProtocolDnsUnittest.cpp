@@ -357,7 +357,7 @@ public:
         mObserver->GarbageCollection(GetCurrentTimeInNanoSeconds());
         networkStatistic->Clear();
 
-        APSARA_TEST_EQUAL(mObserver->mAllProcesses.size(), 0);
+        APSARA_TEST_EQUAL(mObserver->mWorkers[0]->mAllProcesses.size(), 0);
 
         std::vector<std::string> rawHexs{rawHex1, rawHex4};
         RawNetPacketReader reader("30.30.30.30", false, ProtocolType_DNS, rawHexs);
@@ -374,7 +374,7 @@ public:
         // GC
         mObserver->GarbageCollection(GetCurrentTimeInNanoSeconds() - 60000000000000ULL);
         ProtocolDebugStatistic* statistic = ProtocolDebugStatistic::GetInstance();
-        APSARA_TEST_EQUAL(mObserver->mAllProcesses.size(), 1);
+        APSARA_TEST_EQUAL(mObserver->mWorkers[0]->mAllProcesses.size(), 1);
         APSARA_TEST_EQUAL(networkStatistic->mGCCount, 1);
         APSARA_TEST_EQUAL(networkStatistic->mGCReleaseConnCount, 0);
         APSARA_TEST_EQUAL(networkStatistic->mGCReleaseProcessCount, 0);
@@ -383,7 +383,7 @@ public:
         statistic->Clear();
 
         mObserver->GarbageCollection(GetCurrentTimeInNanoSeconds());
-        APSARA_TEST_EQUAL(mObserver->mAllProcesses.size(), 0);
+        APSARA_TEST_EQUAL(mObserver->mWorkers[0]->mAllProcesses.size(), 0);
         APSARA_TEST_EQUAL(networkStatistic->mGCCount, 2);
         APSARA_TEST_EQUAL(networkStatistic->mGCReleaseConnCount, 2);
         APSARA_TEST_EQUAL(networkStatistic->mGCReleaseProcessCount, 1);
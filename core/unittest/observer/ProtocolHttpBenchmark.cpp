@@ -0,0 +1,127 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "logger/Logger.h"
+#include "RawNetPacketReader.h"
+#include "network/protocols/http/parser.h"
+
+using namespace std;
+
+// counts heap allocations, so the benchmark shows whether parsing stays allocation free in steady state
+static atomic<uint64_t> sAllocCount{0};
+
+void* operator new(size_t size) {
+    ++sAllocCount;
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace logtail {
+
+// ProtocolHttpBenchmark replays recorded request and response packets of a connection through HTTPProtocolParser,
+// like NetworkObserver does for every data event, and reports the throughput and allocations per packet.
+class ProtocolHttpBenchmark {
+public:
+    static void Run(const string& name, const vector<string>& rawHexs, size_t rounds) {
+        RawNetPacketReader reader("30.43.120.83", false, ProtocolType_HTTP, rawHexs);
+        vector<string> packets;
+        reader.GetAllNetPackets(packets);
+        if (!reader.OK() || packets.empty()) {
+            cout << name << ": bad packets, " << reader.GetParseFailMsg() << endl;
+            return;
+        }
+        auto* firstHeader = reinterpret_cast<PacketEventHeader*>(&packets[0].at(0));
+        HTTPProtocolEventAggregator aggregator(1000, 1000);
+        HTTPProtocolParser* parser = HTTPProtocolParser::Create(&aggregator, firstHeader);
+
+        size_t bytes = 0;
+        uint64_t timeNano = firstHeader->TimeNano;
+        auto replay = [&](size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                for (auto& packet : packets) {
+                    auto* header = reinterpret_cast<PacketEventHeader*>(&packet.at(0));
+                    auto* data = reinterpret_cast<PacketEventData*>(&packet.at(0) + sizeof(PacketEventHeader));
+                    header->TimeNano = ++timeNano;
+                    parser->OnPacket(
+                        data->PktType, data->MsgType, header, data->Buffer, data->BufferLen, data->RealLen);
+                    bytes += data->BufferLen;
+                }
+            }
+        };
+        // the first rounds fill the cache slots and the aggregation items
+        replay(16);
+        bytes = 0;
+        uint64_t allocs = sAllocCount;
+        auto start = chrono::steady_clock::now();
+        replay(rounds);
+        uint64_t ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        allocs = sAllocCount - allocs;
+        HTTPProtocolParser::Delete(parser);
+
+        size_t packetCount = rounds * packets.size();
+        cout << name << ": packets: " << packetCount << endl;
+        cout << "  parse: " << static_cast<double>(ns) / packetCount << "ns/packet, "
+             << bytes * 1000.0 / ns << "MB/s, " << static_cast<double>(allocs) / packetCount << " allocs/packet"
+             << endl;
+    }
+};
+
+} // namespace logtail
+
+// a curl request to baidu.com and its response
+static const string sRequestHex
+    = "00749c945d39a07817a0852e080045000071000040004006a0581e2b7853dcb526fbcd4700506b7401eca5"
+      "91a5ce5018100037ad0000474554202f20485454502f312e310d0a486f73743a2062616964752e636f6d0d"
+      "0a557365722d4167656e743a206375726c2f372e37372e300d0a4163636570743a202a2f2a0d0a0d0a";
+static const string sResponseHex
+    = "a07817a0852e00749c945d390800450001598c7240002a0628fedcb526fb1e2b78530050cd47a591a5ce6b74023550180304c2650000"
+      "485454502f312e3120323030204f4b0d0a446174653a205468752c203237204a616e20323032322030393a34363a313320474d540d0a"
+      "5365727665723a204170616368650d0a4c6173742d4d6f6469666965643a205475652c203132204a616e20323031302031333a34383a"
+      "303020474d540d0a455461673a202235312d34376366376536656538343030220d0a4163636570742d52616e6765733a206279746573"
+      "0d0a436f6e74656e742d4c656e6774683a2038310d0a43616368652d436f6e74726f6c3a206d61782d6167653d38363430300d0a4578"
+      "70697265733a204672692c203238204a616e20323032322030393a34363a313320474d540d0a436f6e6e656374696f6e3a204b656570"
+      "2d416c6976650d0a436f6e74656e742d547970653a20746578742f68746d6c0d0a0d0a";
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+    logtail::ProtocolHttpBenchmark::Run("request and response", {sRequestHex, sResponseHex}, 1000000);
+    // without responses nothing is stitched, new requests take the slots of the oldest ones
+    logtail::ProtocolHttpBenchmark::Run("requests only", {sRequestHex}, 1000000);
+    return 0;
+}
@@ -420,7 +420,7 @@ public:
         ProtocolDebugStatistic* protocolDebugStatistic = ProtocolDebugStatistic::GetInstance();
         mObserver->GarbageCollection(GetCurrentTimeInNanoSeconds());
         networkStatistic->Clear();
-        APSARA_TEST_EQUAL(mObserver->mAllProcesses.size(), 0);
+        APSARA_TEST_EQUAL(mObserver->mWorkers[0]->mAllProcesses.size(), 0);
 
         {
             std::vector<std::string> rawHexs{rawHex1};
@@ -437,7 +437,7 @@ public:
 
 
             mObserver->GarbageCollection(GetCurrentTimeInNanoSeconds() - 60000000000000ULL);
-            APSARA_TEST_EQUAL(mObserver->mAllProcesses.size(), 1);
+            APSARA_TEST_EQUAL(mObserver->mWorkers[0]->mAllProcesses.size(), 1);
             APSARA_TEST_EQUAL(networkStatistic->mGCCount, 1);
             APSARA_TEST_EQUAL(networkStatistic->mGCReleaseConnCount, 0);
             APSARA_TEST_EQUAL(networkStatistic->mGCReleaseProcessCount, 0);
@@ -445,7 +445,7 @@ public:
             APSARA_TEST_EQUAL(protocolDebugStatistic->mHTTPConnectionCachedSize, 1);
 
             mObserver->GarbageCollection(GetCurrentTimeInNanoSeconds());
-            APSARA_TEST_EQUAL(mObserver->mAllProcesses.size(), 0);
+            APSARA_TEST_EQUAL(mObserver->mWorkers[0]->mAllProcesses.size(), 0);
             APSARA_TEST_EQUAL(networkStatistic->mGCCount, 2);
             APSARA_TEST_EQUAL(networkStatistic->mGCReleaseConnCount, 1);
             APSARA_TEST_EQUAL(networkStatistic->mGCReleaseProcessCount, 1);
@@ -467,7 +467,7 @@ public:
             APSARA_TEST_EQUAL(allData.size(), 0);
 
             mObserver->GarbageCollection(GetCurrentTimeInNanoSeconds() - 60000000000000ULL);
-            APSARA_TEST_EQUAL(mObserver->mAllProcesses.size(), 1);
+            APSARA_TEST_EQUAL(mObserver->mWorkers[0]->mAllProcesses.size(), 1);
             APSARA_TEST_EQUAL(networkStatistic->mGCCount, 1);
             APSARA_TEST_EQUAL(networkStatistic->mGCReleaseConnCount, 0);
             APSARA_TEST_EQUAL(networkStatistic->mGCReleaseProcessCount, 0);
@@ -476,7 +476,7 @@ public:
 
 
             mObserver->GarbageCollection(GetCurrentTimeInNanoSeconds());
-            APSARA_TEST_EQUAL(mObserver->mAllProcesses.size(), 0);
+            APSARA_TEST_EQUAL(mObserver->mWorkers[0]->mAllProcesses.size(), 0);
             APSARA_TEST_EQUAL(networkStatistic->mGCCount, 2);
             APSARA_TEST_EQUAL(networkStatistic->mGCReleaseConnCount, 1);
             APSARA_TEST_EQUAL(networkStatistic->mGCReleaseProcessCount, 1);
@@ -485,6 +485,89 @@ public:
         }
     }
 
+    void TestHTTPMethodAndVersion() {
+        const char* methods[] = {"GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"};
+        for (const char* method : methods) {
+            HTTPMethod parsed = ParseHTTPMethod(SlsStringPiece(method, strlen(method)));
+            APSARA_TEST_NOT_EQUAL(parsed, HTTPMethod_Unknown);
+            APSARA_TEST_EQUAL(HTTPMethodToString(parsed), method);
+        }
+        APSARA_TEST_EQUAL(ParseHTTPMethod(SlsStringPiece("PROPFIND", 8)), HTTPMethod_Unknown);
+        APSARA_TEST_EQUAL(ParseHTTPMethod(SlsStringPiece("get", 3)), HTTPMethod_Unknown);
+        APSARA_TEST_EQUAL(ParseHTTPMethod(SlsStringPiece("GETS", 4)), HTTPMethod_Unknown);
+        APSARA_TEST_EQUAL(HTTPVersionToString(0), "0");
+        APSARA_TEST_EQUAL(HTTPVersionToString(1), "1");
+        APSARA_TEST_EQUAL(HTTPVersionToString(-1), "");
+    }
+
+    // requests are parsed into reused cache slots and the stitched events must not see the previous request
+    void TestHTTPParserReuseSlots() {
+        PacketEventHeader header{};
+        header.PID = 1;
+        header.SockHash = 2;
+        header.EventType = PacketEventType_Data;
+        header.RoleType = PacketRoleType::Client;
+        header.SrcAddr.Type = SockAddressType_IPV4;
+        header.SrcAddr.Addr.IPV4 = htonl(0x0a000001);
+        header.SrcPort = 40000;
+        header.DstAddr.Type = SockAddressType_IPV4;
+        header.DstAddr.Addr.IPV4 = htonl(0x0a000002);
+        header.DstPort = 80;
+
+        HTTPProtocolEventAggregator aggregator(100, 100);
+        HTTPProtocolParser* parser = HTTPProtocolParser::Create(&aggregator, &header);
+        const std::string requests[] = {
+            "POST /api/v1/items/with/a/long/resource/path?id=1 HTTP/1.1\r\nHost: service.local\r\n\r\n",
+            "GET /a HTTP/1.0\r\n\r\n",
+            "PROPFIND /dav HTTP/1.1\r\nHost: dav.local\r\n\r\n",
+        };
+        const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+        for (int round = 0; round < 4; ++round) {
+            for (const auto& request : requests) {
+                header.TimeNano += 10;
+                APSARA_TEST_EQUAL(parser->OnPacket(PacketType_Out,
+                                                   MessageType_Request,
+                                                   &header,
+                                                   request.data(),
+                                                   request.size(),
+                                                   request.size()),
+                                  ParseResult_OK);
+                header.TimeNano += 10;
+                APSARA_TEST_EQUAL(parser->OnPacket(PacketType_In,
+                                                   MessageType_Response,
+                                                   &header,
+                                                   response.data(),
+                                                   response.size(),
+                                                   response.size()),
+                                  ParseResult_OK);
+            }
+        }
+        HTTPProtocolParser::Delete(parser);
+
+        std::vector<sls_logs::Log> allData;
+        google::protobuf::RepeatedPtrField<sls_logs::Log_Content> tags;
+        aggregator.FlushLogs(allData, {}, tags, 1);
+        APSARA_TEST_EQUAL(allData.size(), 3);
+        for (auto& log : allData) {
+            APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "count", "4"));
+            APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "resp_code", "200"));
+            if (UnitTestHelper::LogKeyMatched(&log, "req_type", "POST")) {
+                APSARA_TEST_TRUE(
+                    UnitTestHelper::LogKeyMatched(&log, "req_resource", "/api/v1/items/with/a/long/resource/path"));
+                APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "req_domain", "service.local"));
+                APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "version", "1"));
+            } else if (UnitTestHelper::LogKeyMatched(&log, "req_type", "GET")) {
+                APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "req_resource", "/a"));
+                // no Host header, the remote address is used
+                APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "req_domain", "10.0.0.2"));
+                APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "version", "0"));
+            } else {
+                APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "req_type", "PROPFIND"));
+                APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "req_resource", "/dav"));
+                APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&log, "req_domain", "dav.local"));
+            }
+        }
+    }
 
     NetworkObserver* mObserver = NetworkObserver::GetInstance();
     const std::string rawHex1 = "00749c945d39a07817a0852e080045000071000040004006a0581e2b7853dcb526fbcd4700506b7401eca5"
@@ -506,6 +589,8 @@ APSARA_UNIT_TEST_CASE(ProtocolHttpUnittest, TestHTTPPacketReaderOrder, 0);
 APSARA_UNIT_TEST_CASE(ProtocolHttpUnittest, TestHTTPPacketReaderUnorder, 0);
 APSARA_UNIT_TEST_CASE(ProtocolHttpUnittest, TestHTTPParserGC, 0);
 APSARA_UNIT_TEST_CASE(ProtocolHttpUnittest, TestCommonRequest2, 0);
+APSARA_UNIT_TEST_CASE(ProtocolHttpUnittest, TestHTTPMethodAndVersion, 0);
+APSARA_UNIT_TEST_CASE(ProtocolHttpUnittest, TestHTTPParserReuseSlots, 0);
 // TODO : currently only accept the data starts with HTTP or special METHOD , such as GET, PUT and etc.
 // APSARA_UNIT_TEST_CASE(ProtocolHttpUnittest, TestChunkedResponse, 0);
 // APSARA_UNIT_TEST_CASE(ProtocolHttpUnittest, TestMoreContentResponse, 0);
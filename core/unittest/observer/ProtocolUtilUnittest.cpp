@@ -327,6 +327,66 @@ public:
         APSARA_TEST_EQUAL(cache.GetResponsesSize(), 0);
         APSARA_TEST_EQUAL(count, 1);
     }
+
+    void TestAggTableCompareFullKey() {
+        ProtocolEventAggTable<MySQLProtocolEventAggItem> table(16);
+        MySQLProtocolEventKey key1, key2;
+        key1.Query = "select 1";
+        key2.Query = "select 2";
+        // same hash for different keys must not merge them
+        auto item1 = table.Insert(MySQLProtocolEventKey(key1), 42);
+        auto item2 = table.Insert(MySQLProtocolEventKey(key2), 42);
+        APSARA_TEST_TRUE(item1 != nullptr && item2 != nullptr);
+        APSARA_TEST_EQUAL(table.Size(), 2);
+        APSARA_TEST_TRUE(table.Find(key1, 42) != nullptr);
+        APSARA_TEST_EQUAL(table.Find(key1, 42)->Key.Query, "select 1");
+        APSARA_TEST_EQUAL(table.Find(key2, 42)->Key.Query, "select 2");
+        APSARA_TEST_TRUE(table.Find(key1, 43) == nullptr);
+    }
+
+    void TestAggTableRetain() {
+        ProtocolEventAggTable<MySQLProtocolEventAggItem> table(100);
+        for (int i = 0; i < 100; ++i) {
+            MySQLProtocolEventKey key;
+            key.Query = std::to_string(i);
+            // few distinct hashes make long probe sequences
+            APSARA_TEST_TRUE(table.Insert(std::move(key), i % 7) != nullptr);
+        }
+        MySQLProtocolEventKey extra;
+        APSARA_TEST_TRUE(table.Insert(std::move(extra), 1) == nullptr);
+        APSARA_TEST_EQUAL(table.Size(), 100);
+        table.Retain([](MySQLProtocolEventAggItem& item) { return std::stoi(item.Key.Query) % 2 == 1; });
+        APSARA_TEST_EQUAL(table.Size(), 50);
+        for (int i = 0; i < 100; ++i) {
+            MySQLProtocolEventKey key;
+            key.Query = std::to_string(i);
+            APSARA_TEST_EQUAL(table.Find(key, i % 7) != nullptr, i % 2 == 1);
+        }
+    }
+
+    void TestAggregatorOverflow() {
+        MySQLProtocolEventAggregator aggregator(2, 2);
+        for (int i = 0; i < 5; ++i) {
+            MySQLProtocolEvent event;
+            event.Key.ConnKey.Role = PacketRoleType::Client;
+            event.Key.Query = "select " + std::to_string(i);
+            event.Info.LatencyNs = 100;
+            APSARA_TEST_TRUE(aggregator.AddEvent(std::move(event)));
+        }
+        std::vector<sls_logs::Log> allData;
+        google::protobuf::RepeatedPtrField<sls_logs::Log_Content> tags;
+        aggregator.FlushLogs(allData, {}, tags, 1);
+        APSARA_TEST_EQUAL(allData.size(), 3);
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&allData[2], "query", kOverflowAggValue));
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&allData[2], "count", "3"));
+        APSARA_TEST_TRUE(UnitTestHelper::LogKeyMatched(&allData[2], "role", "c"));
+
+        // keys not updated in an interval are removed, and the overflow item is not flushed when unused
+        allData.clear();
+        aggregator.FlushLogs(allData, {}, tags, 1);
+        APSARA_TEST_EQUAL(allData.size(), 0);
+        APSARA_TEST_EQUAL(aggregator.mProtocolEventAggTable.Size(), 0);
+    }
 };
 
 
@@ -339,6 +399,9 @@ APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestCommonCacheContinueOneByOneAndRe
 APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestCommonCacheInsertOldResp, 0);
 APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestCommonCacheInsertNewReq, 0);
 APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestCommonCacheTryMatchingReq, 0);
+APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestAggTableCompareFullKey, 0);
+APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestAggTableRetain, 0);
+APSARA_UNIT_TEST_CASE(ProtocolUtilUnittest, TestAggregatorOverflow, 0);
 } // namespace logtail
 
 
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 iLogtail Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <boost/filesystem.hpp>
+
+namespace logtail {
+
+// SyntheticProcTree creates a directory laid out like /proc for ConnectionMetaManager, processes have a stat file,
+// socket fds and a network namespace. Links are dangling, only their targets are read.
+class SyntheticProcTree {
+public:
+    explicit SyntheticProcTree(const std::string& basePath) : mBasePath(basePath) {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(mBasePath, ec);
+        boost::filesystem::create_directories(mBasePath);
+    }
+
+    ~SyntheticProcTree() {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(mBasePath, ec);
+    }
+
+    const std::string& BasePath() const { return mBasePath; }
+
+    void AddProcess(uint32_t pid, uint64_t startTime, uint32_t netNsInode) {
+        std::string processPath = ProcessPath(pid);
+        boost::filesystem::create_directories(processPath + "/fd");
+        boost::filesystem::create_directories(processPath + "/ns");
+        SetStartTime(pid, startTime);
+        boost::filesystem::create_symlink("net:[" + std::to_string(netNsInode) + "]", processPath + "/ns/net");
+    }
+
+    // SetStartTime writes a stat file whose 22nd field is startTime, the command has a space like real ones may.
+    void SetStartTime(uint32_t pid, uint64_t startTime) {
+        std::ofstream stat(ProcessPath(pid) + "/stat", std::ios::trunc);
+        stat << pid << " (synthetic proc) S";
+        for (int field = 4; field < 22; ++field) {
+            stat << " 0";
+        }
+        stat << " " << startTime << " 0 0\n";
+    }
+
+    void AddSocket(uint32_t pid, uint32_t fd, uint32_t inode) {
+        boost::filesystem::create_symlink("socket:[" + std::to_string(inode) + "]", FdPath(pid, fd));
+    }
+
+    void RemoveFd(uint32_t pid, uint32_t fd) { boost::filesystem::remove(FdPath(pid, fd)); }
+
+    void RemoveProcess(uint32_t pid) { boost::filesystem::remove_all(ProcessPath(pid)); }
+
+private:
+    std::string ProcessPath(uint32_t pid) const { return mBasePath + "/" + std::to_string(pid); }
+
+    std::string FdPath(uint32_t pid, uint32_t fd) const {
+        return ProcessPath(pid) + "/fd/" + std::to_string(fd);
+    }
+
+    std::string mBasePath;
+};
+
+} // namespace logtail
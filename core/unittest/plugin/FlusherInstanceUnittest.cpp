@@ -28,6 +28,7 @@ public:
     void TestInit() const;
     void TestStart() const;
     void TestStop() const;
+    void TestOnFlush() const;
 };
 
 void FlusherInstanceUnittest::TestName() const {
@@ -53,10 +54,26 @@ void FlusherInstanceUnittest::TestStop() const {
     APSARA_TEST_TRUE(flusher->Stop(true));
 }
 
+void FlusherInstanceUnittest::TestOnFlush() const {
+    unique_ptr<FlusherInstance> flusher = unique_ptr<FlusherInstance>(new FlusherInstance(new FlusherMock(), "0"));
+    // not initialized, nothing is recorded
+    flusher->OnFlush(1, 100, 10);
+    Json::Value config, opt;
+    PipelineContext context;
+    APSARA_TEST_TRUE_FATAL(flusher->Init(config, context, opt));
+    flusher->OnFlush(10, 1000, 100);
+    flusher->OnFlush(5, 500, 3000);
+    APSARA_TEST_EQUAL(15U, flusher->mFlusherInRecordsTotal->GetValue());
+    APSARA_TEST_EQUAL(1500U, flusher->mFlusherInSizeBytes->GetValue());
+    APSARA_TEST_EQUAL(2U, flusher->mFlusherLatencyUs->GetCount());
+    APSARA_TEST_EQUAL(3100U, flusher->mFlusherLatencyUs->GetSum());
+}
+
 UNIT_TEST_CASE(FlusherInstanceUnittest, TestName)
 UNIT_TEST_CASE(FlusherInstanceUnittest, TestInit)
 UNIT_TEST_CASE(FlusherInstanceUnittest, TestStart)
 UNIT_TEST_CASE(FlusherInstanceUnittest, TestStop)
+UNIT_TEST_CASE(FlusherInstanceUnittest, TestOnFlush)
 
 } // namespace logtail
 
@@ -0,0 +1,116 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "logger/Logger.h"
+#include "models/LogEvent.h"
+#include "plugin/instance/ProcessorInstance.h"
+
+using namespace std;
+
+namespace logtail {
+
+// ProcessorLookupMock does the least work of real processors, it looks up a content of every event.
+class ProcessorLookupMock : public Processor {
+public:
+    static const string sName;
+
+    const string& Name() const override { return sName; }
+    bool Init(const Json::Value& config) override { return true; }
+    void Process(PipelineEventGroup& logGroup) override {
+        for (auto& event : logGroup.MutableEvents()) {
+            mFound += event.Cast<LogEvent>().HasContent("key0") ? 1 : 0;
+        }
+    }
+
+    uint64_t mFound = 0;
+
+protected:
+    bool IsSupportedEvent(const PipelineEventPtr& e) const override { return true; }
+};
+
+const string ProcessorLookupMock::sName = "processor_lookup_mock";
+
+// ProcessorInstanceBenchmark measures the overhead of the metrics ProcessorInstance records around a cheap processor
+// by comparing it with calling the processor directly.
+class ProcessorInstanceBenchmark {
+public:
+    static void Run(uint32_t eventCount, uint32_t contentCount, uint32_t calls) {
+        vector<PipelineEventGroup> logGroupList;
+        logGroupList.emplace_back(make_shared<SourceBuffer>());
+        for (uint32_t i = 0; i < eventCount; ++i) {
+            auto event = logGroupList[0].AddLogEvent();
+            for (uint32_t j = 0; j < contentCount; ++j) {
+                event->SetContent("key" + to_string(j), "value of event " + to_string(i));
+            }
+        }
+
+        PipelineContext context;
+        Json::Value config;
+        ProcessorLookupMock* plugin = new ProcessorLookupMock();
+        ProcessorInstance instance(plugin, "0");
+        if (!instance.Init(config, context)) {
+            cout << "init processor instance failed" << endl;
+            return;
+        }
+
+        // interleave rounds so that frequency changes affect both sides alike
+        uint64_t rawNs = 0;
+        uint64_t instanceNs = 0;
+        for (int round = 0; round < 10; ++round) {
+            rawNs += Measure([&]() {
+                for (uint32_t i = 0; i < calls / 10; ++i) {
+                    static_cast<Processor*>(plugin)->Process(logGroupList);
+                }
+            });
+            instanceNs += Measure([&]() {
+                for (uint32_t i = 0; i < calls / 10; ++i) {
+                    instance.Process(logGroupList);
+                }
+            });
+        }
+
+        cout << "events: " << eventCount << ", contents: " << contentCount << ", calls: " << calls << endl;
+        cout << "  raw: " << static_cast<double>(rawNs) / calls << "ns/call, instance: "
+             << static_cast<double>(instanceNs) / calls << "ns/call, overhead: "
+             << (static_cast<double>(instanceNs) - rawNs) * 100 / rawNs << "%" << endl;
+    }
+
+private:
+    template <typename Func>
+    static uint64_t Measure(Func func) {
+        auto start = chrono::steady_clock::now();
+        func();
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+} // namespace logtail
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+    logtail::ProcessorInstanceBenchmark::Run(10, 5, 100000);
+    logtail::ProcessorInstanceBenchmark::Run(100, 10, 100000);
+    logtail::ProcessorInstanceBenchmark::Run(1000, 10, 10000);
+    return 0;
+}
@@ -14,10 +14,13 @@
 
 #include <memory>
 
+#include "common/Flags.h"
 #include "unittest/plugin/PluginMock.h"
 #include "plugin/instance/ProcessorInstance.h"
 #include "unittest/Unittest.h"
 
+DECLARE_FLAG_INT32(plugin_metrics_size_sample_interval);
+
 using namespace std;
 
 namespace logtail {
@@ -26,6 +29,7 @@ class ProcessorInstanceUnittest : public testing::Test {
 public:
     void TestName() const;
     void TestInit() const;
+    void TestProcessMetrics() const;
 };
 
 void ProcessorInstanceUnittest::TestName() const {
@@ -43,8 +47,38 @@ void ProcessorInstanceUnittest::TestInit() const {
     APSARA_TEST_EQUAL(&context, &processor->mPlugin->GetContext());
 }
 
+void ProcessorInstanceUnittest::TestProcessMetrics() const {
+    unique_ptr<ProcessorInstance> processor
+        = unique_ptr<ProcessorInstance>(new ProcessorInstance(new ProcessorMock(), "0"));
+    Json::Value config;
+    PipelineContext context;
+    APSARA_TEST_TRUE_FATAL(processor->Init(config, context));
+
+    vector<PipelineEventGroup> logGroupList;
+    logGroupList.emplace_back(make_shared<SourceBuffer>());
+    for (int i = 0; i < 3; ++i) {
+        auto event = logGroupList[0].AddLogEvent();
+        event->SetContent(string("key"), string("value"));
+    }
+    int32_t interval = INT32_FLAG(plugin_metrics_size_sample_interval);
+    INT32_FLAG(plugin_metrics_size_sample_interval) = 1;
+    processor->Process(logGroupList);
+    processor->Process(logGroupList);
+    INT32_FLAG(plugin_metrics_size_sample_interval) = 0;
+    processor->Process(logGroupList);
+    INT32_FLAG(plugin_metrics_size_sample_interval) = interval;
+
+    APSARA_TEST_EQUAL(9U, processor->mProcInRecordsTotal->GetValue());
+    APSARA_TEST_EQUAL(9U, processor->mProcOutRecordsTotal->GetValue());
+    // sizes are only measured while sampling is enabled
+    APSARA_TEST_EQUAL(2U * 3 * strlen("keyvalue"), processor->mProcInRecordsSizeBytes->GetValue());
+    APSARA_TEST_EQUAL(2U * 3 * strlen("keyvalue"), processor->mProcOutRecordsSizeBytes->GetValue());
+    APSARA_TEST_EQUAL(3U, processor->mProcLatencyUs->GetCount());
+}
+
 UNIT_TEST_CASE(ProcessorInstanceUnittest, TestName)
 UNIT_TEST_CASE(ProcessorInstanceUnittest, TestInit)
+UNIT_TEST_CASE(ProcessorInstanceUnittest, TestProcessMetrics)
 
 } // namespace logtail
 
@@ -0,0 +1,194 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "common/Flags.h"
+#include "common/TimeUtil.h"
+#include "polling/PollingDirSnapshot.h"
+#include "unittest/Unittest.h"
+
+DECLARE_FLAG_INT32(polling_dir_read_buffer_size);
+
+using namespace std;
+
+namespace logtail {
+
+class PollingDirSnapshotUnittest : public ::testing::Test {
+public:
+    void TestLoad();
+    void TestLoadLargeDir();
+    void TestCacheReuse();
+    void TestRemoveUnchecked();
+    void TestOwner();
+
+protected:
+    void SetUp() override {
+        mRootDir = GetProcessExecutionDir() + "PollingDirSnapshotUnittest";
+        bfs::remove_all(mRootDir);
+        bfs::create_directories(mRootDir);
+    }
+
+    void TearDown() override { bfs::remove_all(mRootDir); }
+
+    void CreateFile(const string& name) { ofstream(mRootDir + "/" + name) << "test"; }
+
+    static uint64_t GetOwnerOf(DirSnapshotCache& cache, const DevInode& devInode) {
+        return cache.mSnapshots[devInode].GetOwner();
+    }
+
+    static map<string, DirSnapshot::EntryType> GetEntries(DirSnapshot& snapshot) {
+        map<string, DirSnapshot::EntryType> entries;
+        for (size_t idx = 0; idx < snapshot.Size(); ++idx) {
+            entries[snapshot.GetName(snapshot.At(idx))] = snapshot.At(idx).mType;
+        }
+        return entries;
+    }
+
+    string mRootDir;
+};
+
+UNIT_TEST_CASE(PollingDirSnapshotUnittest, TestLoad);
+UNIT_TEST_CASE(PollingDirSnapshotUnittest, TestLoadLargeDir);
+UNIT_TEST_CASE(PollingDirSnapshotUnittest, TestCacheReuse);
+UNIT_TEST_CASE(PollingDirSnapshotUnittest, TestRemoveUnchecked);
+UNIT_TEST_CASE(PollingDirSnapshotUnittest, TestOwner);
+
+void PollingDirSnapshotUnittest::TestLoad() {
+    CreateFile("a.log");
+    CreateFile(".hidden.log");
+    bfs::create_directories(mRootDir + "/sub");
+    bfs::create_symlink(mRootDir + "/a.log", mRootDir + "/link.log");
+
+    DirSnapshot snapshot;
+    APSARA_TEST_TRUE(snapshot.Load(mRootDir));
+    auto entries = GetEntries(snapshot);
+    APSARA_TEST_EQUAL(3U, entries.size());
+    APSARA_TEST_TRUE(entries["a.log"] == DirSnapshot::EntryType::REG_FILE);
+    APSARA_TEST_TRUE(entries["sub"] == DirSnapshot::EntryType::DIR);
+    APSARA_TEST_TRUE(entries["link.log"] == DirSnapshot::EntryType::UNRESOLVED);
+
+    APSARA_TEST_FALSE(snapshot.Load(mRootDir + "/not_exist"));
+    APSARA_TEST_EQUAL(ENOENT, errno);
+    APSARA_TEST_EQUAL(0U, snapshot.Size());
+}
+
+void PollingDirSnapshotUnittest::TestLoadLargeDir() {
+    int32_t bufferSize = INT32_FLAG(polling_dir_read_buffer_size);
+    // entries are read by many calls
+    INT32_FLAG(polling_dir_read_buffer_size) = 4096;
+    const size_t kFileCount = 1000;
+    for (size_t i = 0; i < kFileCount; ++i) {
+        CreateFile("file_with_a_long_name_" + to_string(i) + ".log");
+    }
+    DirSnapshot snapshot;
+    APSARA_TEST_TRUE(snapshot.Load(mRootDir));
+    auto entries = GetEntries(snapshot);
+    APSARA_TEST_EQUAL(kFileCount, entries.size());
+    APSARA_TEST_EQUAL(1U, entries.count("file_with_a_long_name_999.log"));
+    INT32_FLAG(polling_dir_read_buffer_size) = bufferSize;
+}
+
+void PollingDirSnapshotUnittest::TestCacheReuse() {
+    CreateFile("a.log");
+    DirSnapshotCache cache;
+    DirSnapshot privateSnapshot;
+    const DevInode devInode(1, 2);
+    // modified long ago
+    const int64_t oldTime = (int64_t)GetCurrentTimeInNanoSeconds() - 10 * 1000000000LL;
+    bool loaded = false;
+    DirSnapshot* snapshot = cache.Get(mRootDir, devInode, oldTime, 2, 1, 1, privateSnapshot, loaded);
+    APSARA_TEST_TRUE(snapshot != nullptr);
+    APSARA_TEST_TRUE(loaded);
+    APSARA_TEST_EQUAL(1U, snapshot->Size());
+    snapshot->At(0).mMatch = DirSnapshot::MatchStatus::MATCHED;
+
+    // unchanged directory is not read again, so new files are not seen
+    CreateFile("b.log");
+    snapshot = cache.Get(mRootDir, devInode, oldTime, 2, 2, 1, privateSnapshot, loaded);
+    APSARA_TEST_FALSE(loaded);
+    APSARA_TEST_EQUAL(1U, snapshot->Size());
+    APSARA_TEST_TRUE(snapshot->At(0).mMatch == DirSnapshot::MatchStatus::MATCHED);
+
+    // changed modify time or link count
+    snapshot = cache.Get(mRootDir, devInode, oldTime + 1, 2, 3, 1, privateSnapshot, loaded);
+    APSARA_TEST_TRUE(loaded);
+    APSARA_TEST_EQUAL(2U, snapshot->Size());
+    snapshot = cache.Get(mRootDir, devInode, oldTime + 1, 3, 4, 1, privateSnapshot, loaded);
+    APSARA_TEST_TRUE(loaded);
+
+    // a directory modified just now may change again within the same timestamp
+    const int64_t now = (int64_t)GetCurrentTimeInNanoSeconds();
+    snapshot = cache.Get(mRootDir, devInode, now, 3, 5, 1, privateSnapshot, loaded);
+    APSARA_TEST_TRUE(loaded);
+    snapshot = cache.Get(mRootDir, devInode, now, 3, 6, 1, privateSnapshot, loaded);
+    APSARA_TEST_TRUE(loaded);
+    // but it is read only once in a round
+    snapshot = cache.Get(mRootDir, devInode, now, 3, 6, 1, privateSnapshot, loaded);
+    APSARA_TEST_FALSE(loaded);
+
+    // match status is reset for a new epoch
+    snapshot->At(0).mMatch = DirSnapshot::MatchStatus::UNMATCHED;
+    snapshot->ResetMatchStatus(snapshot->GetMatchEpoch() + 1);
+    APSARA_TEST_TRUE(snapshot->At(0).mMatch == DirSnapshot::MatchStatus::UNKNOWN);
+
+    // unreadable directory is removed from cache
+    bfs::remove_all(mRootDir);
+    APSARA_TEST_TRUE(cache.Get(mRootDir, devInode, now + 1, 3, 7, 1, privateSnapshot, loaded) == nullptr);
+    APSARA_TEST_EQUAL(0U, cache.Size());
+}
+
+void PollingDirSnapshotUnittest::TestRemoveUnchecked() {
+    DirSnapshotCache cache;
+    DirSnapshot privateSnapshot;
+    bool loaded = false;
+    APSARA_TEST_TRUE(cache.Get(mRootDir, DevInode(1, 1), 0, 2, 1, 1, privateSnapshot, loaded) != nullptr);
+    APSARA_TEST_TRUE(cache.Get(mRootDir, DevInode(1, 2), 0, 2, 5, 1, privateSnapshot, loaded) != nullptr);
+    cache.RemoveUnchecked(10, 5);
+    APSARA_TEST_EQUAL(1U, cache.Size());
+    APSARA_TEST_TRUE(cache.mSnapshots.find(DevInode(1, 2)) != cache.mSnapshots.end());
+    APSARA_TEST_TRUE(cache.GetMemorySize() > 0);
+}
+
+void PollingDirSnapshotUnittest::TestOwner() {
+    CreateFile("a.log");
+    DirSnapshotCache cache;
+    DirSnapshot privateSnapshot;
+    const DevInode devInode(1, 2);
+    const int64_t oldTime = (int64_t)GetCurrentTimeInNanoSeconds() - 10 * 1000000000LL;
+    bool loaded = false;
+    DirSnapshot* snapshot = cache.Get(mRootDir, devInode, oldTime, 2, 1, 1, privateSnapshot, loaded);
+    APSARA_TEST_TRUE(snapshot != &privateSnapshot);
+    APSARA_TEST_TRUE(loaded);
+
+    // another owner in the same round reads the directory by itself
+    DirSnapshot* other = cache.Get(mRootDir, devInode, oldTime, 2, 1, 2, privateSnapshot, loaded);
+    APSARA_TEST_TRUE(other == &privateSnapshot);
+    APSARA_TEST_TRUE(loaded);
+    APSARA_TEST_EQUAL(1U, other->Size());
+    APSARA_TEST_EQUAL(1U, GetOwnerOf(cache, devInode));
+
+    // the first owner of a round claims it
+    other = cache.Get(mRootDir, devInode, oldTime, 2, 2, 2, privateSnapshot, loaded);
+    APSARA_TEST_TRUE(other == snapshot);
+    APSARA_TEST_FALSE(loaded);
+    APSARA_TEST_EQUAL(2U, GetOwnerOf(cache, devInode));
+    APSARA_TEST_TRUE(cache.Get(mRootDir, devInode, oldTime, 2, 2, 1, privateSnapshot, loaded) == &privateSnapshot);
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,73 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "polling/PollingStatPool.h"
+#include "unittest/Unittest.h"
+
+using namespace std;
+
+namespace logtail {
+
+class PollingStatPoolUnittest : public ::testing::Test {
+public:
+    void TestRun();
+    void TestConcurrentRun();
+};
+
+UNIT_TEST_CASE(PollingStatPoolUnittest, TestRun);
+UNIT_TEST_CASE(PollingStatPoolUnittest, TestConcurrentRun);
+
+void PollingStatPoolUnittest::TestRun() {
+    PollingStatPool* pool = PollingStatPool::GetInstance();
+    APSARA_TEST_TRUE(pool->GetThreadCount() >= 1U);
+
+    pool->Run(0, [](size_t) {});
+    vector<atomic_int> counts(1000);
+    pool->Run(counts.size(), [&counts](size_t idx) { ++counts[idx]; });
+    for (auto& count : counts) {
+        APSARA_TEST_EQUAL(1, count.load());
+    }
+}
+
+void PollingStatPoolUnittest::TestConcurrentRun() {
+    // callers share workers, each of them returns after its own tasks are done
+    PollingStatPool* pool = PollingStatPool::GetInstance();
+    const size_t kCallerCount = 4;
+    const size_t kTaskCount = 100;
+    vector<vector<int>> results(kCallerCount, vector<int>(kTaskCount, 0));
+    vector<thread> callers;
+    for (size_t i = 0; i < kCallerCount; ++i) {
+        callers.emplace_back([pool, &results, i]() {
+            for (int round = 0; round < 10; ++round) {
+                pool->Run(kTaskCount, [&results, i](size_t idx) { ++results[i][idx]; });
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    for (auto& result : results) {
+        for (int count : result) {
+            APSARA_TEST_EQUAL(10, count);
+        }
+    }
+}
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -0,0 +1,143 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <fstream>
+
+#include "common/FileSystemUtil.h"
+#include "reader/GloablFileDescriptorManager.h"
+#include "reader/LogFileReader.h"
+#include "unittest/Unittest.h"
+
+using namespace std;
+
+namespace logtail {
+
+class FileDescriptorCacheUnittest : public testing::Test {
+public:
+    void TestLruOrder();
+    void TestEvictIdleFiles();
+    void TestCloseRemovedFileOnTimeout();
+
+protected:
+    void SetUp() override {
+        for (size_t i = 0; i < kReaderCount; ++i) {
+            string fileName = "FileDescriptorCacheUnittest_" + to_string(i) + ".txt";
+            ofstream(fileName).close();
+            mReaders[i].reset(new LogFileReader(".",
+                                                fileName,
+                                                GetFileDevInode("./" + fileName),
+                                                make_pair(&readerOpts, &ctx),
+                                                make_pair(&multilineOpts, &ctx)));
+        }
+    }
+
+    void TearDown() override {
+        for (size_t i = 0; i < kReaderCount; ++i) {
+            mReaders[i].reset();
+            remove(("FileDescriptorCacheUnittest_" + to_string(i) + ".txt").c_str());
+        }
+    }
+
+private:
+    static const size_t kReaderCount = 3;
+    LogFileReaderPtr mReaders[kReaderCount];
+    FileReaderOptions readerOpts;
+    MultilineOptions multilineOpts;
+    PipelineContext ctx;
+};
+
+void FileDescriptorCacheUnittest::TestLruOrder() {
+    GloablFileDescriptorManager* manager = GloablFileDescriptorManager::GetInstance();
+    int32_t openFiles = manager->GetOpenedFilePtrSize();
+    uint64_t openCount = manager->GetOpenCount();
+    uint64_t avoidedOpenCount = manager->GetAvoidedOpenCount();
+    for (size_t i = 0; i < kReaderCount; ++i) {
+        APSARA_TEST_TRUE(mReaders[i]->UpdateFilePtr());
+    }
+    APSARA_TEST_EQUAL(manager->GetOpenedFilePtrSize(), openFiles + 3);
+    APSARA_TEST_EQUAL(manager->GetOpenCount(), openCount + 3);
+    APSARA_TEST_EQUAL(manager->mLruList.front().mReader, mReaders[2].get());
+    APSARA_TEST_EQUAL(manager->mLruList.back().mReader, mReaders[0].get());
+
+    // using an open file moves it to the front without opening it again
+    APSARA_TEST_TRUE(mReaders[0]->UpdateFilePtr());
+    APSARA_TEST_EQUAL(manager->GetOpenCount(), openCount + 3);
+    APSARA_TEST_EQUAL(manager->mLruList.front().mReader, mReaders[0].get());
+    APSARA_TEST_EQUAL(manager->mLruList.back().mReader, mReaders[1].get());
+    // it is not an avoided open unless the file has been unused for longer than the close timeout
+    APSARA_TEST_EQUAL(manager->GetAvoidedOpenCount(), avoidedOpenCount);
+    mReaders[0]->mLastUpdateTime -= readerOpts.mCloseUnusedReaderIntervalSec + 1;
+    APSARA_TEST_TRUE(mReaders[0]->UpdateFilePtr());
+    APSARA_TEST_EQUAL(manager->GetOpenCount(), openCount + 3);
+    APSARA_TEST_EQUAL(manager->GetAvoidedOpenCount(), avoidedOpenCount + 1);
+
+    mReaders[1]->CloseFilePtr();
+    APSARA_TEST_EQUAL(manager->GetOpenedFilePtrSize(), openFiles + 2);
+    APSARA_TEST_EQUAL(manager->mLruIndex.count(mReaders[1].get()), 0U);
+    APSARA_TEST_EQUAL(manager->mLruList.back().mReader, mReaders[2].get());
+}
+
+void FileDescriptorCacheUnittest::TestEvictIdleFiles() {
+    GloablFileDescriptorManager* manager = GloablFileDescriptorManager::GetInstance();
+    for (size_t i = 0; i < kReaderCount; ++i) {
+        APSARA_TEST_TRUE(mReaders[i]->UpdateFilePtr());
+    }
+    // LRU order from the oldest: 1, 2, 0
+    APSARA_TEST_TRUE(mReaders[0]->UpdateFilePtr());
+    // file 1 has data not read yet, so it is kept open
+    ofstream("FileDescriptorCacheUnittest_1.txt") << "not read\n";
+
+    uint64_t evictCount = manager->GetEvictCount();
+    APSARA_TEST_EQUAL(manager->EvictIdleFiles(1), 1U);
+    APSARA_TEST_TRUE(mReaders[1]->IsFileOpened());
+    APSARA_TEST_FALSE(mReaders[2]->IsFileOpened());
+    APSARA_TEST_TRUE(mReaders[0]->IsFileOpened());
+    APSARA_TEST_EQUAL(manager->EvictIdleFiles(5), 1U);
+    APSARA_TEST_FALSE(mReaders[0]->IsFileOpened());
+    APSARA_TEST_EQUAL(manager->GetEvictCount(), evictCount + 2);
+
+    // evicted files are opened again when they are used
+    APSARA_TEST_TRUE(mReaders[2]->UpdateFilePtr());
+    APSARA_TEST_TRUE(mReaders[2]->IsFileOpened());
+}
+
+void FileDescriptorCacheUnittest::TestCloseRemovedFileOnTimeout() {
+    GloablFileDescriptorManager* manager = GloablFileDescriptorManager::GetInstance();
+    APSARA_TEST_TRUE(mReaders[0]->UpdateFilePtr());
+    int32_t openFiles = manager->GetOpenedFilePtrSize();
+    int32_t timeoutTime = (int32_t)(mReaders[0]->mLastUpdateTime + readerOpts.mCloseUnusedReaderIntervalSec * 2);
+
+    // files still on the disk are kept open unless all timeout files are closed
+    APSARA_TEST_FALSE(mReaders[0]->CloseTimeoutFilePtr(timeoutTime, true));
+    APSARA_TEST_TRUE(mReaders[0]->IsFileOpened());
+
+    // a removed file is not closed before the timeout
+    remove("FileDescriptorCacheUnittest_0.txt");
+    APSARA_TEST_FALSE(mReaders[0]->CloseTimeoutFilePtr((int32_t)mReaders[0]->mLastUpdateTime, true));
+    APSARA_TEST_TRUE(mReaders[0]->IsFileOpened());
+
+    // but it is after the timeout, which releases its disk space
+    APSARA_TEST_TRUE(mReaders[0]->CloseTimeoutFilePtr(timeoutTime, true));
+    APSARA_TEST_FALSE(mReaders[0]->IsFileOpened());
+    APSARA_TEST_EQUAL(manager->GetOpenedFilePtrSize(), openFiles - 1);
+}
+
+UNIT_TEST_CASE(FileDescriptorCacheUnittest, TestLruOrder)
+UNIT_TEST_CASE(FileDescriptorCacheUnittest, TestEvictIdleFiles)
+UNIT_TEST_CASE(FileDescriptorCacheUnittest, TestCloseRemovedFileOnTimeout)
+
+} // namespace logtail
+
+UNIT_TEST_MAIN
@@ -26,6 +26,7 @@ public:
     void SetUp() override {}
     void TearDown() override {}
     void TestBufferAllocatorAllocate();
+    void TestBufferAllocatorMemoryBudget();
 };
 
 void SourceBufferUnittest::TestBufferAllocatorAllocate() {
@@ -59,7 +60,34 @@ void SourceBufferUnittest::TestBufferAllocatorAllocate() {
     APSARA_TEST_EQUAL('c', static_cast<char*>(alloc3)[0]);
 }
 
+void SourceBufferUnittest::TestBufferAllocatorMemoryBudget() {
+    MemoryBudget* budget = MemoryBudget::GetInstance();
+    int64_t baseUsed = budget->GetUsedBytes();
+    {
+        BufferAllocator allocator;
+        APSARA_TEST_EQUAL(baseUsed + 4096, budget->GetUsedBytes());
+        allocator.Allocate(4000);
+        allocator.Allocate(10000);
+        APSARA_TEST_EQUAL(baseUsed + allocator.mAllocated, budget->GetUsedBytes());
+        allocator.Reset();
+        APSARA_TEST_EQUAL(baseUsed + 4096, budget->GetUsedBytes());
+        allocator.Allocate(10000);
+    }
+    APSARA_TEST_EQUAL(baseUsed, budget->GetUsedBytes());
+
+    budget->SetLimitBytes(baseUsed + 8192);
+    {
+        BufferAllocator allocator;
+        APSARA_TEST_FALSE(budget->IsExceeded());
+        allocator.Allocate(10000);
+        APSARA_TEST_TRUE(budget->IsExceeded());
+    }
+    APSARA_TEST_FALSE(budget->IsExceeded());
+    budget->SetLimitBytes(0);
+}
+
 UNIT_TEST_CASE(SourceBufferUnittest, TestBufferAllocatorAllocate);
+UNIT_TEST_CASE(SourceBufferUnittest, TestBufferAllocatorMemoryBudget);
 
 } // namespace logtail
 
@@ -0,0 +1,197 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+#include "unittest/Unittest.h"
+#include "sdk/DNSCache.h"
+
+DECLARE_FLAG_INT32(dns_cache_ttl_sec);
+DECLARE_FLAG_INT32(dns_cache_negative_ttl_sec);
+DECLARE_FLAG_INT32(dns_cache_address_fail_cooldown_sec);
+
+namespace logtail {
+namespace sdk {
+
+    // StubResolver answers from a static table and counts the lookups, hosts not in the table fail.
+    struct StubResolver {
+        std::map<std::string, std::vector<std::string>> mRecords;
+        std::map<std::string, int32_t> mTTLs;
+        int32_t mLookupCount = 0;
+
+        DnsCache::Resolver AsResolver() {
+            return [this](const std::string& host, std::vector<std::string>& addresses, int32_t& ttlSec) {
+                ++mLookupCount;
+                auto iter = mRecords.find(host);
+                if (iter == mRecords.end()) {
+                    return false;
+                }
+                addresses = iter->second;
+                ttlSec = mTTLs.count(host) ? mTTLs[host] : 0;
+                return true;
+            };
+        }
+    };
+
+    class DnsCacheUnittest : public ::testing::Test {
+    public:
+        void TestNonBlockingLookup();
+        void TestTTL();
+        void TestNegativeCache();
+        void TestLatencyRanking();
+        void TestFailedAddressSkipped();
+        void TestBackgroundThread();
+
+    protected:
+        void SetUp() override {
+            mResolver.mRecords["sls.example.com"] = {"10.0.0.1", "10.0.0.2"};
+            mCache.reset(new DnsCache(mResolver.AsResolver(), false));
+        }
+
+        StubResolver mResolver;
+        std::unique_ptr<DnsCache, void (*)(DnsCache*)> mCache{NULL, [](DnsCache* cache) { delete cache; }};
+    };
+
+    UNIT_TEST_CASE(DnsCacheUnittest, TestNonBlockingLookup);
+    UNIT_TEST_CASE(DnsCacheUnittest, TestTTL);
+    UNIT_TEST_CASE(DnsCacheUnittest, TestNegativeCache);
+    UNIT_TEST_CASE(DnsCacheUnittest, TestLatencyRanking);
+    UNIT_TEST_CASE(DnsCacheUnittest, TestFailedAddressSkipped);
+    UNIT_TEST_CASE(DnsCacheUnittest, TestBackgroundThread);
+
+    void DnsCacheUnittest::TestNonBlockingLookup() {
+        std::string address;
+        // Raw ip is returned directly.
+        APSARA_TEST_TRUE(mCache->GetAddress("192.168.1.1", address, 100));
+        APSARA_TEST_EQUAL("192.168.1.1", address);
+        // First lookup only schedules resolving.
+        APSARA_TEST_FALSE(mCache->GetAddress("sls.example.com", address, 100));
+        APSARA_TEST_FALSE(mCache->GetAddress("sls.example.com", address, 100));
+        APSARA_TEST_EQUAL(0, mResolver.mLookupCount);
+        // Repeated lookups are scheduled once.
+        APSARA_TEST_EQUAL(1U, mCache->ProcessPendingHosts(100));
+        APSARA_TEST_EQUAL(1, mResolver.mLookupCount);
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 101));
+        APSARA_TEST_EQUAL("10.0.0.1", address);
+    }
+
+    void DnsCacheUnittest::TestTTL() {
+        mResolver.mTTLs["sls.example.com"] = 30;
+        std::string address;
+        mCache->GetAddress("sls.example.com", address, 100);
+        mCache->ProcessPendingHosts(100);
+        mCache->GetAddress("sls.example.com", address, 129);
+        APSARA_TEST_EQUAL(0U, mCache->ProcessPendingHosts(129));
+
+        // Expired entry still serves the old address while refreshing.
+        mResolver.mRecords["sls.example.com"] = {"10.0.0.3"};
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 130));
+        APSARA_TEST_EQUAL("10.0.0.1", address);
+        APSARA_TEST_EQUAL(1U, mCache->ProcessPendingHosts(130));
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 131));
+        APSARA_TEST_EQUAL("10.0.0.3", address);
+
+        // Default ttl is used when the resolver does not give one.
+        mResolver.mTTLs.clear();
+        mCache->GetAddress("sls.example.com", address, 160);
+        mCache->ProcessPendingHosts(160);
+        mCache->GetAddress("sls.example.com", address, 160 + INT32_FLAG(dns_cache_ttl_sec) - 1);
+        APSARA_TEST_EQUAL(0U, mCache->ProcessPendingHosts(160));
+    }
+
+    void DnsCacheUnittest::TestNegativeCache() {
+        std::string address;
+        APSARA_TEST_FALSE(mCache->GetAddress("unknown.example.com", address, 100));
+        mCache->ProcessPendingHosts(100);
+        APSARA_TEST_FALSE(mCache->GetAddress("unknown.example.com", address, 101));
+        APSARA_TEST_EQUAL(0U, mCache->ProcessPendingHosts(101));
+        APSARA_TEST_FALSE(
+            mCache->GetAddress("unknown.example.com", address, 100 + INT32_FLAG(dns_cache_negative_ttl_sec)));
+        APSARA_TEST_EQUAL(1U, mCache->ProcessPendingHosts(100 + INT32_FLAG(dns_cache_negative_ttl_sec)));
+        APSARA_TEST_EQUAL(2, mResolver.mLookupCount);
+
+        // Failed refresh keeps the last known addresses.
+        mCache->GetAddress("sls.example.com", address, 100);
+        mCache->ProcessPendingHosts(100);
+        mResolver.mRecords.clear();
+        int32_t expired = 100 + INT32_FLAG(dns_cache_ttl_sec);
+        mCache->GetAddress("sls.example.com", address, expired);
+        mCache->ProcessPendingHosts(expired);
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, expired + 1));
+        APSARA_TEST_EQUAL("10.0.0.1", address);
+    }
+
+    void DnsCacheUnittest::TestLatencyRanking() {
+        std::string address;
+        mCache->GetAddress("sls.example.com", address, 100);
+        mCache->ProcessPendingHosts(100);
+        mCache->UpdateAddressStatus("sls.example.com", "10.0.0.1", 50, true, 100);
+        // Addresses without samples are probed first.
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 101));
+        APSARA_TEST_EQUAL("10.0.0.2", address);
+        mCache->UpdateAddressStatus("sls.example.com", "10.0.0.2", 10, true, 101);
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 102));
+        APSARA_TEST_EQUAL("10.0.0.2", address);
+        // Reused connections do not change the ranking.
+        mCache->UpdateAddressStatus("sls.example.com", "10.0.0.2", 0, true, 102);
+        for (int i = 0; i < 10; ++i) {
+            mCache->UpdateAddressStatus("sls.example.com", "10.0.0.2", 200, true, 102);
+        }
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 103));
+        APSARA_TEST_EQUAL("10.0.0.1", address);
+
+        // Samples survive refreshing.
+        mCache->GetAddress("sls.example.com", address, 100 + INT32_FLAG(dns_cache_ttl_sec));
+        mCache->ProcessPendingHosts(100 + INT32_FLAG(dns_cache_ttl_sec));
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 101 + INT32_FLAG(dns_cache_ttl_sec)));
+        APSARA_TEST_EQUAL("10.0.0.1", address);
+    }
+
+    void DnsCacheUnittest::TestFailedAddressSkipped() {
+        std::string address;
+        mCache->GetAddress("sls.example.com", address, 100);
+        mCache->ProcessPendingHosts(100);
+        mCache->UpdateAddressStatus("sls.example.com", "10.0.0.1", 10, true, 100);
+        mCache->UpdateAddressStatus("sls.example.com", "10.0.0.2", 20, true, 100);
+        mCache->UpdateAddressStatus("sls.example.com", "10.0.0.1", 0, false, 101);
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 102));
+        APSARA_TEST_EQUAL("10.0.0.2", address);
+        // All failed, the one with fewer failures is used.
+        mCache->UpdateAddressStatus("sls.example.com", "10.0.0.2", 0, false, 102);
+        mCache->UpdateAddressStatus("sls.example.com", "10.0.0.2", 0, false, 102);
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 103));
+        APSARA_TEST_EQUAL("10.0.0.1", address);
+        // Back to latency ranking after cooldown.
+        int32_t cooldown = INT32_FLAG(dns_cache_address_fail_cooldown_sec);
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 102 + cooldown));
+        APSARA_TEST_EQUAL("10.0.0.1", address);
+        mCache->UpdateAddressStatus("sls.example.com", "10.0.0.1", 0, false, 102 + cooldown);
+        APSARA_TEST_TRUE(mCache->GetAddress("sls.example.com", address, 103 + cooldown));
+        APSARA_TEST_EQUAL("10.0.0.2", address);
+    }
+
+    void DnsCacheUnittest::TestBackgroundThread() {
+        std::unique_ptr<DnsCache, void (*)(DnsCache*)> cache(new DnsCache(mResolver.AsResolver(), true),
+                                                             [](DnsCache* cache) { delete cache; });
+        std::string address;
+        APSARA_TEST_FALSE(cache->GetIPFromDnsCache("sls.example.com", address));
+        for (int i = 0; i < 100 && !cache->GetIPFromDnsCache("sls.example.com", address); ++i) {
+            usleep(10 * 1000);
+        }
+        APSARA_TEST_EQUAL("10.0.0.1", address);
+    }
+
+} // namespace sdk
+} // namespace logtail
+
+UNIT_TEST_MAIN
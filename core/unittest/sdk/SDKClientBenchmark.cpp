@@ -0,0 +1,213 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "unittest/Unittest.h"
+#include "common/TimeUtil.h"
+#include "sdk/Client.h"
+
+using namespace logtail;
+
+// MockSLSServer is a minimal HTTP/1.1 keep-alive server on loopback which acknowledges every request with
+// an empty 200 response carrying a request id, just enough for sdk::Client to treat it as a success.
+class MockSLSServer {
+public:
+    bool Start() {
+        mListenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if (mListenFd < 0) {
+            return false;
+        }
+        int opt = 1;
+        setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        if (bind(mListenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(mListenFd, 128) != 0) {
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(mListenFd, (sockaddr*)&addr, &len);
+        mPort = ntohs(addr.sin_port);
+        mAcceptThread = std::thread([this]() { AcceptLoop(); });
+        return true;
+    }
+
+    void Stop() {
+        shutdown(mListenFd, SHUT_RDWR);
+        close(mListenFd);
+        mAcceptThread.join();
+        for (auto& t : mConnThreads) {
+            t.detach();
+        }
+    }
+
+    int32_t GetPort() const { return mPort; }
+    int32_t GetConnectionCount() const { return mConnCount.load(); }
+
+private:
+    void AcceptLoop() {
+        while (true) {
+            int fd = accept(mListenFd, NULL, NULL);
+            if (fd < 0) {
+                return;
+            }
+            ++mConnCount;
+            mConnThreads.emplace_back([fd]() { Serve(fd); });
+        }
+    }
+
+    static void Serve(int fd) {
+        static const std::string kResponse
+            = "HTTP/1.1 200 OK\r\nx-log-requestid: mock\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+        std::string buffer;
+        char chunk[64 * 1024];
+        while (true) {
+            size_t headerEnd = buffer.find("\r\n\r\n");
+            if (headerEnd != std::string::npos) {
+                size_t contentLength = 0;
+                std::string header = buffer.substr(0, headerEnd);
+                std::transform(header.begin(), header.end(), header.begin(), ::tolower);
+                size_t pos = header.find("content-length:");
+                if (pos != std::string::npos) {
+                    contentLength = std::stoul(header.substr(pos + 15));
+                }
+                size_t requestSize = headerEnd + 4 + contentLength;
+                if (buffer.size() >= requestSize) {
+                    buffer.erase(0, requestSize);
+                    if (write(fd, kResponse.data(), kResponse.size()) < 0) {
+                        break;
+                    }
+                    continue;
+                }
+            }
+            ssize_t n = read(fd, chunk, sizeof(chunk));
+            if (n <= 0) {
+                break;
+            }
+            buffer.append(chunk, n);
+        }
+        close(fd);
+    }
+
+    int mListenFd = -1;
+    int32_t mPort = 0;
+    std::atomic_int mConnCount{0};
+    std::thread mAcceptThread;
+    std::vector<std::thread> mConnThreads;
+};
+
+class BenchmarkClosure : public sdk::PostLogStoreLogsClosure {
+public:
+    void OnSuccess(sdk::Response* response) override { Finish(true); }
+    void OnFail(sdk::Response* response, const std::string& errorCode, const std::string& errorMessage) override {
+        Finish(false);
+    }
+
+    uint64_t mStartTime = 0;
+    std::vector<uint64_t>* mLatencies = NULL;
+    std::atomic_int* mDone = NULL;
+    std::atomic_int* mFailed = NULL;
+    std::mutex* mMux = NULL;
+    std::condition_variable* mCond = NULL;
+
+private:
+    void Finish(bool success) {
+        uint64_t latency = GetCurrentTimeInMicroSeconds() - mStartTime;
+        {
+            std::lock_guard<std::mutex> lock(*mMux);
+            mLatencies->push_back(latency);
+            if (!success) {
+                ++*mFailed;
+            }
+            ++*mDone;
+        }
+        mCond->notify_one();
+        delete this;
+    }
+};
+
+// BM_PostLogStoreLogs posts totalCount bodies of bodySize bytes with at most inflight outstanding requests,
+// reporting posts/s, p50/p99 latency and how many connections the mock server saw.
+static void BM_PostLogStoreLogs(int totalCount, int inflight, size_t bodySize) {
+    MockSLSServer server;
+    if (!server.Start()) {
+        std::cout << "failed to start mock server" << std::endl;
+        return;
+    }
+    sdk::Client client("127.0.0.1", "ak_id", "ak_secret");
+    client.SetPort(server.GetPort());
+
+    // Bodies are referenced, not copied, by async requests, so they must stay alive until all callbacks are done.
+    std::string body(bodySize, 'x');
+    std::vector<uint64_t> latencies;
+    latencies.reserve(totalCount);
+    std::atomic_int done{0};
+    std::atomic_int failed{0};
+    std::mutex mux;
+    std::condition_variable cond;
+
+    uint64_t startTime = GetCurrentTimeInMicroSeconds();
+    for (int i = 0; i < totalCount; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mux);
+            cond.wait(lock, [&]() { return i - done.load() < inflight; });
+        }
+        BenchmarkClosure* closure = new BenchmarkClosure;
+        closure->mStartTime = GetCurrentTimeInMicroSeconds();
+        closure->mLatencies = &latencies;
+        closure->mDone = &done;
+        closure->mFailed = &failed;
+        closure->mMux = &mux;
+        closure->mCond = &cond;
+        client.PostLogStoreLogs("project", "logstore", sls_logs::SLS_CMP_NONE, body, bodySize, closure);
+    }
+    {
+        std::unique_lock<std::mutex> lock(mux);
+        cond.wait(lock, [&]() { return done.load() == totalCount; });
+    }
+    uint64_t durationTime = GetCurrentTimeInMicroSeconds() - startTime;
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "count: " << totalCount << " inflight: " << inflight << " body: " << bodySize << std::endl;
+    std::cout << "failed: " << failed.load() << " connections: " << server.GetConnectionCount() << std::endl;
+    std::cout << "posts/s: " << (uint64_t)totalCount * 1000000 / std::max<uint64_t>(durationTime, 1) << std::endl;
+    std::cout << "p50 latency(us): " << latencies[latencies.size() / 2] << std::endl;
+    std::cout << "p99 latency(us): " << latencies[latencies.size() * 99 / 100] << std::endl;
+    server.Stop();
+}
+
+int main(int argc, char** argv) {
+    logtail::Logger::Instance().InitGlobalLoggers();
+#ifdef NDEBUG
+    std::cout << "release" << std::endl;
+#else
+    std::cout << "debug" << std::endl;
+#endif
+
+    BM_PostLogStoreLogs(20000, 1, 1024);
+    BM_PostLogStoreLogs(20000, 32, 1024);
+    BM_PostLogStoreLogs(5000, 32, 512 * 1024);
+    return 0;
+}
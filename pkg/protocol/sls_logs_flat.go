@@ -0,0 +1,132 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package protocol
+
+import (
+	"encoding/binary"
+	"errors"
+	"reflect"
+	"unsafe"
+)
+
+// The flat log group is written by core/go_pipeline/FlatLogGroup.cpp, see the layout there.
+const (
+	flatLogGroupMagic      = 0x3146474c // "LGF1"
+	flatStringSize         = 8
+	flatPairSize           = 2 * flatStringSize
+	flatLogSize            = 16
+	flatLogGroupHeaderSize = 16 + 4*flatStringSize
+)
+
+var errInvalidFlatLogGroup = errors.New("invalid flat log group")
+
+// UnmarshalFlat decodes a flat log group. data is copied once, and all strings of the group refer to the copy, so the
+// count of allocations depends on neither the count of logs nor of fields.
+func (m *LogGroup) UnmarshalFlat(data []byte) error {
+	if len(data) < flatLogGroupHeaderSize || binary.LittleEndian.Uint32(data) != flatLogGroupMagic {
+		return errInvalidFlatLogGroup
+	}
+	logCount := uint64(binary.LittleEndian.Uint32(data[4:]))
+	contentCount := uint64(binary.LittleEndian.Uint32(data[8:]))
+	tagCount := uint64(binary.LittleEndian.Uint32(data[12:]))
+	if flatLogGroupHeaderSize+logCount*flatLogSize+(contentCount+tagCount)*flatPairSize > uint64(len(data)) {
+		return errInvalidFlatLogGroup
+	}
+	buf := make([]byte, len(data))
+	copy(buf, data)
+	d := flatDecoder{buf: buf}
+
+	m.Category = d.string(16)
+	m.Topic = d.string(16 + flatStringSize)
+	m.Source = d.string(16 + 2*flatStringSize)
+	m.MachineUUID = d.string(16 + 3*flatStringSize)
+
+	logs := make([]Log, logCount)
+	m.Logs = make([]*Log, logCount)
+	contents := make([]Log_Content, contentCount)
+	contentPtrs := make([]*Log_Content, contentCount)
+	var timeNs []uint32
+	logOffset := uint64(flatLogGroupHeaderSize)
+	contentOffset := logOffset + logCount*flatLogSize
+	contentIndex := uint64(0)
+	for i := range logs {
+		log := &logs[i]
+		log.Time = binary.LittleEndian.Uint32(buf[logOffset:])
+		if binary.LittleEndian.Uint32(buf[logOffset+8:]) != 0 {
+			if timeNs == nil {
+				timeNs = make([]uint32, logCount)
+			}
+			timeNs[i] = binary.LittleEndian.Uint32(buf[logOffset+4:])
+			log.TimeNs = &timeNs[i]
+		}
+		count := uint64(binary.LittleEndian.Uint32(buf[logOffset+12:]))
+		if contentIndex+count > contentCount {
+			return errInvalidFlatLogGroup
+		}
+		for j := contentIndex; j < contentIndex+count; j++ {
+			contents[j].Key = d.string(contentOffset + j*flatPairSize)
+			contents[j].Value = d.string(contentOffset + j*flatPairSize + flatStringSize)
+			contentPtrs[j] = &contents[j]
+		}
+		if count > 0 {
+			// the capacity is limited so that appending to a log does not overwrite the next one
+			log.Contents = contentPtrs[contentIndex : contentIndex+count : contentIndex+count]
+		}
+		contentIndex += count
+		m.Logs[i] = log
+		logOffset += flatLogSize
+	}
+	if contentIndex != contentCount {
+		return errInvalidFlatLogGroup
+	}
+
+	if tagCount > 0 {
+		tags := make([]LogTag, tagCount)
+		m.LogTags = make([]*LogTag, tagCount)
+		tagOffset := contentOffset + contentCount*flatPairSize
+		for i := range tags {
+			tags[i].Key = d.string(tagOffset + uint64(i)*flatPairSize)
+			tags[i].Value = d.string(tagOffset + uint64(i)*flatPairSize + flatStringSize)
+			m.LogTags[i] = &tags[i]
+		}
+	}
+	return d.err
+}
+
+type flatDecoder struct {
+	buf []byte
+	err error
+}
+
+// string returns the string whose FlatString is at offset, which the caller has checked to be in buf.
+//
+//nolint:gosec
+func (d *flatDecoder) string(offset uint64) (s string) {
+	begin := uint64(binary.LittleEndian.Uint32(d.buf[offset:]))
+	length := uint64(binary.LittleEndian.Uint32(d.buf[offset+4:]))
+	if length == 0 {
+		return
+	}
+	if begin+length > uint64(len(d.buf)) {
+		d.err = errInvalidFlatLogGroup
+		return
+	}
+	bytes := d.buf[begin : begin+length]
+	pbytes := (*reflect.SliceHeader)(unsafe.Pointer(&bytes))
+	pstring := (*reflect.StringHeader)(unsafe.Pointer(&s))
+	pstring.Data = pbytes.Data
+	pstring.Len = pbytes.Len
+	return
+}
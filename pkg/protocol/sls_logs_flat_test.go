@@ -0,0 +1,216 @@
+// Copyright 2024 iLogtail Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package protocol
+
+import (
+	"encoding/binary"
+	"os"
+	"strconv"
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+// marshalFlat encodes like FlatLogGroupWriter in core/go_pipeline/FlatLogGroup.cpp.
+func marshalFlat(m *LogGroup) []byte {
+	contentCount := 0
+	for _, log := range m.Logs {
+		contentCount += len(log.Contents)
+	}
+	recordSize := flatLogGroupHeaderSize + len(m.Logs)*flatLogSize + (contentCount+len(m.LogTags))*flatPairSize
+	records := make([]byte, 0, recordSize)
+	var strs []byte
+	putUint32 := func(v uint32) {
+		records = binary.LittleEndian.AppendUint32(records, v)
+	}
+	putString := func(s string) {
+		putUint32(uint32(recordSize + len(strs)))
+		putUint32(uint32(len(s)))
+		strs = append(strs, s...)
+	}
+	putUint32(flatLogGroupMagic)
+	putUint32(uint32(len(m.Logs)))
+	putUint32(uint32(contentCount))
+	putUint32(uint32(len(m.LogTags)))
+	putString(m.Category)
+	putString(m.Topic)
+	putString(m.Source)
+	putString(m.MachineUUID)
+	for _, log := range m.Logs {
+		putUint32(log.Time)
+		if log.TimeNs != nil {
+			putUint32(*log.TimeNs)
+			putUint32(1)
+		} else {
+			putUint32(0)
+			putUint32(0)
+		}
+		putUint32(uint32(len(log.Contents)))
+	}
+	for _, log := range m.Logs {
+		for _, content := range log.Contents {
+			putString(content.Key)
+			putString(content.Value)
+		}
+	}
+	for _, tag := range m.LogTags {
+		putString(tag.Key)
+		putString(tag.Value)
+	}
+	return append(records, strs...)
+}
+
+func newFlatTestLogGroup(logCount, contentCount int) *LogGroup {
+	logGroup := &LogGroup{
+		Category: "logstore",
+		Source:   "192.168.0.1",
+		LogTags: []*LogTag{
+			{Key: "__path__", Value: "/var/log/app/access.log"},
+			{Key: "__hostname__", Value: "host-0"},
+		},
+	}
+	for i := 0; i < logCount; i++ {
+		log := &Log{Time: uint32(1700000000 + i)}
+		if i%2 == 0 {
+			SetLogTimeWithNano(log, log.Time, uint32(i))
+		}
+		for j := 0; j < contentCount; j++ {
+			log.Contents = append(log.Contents, &Log_Content{
+				Key:   "key" + strconv.Itoa(j),
+				Value: "value of log " + strconv.Itoa(i) + " field " + strconv.Itoa(j),
+			})
+		}
+		logGroup.Logs = append(logGroup.Logs, log)
+	}
+	return logGroup
+}
+
+func TestLogGroupUnmarshalFlat(t *testing.T) {
+	expected := newFlatTestLogGroup(10, 5)
+	expected.Logs = append(expected.Logs, &Log{Time: 1})
+	data := marshalFlat(expected)
+
+	logGroup := &LogGroup{}
+	require.NoError(t, logGroup.UnmarshalFlat(data))
+	assert.Equal(t, expected, logGroup)
+
+	// the group does not refer to data, which is owned by core
+	for i := range data {
+		data[i] = 0
+	}
+	assert.Equal(t, "key0", logGroup.Logs[0].Contents[0].Key)
+	// appending to a log leaves the next one unchanged
+	logGroup.Logs[0].Contents = append(logGroup.Logs[0].Contents, &Log_Content{Key: "k", Value: "v"})
+	assert.Equal(t, "key0", logGroup.Logs[1].Contents[0].Key)
+}
+
+// newFlatGoldenLogGroup returns the group encoded in testdata/flat_log_group.golden, which is written by
+// FlatLogGroupWriter and checked by TestGolden in core/unittest/go_pipeline/FlatLogGroupUnittest.cpp. The group must be
+// kept the same as the one there.
+func newFlatGoldenLogGroup() *LogGroup {
+	timeNs := uint32(123456789)
+	return &LogGroup{
+		Category:    "logstore",
+		Topic:       "topic",
+		Source:      "192.168.0.1",
+		MachineUUID: "machine-uuid",
+		Logs: []*Log{
+			{
+				Time:   1700000000,
+				TimeNs: &timeNs,
+				Contents: []*Log_Content{
+					{Key: "method", Value: "GET"},
+					{Key: "status", Value: "200"},
+				},
+			},
+			{Time: 1700000001},
+			{
+				Time: 1700000002,
+				Contents: []*Log_Content{
+					{Key: "", Value: ""},
+					{Key: "msg", Value: "\u4e2d\u6587 text"},
+				},
+			},
+		},
+		LogTags: []*LogTag{
+			{Key: "__path__", Value: "/var/log/app/access.log"},
+			{Key: "__hostname__", Value: "host-0"},
+		},
+	}
+}
+
+// TestLogGroupFlatGolden checks the decoder and marshalFlat against the bytes core writes.
+func TestLogGroupFlatGolden(t *testing.T) {
+	golden, err := os.ReadFile("testdata/flat_log_group.golden")
+	require.NoError(t, err)
+	expected := newFlatGoldenLogGroup()
+
+	logGroup := &LogGroup{}
+	require.NoError(t, logGroup.UnmarshalFlat(golden))
+	assert.Equal(t, expected, logGroup)
+	assert.Equal(t, golden, marshalFlat(expected))
+}
+
+func TestLogGroupUnmarshalFlatInvalid(t *testing.T) {
+	data := marshalFlat(newFlatTestLogGroup(2, 2))
+	assert.Error(t, (&LogGroup{}).UnmarshalFlat(data[:flatLogGroupHeaderSize-1]))
+	assert.Error(t, (&LogGroup{}).UnmarshalFlat(data[:flatLogGroupHeaderSize+flatLogSize]))
+
+	badMagic := append([]byte{}, data...)
+	badMagic[0]++
+	assert.Error(t, (&LogGroup{}).UnmarshalFlat(badMagic))
+
+	// the string of the first content ends beyond the buffer
+	badString := append([]byte{}, data...)
+	contentOffset := flatLogGroupHeaderSize + 2*flatLogSize
+	binary.LittleEndian.PutUint32(badString[contentOffset+4:], uint32(len(data)))
+	assert.Error(t, (&LogGroup{}).UnmarshalFlat(badString))
+
+	// the logs claim more contents than the group has
+	badCount := append([]byte{}, data...)
+	binary.LittleEndian.PutUint32(badCount[flatLogGroupHeaderSize+12:], 3)
+	assert.Error(t, (&LogGroup{}).UnmarshalFlat(badCount))
+}
+
+// BenchmarkLogGroupUnmarshal compares the groups/s the Go side of the bridge decodes from protobuf and the flat format.
+func BenchmarkLogGroupUnmarshal(b *testing.B) {
+	logGroup := newFlatTestLogGroup(100, 10)
+	pbData, err := logGroup.Marshal()
+	require.NoError(b, err)
+	flatData := marshalFlat(logGroup)
+
+	b.Run("protobuf", func(b *testing.B) {
+		b.ReportAllocs()
+		start := time.Now()
+		for i := 0; i < b.N; i++ {
+			if err := (&LogGroup{}).Unmarshal(pbData); err != nil {
+				b.Fatal(err)
+			}
+		}
+		b.ReportMetric(float64(b.N)/time.Since(start).Seconds(), "groups/s")
+	})
+	b.Run("flat", func(b *testing.B) {
+		b.ReportAllocs()
+		start := time.Now()
+		for i := 0; i < b.N; i++ {
+			if err := (&LogGroup{}).UnmarshalFlat(flatData); err != nil {
+				b.Fatal(err)
+			}
+		}
+		b.ReportMetric(float64(b.N)/time.Since(start).Seconds(), "groups/s")
+	})
+}
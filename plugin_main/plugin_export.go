@@ -173,6 +173,16 @@ func ProcessLogGroup(configName string, logBytes []byte, packID string) int {
 	return config.ProcessLogGroup(logBytes, packID)
 }
 
+//export ProcessLogGroupFlat
+func ProcessLogGroupFlat(configName string, flatBytes []byte, packID string) int {
+	config, exists := pluginmanager.LogtailConfig[configName]
+	if !exists {
+		logger.Debug(context.Background(), "config not found", configName)
+		return -1
+	}
+	return config.ProcessLogGroupFlat(flatBytes, packID)
+}
+
 //export HoldOn
 func HoldOn(exitFlag int) {
 	logger.Info(context.Background(), "Hold on", "start", "flag", exitFlag)
@@ -346,6 +346,22 @@ func (lc *LogstoreConfig) ProcessLogGroup(logByte []byte, packID string) int {
 	return 0
 }
 
+// ProcessLogGroupFlat is ProcessLogGroup for log groups in the flat format of core/go_pipeline/FlatLogGroup.h.
+func (lc *LogstoreConfig) ProcessLogGroupFlat(flatBytes []byte, packID string) int {
+	logGroup := &protocol.LogGroup{}
+	err := logGroup.UnmarshalFlat(flatBytes)
+	if err != nil {
+		logger.Error(lc.Context.GetRuntimeContext(), "WRONG_PROTOBUF_ALARM",
+			"cannot process flat log group passed by core, err", err)
+		return -1
+	}
+	lc.PluginRunner.ReceiveLogGroup(pipeline.LogGroupWithContext{
+		LogGroup: logGroup,
+		Context:  map[string]interface{}{ctxKeySource: packID}},
+	)
+	return 0
+}
+
 func hasDockerStdoutInput(plugins map[string]interface{}) bool {
 	inputs, exists := plugins["inputs"]
 	if !exists {